@@ -30,12 +30,59 @@ GameLayer::GameLayer()
 Scene* GameLayer::createScene(int level)
 {
     auto scene = Scene::create();
-    auto layer = GameLayer::create(level);
-    scene->addChild(layer);
+    
+    //画像をバックグラウンドで先読みし、読み込み完了後にレイヤーを生成する
+    auto preloader = AssetPreloader::create();
+    for (auto& fileName : getPreloadFileNames(level))
+        preloader->addTexture(fileName);
+    
+    scene->retain();
+    preloader->retain();
+    preloader->start(nullptr, [scene, preloader, level]()
+    {
+        auto layer = GameLayer::create(level);
+        scene->addChild(layer);
+        
+        //テクスチャはスプライトが保持しているので解放してよい
+        scene->release();
+        preloader->release();
+    });
     
     return scene;
 }
 
+//先読みする画像の取得
+std::vector<std::string> GameLayer::getPreloadFileNames(int level)
+{
+    std::vector<std::string> fileNames
+    {
+        "Background1.png",
+        "Background2.png",
+        "HpEnemyBackground.png",
+        "HpEnemyRed.png",
+        "CardBlue.png",
+        "CardRed.png",
+        "CardGreen.png",
+        "CardYellow.png",
+        "CardPurple.png",
+        "HpCardBackground.png",
+        "HpCardGreen.png",
+        "Level.png",
+        "Win.png",
+        "Lose.png",
+    };
+    
+    //レベルごとの画像
+    fileNames.push_back(StringUtils::format("Enemy%d.png", level));
+    fileNames.push_back(StringUtils::format("%d.png", level));
+    
+    //ボールの画像
+    for (int type = (int)BallSprite::BallType::Blue; type <= (int)BallSprite::BallType::Pink; type++)
+        fileNames.push_back(BallSprite::getBallImageFilePath((BallSprite::BallType)type));
+    
+    return fileNames;
+}
+
 //インスタンス生成
 GameLayer* GameLayer::create(int level)
 {
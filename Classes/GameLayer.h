@@ -81,6 +81,7 @@ protected:
     void winAnimation(); //Winアニメーション
     void loseAnimation(); //Loseアニメーション
     void nextScene(float dt); //次のシーンへ遷移
+    static std::vector<std::string> getPreloadFileNames(int level); //先読みする画像の取得
     
 public:
     GameLayer(); //コンストラクタ
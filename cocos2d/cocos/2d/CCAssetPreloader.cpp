@@ -0,0 +1,532 @@
+/****************************************************************************
+ Copyright (c) 2013-2014 Chukong Technologies Inc.
+
+ http://www.cocos2d-x.org
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#include "2d/CCAssetPreloader.h"
+
+#include <chrono>
+#include <sstream>
+
+#include "2d/CCSpriteFrameCache.h"
+#include "2d/CCFontAtlasCache.h"
+#include "base/CCDirector.h"
+#include "base/CCScheduler.h"
+#include "platform/CCFileUtils.h"
+#include "renderer/CCTextureCache.h"
+
+NS_CC_BEGIN
+
+AssetPreloader* AssetPreloader::create()
+{
+    AssetPreloader* ret = new AssetPreloader();
+    ret->autorelease();
+    return ret;
+}
+
+AssetPreloader::AssetPreloader()
+: _startedCount(0)
+, _loading(false)
+, _cancelled(false)
+, _loadedCount(0)
+, _failedCount(0)
+, _reportedCount(0)
+, _mainThreadBudget(1.0f / 240)
+, _threadCount(0)
+, _needQuit(false)
+{
+    unsigned int cores = std::thread::hardware_concurrency();
+    _threadCount = MIN(MAX(cores, 2u) - 1, 4u);
+}
+
+AssetPreloader::~AssetPreloader()
+{
+    CCLOGINFO("deallocing AssetPreloader: %p", this);
+
+    for (auto& atlas : _fontAtlases)
+    {
+        FontAtlasCache::releaseFontAtlas(atlas);
+    }
+
+    for (auto& asset : _assets)
+    {
+        delete asset;
+    }
+}
+
+AssetPreloader::Asset* AssetPreloader::addAsset(AssetType type, const std::string& key, const std::string& filename)
+{
+    auto it = _assetsByKey.find(key);
+    if (it != _assetsByKey.end())
+    {
+        return it->second;
+    }
+
+    Asset* asset = new Asset(type, filename);
+    _assets.push_back(asset);
+    _assetsByKey[key] = asset;
+    return asset;
+}
+
+void AssetPreloader::addTexture(const std::string& filename)
+{
+    CCASSERT(!_loading, "AssetPreloader: can't add assets while loading");
+    // keyed by the full path, as the TextureCache
+    std::string fullpath = FileUtils::getInstance()->fullPathForFilename(filename);
+    addAsset(AssetType::TEXTURE, "texture:" + fullpath, fullpath);
+}
+
+void AssetPreloader::addSpriteFrames(const std::string& plist)
+{
+    CCASSERT(!_loading, "AssetPreloader: can't add assets while loading");
+    // keyed by the plist name, as the SpriteFrameCache
+    addAsset(AssetType::SPRITE_FRAMES, "spriteFrames:" + plist, plist);
+}
+
+void AssetPreloader::addParticle(const std::string& plist)
+{
+    CCASSERT(!_loading, "AssetPreloader: can't add assets while loading");
+    addAsset(AssetType::PARTICLE, "particle:" + plist, plist);
+}
+
+void AssetPreloader::addFont(const TTFConfig& config)
+{
+    CCASSERT(!_loading, "AssetPreloader: can't add assets while loading");
+
+    std::stringstream key;
+    key << "font:" << config.fontFilePath << ":" << config.fontSize << ":" << (int)config.glyphs << ":"
+        << config.distanceFieldEnabled << ":" << config.outlineSize;
+    if (config.customGlyphs)
+    {
+        key << ":" << config.customGlyphs;
+    }
+
+    Asset* asset = addAsset(AssetType::FONT, key.str(), config.fontFilePath);
+    asset->ttfConfig = config;
+    // the config only points to the custom glyphs
+    if (config.customGlyphs)
+    {
+        asset->customGlyphs = config.customGlyphs;
+    }
+}
+
+void AssetPreloader::addTask(const std::string& name, const std::function<void()>& task, bool onWorkerThread)
+{
+    CCASSERT(!_loading, "AssetPreloader: can't add assets while loading");
+
+    // tasks are never merged
+    Asset* asset = new Asset(AssetType::TASK, name);
+    asset->task = task;
+    asset->onWorkerThread = onWorkerThread;
+    _assets.push_back(asset);
+}
+
+bool AssetPreloader::addManifest(const std::string& plist)
+{
+    ValueMap manifest = FileUtils::getInstance()->getValueMapFromFile(plist);
+    if (manifest.empty())
+    {
+        CCLOG("cocos2d: AssetPreloader: can't read the manifest %s", plist.c_str());
+        return false;
+    }
+
+    auto addFiles = [&manifest](const std::string& key, const std::function<void(const std::string&)>& add) {
+        auto it = manifest.find(key);
+        if (it != manifest.end() && it->second.getType() == Value::Type::VECTOR)
+        {
+            for (const auto& value : it->second.asValueVector())
+            {
+                add(value.asString());
+            }
+        }
+    };
+
+    addFiles("textures", [this](const std::string& filename) { addTexture(filename); });
+    addFiles("spriteFrames", [this](const std::string& filename) { addSpriteFrames(filename); });
+    addFiles("particles", [this](const std::string& filename) { addParticle(filename); });
+
+    auto fonts = manifest.find("fonts");
+    if (fonts != manifest.end() && fonts->second.getType() == Value::Type::VECTOR)
+    {
+        for (auto& value : fonts->second.asValueVector())
+        {
+            if (value.getType() != Value::Type::MAP)
+            {
+                continue;
+            }
+
+            ValueMap& font = value.asValueMap();
+            TTFConfig config;
+            config.fontFilePath = font["file"].asString();
+            config.fontSize = font["size"].asInt();
+            config.outlineSize = font.find("outline") != font.end() ? font["outline"].asInt() : 0;
+            config.distanceFieldEnabled = config.outlineSize == 0 && font.find("distanceField") != font.end() && font["distanceField"].asBool();
+            addFont(config);
+        }
+    }
+
+    return true;
+}
+
+void AssetPreloader::start(const ProgressCallback& progressCallback, const CompletionCallback& completionCallback)
+{
+    CCASSERT(!_loading, "AssetPreloader: already loading");
+
+    _progressCallback = progressCallback;
+    _completionCallback = completionCallback;
+    _loading = true;
+    _cancelled = false;
+
+    // released once loaded, the threads and the TextureCache call it back until then
+    retain();
+    Director::getInstance()->getScheduler()->scheduleUpdate(this, 0, false);
+
+    // the dependencies found while loading are appended to _assets, and loaded then
+    size_t count = _assets.size();
+    for (size_t i = _startedCount; i < count; ++i)
+    {
+        loadAsset(_assets[i]);
+    }
+    _startedCount = count;
+}
+
+void AssetPreloader::cancel()
+{
+    _cancelled = true;
+}
+
+void AssetPreloader::loadAsset(Asset* asset)
+{
+    switch (asset->type)
+    {
+        case AssetType::TEXTURE:
+            Director::getInstance()->getTextureCache()->addImageAsync(asset->filename, [this, asset](Texture2D* texture) {
+                if (texture)
+                {
+                    // kept until the preloader is released, for the memory budget of the TextureCache not to evict it
+                    asset->texture = texture;
+                    _textures.pushBack(texture);
+                }
+                else
+                {
+                    asset->failed = true;
+                }
+                onAssetLoaded(asset);
+            });
+            break;
+
+        case AssetType::SPRITE_FRAMES:
+            if (SpriteFrameCache::getInstance()->isSpriteFramesWithFileLoaded(asset->filename))
+            {
+                onAssetLoaded(asset);
+                break;
+            }
+            // fall through
+        case AssetType::PARTICLE:
+            readOnWorkerThread(asset);
+            break;
+
+        case AssetType::FONT:
+            _mainThreadQueue.push_back(asset);
+            break;
+
+        case AssetType::TASK:
+            if (asset->onWorkerThread)
+            {
+                readOnWorkerThread(asset);
+            }
+            else
+            {
+                _mainThreadQueue.push_back(asset);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+void AssetPreloader::readOnWorkerThread(Asset* asset)
+{
+    if (_workerThreads.empty())
+    {
+        _needQuit = false;
+        for (unsigned int i = 0; i < _threadCount; ++i)
+        {
+            _workerThreads.push_back(std::thread(&AssetPreloader::workerLoop, this));
+        }
+    }
+
+    _workerQueueMutex.lock();
+    _workerQueue.push_back(asset);
+    _workerQueueMutex.unlock();
+
+    _workerCondition.notify_one();
+}
+
+void AssetPreloader::workerLoop()
+{
+    while (true)
+    {
+        Asset* asset = nullptr;
+        {
+            std::unique_lock<std::mutex> lk(_workerQueueMutex);
+            _workerCondition.wait(lk, [this]() { return _needQuit || !_workerQueue.empty(); });
+            if (_needQuit)
+            {
+                break;
+            }
+
+            asset = _workerQueue.front();
+            _workerQueue.pop_front();
+        }
+
+        if (_cancelled)
+        {
+            asset->failed = true;
+        }
+        else if (asset->type == AssetType::TASK)
+        {
+            asset->task();
+        }
+        else
+        {
+            std::string fullpath = FileUtils::getInstance()->fullPathForFilename(asset->filename);
+            asset->dictionary = FileUtils::getInstance()->getValueMapFromFile(fullpath);
+
+            if (asset->dictionary.empty())
+            {
+                CCLOG("cocos2d: AssetPreloader: can't read %s", asset->filename.c_str());
+                asset->failed = true;
+            }
+            else if (asset->type == AssetType::SPRITE_FRAMES)
+            {
+                asset->texturePath = SpriteFrameCache::getTextureFileName(asset->filename, asset->dictionary);
+            }
+            else
+            {
+                // the texture file, found as ParticleSystem::initWithFile() does. The textures embedded in the plist aren't preloaded
+                auto it = asset->dictionary.find("textureFileName");
+                std::string textureName = it != asset->dictionary.end() ? it->second.asString() : "";
+                size_t pos = asset->filename.rfind('/');
+                std::string dirname = pos != std::string::npos ? asset->filename.substr(0, pos + 1) : "";
+
+                size_t rPos = textureName.rfind('/');
+                if (rPos != std::string::npos)
+                {
+                    if (!dirname.empty() && textureName.substr(0, rPos + 1) != dirname)
+                    {
+                        textureName = dirname + textureName.substr(rPos + 1);
+                    }
+                }
+                else if (!dirname.empty() && !textureName.empty())
+                {
+                    textureName = dirname + textureName;
+                }
+
+                if (!textureName.empty() && FileUtils::getInstance()->isFileExist(textureName))
+                {
+                    asset->texturePath = textureName;
+                }
+            }
+        }
+
+        Director::getInstance()->getScheduler()->performFunctionInCocosThread([this, asset]() {
+            onAssetRead(asset);
+        });
+    }
+}
+
+void AssetPreloader::onAssetRead(Asset* asset)
+{
+    if (asset->type == AssetType::TASK || asset->failed)
+    {
+        onAssetLoaded(asset);
+        return;
+    }
+
+    if (!asset->texturePath.empty())
+    {
+        std::string fullpath = FileUtils::getInstance()->fullPathForFilename(asset->texturePath);
+        std::string key = "texture:" + fullpath;
+        bool added = _assetsByKey.find(key) == _assetsByKey.end();
+        Asset* textureAsset = addAsset(AssetType::TEXTURE, key, fullpath);
+        asset->textureAsset = textureAsset;
+
+        if (added)
+        {
+            // not listed, load it as well
+            _startedCount = _assets.size();
+            loadAsset(textureAsset);
+        }
+
+        if (!textureAsset->loaded)
+        {
+            ++asset->pendingDependencies;
+            textureAsset->dependents.push_back(asset);
+            return;
+        }
+        asset->failed = textureAsset->failed;
+    }
+
+    if (asset->type == AssetType::SPRITE_FRAMES && !asset->failed)
+    {
+        _mainThreadQueue.push_back(asset);
+    }
+    else
+    {
+        onAssetLoaded(asset);
+    }
+}
+
+void AssetPreloader::loadOnMainThread(Asset* asset)
+{
+    if (_cancelled)
+    {
+        asset->failed = true;
+        return;
+    }
+
+    switch (asset->type)
+    {
+        case AssetType::SPRITE_FRAMES:
+            SpriteFrameCache::getInstance()->addSpriteFramesWithDictionary(asset->filename, asset->dictionary, asset->textureAsset->texture);
+            // not needed anymore
+            asset->dictionary.clear();
+            break;
+
+        case AssetType::FONT:
+        {
+            TTFConfig config = asset->ttfConfig;
+            config.customGlyphs = asset->customGlyphs.empty() ? nullptr : asset->customGlyphs.c_str();
+            FontAtlas* atlas = FontAtlasCache::getFontAtlasTTF(config);
+            if (atlas)
+            {
+                _fontAtlases.push_back(atlas);
+            }
+            else
+            {
+                CCLOG("cocos2d: AssetPreloader: can't load the font %s", asset->filename.c_str());
+                asset->failed = true;
+            }
+            break;
+        }
+
+        case AssetType::TASK:
+            asset->task();
+            break;
+
+        default:
+            break;
+    }
+}
+
+void AssetPreloader::onAssetLoaded(Asset* asset)
+{
+    asset->loaded = true;
+    ++_loadedCount;
+    if (asset->failed)
+    {
+        ++_failedCount;
+    }
+
+    for (auto& dependent : asset->dependents)
+    {
+        dependent->failed = dependent->failed || asset->failed;
+        if (--dependent->pendingDependencies == 0)
+        {
+            if (dependent->type == AssetType::SPRITE_FRAMES && !dependent->failed)
+            {
+                _mainThreadQueue.push_back(dependent);
+            }
+            else
+            {
+                onAssetLoaded(dependent);
+            }
+        }
+    }
+    asset->dependents.clear();
+}
+
+void AssetPreloader::update(float dt)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    while (!_mainThreadQueue.empty())
+    {
+        Asset* asset = _mainThreadQueue.front();
+        _mainThreadQueue.pop_front();
+
+        loadOnMainThread(asset);
+        onAssetLoaded(asset);
+
+        std::chrono::duration<float> elapsed = std::chrono::steady_clock::now() - start;
+        if (elapsed.count() > _mainThreadBudget)
+        {
+            break;
+        }
+    }
+
+    if (!_cancelled && _progressCallback && _reportedCount != _loadedCount)
+    {
+        _progressCallback(_loadedCount, (int)_assets.size());
+    }
+    _reportedCount = _loadedCount;
+
+    if (_loadedCount == (int)_assets.size())
+    {
+        finish();
+    }
+}
+
+void AssetPreloader::finish()
+{
+    Director::getInstance()->getScheduler()->unscheduleUpdate(this);
+
+    // the threads are idle
+    _workerQueueMutex.lock();
+    _needQuit = true;
+    _workerQueueMutex.unlock();
+    _workerCondition.notify_all();
+
+    for (auto& thread : _workerThreads)
+    {
+        thread.join();
+    }
+    _workerThreads.clear();
+
+    _loading = false;
+
+    // the callback may start loading again
+    CompletionCallback completionCallback = _cancelled ? nullptr : _completionCallback;
+    _progressCallback = nullptr;
+    _completionCallback = nullptr;
+
+    if (completionCallback)
+    {
+        completionCallback();
+    }
+
+    release();
+}
+
+NS_CC_END
@@ -0,0 +1,210 @@
+/****************************************************************************
+ Copyright (c) 2013-2014 Chukong Technologies Inc.
+
+ http://www.cocos2d-x.org
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#ifndef __CCASSET_PRELOADER_H__
+#define __CCASSET_PRELOADER_H__
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+#include "base/CCRef.h"
+#include "base/CCValue.h"
+#include "base/CCVector.h"
+#include "2d/CCLabel.h"
+
+NS_CC_BEGIN
+
+class Texture2D;
+class FontAtlas;
+
+/**
+ * @addtogroup misc_nodes
+ * @{
+ */
+
+/** @brief Loads the assets of a scene ahead of its creation, without blocking the cocos2d thread.
+
+ The assets are listed with the add methods or with a manifest, then start() loads them:
+ - the textures, decoded by the TextureCache::addImageAsync threads
+ - the sprite frames plists, read by the preloader threads; their texture is loaded before the frames are added to the SpriteFrameCache
+ - the particle plists, read by the preloader threads; their texture is loaded into the TextureCache
+ - the TTF fonts, whose atlases are created by the FontAtlasCache on the cocos2d thread
+ - the tasks, custom work such as preloading the audio, run by the preloader threads or on the cocos2d thread
+
+ An asset is loaded once, even if several plists depend on it, and after the assets it depends on.
+ The work left to the cocos2d thread is spread over the frames, a few milliseconds per frame.
+ The preloader keeps the textures and the font atlases it loaded until it is released, so the caches
+ still hold them when the scene is created.
+ @since v3.2
+ */
+class CC_DLL AssetPreloader : public Ref
+{
+public:
+    /** Called with the number of assets loaded, failed included, and the number of assets, dependencies included */
+    typedef std::function<void(int loadedCount, int totalCount)> ProgressCallback;
+    /** Called once all the assets are loaded, see getFailedCount() */
+    typedef std::function<void()> CompletionCallback;
+
+    static AssetPreloader* create();
+
+    /** Adds an image file loaded into the TextureCache */
+    void addTexture(const std::string& filename);
+
+    /** Adds a sprite frames plist loaded into the SpriteFrameCache, as SpriteFrameCache::addSpriteFramesWithFile(plist) does */
+    void addSpriteFrames(const std::string& plist);
+
+    /** Adds a particle plist whose texture is loaded into the TextureCache */
+    void addParticle(const std::string& plist);
+
+    /** Adds a TTF font whose atlas is created by the FontAtlasCache */
+    void addFont(const TTFConfig& config);
+
+    /** Adds a custom task, run by a preloader thread or on the cocos2d thread */
+    void addTask(const std::string& name, const std::function<void()>& task, bool onWorkerThread = true);
+
+    /** Adds the assets listed by a plist manifest, a dictionary of arrays:
+     "textures", "spriteFrames" and "particles" list file names,
+     "fonts" lists dictionaries with the "file", "size" and optional "outline" and "distanceField" keys.
+     Returns false if the manifest can't be read.
+     */
+    bool addManifest(const std::string& plist);
+
+    /** Starts loading the assets added so far. The callbacks are called on the cocos2d thread.
+     The preloader is retained until the loading is done.
+     */
+    void start(const ProgressCallback& progressCallback, const CompletionCallback& completionCallback);
+
+    /** Stops loading the assets, the callbacks won't be called. The work in progress is waited for. */
+    void cancel();
+
+    bool isLoading() const { return _loading; }
+    int getLoadedCount() const { return _loadedCount; }
+    int getTotalCount() const { return (int)_assets.size(); }
+    int getFailedCount() const { return _failedCount; }
+
+    /** Sets the number of threads reading the plists and running the tasks. By default, one less than the number of cores, between 1 and 4 */
+    void setThreadCount(unsigned int count) { _threadCount = MAX(count, 1u); }
+    unsigned int getThreadCount() const { return _threadCount; }
+
+    /** Sets how long, in seconds, the assets may be loaded on the cocos2d thread every frame.
+     At least one asset is loaded per frame whatever the budget. 4ms by default.
+     */
+    void setMainThreadBudget(float seconds) { _mainThreadBudget = seconds; }
+    float getMainThreadBudget() const { return _mainThreadBudget; }
+
+    /** Loads the assets left to the cocos2d thread, called every frame while loading */
+    void update(float dt);
+
+CC_CONSTRUCTOR_ACCESS:
+    AssetPreloader();
+    virtual ~AssetPreloader();
+
+protected:
+    enum class AssetType
+    {
+        TEXTURE,
+        SPRITE_FRAMES,
+        PARTICLE,
+        FONT,
+        TASK,
+    };
+
+    struct Asset
+    {
+        Asset(AssetType t, const std::string& fn) : type(t), filename(fn), onWorkerThread(false), texture(nullptr), textureAsset(nullptr), pendingDependencies(0), loaded(false), failed(false) {}
+
+        AssetType type;
+        // the file, or the name of the task
+        std::string filename;
+        TTFConfig ttfConfig;
+        std::string customGlyphs;
+        std::function<void()> task;
+        bool onWorkerThread;
+
+        // read by a preloader thread
+        ValueMap dictionary;
+        std::string texturePath;
+
+        Texture2D* texture;
+        Asset* textureAsset;
+
+        // the assets waiting for this one
+        std::vector<Asset*> dependents;
+        int pendingDependencies;
+        bool loaded;
+        bool failed;
+    };
+
+    Asset* addAsset(AssetType type, const std::string& key, const std::string& filename);
+    void loadAsset(Asset* asset);
+    void onAssetRead(Asset* asset);
+    void onAssetLoaded(Asset* asset);
+    void loadOnMainThread(Asset* asset);
+    void readOnWorkerThread(Asset* asset);
+    void workerLoop();
+    void finish();
+
+    std::vector<Asset*> _assets;
+    std::unordered_map<std::string, Asset*> _assetsByKey;
+    // the assets added since the last start()
+    size_t _startedCount;
+
+    bool _loading;
+    std::atomic<bool> _cancelled;
+    int _loadedCount;
+    int _failedCount;
+    int _reportedCount;
+
+    ProgressCallback _progressCallback;
+    CompletionCallback _completionCallback;
+
+    // waiting for the cocos2d thread, the assets they depend on loaded
+    std::deque<Asset*> _mainThreadQueue;
+    float _mainThreadBudget;
+
+    // waiting for a preloader thread
+    std::deque<Asset*> _workerQueue;
+    std::mutex _workerQueueMutex;
+    std::condition_variable _workerCondition;
+    std::vector<std::thread> _workerThreads;
+    unsigned int _threadCount;
+    bool _needQuit;
+
+    Vector<Texture2D*> _textures;
+    std::vector<FontAtlas*> _fontAtlases;
+};
+
+// end of misc_nodes group
+/// @}
+
+NS_CC_END
+
+#endif // __CCASSET_PRELOADER_H__
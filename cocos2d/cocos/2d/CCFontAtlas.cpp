@@ -24,12 +24,16 @@
  ****************************************************************************/
 
 #include "2d/CCFontAtlas.h"
+
+#include <algorithm>
+
 #include "2d/CCFontFreeType.h"
 #include "base/ccUTF8.h"
 #include "base/CCDirector.h"
 #include "base/CCEventListenerCustom.h"
 #include "base/CCEventDispatcher.h"
 #include "base/CCEventType.h"
+#include "base/CCProfiling.h"
 
 NS_CC_BEGIN
 
@@ -37,9 +41,32 @@ const int FontAtlas::CacheTextureWidth = 512;
 const int FontAtlas::CacheTextureHeight = 512;
 const char* FontAtlas::EVENT_PURGE_TEXTURES = "__cc_FontAtlasPurgeTextures";
 
+static int s_defaultPageWidth = FontAtlas::CacheTextureWidth;
+static int s_defaultPageHeight = FontAtlas::CacheTextureHeight;
+static int s_defaultMaxPageCount = 0;
+
+void FontAtlas::setDefaultPageSize(int width, int height)
+{
+    CCASSERT(width > 0 && height > 0, "Invalid page size");
+    s_defaultPageWidth = width;
+    s_defaultPageHeight = height;
+}
+
+void FontAtlas::setDefaultMaxPageCount(int maxPageCount)
+{
+    s_defaultMaxPageCount = MAX(maxPageCount, 0);
+}
+
 FontAtlas::FontAtlas(Font &theFont) 
 : _font(&theFont)
-, _currentPageData(nullptr)
+, _pageWidth(s_defaultPageWidth)
+, _pageHeight(s_defaultPageHeight)
+, _maxPageCount(s_defaultMaxPageCount)
+, _bytesPerPixel(1)
+, _pixelFormat(Texture2D::PixelFormat::A8)
+, _evictedPageCount(0)
+, _pagesEvicted(false)
+, _letterPadding(0)
 , _fontAscender(0)
 , _toForegroundListener(nullptr)
 , _toBackgroundListener(nullptr)
@@ -52,31 +79,22 @@ FontAtlas::FontAtlas(Font &theFont)
     {
         _commonLineHeight = _font->getFontMaxHeight();
         _fontAscender = fontTTf->getFontAscender();
-        auto texture = new Texture2D;
-        _currentPage = 0;
-        _currentPageOrigX = 0;
-        _currentPageOrigY = 0;
-        _letterPadding = 0;
 
         if(fontTTf->isDistanceFieldEnabled())
         {
             _letterPadding += 2 * FontFreeType::DistanceMapSpread;    
         }
-        _currentPageDataSize = CacheTextureWidth * CacheTextureHeight;
         if(fontTTf->getOutlineSize() > 0)
         {
-            _currentPageDataSize *= 2;
+            _pixelFormat = Texture2D::PixelFormat::AI88;
+            _bytesPerPixel = 2;
         }    
 
-        _currentPageData = new unsigned char[_currentPageDataSize];
-        memset(_currentPageData, 0, _currentPageDataSize);
-
-        auto  pixelFormat = fontTTf->getOutlineSize() > 0 ? Texture2D::PixelFormat::AI88 : Texture2D::PixelFormat::A8; 
-        texture->initWithData(_currentPageData, _currentPageDataSize, 
-            pixelFormat, CacheTextureWidth, CacheTextureHeight, Size(CacheTextureWidth,CacheTextureHeight) );
-
+        auto texture = createPageTexture();
         addTexture(texture,0);
         texture->release();
+        _skylines.resize(1);
+        resetSkyline(0);
 #if CC_ENABLE_CACHE_TEXTURE_DATA
         auto eventDispatcher = Director::getInstance()->getEventDispatcher();
         _toBackgroundListener = EventListenerCustom::create(EVENT_COME_TO_BACKGROUND, CC_CALLBACK_1(FontAtlas::listenToBackground, this));
@@ -109,8 +127,6 @@ FontAtlas::~FontAtlas()
 
     _font->release();
     relaseTextures();
-
-    delete []_currentPageData;
 }
 
 void FontAtlas::relaseTextures()
@@ -122,27 +138,67 @@ void FontAtlas::relaseTextures()
     _atlasTextures.clear();
 }
 
-void FontAtlas::purgeTexturesAtlas()
+Texture2D* FontAtlas::createPageTexture()
 {
-    FontFreeType* fontTTf = dynamic_cast<FontFreeType*>(_font);
-    if (fontTTf && _atlasTextures.size() > 1)
+    ssize_t dataLen = _pageWidth * _pageHeight * _bytesPerPixel;
+    auto data = (unsigned char*)calloc(dataLen, 1);
+
+    auto texture = new Texture2D;
+    if (_antialiasEnabled)
+    {
+        texture->setAntiAliasTexParameters();
+    } 
+    else
     {
-        for( auto &item: _atlasTextures)
+        texture->setAliasTexParameters();
+    }
+    texture->initWithData(data, dataLen, _pixelFormat, _pageWidth, _pageHeight, Size(_pageWidth,_pageHeight));
+    free(data);
+
+    return texture;
+}
+
+void FontAtlas::clearPage(int page)
+{
+    // the glyphs are uploaded one by one, so the old ones have to be erased from the texture
+    auto data = (unsigned char*)calloc(_pageWidth * _pageHeight * _bytesPerPixel, 1);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    _atlasTextures[page]->updateWithData(data, 0, 0, _pageWidth, _pageHeight);
+    free(data);
+
+    resetSkyline(page);
+}
+
+void FontAtlas::resetSkyline(int page)
+{
+    _skylines[page].clear();
+    _skylines[page].push_back({0, 0, _pageWidth});
+}
+
+void FontAtlas::resetPages()
+{
+    for( auto &item: _atlasTextures)
+    {
+        if (item.first != 0)
         {
-            if (item.first != 0)
-            {
-                item.second->release();
-            }
+            item.second->release();
         }
-        auto temp = _atlasTextures[0];
-        _atlasTextures.clear();
-        _atlasTextures[0] = temp;
+    }
+    auto temp = _atlasTextures[0];
+    _atlasTextures.clear();
+    _atlasTextures[0] = temp;
+    _skylines.resize(1);
+
+    _fontLetterDefinitions.clear();
+}
 
-        _fontLetterDefinitions.clear();
-        memset(_currentPageData,0,_currentPageDataSize);
-        _currentPage = 0;
-        _currentPageOrigX = 0;
-        _currentPageOrigY = 0;
+void FontAtlas::purgeTexturesAtlas()
+{
+    FontFreeType* fontTTf = dynamic_cast<FontFreeType*>(_font);
+    if (fontTTf && _atlasTextures.size() > 1)
+    {
+        resetPages();
+        clearPage(0);
 
         auto eventDispatcher = Director::getInstance()->getEventDispatcher();
         eventDispatcher->dispatchCustomEvent(EVENT_PURGE_TEXTURES,this);
@@ -153,24 +209,10 @@ void FontAtlas::listenToBackground(EventCustom *event)
 {
 #if CC_ENABLE_CACHE_TEXTURE_DATA
     FontFreeType* fontTTf = dynamic_cast<FontFreeType*>(_font);
-    if (fontTTf && _atlasTextures.size() > 1)
+    if (fontTTf)
     {
-        for( auto &item: _atlasTextures)
-        {
-            if (item.first != 0)
-            {
-                item.second->release();
-            }
-        }
-        auto temp = _atlasTextures[0];
-        _atlasTextures.clear();
-        _atlasTextures[0] = temp;
-
-        _fontLetterDefinitions.clear();
-        memset(_currentPageData,0,_currentPageDataSize);
-        _currentPage = 0;
-        _currentPageOrigX = 0;
-        _currentPageOrigY = 0;
+        resetPages();
+        resetSkyline(0);
     }
 #endif
 }
@@ -181,18 +223,14 @@ void FontAtlas::listenToForeground(EventCustom *event)
     FontFreeType* fontTTf = dynamic_cast<FontFreeType*>(_font);
     if (fontTTf)
     {
-        if (_currentPageOrigX == 0 && _currentPageOrigY == 0)
-        {
-            auto eventDispatcher = Director::getInstance()->getEventDispatcher();
-            eventDispatcher->dispatchCustomEvent(EVENT_PURGE_TEXTURES,this);
-        }
-        else
-        {
-            auto  pixelFormat = fontTTf->getOutlineSize() > 0 ? Texture2D::PixelFormat::AI88 : Texture2D::PixelFormat::A8;
+        // the glyphs are not kept in memory, the labels render them again
+        ssize_t dataLen = _pageWidth * _pageHeight * _bytesPerPixel;
+        auto data = (unsigned char*)calloc(dataLen, 1);
+        _atlasTextures[0]->initWithData(data, dataLen, _pixelFormat, _pageWidth, _pageHeight, Size(_pageWidth,_pageHeight));
+        free(data);
 
-            _atlasTextures[_currentPage]->initWithData(_currentPageData, _currentPageDataSize, 
-                pixelFormat, CacheTextureWidth, CacheTextureHeight, Size(CacheTextureWidth,CacheTextureHeight) );
-        }
+        auto eventDispatcher = Director::getInstance()->getEventDispatcher();
+        eventDispatcher->dispatchCustomEvent(EVENT_PURGE_TEXTURES,this);
     }
 #endif
 }
@@ -218,116 +256,276 @@ bool FontAtlas::getLetterDefinitionForChar(char16_t letteCharUTF16, FontLetterDe
     }
 }
 
-bool FontAtlas::prepareLetterDefinitions(const std::u16string& utf16String)
+bool FontAtlas::findPosition(int page, int width, int height, int& outX, int& outY, size_t& outIndex) const
 {
-    FontFreeType* fontTTf = dynamic_cast<FontFreeType*>(_font);
-    if(fontTTf == nullptr)
+    // bottom-left rule: the lowest position, then the narrowest segment
+    const auto& skyline = _skylines[page];
+    int bestBottom = _pageHeight + 1;
+    int bestWidth = _pageWidth + 1;
+    bool found = false;
+
+    for (size_t i = 0; i < skyline.size(); ++i)
+    {
+        int x = skyline[i].x;
+        if (x + width > _pageWidth)
+            break;
+
+        // the glyph rests on the highest segment it spans
+        int y = 0;
+        int widthLeft = width;
+        for (size_t j = i; widthLeft > 0; ++j)
+        {
+            y = MAX(y, skyline[j].y);
+            widthLeft -= skyline[j].width;
+        }
+        if (y + height > _pageHeight)
+            continue;
+
+        if (y + height < bestBottom || (y + height == bestBottom && skyline[i].width < bestWidth))
+        {
+            bestBottom = y + height;
+            bestWidth = skyline[i].width;
+            outX = x;
+            outY = y;
+            outIndex = i;
+            found = true;
+        }
+    }
+    return found;
+}
+
+void FontAtlas::addSkylineLevel(int page, size_t index, int x, int y, int width, int height)
+{
+    auto& skyline = _skylines[page];
+    skyline.insert(skyline.begin() + index, {x, y + height, width});
+
+    // shrink or remove the segments now covered by the new one
+    for (size_t i = index + 1; i < skyline.size(); )
+    {
+        auto& node = skyline[i];
+        auto& previous = skyline[i - 1];
+        if (node.x >= previous.x + previous.width)
+            break;
+
+        int shrink = previous.x + previous.width - node.x;
+        node.x += shrink;
+        node.width -= shrink;
+        if (node.width > 0)
+            break;
+        skyline.erase(skyline.begin() + i);
+    }
+
+    // merge the neighbours of the same height
+    for (size_t i = 0; i + 1 < skyline.size(); )
+    {
+        if (skyline[i].y == skyline[i + 1].y)
+        {
+            skyline[i].width += skyline[i + 1].width;
+            skyline.erase(skyline.begin() + i + 1);
+        }
+        else
+        {
+            ++i;
+        }
+    }
+}
+
+bool FontAtlas::allocateGlyph(int width, int height, unsigned int frame, int& outPage, int& outX, int& outY)
+{
+    if (width > _pageWidth || height > _pageHeight)
         return false;
 
-    size_t length = utf16String.length();
+    size_t index;
+    int pageCount = static_cast<int>(_skylines.size());
+    for (int page = 0; page < pageCount; ++page)
+    {
+        if (findPosition(page, width, height, outX, outY, index))
+        {
+            addSkylineLevel(page, index, outX, outY, width, height);
+            outPage = page;
+            return true;
+        }
+    }
+
+    outPage = -1;
+    if (_maxPageCount > 0 && pageCount >= _maxPageCount)
+    {
+        // reuse the least recently used page, unless it is still on screen
+        unsigned int oldestFrame = frame;
+        for (int page = 0; page < pageCount; ++page)
+        {
+            unsigned int lastUsedFrame = _atlasTextures[page]->getLastUsedFrame();
+            if (lastUsedFrame + 1 < frame && lastUsedFrame < oldestFrame)
+            {
+                oldestFrame = lastUsedFrame;
+                outPage = page;
+            }
+        }
+
+        if (outPage >= 0)
+        {
+            for (auto it = _fontLetterDefinitions.begin(); it != _fontLetterDefinitions.end(); )
+            {
+                if (it->second.textureID == outPage && it->second.width > 0)
+                    it = _fontLetterDefinitions.erase(it);
+                else
+                    ++it;
+            }
+            clearPage(outPage);
+            _evictedPageCount++;
+            _pagesEvicted = true;
+        }
+    }
 
-    float offsetAdjust = _letterPadding / 2;  
-    long bitmapWidth;
-    long bitmapHeight;
-    Rect tempRect;
+    if (outPage < 0)
+    {
+        outPage = pageCount;
+        auto texture = createPageTexture();
+        addTexture(texture, outPage);
+        texture->release();
+        _skylines.resize(pageCount + 1);
+        resetSkyline(outPage);
+    }
+
+    findPosition(outPage, width, height, outX, outY, index);
+    addSkylineLevel(outPage, index, outX, outY, width, height);
+    _atlasTextures[outPage]->setLastUsedFrame(frame);
+    return true;
+}
+
+void FontAtlas::addGlyph(unsigned short letter, const Rect& rect, int xAdvance, const unsigned char* data, int width, int height, unsigned int frame)
+{
     FontLetterDefinition tempDef;
+    tempDef.letteCharUTF16 = letter;
+    tempDef.xAdvance = xAdvance;
 
-    auto scaleFactor = CC_CONTENT_SCALE_FACTOR();
-    auto  pixelFormat = fontTTf->getOutlineSize() > 0 ? Texture2D::PixelFormat::AI88 : Texture2D::PixelFormat::A8; 
+    if (data)
+    {
+        float offsetAdjust = _letterPadding / 2;
+        int bottomHeight = _commonLineHeight - _fontAscender;
+
+        tempDef.validDefinition = true;
+        tempDef.width            = rect.size.width + _letterPadding;
+        tempDef.height           = rect.size.height + _letterPadding;
+        tempDef.offsetX          = rect.origin.x + offsetAdjust;
+        tempDef.offsetY          = _fontAscender + rect.origin.y - offsetAdjust;
+        tempDef.clipBottom     = bottomHeight - (tempDef.height + rect.origin.y + offsetAdjust);
+
+        // one pixel apart, so that the bilinear filtering doesn't bleed between the glyphs
+        int rectWidth = MAX(width, (int)ceilf(tempDef.width)) + 1;
+        int rectHeight = MAX(height, (int)ceilf(tempDef.height)) + 1;
+        int page, x, y;
+        if (allocateGlyph(rectWidth, rectHeight, frame, page, x, y))
+        {
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            _atlasTextures[page]->updateWithData(data, x, y, width, height);
+
+            // take from pixels to points
+            auto scaleFactor = CC_CONTENT_SCALE_FACTOR();
+            tempDef.width  =    tempDef.width  / scaleFactor;
+            tempDef.height =    tempDef.height / scaleFactor;      
+            tempDef.U      =    x / scaleFactor;
+            tempDef.V      =    y / scaleFactor;
+            tempDef.textureID = page;
+        }
+        else
+        {
+            CCLOG("cocos2d: FontAtlas: the glyph %d doesn't fit in a %dx%d page", (int)letter, _pageWidth, _pageHeight);
+            tempDef.validDefinition = false;
+            tempDef.width            = 0;
+            tempDef.height           = 0;
+            tempDef.U                = 0;
+            tempDef.V                = 0;
+            tempDef.textureID        = 0;
+        }
+    }
+    else
+    {
+        tempDef.validDefinition  = xAdvance != 0;
+        tempDef.width            = 0;
+        tempDef.height           = 0;
+        tempDef.U                = 0;
+        tempDef.V                = 0;
+        tempDef.offsetX          = 0;
+        tempDef.offsetY          = 0;
+        tempDef.textureID        = 0;
+        tempDef.clipBottom = 0;
+    }
 
-    bool existNewLetter = false;
-    int bottomHeight = _commonLineHeight - _fontAscender;
+    _fontLetterDefinitions[letter] = tempDef;
+}
 
-    float startY = _currentPageOrigY;
+bool FontAtlas::prepareLetterDefinitions(const std::u16string& utf16String)
+{
+    FontFreeType* fontTTf = dynamic_cast<FontFreeType*>(_font);
+    if(fontTTf == nullptr)
+        return false;
+
+    size_t length = utf16String.length();
+    unsigned int frame = Director::getInstance()->getTotalFrames();
 
+    // the pages holding the letters already there can't be reused while the new ones are added
+    std::vector<unsigned short> newLetters;
     for (size_t i = 0; i < length; ++i)
     {
         auto outIterator = _fontLetterDefinitions.find(utf16String[i]);
-
         if (outIterator == _fontLetterDefinitions.end())
-        {  
-            existNewLetter = true;
+        {
+            newLetters.push_back(utf16String[i]);
+        }
+        else if (outIterator->second.width > 0)
+        {
+            _atlasTextures[outIterator->second.textureID]->setLastUsedFrame(frame);
+        }
+    }
+    if (newLetters.empty())
+        return true;
+
+    std::sort(newLetters.begin(), newLetters.end());
+    newLetters.erase(std::unique(newLetters.begin(), newLetters.end()), newLetters.end());
+
+    if (fontTTf->isDistanceFieldEnabled())
+    {
+        // the distance fields are computed on several threads, or read from the disk cache
+        std::vector<FontFreeType::DistanceFieldGlyph> glyphs;
+        fontTTf->getDistanceFieldGlyphs(newLetters, glyphs);
+        for (const auto& glyph : glyphs)
+        {
+            addGlyph(glyph.charCode, glyph.rect, glyph.xAdvance, glyph.data.empty() ? nullptr : glyph.data.data(), (int)glyph.width, (int)glyph.height, frame);
+        }
+    }
+    else
+    {
+        long bitmapWidth;
+        long bitmapHeight;
+        Rect tempRect;
+        int xAdvance;
 
-            auto bitmap = fontTTf->getGlyphBitmap(utf16String[i],bitmapWidth,bitmapHeight,tempRect,tempDef.xAdvance);
+        for (auto letter : newLetters)
+        {
+            CC_TRACE_SCOPE("FontAtlas::generateGlyph", "font");
+            xAdvance = 0;
+            auto bitmap = fontTTf->getGlyphBitmap(letter,bitmapWidth,bitmapHeight,tempRect,xAdvance);
             if (bitmap)
             {
-                tempDef.validDefinition = true;
-                tempDef.letteCharUTF16   = utf16String[i];
-                tempDef.width            = tempRect.size.width + _letterPadding;
-                tempDef.height           = tempRect.size.height + _letterPadding;
-                tempDef.offsetX          = tempRect.origin.x + offsetAdjust;
-                tempDef.offsetY          = _fontAscender + tempRect.origin.y - offsetAdjust;
-                tempDef.clipBottom     = bottomHeight - (tempDef.height + tempRect.origin.y + offsetAdjust);
-
-                if (_currentPageOrigX + tempDef.width > CacheTextureWidth)
-                {
-                    _currentPageOrigY += _commonLineHeight;
-                    _currentPageOrigX = 0;
-                    if(_currentPageOrigY + _commonLineHeight >= CacheTextureHeight)
-                    {     
-                        auto data = _currentPageData + CacheTextureWidth * (int)startY;
-                        _atlasTextures[_currentPage]->updateWithData(data, 0, startY, 
-                            CacheTextureWidth, CacheTextureHeight - startY);
-
-                        startY = 0.0f;
-
-                        _currentPageOrigY = 0;
-                        memset(_currentPageData, 0, _currentPageDataSize);
-                        _currentPage++;
-                        auto tex = new Texture2D;
-                        if (_antialiasEnabled)
-                        {
-                            tex->setAntiAliasTexParameters();
-                        } 
-                        else
-                        {
-                            tex->setAliasTexParameters();
-                        }
-                        tex->initWithData(_currentPageData, _currentPageDataSize, 
-                            pixelFormat, CacheTextureWidth, CacheTextureHeight, Size(CacheTextureWidth,CacheTextureHeight) );
-                        addTexture(tex,_currentPage);
-                        tex->release();
-                    }  
-                }
-                fontTTf->renderCharAt(_currentPageData,_currentPageOrigX,_currentPageOrigY,bitmap,bitmapWidth,bitmapHeight);
-
-                tempDef.U                = _currentPageOrigX;
-                tempDef.V                = _currentPageOrigY;
-                tempDef.textureID        = _currentPage;
-                _currentPageOrigX        += tempDef.width + 1;
-                // take from pixels to points
-                tempDef.width  =    tempDef.width  / scaleFactor;
-                tempDef.height =    tempDef.height / scaleFactor;      
-                tempDef.U      =    tempDef.U      / scaleFactor;
-                tempDef.V      =    tempDef.V      / scaleFactor;
+                // render the glyph alone, only its rectangle is uploaded
+                _glyphData.assign(bitmapWidth * bitmapHeight * _bytesPerPixel, 0);
+                fontTTf->renderCharAt(_glyphData.data(),0,0,bitmap,bitmapWidth,bitmapHeight,(int)bitmapWidth);
+                addGlyph(letter, tempRect, xAdvance, _glyphData.data(), (int)bitmapWidth, (int)bitmapHeight, frame);
             }
-            else{
-                if(tempDef.xAdvance)
-                    tempDef.validDefinition = true;
-                else
-                    tempDef.validDefinition = false;
-
-                tempDef.letteCharUTF16   = utf16String[i];
-                tempDef.width            = 0;
-                tempDef.height           = 0;
-                tempDef.U                = 0;
-                tempDef.V                = 0;
-                tempDef.offsetX          = 0;
-                tempDef.offsetY          = 0;
-                tempDef.textureID        = 0;
-                tempDef.clipBottom = 0;
-                _currentPageOrigX += 1;
+            else
+            {
+                addGlyph(letter, tempRect, xAdvance, nullptr, 0, 0, frame);
             }
-
-            _fontLetterDefinitions[tempDef.letteCharUTF16] = tempDef;
-        }       
+        }
     }
 
-    if(existNewLetter)
+    if (_pagesEvicted)
     {
-        auto data = _currentPageData + CacheTextureWidth * (int)startY;
-        _atlasTextures[_currentPage]->updateWithData(data, 0, startY, 
-            CacheTextureWidth, _currentPageOrigY - startY + _commonLineHeight);
+        // the labels that used the evicted glyphs have to lay out their letters again
+        _pagesEvicted = false;
+        auto eventDispatcher = Director::getInstance()->getEventDispatcher();
+        eventDispatcher->dispatchCustomEvent(EVENT_PURGE_TEXTURES,this);
     }
     return true;
 }
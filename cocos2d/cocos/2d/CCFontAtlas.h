@@ -28,8 +28,10 @@
 #include "base/CCPlatformMacros.h"
 #include "base/CCRef.h"
 #include "CCStdC.h"
+#include "renderer/CCTexture2D.h"
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 NS_CC_BEGIN
 
@@ -61,6 +63,17 @@ public:
     static const int CacheTextureWidth;
     static const int CacheTextureHeight;
     static const char* EVENT_PURGE_TEXTURES;
+
+    /** Sets the size in pixels of the pages created by the next font atlases.
+     The default is CacheTextureWidth x CacheTextureHeight.
+     */
+    static void setDefaultPageSize(int width, int height);
+
+    /** Sets how many pages a font atlas may create before it starts to reuse the least recently
+     used one. The glyphs of a page are only evicted when it was not drawn in the current or
+     the previous frame, otherwise a new page is still added. 0 means unlimited (the default).
+     */
+    static void setDefaultMaxPageCount(int maxPageCount);
     /**
      * @js ctor
      */
@@ -84,6 +97,9 @@ public:
     Texture2D* getTexture(int slot);
     const Font* getFont() const;
 
+    /** returns the number of pages whose glyphs were evicted to make room for new glyphs */
+    unsigned int getEvictedPageCount() const { return _evictedPageCount; }
+
     /** Listen "come to background" message, and clear the texture atlas.
      It only has effect on Android.
      */
@@ -113,18 +129,39 @@ public:
 
 private:
 
+    // a segment of the skyline of a page: the top of the glyphs packed in [x, x + width)
+    struct SkylineNode
+    {
+        int x;
+        int y;
+        int width;
+    };
+
     void relaseTextures();
+    Texture2D* createPageTexture();
+    void clearPage(int page);
+    void resetSkyline(int page);
+    void resetPages();
+    bool findPosition(int page, int width, int height, int& outX, int& outY, size_t& outIndex) const;
+    void addSkylineLevel(int page, size_t index, int x, int y, int width, int height);
+    bool allocateGlyph(int width, int height, unsigned int frame, int& outPage, int& outX, int& outY);
+    void addGlyph(unsigned short letter, const Rect& rect, int xAdvance, const unsigned char* data, int width, int height, unsigned int frame);
+
     std::unordered_map<ssize_t, Texture2D*> _atlasTextures;
     std::unordered_map<unsigned short, FontLetterDefinition> _fontLetterDefinitions;
     float _commonLineHeight;
     Font * _font;
 
     // Dynamic GlyphCollection related stuff
-    int _currentPage;
-    unsigned char *_currentPageData;
-    int _currentPageDataSize;
-    float _currentPageOrigX;
-    float _currentPageOrigY;
+    std::vector<std::vector<SkylineNode>> _skylines;
+    std::vector<unsigned char> _glyphData;
+    int _pageWidth;
+    int _pageHeight;
+    int _maxPageCount;
+    int _bytesPerPixel;
+    Texture2D::PixelFormat _pixelFormat;
+    unsigned int _evictedPageCount;
+    bool _pagesEvicted;
     float _letterPadding;
     bool  _makeDistanceMap;
 
@@ -27,6 +27,7 @@
 
 #include "2d/CCFontAtlasCache.h"
 
+#include "2d/CCFontBaked.h"
 #include "2d/CCFontFNT.h"
 #include "2d/CCFontFreeType.h"
 #include "CCFontCharMap.h"
@@ -59,6 +60,17 @@ FontAtlas * FontAtlasCache::getFontAtlasTTF(const TTFConfig & config)
         fontSize = Label::DistanceFieldFontSize / contentScaleFactor;
     }
 
+    if (FontBaked::isBakedFontFile(config.fontFilePath))
+    {
+        auto atlas = getFontAtlasBaked(config.fontFilePath);
+        auto font = atlas ? dynamic_cast<const FontBaked*>(atlas->getFont()) : nullptr;
+        if (font && (font->getFontSize() != fontSize || font->isDistanceFieldEnabled() != useDistanceField || font->getOutlineSize() != config.outlineSize))
+        {
+            CCLOG("cocos2d: FontAtlasCache: %s was baked with another size, distance field or outline than the label's", config.fontFilePath.c_str());
+        }
+        return atlas;
+    }
+
     auto atlasName = generateFontName(config.fontFilePath, fontSize, GlyphCollection::DYNAMIC, useDistanceField);
     atlasName.append("_outline_");
     std::stringstream ss;
@@ -92,6 +104,11 @@ FontAtlas * FontAtlasCache::getFontAtlasTTF(const TTFConfig & config)
 
 FontAtlas * FontAtlasCache::getFontAtlasFNT(const std::string& fontFileName, const Vec2& imageOffset /* = Vec2::ZERO */)
 {
+    if (FontBaked::isBakedFontFile(fontFileName))
+    {
+        return getFontAtlasBaked(fontFileName);
+    }
+
     std::string atlasName = generateFontName(fontFileName, 0, GlyphCollection::CUSTOM,false);
     auto it = _atlasMap.find(atlasName);
 
@@ -204,6 +221,34 @@ FontAtlas * FontAtlasCache::getFontAtlasCharMap(const std::string& charMapFile,
     return nullptr;
 }
 
+FontAtlas * FontAtlasCache::getFontAtlasBaked(const std::string& bakedFileName)
+{
+    std::string atlasName = generateFontName(bakedFileName, 0, GlyphCollection::CUSTOM,false);
+    auto it = _atlasMap.find(atlasName);
+
+    if ( it == _atlasMap.end() )
+    {
+        auto font = FontBaked::create(bakedFileName);
+
+        if(font)
+        {
+            auto tempAtlas = font->createFontAtlas();
+            if (tempAtlas)
+            {
+                _atlasMap[atlasName] = tempAtlas;
+                return _atlasMap[atlasName];
+            }
+        }
+    }
+    else
+    {
+        _atlasMap[atlasName]->retain();
+        return _atlasMap[atlasName];
+    }
+
+    return nullptr;
+}
+
 std::string FontAtlasCache::generateFontName(const std::string& fontFileName, int size, GlyphCollection theGlyphs, bool useDistanceField)
 {
     std::string tempName(fontFileName);
@@ -37,6 +37,9 @@ NS_CC_BEGIN
 class CC_DLL FontAtlasCache
 {  
 public:
+    /** A ".ccfont" file baked with FontBaked can be given instead of the TTF and FNT files, it is memory mapped
+     and its glyphs aren't rendered again. Its glyphs must have been baked with the same size, distance field and outline.
+     */
     static FontAtlas * getFontAtlasTTF(const TTFConfig & config);
     static FontAtlas * getFontAtlasFNT(const std::string& fontFileName, const Vec2& imageOffset = Vec2::ZERO);
 
@@ -52,6 +55,7 @@ public:
     static void purgeCachedData();
     
 private: 
+    static FontAtlas * getFontAtlasBaked(const std::string& bakedFileName);
     static std::string generateFontName(const std::string& fontFileName, int size, GlyphCollection theGlyphs, bool useDistanceField);
     static std::unordered_map<std::string, FontAtlas *> _atlasMap;
 };
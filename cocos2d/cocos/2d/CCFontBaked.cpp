@@ -0,0 +1,637 @@
+/****************************************************************************
+ Copyright (c) 2013-2014 Chukong Technologies Inc.
+
+ http://www.cocos2d-x.org
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#include "2d/CCFontBaked.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+
+#include "2d/CCFontAtlas.h"
+#include "2d/CCFontFNT.h"
+#include "2d/CCFontFreeType.h"
+#include "2d/CCLabel.h"
+#include "base/ccUTF8.h"
+#include "base/CCDirector.h"
+#include "platform/CCFileUtils.h"
+#include "platform/CCImage.h"
+#include "renderer/CCTextureCache.h"
+
+NS_CC_BEGIN
+
+const char* FontBaked::FILE_EXTENSION = ".ccfont";
+
+namespace
+{
+    const char FILE_MAGIC[4] = { 'C', 'C', 'F', 'B' };
+    // 2: the source type is stored instead of being told by the font size
+    const uint32_t FILE_VERSION = 2;
+    const uint32_t FLAG_DISTANCE_FIELD = 1;
+    // the texels of the pages start on 16 bytes boundaries
+    const uint32_t PAGE_ALIGNMENT = 16;
+
+    uint32_t alignOffset(uint32_t offset, uint32_t alignment)
+    {
+        return (offset + alignment - 1) & ~(alignment - 1);
+    }
+
+    uint32_t kerningKey(unsigned short first, unsigned short second)
+    {
+        return ((uint32_t)first << 16) | second;
+    }
+}
+
+// followed by the glyphs, the kerning pairs sorted by key, the pages and their texels
+struct FontBaked::FileHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t sourceType;
+    int32_t fontSize;
+    int32_t outlineSize;
+    uint32_t flags;
+    float commonLineHeight;
+    uint32_t glyphCount;
+    uint32_t glyphsOffset;
+    uint32_t kerningCount;
+    uint32_t kerningsOffset;
+    uint32_t pageCount;
+    uint32_t pagesOffset;
+};
+
+// in pixels
+struct FontBaked::FileGlyph
+{
+    uint16_t charCode;
+    uint16_t page;
+    int32_t xAdvance;
+    int32_t clipBottom;
+    uint32_t valid;
+    float U;
+    float V;
+    float width;
+    float height;
+    float offsetX;
+    float offsetY;
+};
+
+struct FontBaked::FileKerning
+{
+    uint32_t key;
+    int32_t amount;
+};
+
+struct FontBaked::FilePage
+{
+    int32_t pixelFormat;
+    int32_t width;
+    int32_t height;
+    uint32_t premultipliedAlpha;
+    uint32_t dataOffset;
+    uint32_t dataSize;
+};
+
+FontBaked* FontBaked::create(const std::string& bakedFilePath)
+{
+    FontBaked* ret = new FontBaked();
+    if (ret->initWithFile(bakedFilePath))
+    {
+        ret->autorelease();
+        return ret;
+    }
+    delete ret;
+    return nullptr;
+}
+
+bool FontBaked::isBakedFontFile(const std::string& filePath)
+{
+    size_t extensionLength = strlen(FILE_EXTENSION);
+    return filePath.length() > extensionLength
+        && filePath.compare(filePath.length() - extensionLength, extensionLength, FILE_EXTENSION) == 0;
+}
+
+FontBaked::FontBaked()
+: _header(nullptr)
+, _kernings(nullptr)
+{
+}
+
+FontBaked::~FontBaked()
+{
+}
+
+bool FontBaked::initWithFile(const std::string& bakedFilePath)
+{
+    _file = std::make_shared<Data>(FileUtils::getInstance()->getMappedDataFromFile(bakedFilePath));
+    auto bytes = _file->getBytes();
+    auto size = (size_t)_file->getSize();
+
+    auto header = reinterpret_cast<const FileHeader*>(bytes);
+    if (size < sizeof(FileHeader)
+        || memcmp(header->magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0
+        || header->version != FILE_VERSION
+        || (header->sourceType != (uint32_t)SourceType::TTF && header->sourceType != (uint32_t)SourceType::FNT))
+    {
+        CCLOG("cocos2d: FontBaked: %s isn't a baked font file, or was baked by another version", bakedFilePath.c_str());
+        return false;
+    }
+
+    // the sections must lie inside the file, a truncated file is rejected instead of read past its end
+    if (header->glyphsOffset + (size_t)header->glyphCount * sizeof(FileGlyph) > size
+        || header->kerningsOffset + (size_t)header->kerningCount * sizeof(FileKerning) > size
+        || header->pagesOffset + (size_t)header->pageCount * sizeof(FilePage) > size)
+    {
+        CCLOG("cocos2d: FontBaked: %s is truncated", bakedFilePath.c_str());
+        return false;
+    }
+    auto pages = reinterpret_cast<const FilePage*>(bytes + header->pagesOffset);
+    for (uint32_t i = 0; i < header->pageCount; ++i)
+    {
+        if (pages[i].dataOffset + (size_t)pages[i].dataSize > size)
+        {
+            CCLOG("cocos2d: FontBaked: %s is truncated", bakedFilePath.c_str());
+            return false;
+        }
+    }
+
+    _header = header;
+    _kernings = reinterpret_cast<const FileKerning*>(bytes + header->kerningsOffset);
+    return true;
+}
+
+FontBaked::SourceType FontBaked::getSourceType() const
+{
+    return static_cast<SourceType>(_header->sourceType);
+}
+
+int FontBaked::getFontSize() const
+{
+    return _header->fontSize;
+}
+
+bool FontBaked::isDistanceFieldEnabled() const
+{
+    return (_header->flags & FLAG_DISTANCE_FIELD) != 0;
+}
+
+int FontBaked::getOutlineSize() const
+{
+    return _header->outlineSize;
+}
+
+int FontBaked::getFontMaxHeight() const
+{
+    return (int)_header->commonLineHeight;
+}
+
+int* FontBaked::getHorizontalKerningForTextUTF16(const std::u16string& text, int &outNumLetters) const
+{
+    outNumLetters = static_cast<int>(text.length());
+
+    if (!outNumLetters)
+        return nullptr;
+
+    // the kerning of a pair is given where the font it was baked from gives it: before the second letter
+    // for a TTF font, after the first one for a BMFont
+    int *sizes = new int[outNumLetters];
+    memset(sizes, 0, outNumLetters * sizeof(int));
+    for (int c = 1; c < outNumLetters; ++c)
+    {
+        int kerning = getHorizontalKerningForChars(text[c-1], text[c]);
+        if (getSourceType() == SourceType::TTF)
+            sizes[c] = kerning;
+        else
+            sizes[c-1] = kerning;
+    }
+
+    return sizes;
+}
+
+int FontBaked::getHorizontalKerningForChars(unsigned short firstChar, unsigned short secondChar) const
+{
+    auto end = _kernings + _header->kerningCount;
+    uint32_t key = kerningKey(firstChar, secondChar);
+    auto it = std::lower_bound(_kernings, end, key, [](const FileKerning& kerning, uint32_t k) {
+        return kerning.key < k;
+    });
+    return (it != end && it->key == key) ? it->amount : 0;
+}
+
+FontAtlas* FontBaked::createFontAtlas()
+{
+    auto bytes = _file->getBytes();
+    auto tempAtlas = new FontAtlas(*this);
+    tempAtlas->setCommonLineHeight(_header->commonLineHeight);
+
+    // the texels are uploaded from the mapping, without being copied
+    auto pages = reinterpret_cast<const FilePage*>(bytes + _header->pagesOffset);
+    for (uint32_t i = 0; i < _header->pageCount; ++i)
+    {
+        const FilePage& page = pages[i];
+        auto pixelFormat = static_cast<Texture2D::PixelFormat>(page.pixelFormat);
+        Size size(page.width, page.height);
+
+        auto texture = new Texture2D();
+        if (!texture->initWithData(bytes + page.dataOffset, page.dataSize, pixelFormat, page.width, page.height, size, page.premultipliedAlpha != 0))
+        {
+            CCLOG("cocos2d: FontBaked: can't create the texture of page %u", i);
+            texture->release();
+            tempAtlas->release();
+            return nullptr;
+        }
+#if CC_ENABLE_CACHE_TEXTURE_DATA
+        // uploaded again from the mapping when the context is lost, the texture keeps it mapped
+        std::shared_ptr<Data> file = _file;
+        Data texels;
+        texels.fastSet(bytes + page.dataOffset, page.dataSize, [file](unsigned char*, ssize_t) {});
+        VolatileTextureMgr::addDataTexture(texture, std::move(texels), pixelFormat, size);
+#endif
+        tempAtlas->addTexture(texture, i);
+        texture->release();
+    }
+
+    // take from pixels to points
+    auto scaleFactor = CC_CONTENT_SCALE_FACTOR();
+    auto glyphs = reinterpret_cast<const FileGlyph*>(bytes + _header->glyphsOffset);
+    for (uint32_t i = 0; i < _header->glyphCount; ++i)
+    {
+        const FileGlyph& glyph = glyphs[i];
+
+        FontLetterDefinition tempDefinition;
+        tempDefinition.letteCharUTF16 = glyph.charCode;
+        tempDefinition.U = glyph.U / scaleFactor;
+        tempDefinition.V = glyph.V / scaleFactor;
+        tempDefinition.width = glyph.width / scaleFactor;
+        tempDefinition.height = glyph.height / scaleFactor;
+        tempDefinition.offsetX = glyph.offsetX;
+        tempDefinition.offsetY = glyph.offsetY;
+        tempDefinition.textureID = glyph.page;
+        tempDefinition.validDefinition = glyph.valid != 0;
+        tempDefinition.xAdvance = glyph.xAdvance;
+        tempDefinition.clipBottom = glyph.clipBottom;
+        tempAtlas->addLetterDefinition(tempDefinition);
+    }
+
+    return tempAtlas;
+}
+
+bool FontBaked::writeFile(const std::string& outputFile, SourceType sourceType, int fontSize, bool distanceFieldEnabled, int outlineSize, float commonLineHeight,
+                          const std::vector<Glyph>& glyphs, std::vector<KerningPair> kernings, const std::vector<Page>& pages)
+{
+    std::sort(kernings.begin(), kernings.end(), [](const KerningPair& a, const KerningPair& b) {
+        return kerningKey(a.first, a.second) < kerningKey(b.first, b.second);
+    });
+
+    FileHeader header;
+    memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+    header.version = FILE_VERSION;
+    header.sourceType = (uint32_t)sourceType;
+    header.fontSize = fontSize;
+    header.outlineSize = outlineSize;
+    header.flags = distanceFieldEnabled ? FLAG_DISTANCE_FIELD : 0;
+    header.commonLineHeight = commonLineHeight;
+    header.glyphCount = (uint32_t)glyphs.size();
+    header.glyphsOffset = sizeof(FileHeader);
+    header.kerningCount = (uint32_t)kernings.size();
+    header.kerningsOffset = header.glyphsOffset + header.glyphCount * sizeof(FileGlyph);
+    header.pageCount = (uint32_t)pages.size();
+    header.pagesOffset = header.kerningsOffset + header.kerningCount * sizeof(FileKerning);
+
+    std::vector<unsigned char> buffer(header.pagesOffset + header.pageCount * sizeof(FilePage));
+    memcpy(buffer.data(), &header, sizeof(header));
+
+    auto fileGlyphs = reinterpret_cast<FileGlyph*>(buffer.data() + header.glyphsOffset);
+    for (const auto& glyph : glyphs)
+    {
+        fileGlyphs->charCode = glyph.charCode;
+        fileGlyphs->page = glyph.page;
+        fileGlyphs->xAdvance = glyph.xAdvance;
+        fileGlyphs->clipBottom = glyph.clipBottom;
+        fileGlyphs->valid = glyph.valid ? 1 : 0;
+        fileGlyphs->U = glyph.U;
+        fileGlyphs->V = glyph.V;
+        fileGlyphs->width = glyph.width;
+        fileGlyphs->height = glyph.height;
+        fileGlyphs->offsetX = glyph.offsetX;
+        fileGlyphs->offsetY = glyph.offsetY;
+        ++fileGlyphs;
+    }
+
+    auto fileKernings = reinterpret_cast<FileKerning*>(buffer.data() + header.kerningsOffset);
+    for (const auto& kerning : kernings)
+    {
+        fileKernings->key = kerningKey(kerning.first, kerning.second);
+        fileKernings->amount = kerning.amount;
+        ++fileKernings;
+    }
+
+    auto filePages = reinterpret_cast<FilePage*>(buffer.data() + header.pagesOffset);
+    uint32_t dataOffset = (uint32_t)buffer.size();
+    for (const auto& page : pages)
+    {
+        dataOffset = alignOffset(dataOffset, PAGE_ALIGNMENT);
+        filePages->pixelFormat = static_cast<int32_t>(page.pixelFormat);
+        filePages->width = page.width;
+        filePages->height = page.height;
+        filePages->premultipliedAlpha = page.premultipliedAlpha ? 1 : 0;
+        filePages->dataOffset = dataOffset;
+        filePages->dataSize = (uint32_t)page.data.size();
+        dataOffset += filePages->dataSize;
+        ++filePages;
+    }
+
+    FILE* file = fopen(outputFile.c_str(), "wb");
+    if (file == nullptr)
+    {
+        CCLOG("cocos2d: FontBaked: can't write %s", outputFile.c_str());
+        return false;
+    }
+
+    bool ok = fwrite(buffer.data(), buffer.size(), 1, file) == 1;
+    long offset = (long)buffer.size();
+    static const unsigned char padding[PAGE_ALIGNMENT] = { 0 };
+    for (const auto& page : pages)
+    {
+        long aligned = alignOffset((uint32_t)offset, PAGE_ALIGNMENT);
+        ok = ok && (aligned == offset || fwrite(padding, aligned - offset, 1, file) == 1);
+        ok = ok && (page.data.empty() || fwrite(page.data.data(), page.data.size(), 1, file) == 1);
+        offset = aligned + (long)page.data.size();
+    }
+    ok = (fclose(file) == 0) && ok;
+
+    if (!ok)
+    {
+        CCLOG("cocos2d: FontBaked: can't write %s", outputFile.c_str());
+        remove(outputFile.c_str());
+    }
+    return ok;
+}
+
+bool FontBaked::bakeTTF(const std::string& fontFilePath, int fontSize, GlyphCollection glyphs, const char* customGlyphs,
+                        bool distanceFieldEnabled, int outlineSize, const std::string& outputFile, int pageSize /* = 1024 */)
+{
+    // the same font as FontAtlasCache::getFontAtlasTTF()
+    if (outlineSize > 0)
+    {
+        distanceFieldEnabled = false;
+    }
+    if (distanceFieldEnabled)
+    {
+        fontSize = Label::DistanceFieldFontSize / CC_CONTENT_SCALE_FACTOR();
+    }
+
+    auto font = FontFreeType::create(fontFilePath, fontSize, glyphs, customGlyphs, distanceFieldEnabled, outlineSize);
+    if (font == nullptr)
+    {
+        CCLOG("cocos2d: FontBaked: can't load the font %s", fontFilePath.c_str());
+        return false;
+    }
+
+    std::u16string utf16;
+    const char* collection = font->getCurrentGlyphCollection();
+    if (collection == nullptr || !StringUtils::UTF8ToUTF16(collection, utf16) || utf16.empty())
+    {
+        CCLOG("cocos2d: FontBaked: no glyph to bake, GlyphCollection::DYNAMIC can't be baked");
+        font->release();
+        return false;
+    }
+    std::vector<unsigned short> chars(utf16.begin(), utf16.end());
+    std::sort(chars.begin(), chars.end());
+    chars.erase(std::unique(chars.begin(), chars.end()), chars.end());
+
+    // the glyphs, laid out as FontAtlas::addGlyph() does
+    struct GlyphBitmap
+    {
+        size_t glyph;
+        int width;
+        int height;
+        int rectWidth;
+        int rectHeight;
+        std::vector<unsigned char> data;
+    };
+    std::vector<Glyph> bakedGlyphs;
+    std::vector<GlyphBitmap> bitmaps;
+    int bytesPerPixel = outlineSize > 0 ? 2 : 1;
+    float letterPadding = distanceFieldEnabled ? 2 * FontFreeType::DistanceMapSpread : 0;
+    float commonLineHeight = font->getFontMaxHeight();
+    int fontAscender = font->getFontAscender();
+
+    auto addGlyph = [&](unsigned short letter, const Rect& rect, int xAdvance, std::vector<unsigned char>* data, int width, int height) {
+        Glyph glyph;
+        memset(&glyph, 0, sizeof(glyph));
+        glyph.charCode = letter;
+        glyph.xAdvance = xAdvance;
+        glyph.valid = xAdvance != 0;
+        if (data)
+        {
+            float offsetAdjust = letterPadding / 2;
+            int bottomHeight = commonLineHeight - fontAscender;
+
+            glyph.valid = true;
+            glyph.width = rect.size.width + letterPadding;
+            glyph.height = rect.size.height + letterPadding;
+            glyph.offsetX = rect.origin.x + offsetAdjust;
+            glyph.offsetY = fontAscender + rect.origin.y - offsetAdjust;
+            glyph.clipBottom = bottomHeight - (glyph.height + rect.origin.y + offsetAdjust);
+
+            GlyphBitmap bitmap;
+            bitmap.glyph = bakedGlyphs.size();
+            bitmap.width = width;
+            bitmap.height = height;
+            // one pixel apart, so that the bilinear filtering doesn't bleed between the glyphs
+            bitmap.rectWidth = MAX(width, (int)ceilf(glyph.width)) + 1;
+            bitmap.rectHeight = MAX(height, (int)ceilf(glyph.height)) + 1;
+            bitmap.data.swap(*data);
+            bitmaps.push_back(std::move(bitmap));
+        }
+        bakedGlyphs.push_back(glyph);
+    };
+
+    if (distanceFieldEnabled)
+    {
+        std::vector<FontFreeType::DistanceFieldGlyph> distanceFieldGlyphs;
+        font->getDistanceFieldGlyphs(chars, distanceFieldGlyphs);
+        for (auto& glyph : distanceFieldGlyphs)
+        {
+            addGlyph(glyph.charCode, glyph.rect, glyph.xAdvance, glyph.data.empty() ? nullptr : &glyph.data, (int)glyph.width, (int)glyph.height);
+        }
+    }
+    else
+    {
+        long bitmapWidth;
+        long bitmapHeight;
+        Rect tempRect;
+        int xAdvance;
+        std::vector<unsigned char> data;
+
+        for (auto letter : chars)
+        {
+            xAdvance = 0;
+            auto bitmap = font->getGlyphBitmap(letter, bitmapWidth, bitmapHeight, tempRect, xAdvance);
+            if (bitmap)
+            {
+                data.assign(bitmapWidth * bitmapHeight * bytesPerPixel, 0);
+                font->renderCharAt(data.data(), 0, 0, bitmap, bitmapWidth, bitmapHeight, (int)bitmapWidth);
+                addGlyph(letter, tempRect, xAdvance, &data, (int)bitmapWidth, (int)bitmapHeight);
+            }
+            else
+            {
+                addGlyph(letter, tempRect, xAdvance, nullptr, 0, 0);
+            }
+        }
+    }
+
+    // the pages are filled offline, the tallest glyphs first on shelves
+    std::sort(bitmaps.begin(), bitmaps.end(), [](const GlyphBitmap& a, const GlyphBitmap& b) {
+        return a.rectHeight > b.rectHeight;
+    });
+    std::vector<Page> pages;
+    int x = pageSize;
+    int y = 0;
+    int shelfHeight = 0;
+    for (const auto& bitmap : bitmaps)
+    {
+        Glyph& glyph = bakedGlyphs[bitmap.glyph];
+        if (bitmap.rectWidth > pageSize || bitmap.rectHeight > pageSize)
+        {
+            CCLOG("cocos2d: FontBaked: the glyph %d doesn't fit in a %dx%d page", (int)glyph.charCode, pageSize, pageSize);
+            glyph.valid = false;
+            glyph.width = 0;
+            glyph.height = 0;
+            continue;
+        }
+        if (x + bitmap.rectWidth > pageSize)
+        {
+            x = 0;
+            y += shelfHeight;
+            shelfHeight = bitmap.rectHeight;
+        }
+        if (pages.empty() || y + bitmap.rectHeight > pageSize)
+        {
+            Page page;
+            page.pixelFormat = outlineSize > 0 ? Texture2D::PixelFormat::AI88 : Texture2D::PixelFormat::A8;
+            page.width = pageSize;
+            page.height = pageSize;
+            page.premultipliedAlpha = false;
+            page.data.assign(pageSize * pageSize * bytesPerPixel, 0);
+            pages.push_back(std::move(page));
+            x = 0;
+            y = 0;
+            shelfHeight = bitmap.rectHeight;
+        }
+
+        Page& page = pages.back();
+        for (int row = 0; row < bitmap.height; ++row)
+        {
+            memcpy(page.data.data() + ((y + row) * pageSize + x) * bytesPerPixel,
+                   bitmap.data.data() + row * bitmap.width * bytesPerPixel,
+                   bitmap.width * bytesPerPixel);
+        }
+        glyph.U = x;
+        glyph.V = y;
+        glyph.page = (unsigned short)(pages.size() - 1);
+        x += bitmap.rectWidth;
+    }
+    if (pages.empty())
+    {
+        // the atlas of a font without any bitmap still has a texture
+        Page page;
+        page.pixelFormat = outlineSize > 0 ? Texture2D::PixelFormat::AI88 : Texture2D::PixelFormat::A8;
+        page.width = 8;
+        page.height = 8;
+        page.premultipliedAlpha = false;
+        page.data.assign(8 * 8 * bytesPerPixel, 0);
+        pages.push_back(std::move(page));
+    }
+
+    // the kerning of every pair of glyphs: FreeType gives the kerning of (first, second) on the odd letters
+    // of "first second0 first second1 ..."
+    std::vector<KerningPair> kernings;
+    std::u16string pairs(chars.size() * 2, 0);
+    for (auto first : chars)
+    {
+        for (size_t i = 0; i < chars.size(); ++i)
+        {
+            pairs[i * 2] = first;
+            pairs[i * 2 + 1] = chars[i];
+        }
+        int letterCount = 0;
+        int* pairKernings = font->getHorizontalKerningForTextUTF16(pairs, letterCount);
+        if (pairKernings == nullptr)
+            break;
+        for (size_t i = 0; i < chars.size(); ++i)
+        {
+            if (pairKernings[i * 2 + 1] != 0)
+            {
+                KerningPair kerning;
+                kerning.first = first;
+                kerning.second = chars[i];
+                kerning.amount = pairKernings[i * 2 + 1];
+                kernings.push_back(kerning);
+            }
+        }
+        delete [] pairKernings;
+    }
+
+    bool ok = writeFile(outputFile, SourceType::TTF, fontSize, distanceFieldEnabled, outlineSize, commonLineHeight, bakedGlyphs, kernings, pages);
+    font->release();
+    return ok;
+}
+
+bool FontBaked::bakeFNT(const std::string& fntFilePath, const std::string& outputFile)
+{
+    std::vector<Glyph> glyphs;
+    std::vector<KerningPair> kernings;
+    float commonLineHeight = 0;
+    std::string atlasName;
+    if (!FontFNT::getGlyphsToBake(fntFilePath, glyphs, kernings, commonLineHeight, atlasName))
+    {
+        CCLOG("cocos2d: FontBaked: can't load the BMFont %s", fntFilePath.c_str());
+        return false;
+    }
+
+    Image image;
+    if (!image.initWithImageFile(atlasName))
+    {
+        CCLOG("cocos2d: FontBaked: can't decode %s", atlasName.c_str());
+        return false;
+    }
+    if (image.isCompressed())
+    {
+        CCLOG("cocos2d: FontBaked: the compressed image %s can't be baked", atlasName.c_str());
+        return false;
+    }
+
+    std::vector<Page> pages(1);
+    Page& page = pages.back();
+    page.pixelFormat = image.getRenderFormat();
+    page.width = image.getWidth();
+    page.height = image.getHeight();
+    page.premultipliedAlpha = image.hasPremultipliedAlpha();
+    page.data.assign(image.getData(), image.getData() + image.getDataLen());
+
+    return writeFile(outputFile, SourceType::FNT, 0, false, 0, commonLineHeight, glyphs, kernings, pages);
+}
+
+NS_CC_END
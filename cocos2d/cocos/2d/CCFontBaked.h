@@ -0,0 +1,153 @@
+/****************************************************************************
+ Copyright (c) 2013-2014 Chukong Technologies Inc.
+
+ http://www.cocos2d-x.org
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#ifndef _CCFontBaked_h_
+#define _CCFontBaked_h_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "2d/CCFont.h"
+#include "base/CCData.h"
+#include "renderer/CCTexture2D.h"
+
+NS_CC_BEGIN
+
+/** @brief A font atlas baked offline into a ".ccfont" file: the glyph metrics, the kerning pairs and the
+ pages of the atlas, the texels stored as they are uploaded.
+
+ The file is memory mapped, the pages are uploaded from the mapping and the kerning pairs are looked up in it,
+ so loading it doesn't render nor decode anything. FontAtlasCache::getFontAtlasTTF() and getFontAtlasFNT()
+ load a ".ccfont" file given instead of the TTF or FNT file it was baked from.
+ The glyphs which weren't baked aren't rendered, like the glyphs missing from a BMFont.
+
+ The files are written by bakeTTF() and bakeFNT(), e.g. with the "fontbake" command of the Console,
+ in the byte order of the machine baking them: the little endian platforms read them as they are.
+ @since v3.2
+ */
+class CC_DLL FontBaked : public Font
+{
+public:
+    /** The extension of the baked font files */
+    static const char* FILE_EXTENSION;
+
+    /** The kind of font a file was baked from, which tells how its kerning is applied */
+    enum class SourceType
+    {
+        TTF = 0,
+        FNT = 1,
+    };
+
+    /** A glyph of the atlas, in pixels */
+    struct Glyph
+    {
+        unsigned short charCode;
+        unsigned short page;
+        float U;
+        float V;
+        float width;
+        float height;
+        float offsetX;
+        float offsetY;
+        int xAdvance;
+        int clipBottom;
+        bool valid;
+    };
+
+    struct KerningPair
+    {
+        unsigned short first;
+        unsigned short second;
+        int amount;
+    };
+
+    struct Page
+    {
+        Texture2D::PixelFormat pixelFormat;
+        int width;
+        int height;
+        bool premultipliedAlpha;
+        std::vector<unsigned char> data;
+    };
+
+    /** Loads a baked font file, returns nullptr if it isn't valid */
+    static FontBaked* create(const std::string& bakedFilePath);
+
+    /** Returns true if the file name has the baked font extension */
+    static bool isBakedFontFile(const std::string& filePath);
+
+    /** Renders the glyphs of a TTF font, as FontAtlasCache::getFontAtlasTTF() would, and writes them to outputFile.
+     The glyphs of GlyphCollection::DYNAMIC can't be listed: use GlyphCollection::CUSTOM to pass the ones to bake.
+     The glyphs are packed in pages of pageSize x pageSize pixels.
+     */
+    static bool bakeTTF(const std::string& fontFilePath, int fontSize, GlyphCollection glyphs, const char* customGlyphs,
+                        bool distanceFieldEnabled, int outlineSize, const std::string& outputFile, int pageSize = 1024);
+
+    /** Decodes the atlas image of a BMFont and writes it with its glyphs and kerning pairs to outputFile */
+    static bool bakeFNT(const std::string& fntFilePath, const std::string& outputFile);
+
+    /** Writes the glyphs, kerning pairs and pages of an atlas to outputFile */
+    static bool writeFile(const std::string& outputFile, SourceType sourceType, int fontSize, bool distanceFieldEnabled, int outlineSize, float commonLineHeight,
+                          const std::vector<Glyph>& glyphs, std::vector<KerningPair> kernings, const std::vector<Page>& pages);
+
+    virtual int* getHorizontalKerningForTextUTF16(const std::u16string& text, int &outNumLetters) const override;
+    virtual FontAtlas *createFontAtlas() override;
+    virtual int getFontMaxHeight() const override;
+
+    SourceType getSourceType() const;
+    /** The size the glyphs were rendered at, 0 for a BMFont */
+    int getFontSize() const;
+    bool isDistanceFieldEnabled() const;
+    int getOutlineSize() const;
+
+protected:
+    FontBaked();
+    /**
+     * @js NA
+     * @lua NA
+     */
+    virtual ~FontBaked();
+
+    bool initWithFile(const std::string& bakedFilePath);
+
+private:
+    // the layout of the file
+    struct FileHeader;
+    struct FileGlyph;
+    struct FileKerning;
+    struct FilePage;
+
+    int getHorizontalKerningForChars(unsigned short firstChar, unsigned short secondChar) const;
+
+    // the mapped file, the header and the kerning pairs point into it. Shared with the data of the pages
+    // registered to be uploaded again when the context is lost, which can outlive the font
+    std::shared_ptr<Data> _file;
+    const FileHeader* _header;
+    const FileKerning* _kernings;
+};
+
+NS_CC_END
+
+#endif /* defined(_CCFontBaked_h_) */
@@ -0,0 +1,210 @@
+/****************************************************************************
+ Copyright (c) 2013-2014 Chukong Technologies Inc.
+
+ http://www.cocos2d-x.org
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+#include "2d/CCFontDistanceFieldCache.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_WIN32) || (CC_TARGET_PLATFORM == CC_PLATFORM_WINRT) || (CC_TARGET_PLATFORM == CC_PLATFORM_WP8)
+#include <direct.h>
+#endif
+
+#include "xxhash.h"
+
+NS_CC_BEGIN
+
+namespace
+{
+    const char CACHE_MAGIC[4] = { 'C', 'C', 'D', 'F' };
+    // bump it when the distance fields are computed differently
+    const uint32_t CACHE_VERSION = 2;
+
+    struct CacheHeader
+    {
+        char magic[4];
+        uint32_t version;
+        int32_t fontScale;
+        int32_t spread;
+    };
+
+    // followed by the width * height bytes of the distance field
+    struct GlyphRecord
+    {
+        uint16_t charCode;
+        uint16_t width;
+        uint16_t height;
+        int16_t xAdvance;
+        int16_t originX;
+        int16_t originY;
+        uint16_t rectWidth;
+        uint16_t rectHeight;
+    };
+}
+
+FontDistanceFieldCache::FontDistanceFieldCache(const std::string& directory, const Data& fontData, long fontScale, int spread)
+: _file(nullptr)
+, _end(0)
+{
+    std::string dir = directory;
+    if (!dir.empty() && dir.back() != '/')
+    {
+        dir += '/';
+    }
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_WIN32) || (CC_TARGET_PLATFORM == CC_PLATFORM_WINRT) || (CC_TARGET_PLATFORM == CC_PLATFORM_WP8)
+    int ret = _mkdir(dir.c_str());
+#else
+    int ret = mkdir(dir.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
+#endif
+    if (ret != 0 && errno != EEXIST)
+    {
+        CCLOG("cocos2d: FontDistanceFieldCache: can't create the directory %s", dir.c_str());
+        return;
+    }
+
+    char name[48];
+    snprintf(name, sizeof(name), "%08x-%ld-%d.sdf", XXH32(fontData.getBytes(), (int)fontData.getSize(), 0), fontScale, spread);
+    _path = dir + name;
+
+    CacheHeader expected;
+    memcpy(expected.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    expected.version = CACHE_VERSION;
+    expected.fontScale = (int32_t)fontScale;
+    expected.spread = spread;
+
+    _file = fopen(_path.c_str(), "r+b");
+    if (_file)
+    {
+        CacheHeader header;
+        if (fread(&header, sizeof(header), 1, _file) == 1 && memcmp(&header, &expected, sizeof(header)) == 0)
+        {
+            // index the glyphs, a record cut short by a crash is overwritten by the next one
+            fseek(_file, 0, SEEK_END);
+            long size = ftell(_file);
+            _end = sizeof(header);
+            GlyphRecord record;
+            while (_end + (long)sizeof(record) <= size
+                   && fseek(_file, _end, SEEK_SET) == 0
+                   && fread(&record, sizeof(record), 1, _file) == 1)
+            {
+                long recordLen = sizeof(record) + (long)record.width * record.height;
+                if (_end + recordLen > size)
+                    break;
+                _offsets[record.charCode] = _end;
+                _end += recordLen;
+            }
+            return;
+        }
+        fclose(_file);
+        _file = nullptr;
+    }
+
+    _file = fopen(_path.c_str(), "w+b");
+    if (_file == nullptr || fwrite(&expected, sizeof(expected), 1, _file) != 1)
+    {
+        CCLOG("cocos2d: FontDistanceFieldCache: can't write %s", _path.c_str());
+        if (_file)
+        {
+            fclose(_file);
+            _file = nullptr;
+        }
+        return;
+    }
+    _end = sizeof(expected);
+}
+
+FontDistanceFieldCache::~FontDistanceFieldCache()
+{
+    if (_file)
+    {
+        fclose(_file);
+    }
+}
+
+bool FontDistanceFieldCache::getGlyph(unsigned short charCode, FontFreeType::DistanceFieldGlyph& outGlyph)
+{
+    auto it = _offsets.find(charCode);
+    if (_file == nullptr || it == _offsets.end())
+        return false;
+
+    GlyphRecord record;
+    if (fseek(_file, it->second, SEEK_SET) != 0 || fread(&record, sizeof(record), 1, _file) != 1 || record.charCode != charCode)
+    {
+        _offsets.erase(it);
+        return false;
+    }
+
+    outGlyph.charCode = charCode;
+    outGlyph.xAdvance = record.xAdvance;
+    outGlyph.rect.setRect(record.originX, record.originY, record.rectWidth, record.rectHeight);
+    outGlyph.width = record.width;
+    outGlyph.height = record.height;
+    outGlyph.data.resize(record.width * record.height);
+    if (! outGlyph.data.empty() && fread(outGlyph.data.data(), outGlyph.data.size(), 1, _file) != 1)
+    {
+        _offsets.erase(it);
+        return false;
+    }
+    return true;
+}
+
+void FontDistanceFieldCache::addGlyph(const FontFreeType::DistanceFieldGlyph& glyph)
+{
+    if (_file == nullptr)
+        return;
+
+    GlyphRecord record;
+    record.charCode = glyph.charCode;
+    record.width = (uint16_t)glyph.width;
+    record.height = (uint16_t)glyph.height;
+    record.xAdvance = (int16_t)glyph.xAdvance;
+    record.originX = (int16_t)glyph.rect.origin.x;
+    record.originY = (int16_t)glyph.rect.origin.y;
+    record.rectWidth = (uint16_t)glyph.rect.size.width;
+    record.rectHeight = (uint16_t)glyph.rect.size.height;
+
+    if (fseek(_file, _end, SEEK_SET) != 0
+        || fwrite(&record, sizeof(record), 1, _file) != 1
+        || (! glyph.data.empty() && fwrite(glyph.data.data(), glyph.data.size(), 1, _file) != 1))
+    {
+        CCLOG("cocos2d: FontDistanceFieldCache: can't write %s", _path.c_str());
+        fclose(_file);
+        _file = nullptr;
+        return;
+    }
+    _offsets[glyph.charCode] = _end;
+    _end += sizeof(record) + glyph.data.size();
+}
+
+void FontDistanceFieldCache::flush()
+{
+    if (_file)
+    {
+        fflush(_file);
+    }
+}
+
+NS_CC_END
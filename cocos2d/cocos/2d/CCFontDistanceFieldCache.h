@@ -0,0 +1,67 @@
+/****************************************************************************
+ Copyright (c) 2013-2014 Chukong Technologies Inc.
+
+ http://www.cocos2d-x.org
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+#ifndef _CCFontDistanceFieldCache_h_
+#define _CCFontDistanceFieldCache_h_
+
+#include <stdio.h>
+#include <string>
+#include <unordered_map>
+
+#include "2d/CCFontFreeType.h"
+
+NS_CC_BEGIN
+
+/** @brief On-disk cache of the distance fields of the glyphs of a font, at a size.
+
+ The cache file is keyed by a hash of the font data, the scale of the font and the distance map spread.
+ The glyphs are appended to it as they are rendered, the next launch reads them instead of rendering them again.
+ It is used by FontFreeType on the thread of its font atlas.
+ @since v3.2
+ */
+class CC_DLL FontDistanceFieldCache
+{
+public:
+    /** Opens, or creates, the cache file of the font in directory */
+    FontDistanceFieldCache(const std::string& directory, const Data& fontData, long fontScale, int spread);
+    ~FontDistanceFieldCache();
+
+    /** Reads the glyph of charCode, returns false if it isn't cached */
+    bool getGlyph(unsigned short charCode, FontFreeType::DistanceFieldGlyph& outGlyph);
+
+    /** Appends a glyph, call flush() once the glyphs are added */
+    void addGlyph(const FontFreeType::DistanceFieldGlyph& glyph);
+
+    void flush();
+
+private:
+    std::string _path;
+    FILE* _file;
+    // the offset of the glyph records in the file
+    std::unordered_map<unsigned short, long> _offsets;
+    long _end;
+};
+
+NS_CC_END
+
+#endif /* defined(_CCFontDistanceFieldCache_h_) */
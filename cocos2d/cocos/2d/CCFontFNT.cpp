@@ -751,6 +751,49 @@ int  FontFNT::getHorizontalKerningForChars(unsigned short firstChar, unsigned sh
     return ret;
 }
 
+bool FontFNT::getGlyphsToBake(const std::string& fntFilePath, std::vector<FontBaked::Glyph>& glyphs,
+                              std::vector<FontBaked::KerningPair>& kernings, float& commonLineHeight, std::string& atlasName)
+{
+    BMFontConfiguration *configuration = FNTConfigLoadFile(fntFilePath);
+    if (!configuration || !configuration->_fontDefDictionary || configuration->_commonHeight == 0)
+        return false;
+
+    commonLineHeight = configuration->_commonHeight;
+    atlasName = configuration->getAtlasName();
+
+    tFontDefHashElement *currentElement, *tmp;
+    HASH_ITER(hh, configuration->_fontDefDictionary, currentElement, tmp)
+    {
+        const BMFontDef& fontDef = currentElement->fontDef;
+
+        FontBaked::Glyph glyph;
+        glyph.charCode = fontDef.charID;
+        glyph.page = 0;
+        glyph.U = fontDef.rect.origin.x;
+        glyph.V = fontDef.rect.origin.y;
+        glyph.width = fontDef.rect.size.width;
+        glyph.height = fontDef.rect.size.height;
+        glyph.offsetX = fontDef.xOffset;
+        glyph.offsetY = fontDef.yOffset;
+        glyph.xAdvance = fontDef.xAdvance;
+        glyph.clipBottom = 0;
+        glyph.valid = true;
+        glyphs.push_back(glyph);
+    }
+
+    tKerningHashElement *currentKerning, *tmpKerning;
+    HASH_ITER(hh, configuration->_kerningDictionary, currentKerning, tmpKerning)
+    {
+        FontBaked::KerningPair kerning;
+        kerning.first = (currentKerning->key >> 16) & 0xffff;
+        kerning.second = currentKerning->key & 0xffff;
+        kerning.amount = currentKerning->amount;
+        kernings.push_back(kerning);
+    }
+
+    return true;
+}
+
 FontAtlas * FontFNT::createFontAtlas()
 {
     FontAtlas *tempAtlas = new FontAtlas(*this);
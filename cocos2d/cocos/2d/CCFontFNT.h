@@ -27,6 +27,7 @@
 #define _CCFontFNT_h_
 
 #include "CCFont.h"
+#include "2d/CCFontBaked.h"
 
 NS_CC_BEGIN
 
@@ -42,6 +43,9 @@ public:
     Removes from memory the cached configurations and the atlas name dictionary.
     */
     static void purgeCachedData();
+    /** Fills the glyphs, in pixels, and the kerning pairs of a BMFont to bake them with FontBaked::bakeFNT() */
+    static bool getGlyphsToBake(const std::string& fntFilePath, std::vector<FontBaked::Glyph>& glyphs,
+                                std::vector<FontBaked::KerningPair>& kernings, float& commonLineHeight, std::string& atlasName);
     virtual int* getHorizontalKerningForTextUTF16(const std::u16string& text, int &outNumLetters) const override;
     virtual FontAtlas *createFontAtlas() override;
     
@@ -27,10 +27,12 @@ THE SOFTWARE.
 
 #include <stdio.h>
 #include <algorithm>
+#include <thread>
+#include "2d/CCFontDistanceFieldCache.h"
 #include "base/CCDirector.h"
 #include "base/ccUTF8.h"
+#include "base/CCWorkerPool.h"
 #include "platform/CCFileUtils.h"
-#include "edtaa3func.h"
 #include FT_BBOX_H
 
 NS_CC_BEGIN
@@ -48,6 +50,18 @@ typedef struct _DataRef
 
 static std::unordered_map<std::string, DataRef> s_cacheFontData;
 
+static bool s_distanceFieldCacheEnabled = false;
+
+void FontFreeType::setDistanceFieldCacheEnabled(bool enabled)
+{
+    s_distanceFieldCacheEnabled = enabled;
+}
+
+bool FontFreeType::isDistanceFieldCacheEnabled()
+{
+    return s_distanceFieldCacheEnabled;
+}
+
 FontFreeType * FontFreeType::create(const std::string &fontName, int fontSize, GlyphCollection glyphs, const char *customGlyphs,bool distanceFieldEnabled /* = false */,int outline /* = 0 */)
 {
     FontFreeType *tempFont =  new FontFreeType(distanceFieldEnabled,outline);
@@ -99,6 +113,7 @@ FontFreeType::FontFreeType(bool distanceFieldEnabled /* = false */,int outline /
 ,_distanceFieldEnabled(distanceFieldEnabled)
 ,_outlineSize(outline)
 ,_stroker(nullptr)
+,_distanceFieldCache(nullptr)
 {
     if (_outlineSize > 0)
     {
@@ -126,7 +141,8 @@ bool FontFreeType::createFontObject(const std::string &fontName, int fontSize)
     else
     {
         s_cacheFontData[fontName].referenceCount = 1;
-        s_cacheFontData[fontName].data = FileUtils::getInstance()->getDataFromFile(fontName);    
+        // mapped: FreeType only reads the glyphs it renders
+        s_cacheFontData[fontName].data = FileUtils::getInstance()->getMappedDataFromFile(fontName);
 
         if (s_cacheFontData[fontName].data.isNull())
         {
@@ -156,6 +172,7 @@ bool FontFreeType::createFontObject(const std::string &fontName, int fontSize)
 
 FontFreeType::~FontFreeType()
 {
+    delete _distanceFieldCache;
     if (_stroker)
     {
         FT_Stroker_Done(_stroker);
@@ -407,88 +424,196 @@ unsigned char * FontFreeType::getGlyphBitmapWithOutline(unsigned short theChar,
     return ret;
 }
 
+namespace
+{
+    const double DISTANCE_INF = 1e20;
+
+    // squared distance transform of the samples grid[offset + i * stride], i < length (Felzenszwalb & Huttenlocher)
+    void distanceTransform1D(double* grid, long offset, long stride, long length, double* f, double* z, long* v)
+    {
+        for (long q = 0; q < length; ++q)
+        {
+            f[q] = grid[offset + q * stride];
+        }
+
+        long k = 0;
+        v[0] = 0;
+        z[0] = -DISTANCE_INF;
+        z[1] = DISTANCE_INF;
+        for (long q = 1; q < length; ++q)
+        {
+            // intersection of the parabola of q with the lowest one so far
+            double s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2 * q - 2 * v[k]);
+            while (s <= z[k])
+            {
+                --k;
+                s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2 * q - 2 * v[k]);
+            }
+            ++k;
+            v[k] = q;
+            z[k] = s;
+            z[k + 1] = DISTANCE_INF;
+        }
+
+        k = 0;
+        for (long q = 0; q < length; ++q)
+        {
+            while (z[k + 1] < q)
+            {
+                ++k;
+            }
+            grid[offset + q * stride] = f[v[k]] + (q - v[k]) * (q - v[k]);
+        }
+    }
+
+    void distanceTransform2D(double* grid, long width, long height, double* f, double* z, long* v)
+    {
+        for (long x = 0; x < width; ++x)
+        {
+            distanceTransform1D(grid, x, width, height, f, z, v);
+        }
+        for (long y = 0; y < height; ++y)
+        {
+            distanceTransform1D(grid, y * width, 1, width, f, z, v);
+        }
+    }
+}
+
 unsigned char * makeDistanceMap( unsigned char *img, long width, long height)
 {
-    long pixelAmount = (width + 2 * FontFreeType::DistanceMapSpread) * (height + 2 * FontFreeType::DistanceMapSpread);
-
-    short * xdist = (short *)  malloc( pixelAmount * sizeof(short) );
-    short * ydist = (short *)  malloc( pixelAmount * sizeof(short) );
-    double * gx   = (double *) calloc( pixelAmount, sizeof(double) );
-    double * gy      = (double *) calloc( pixelAmount, sizeof(double) );
-    double * data    = (double *) calloc( pixelAmount, sizeof(double) );
-    double * outside = (double *) calloc( pixelAmount, sizeof(double) );
-    double * inside  = (double *) calloc( pixelAmount, sizeof(double) );
-    long i,j;
-
-    // Convert img into double (data) rescale image levels between 0 and 1
     long outWidth = width + 2 * FontFreeType::DistanceMapSpread;
-    for (i = 0; i < width; ++i)
+    long outHeight = height + 2 * FontFreeType::DistanceMapSpread;
+    long pixelAmount = outWidth * outHeight;
+    long maxLength = MAX(outWidth, outHeight);
+
+    // squared distances to the glyph (outside) and to the background (inside), the anti-aliased
+    // pixels are placed at a sub-pixel distance from the contour according to their coverage
+    double * outside = (double *) malloc( pixelAmount * sizeof(double) );
+    double * inside  = (double *) malloc( pixelAmount * sizeof(double) );
+    double * f = (double *) malloc( maxLength * sizeof(double) );
+    double * z = (double *) malloc( (maxLength + 1) * sizeof(double) );
+    long * v = (long *) malloc( maxLength * sizeof(long) );
+
+    for (long i = 0; i < pixelAmount; ++i)
+    {
+        outside[i] = DISTANCE_INF;
+        inside[i] = 0;
+    }
+    for (long j = 0; j < height; ++j)
     {
-        for (j = 0; j < height; ++j)
+        for (long i = 0; i < width; ++i)
         {
-            data[j * outWidth + FontFreeType::DistanceMapSpread + i] = img[j * width + i] / 255.0;
+            // the glyph starts on the first row, like the letter definitions expect
+            long index = j * outWidth + FontFreeType::DistanceMapSpread + i;
+            double a = img[j * width + i] / 255.0;
+            if (a >= 1.0)
+            {
+                outside[index] = 0;
+                inside[index] = DISTANCE_INF;
+            }
+            else if (a > 0.0)
+            {
+                double d = 0.5 - a;
+                outside[index] = d > 0 ? d * d : 0;
+                inside[index] = d < 0 ? d * d : 0;
+            }
         }
     }
 
-    width += 2 * FontFreeType::DistanceMapSpread;
-    height += 2 * FontFreeType::DistanceMapSpread;
-
-    // Transform background (outside contour, in areas of 0's)   
-    computegradient( data, (int)width, (int)height, gx, gy);
-    edtaa3(data, gx, gy, (int)width, (int)height, xdist, ydist, outside);
-    for( i=0; i< pixelAmount; i++)
-        if( outside[i] < 0.0 )
-            outside[i] = 0.0;
-
-    // Transform foreground (inside contour, in areas of 1's)   
-    for( i=0; i< pixelAmount; i++)
-        data[i] = 1 - data[i];
-    computegradient( data, (int)width, (int)height, gx, gy);
-    edtaa3(data, gx, gy, (int)width, (int)height, xdist, ydist, inside);
-    for( i=0; i< pixelAmount; i++)
-        if( inside[i] < 0.0 )
-            inside[i] = 0.0;
-
-    // The bipolar distance field is now outside-inside
-    double dist;
+    distanceTransform2D(outside, outWidth, outHeight, f, z, v);
+    distanceTransform2D(inside, outWidth, outHeight, f, z, v);
+
     /* Single channel 8-bit output (bad precision and range, but simple) */    
     unsigned char *out = (unsigned char *) malloc( pixelAmount * sizeof(unsigned char) );
-    for( i=0; i < pixelAmount; i++)
+    for (long i = 0; i < pixelAmount; ++i)
     {
-        dist = outside[i] - inside[i];
+        double dist = sqrt(outside[i]) - sqrt(inside[i]);
         dist = 128.0 - dist*16;
         if( dist < 0 ) dist = 0;
         if( dist > 255 ) dist = 255;
         out[i] = (unsigned char) dist;
     }
-    /* Dual channel 16-bit output (more complicated, but good precision and range) */
-    /*unsigned char *out = (unsigned char *) malloc( pixelAmount * 3 * sizeof(unsigned char) ); 
-    for( i=0; i< pixelAmount; i++)
-    {
-        dist = outside[i] - inside[i];
-        dist = 128.0 - dist*16;
-        if( dist < 0.0 ) dist = 0.0;
-        if( dist >= 256.0 ) dist = 255.999;
-        // R channel is a copy of the original grayscale image
-        out[3*i] = img[i];
-        // G channel is fraction
-        out[3*i + 1] = (unsigned char) ( 256 - (dist - floor(dist)* 256.0 ));
-        // B channel is truncated integer part
-        out[3*i + 2] = (unsigned char)dist; 
-    }*/
-    
-    free( xdist );
-    free( ydist );
-    free( gx );
-    free( gy );
-    free( data );
+
     free( outside );
     free( inside );
+    free( f );
+    free( z );
+    free( v );
 
     return out;
 }
 
+void FontFreeType::getDistanceFieldGlyphs(const std::vector<unsigned short>& chars, std::vector<DistanceFieldGlyph>& outGlyphs)
+{
+    // glyphs per thread under which the distance fields are computed on the calling thread
+    static const int MIN_GLYPHS_PER_THREAD = 4;
+
+    if (s_distanceFieldCacheEnabled && _distanceFieldCache == nullptr && _fontRef)
+    {
+        _distanceFieldCache = new FontDistanceFieldCache(FileUtils::getInstance()->getWritablePath() + "fontcache/",
+            s_cacheFontData[_fontName].data, _fontRef->size->metrics.y_scale, DistanceMapSpread);
+    }
+
+    outGlyphs.resize(chars.size());
+    std::vector<DistanceFieldGlyph*> pendingGlyphs;
+    for (size_t i = 0; i < chars.size(); ++i)
+    {
+        auto& glyph = outGlyphs[i];
+        if (_distanceFieldCache && _distanceFieldCache->getGlyph(chars[i], glyph))
+            continue;
+
+        // FreeType isn't thread safe, the glyphs are rendered here and copied from its buffer
+        glyph.charCode = chars[i];
+        glyph.xAdvance = 0;
+        auto bitmap = getGlyphBitmap(chars[i], glyph.width, glyph.height, glyph.rect, glyph.xAdvance);
+        if (bitmap)
+        {
+            glyph.data.assign(bitmap, bitmap + glyph.width * glyph.height);
+            pendingGlyphs.push_back(&glyph);
+        }
+        else
+        {
+            glyph.rect = Rect::ZERO;
+            glyph.width = 0;
+            glyph.height = 0;
+            glyph.data.clear();
+            if (_distanceFieldCache)
+                _distanceFieldCache->addGlyph(glyph);
+        }
+    }
+
+    auto computeDistanceFields = [&pendingGlyphs](int first, int last) {
+        for (int i = first; i < last; ++i)
+        {
+            auto glyph = pendingGlyphs[i];
+            auto distanceMap = makeDistanceMap(glyph->data.data(), glyph->width, glyph->height);
+            glyph->width += 2 * DistanceMapSpread;
+            glyph->height += 2 * DistanceMapSpread;
+            glyph->data.assign(distanceMap, distanceMap + glyph->width * glyph->height);
+            free(distanceMap);
+        }
+    };
+
+    int glyphCount = (int)pendingGlyphs.size();
+    int threadCount = std::min((int)std::thread::hardware_concurrency(), CC_FONT_DISTANCE_FIELD_THREADS);
+    WorkerPool::getInstance()->run(glyphCount, std::min(threadCount, glyphCount / MIN_GLYPHS_PER_THREAD), computeDistanceFields);
+
+    if (_distanceFieldCache)
+    {
+        for (auto glyph : pendingGlyphs)
+        {
+            _distanceFieldCache->addGlyph(*glyph);
+        }
+        _distanceFieldCache->flush();
+    }
+}
+
 void FontFreeType::renderCharAt(unsigned char *dest,int posX, int posY, unsigned char* bitmap,long bitmapWidth,long bitmapHeight)
+{
+    renderCharAt(dest, posX, posY, bitmap, bitmapWidth, bitmapHeight, FontAtlas::CacheTextureWidth);
+}
+
+void FontFreeType::renderCharAt(unsigned char *dest,int posX, int posY, unsigned char* bitmap,long bitmapWidth,long bitmapHeight,int destWidth)
 {
     int iX = posX;
     int iY = posY;
@@ -514,7 +639,7 @@ void FontFreeType::renderCharAt(unsigned char *dest,int posX, int posY, unsigned
                 dest[index + 2] = out[index2 + 2];*/
 
                 //Single channel 8-bit output 
-                dest[iX + ( iY * FontAtlas::CacheTextureWidth )] = distanceMap[bitmap_y + x];
+                dest[iX + ( iY * destWidth )] = distanceMap[bitmap_y + x];
 
                 iX += 1;
             }
@@ -534,9 +659,9 @@ void FontFreeType::renderCharAt(unsigned char *dest,int posX, int posY, unsigned
             for (int x = 0; x < bitmapWidth; ++x)
             {
                 tempChar = bitmap[(bitmap_y + x) * 2];
-                dest[(iX + ( iY * FontAtlas::CacheTextureWidth ) ) * 2] = tempChar;
+                dest[(iX + ( iY * destWidth ) ) * 2] = tempChar;
                 tempChar = bitmap[(bitmap_y + x) * 2 + 1];
-                dest[(iX + ( iY * FontAtlas::CacheTextureWidth ) ) * 2 + 1] = tempChar;
+                dest[(iX + ( iY * destWidth ) ) * 2 + 1] = tempChar;
 
                 iX += 1;
             }
@@ -557,7 +682,7 @@ void FontFreeType::renderCharAt(unsigned char *dest,int posX, int posY, unsigned
                 unsigned char cTemp = bitmap[bitmap_y + x];
 
                 // the final pixel
-                dest[(iX + ( iY * FontAtlas::CacheTextureWidth ) )] = cTemp;
+                dest[(iX + ( iY * destWidth ) )] = cTemp;
 
                 iX += 1;
             }
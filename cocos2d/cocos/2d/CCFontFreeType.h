@@ -30,6 +30,7 @@
 #include "base/CCData.h"
 
 #include <string>
+#include <vector>
 #include <ft2build.h>
 
 #if (CC_TARGET_PLATFORM == CC_PLATFORM_WP8) || (CC_TARGET_PLATFORM == CC_PLATFORM_WINRT)
@@ -48,23 +49,51 @@
 
 NS_CC_BEGIN
 
+class FontDistanceFieldCache;
+
 class CC_DLL FontFreeType : public Font
 {
 public:
     static const int DistanceMapSpread;
 
+    /** A glyph rendered as a distance field */
+    struct DistanceFieldGlyph
+    {
+        unsigned short charCode;
+        Rect rect;
+        int xAdvance;
+        // the size of the distance field, the spread included. 0 when the glyph has no bitmap
+        long width;
+        long height;
+        std::vector<unsigned char> data;
+    };
+
     static FontFreeType * create(const std::string &fontName, int fontSize, GlyphCollection glyphs, const char *customGlyphs,bool distanceFieldEnabled = false,int outline = 0);
 
     static void shutdownFreeType();
 
+    /** Enables the on-disk cache of the distance fields, in the "fontcache" folder of the writable path.
+     Disabled by default.
+     */
+    static void setDistanceFieldCacheEnabled(bool enabled);
+    static bool isDistanceFieldCacheEnabled();
+
     bool     isDistanceFieldEnabled() const { return _distanceFieldEnabled;}
     float    getOutlineSize() const { return _outlineSize; }
     void     renderCharAt(unsigned char *dest,int posX, int posY, unsigned char* bitmap,long bitmapWidth,long bitmapHeight); 
+    /** renders the glyph into a buffer of destWidth pixels per row */
+    void     renderCharAt(unsigned char *dest,int posX, int posY, unsigned char* bitmap,long bitmapWidth,long bitmapHeight,int destWidth);
 
     virtual FontAtlas   * createFontAtlas() override;
     virtual int         * getHorizontalKerningForTextUTF16(const std::u16string& text, int &outNumLetters) const override;
     
     unsigned char       * getGlyphBitmap(unsigned short theChar, long &outWidth, long &outHeight, Rect &outRect,int &xAdvance);
+
+    /** Renders the distance fields of the glyphs of chars. FreeType renders the glyphs one after the other,
+     their distance fields are computed on up to CC_FONT_DISTANCE_FIELD_THREADS threads.
+     The glyphs of the disk cache are read from it instead.
+     */
+    void getDistanceFieldGlyphs(const std::vector<unsigned short>& chars, std::vector<DistanceFieldGlyph>& outGlyphs);
     
     virtual int           getFontMaxHeight() const override;  
     virtual int           getFontAscender() const;
@@ -90,6 +119,7 @@ private:
     std::string       _fontName;
     bool              _distanceFieldEnabled;
     float             _outlineSize;
+    FontDistanceFieldCache* _distanceFieldCache;
 };
 
 NS_CC_END
@@ -24,6 +24,10 @@
  ****************************************************************************/
 
 #include "2d/CCLabel.h"
+
+#include <map>
+#include <tuple>
+
 #include "2d/CCFontAtlasCache.h"
 #include "2d/CCSprite.h"
 #include "2d/CCLabelTextFormatter.h"
@@ -46,6 +50,52 @@ NS_CC_BEGIN
 
 const int Label::DistanceFieldFontSize = 50;
 
+static bool s_batchingEnabled = true;
+
+namespace
+{
+    // the program states of the batched labels, shared by the labels drawn with the same program and colors.
+    // They are kept, the labels whose colors change all the time are drawn alone once there are too many
+    const size_t MAX_BATCH_STATES = 256;
+    typedef std::tuple<GLProgram*, uint32_t, uint32_t> BatchStateKey;
+    std::map<BatchStateKey, GLProgramState*> s_batchStates;
+
+    uint32_t colorKey(const Color4B& color)
+    {
+        return ((uint32_t)color.r << 24) | ((uint32_t)color.g << 16) | ((uint32_t)color.b << 8) | color.a;
+    }
+
+    GLProgramState* getBatchGLProgramState(GLProgram* glprogram, const Color4B& textColor, const Color4B& effectColor, bool hasEffectColor)
+    {
+        BatchStateKey key(glprogram, colorKey(textColor), hasEffectColor ? colorKey(effectColor) : 0);
+        auto it = s_batchStates.find(key);
+        if (it != s_batchStates.end())
+            return it->second;
+        if (s_batchStates.size() >= MAX_BATCH_STATES)
+            return nullptr;
+
+        auto state = GLProgramState::create(glprogram);
+        state->retain();
+        state->setUniformVec4("u_textColor", Vec4(textColor.r / 255.0f, textColor.g / 255.0f, textColor.b / 255.0f, textColor.a / 255.0f));
+        if (hasEffectColor)
+        {
+            state->setUniformVec4("u_effectColor", Vec4(effectColor.r / 255.0f, effectColor.g / 255.0f, effectColor.b / 255.0f, effectColor.a / 255.0f));
+        }
+        s_batchStates[key] = state;
+        return state;
+    }
+}
+
+void Label::setBatchingEnabled(bool enabled)
+{
+    s_batchingEnabled = enabled;
+}
+
+bool Label::isBatchingEnabled()
+{
+    return s_batchingEnabled;
+}
+
 Label* Label::create()
 {
     auto ret = new Label();
@@ -261,6 +311,8 @@ Label::Label(FontAtlas *atlas /* = nullptr */, TextHAlignment hAlignment /* = Te
 , _compatibleMode(false)
 , _insideBounds(true)
 , _effectColorF(Color4F::BLACK)
+, _labelGLProgram(nullptr)
+, _atlasEvictedPageCount(0)
 {
     setAnchorPoint(Vec2::ANCHOR_MIDDLE);
     reset();
@@ -279,7 +331,8 @@ Label::Label(FontAtlas *atlas /* = nullptr */, TextHAlignment hAlignment /* = Te
     auto purgeTextureListener = EventListenerCustom::create(FontAtlas::EVENT_PURGE_TEXTURES, [this](EventCustom* event){
         if (_fontAtlas && _currentLabelType == LabelType::TTF && event->getUserData() == _fontAtlas)
         {
-            alignText();
+            // the atlas may be adding the letters of another label, lay out on the next visit
+            _contentDirty = true;
         }
     });
     _eventDispatcher->addEventListenerWithSceneGraphPriority(purgeTextureListener, this);
@@ -363,6 +416,7 @@ void Label::updateShaderProgram()
     }
     
     _uniformTextColor = glGetUniformLocation(getGLProgram()->getProgram(), "u_textColor");
+    _labelGLProgram = getGLProgram();
 }
 
 void Label::setFontAtlas(FontAtlas* atlas,bool distanceFieldEnabled /* = false */, bool useA8Shader /* = false */)
@@ -475,13 +529,18 @@ void Label::setString(const std::string& text)
     if (text.compare(_originalUTF8String))
     {
         _originalUTF8String = text;
-        _contentDirty = true;
 
         std::u16string utf16String;
         if (StringUtils::UTF8ToUTF16(_originalUTF8String, utf16String))
         {
+            // counters and timers change a few letters of an up to date layout
+            if (! _contentDirty && ! _systemFontDirty && updateStringIncrementally(utf16String))
+            {
+                return;
+            }
             _currentUTF16String  = utf16String;
         }
+        _contentDirty = true;
     }
 }
 
@@ -591,6 +650,7 @@ void Label::alignText()
         batchNode->getTextureAtlas()->removeAllQuads();
     }
     _fontAtlas->prepareLetterDefinitions(_currentUTF16String);
+    _atlasEvictedPageCount = _fontAtlas->getEvictedPageCount();
     auto textures = _fontAtlas->getTextures();
     if (textures.size() > _batchNodes.size())
     {
@@ -680,6 +740,110 @@ void Label::updateQuads()
     }
 }
 
+bool Label::updateStringIncrementally(const std::u16string& newString)
+{
+    if (_fontAtlas == nullptr || _textSprite || _horizontalKernings == nullptr
+        || _labelWidth > 0 || _labelHeight > 0 || _maxLineWidth > 0 || _clipEnabled || _currNumLines != 1
+        || _currentUTF16String.empty() || newString.empty() || newString.find(u'\n') != std::u16string::npos)
+    {
+        return false;
+    }
+    // the letters got with getLetter() are sprites
+    for (const auto &child : _children)
+    {
+        if (child->getTag() >= 0)
+            return false;
+    }
+
+    size_t newLength = newString.length();
+    size_t prefix = 0;
+    while (prefix < newLength && prefix < _currentUTF16String.length() && newString[prefix] == _currentUTF16String[prefix])
+    {
+        ++prefix;
+    }
+
+    _fontAtlas->prepareLetterDefinitions(newString.substr(prefix));
+    // the atlas evicted glyphs since the letters were laid out (the label is dirty again) or added a page
+    if (_contentDirty || _fontAtlas->getEvictedPageCount() != _atlasEvictedPageCount || _fontAtlas->getTextures().size() > _batchNodes.size())
+    {
+        return false;
+    }
+
+    // the kerning of a letter depends on the previous one, the first changed letter is computed with it
+    size_t first = prefix > 0 ? prefix - 1 : 0;
+    int letterCount = 0;
+    int* suffixKernings = _fontAtlas->getFont()->getHorizontalKerningForTextUTF16(newString.substr(first), letterCount);
+    if (suffixKernings == nullptr)
+    {
+        return false;
+    }
+    int* kernings = new int[newLength];
+    memcpy(kernings, _horizontalKernings, prefix * sizeof(int));
+    memcpy(kernings + prefix, suffixKernings + (prefix - first), (newLength - prefix) * sizeof(int));
+    delete [] suffixKernings;
+    delete [] _horizontalKernings;
+    _horizontalKernings = kernings;
+
+    std::vector<LetterInfo> oldLetters(_lettersInfo.begin(), _lettersInfo.begin() + _limitShowCount);
+    _currentUTF16String = newString;
+    LabelTextFormatter::createStringSprites(this);
+
+    // the quads are rewritten in place while every letter keeps its page
+    bool inPlace = oldLetters.size() == static_cast<size_t>(_limitShowCount);
+    for (int ctr = 0; inPlace && ctr < _limitShowCount; ++ctr)
+    {
+        const auto &oldDef = oldLetters[ctr].def;
+        const auto &newDef = _lettersInfo[ctr].def;
+        inPlace = oldDef.validDefinition == newDef.validDefinition
+            && (! newDef.validDefinition || oldDef.textureID == newDef.textureID);
+    }
+    if (! inPlace)
+    {
+        for (const auto& batchNode:_batchNodes)
+        {
+            batchNode->getTextureAtlas()->removeAllQuads();
+        }
+        updateQuads();
+        updateColor();
+        return true;
+    }
+
+    Color4B color4 = getQuadColor();
+    for (int ctr = 0; ctr < _limitShowCount; ++ctr)
+    {
+        auto &letterInfo = _lettersInfo[ctr];
+        const auto &letterDef = letterInfo.def;
+        if (! letterDef.validDefinition
+            || (letterDef.letteCharUTF16 == oldLetters[ctr].def.letteCharUTF16 && letterInfo.position.equals(oldLetters[ctr].position)))
+        {
+            continue;
+        }
+
+        _reusedRect.size.height = letterDef.height;
+        _reusedRect.size.width  = letterDef.width;
+        _reusedRect.origin.x    = letterDef.U;
+        _reusedRect.origin.y    = letterDef.V;
+        _reusedLetter->setTextureRect(_reusedRect,false,_reusedRect.size);
+        _reusedLetter->setPosition(letterInfo.position);
+
+        auto batchNode = _batchNodes[letterDef.textureID];
+        letterInfo.atlasIndex = oldLetters[ctr].atlasIndex;
+        _reusedLetter->setBatchNode(batchNode);
+        _reusedLetter->setAtlasIndex(letterInfo.atlasIndex);
+        _reusedLetter->setDirty(true);
+        _reusedLetter->updateTransform();
+
+        auto textureAtlas = batchNode->getTextureAtlas();
+        auto quad = textureAtlas->getQuads()[letterInfo.atlasIndex];
+        quad.bl.colors = color4;
+        quad.br.colors = color4;
+        quad.tl.colors = color4;
+        quad.tr.colors = color4;
+        textureAtlas->updateQuad(&quad, letterInfo.atlasIndex);
+    }
+    return true;
+}
+
 bool Label::recordLetterInfo(const cocos2d::Vec2& point,const FontLetterDefinition& letterDef, int spriteIndex)
 {
     if (static_cast<std::size_t>(spriteIndex) >= _lettersInfo.size())
@@ -883,16 +1047,167 @@ void Label::draw(Renderer *renderer, const Mat4 &transform, bool transformUpdate
     _insideBounds = transformUpdated ? renderer->checkVisibility(transform, _contentSize) : _insideBounds;
 
     if(_insideBounds) {
-        _customCommand.init(_globalZOrder);
-        _customCommand.func = CC_CALLBACK_0(Label::onDraw, this, transform, transformUpdated);
-        renderer->addCommand(&_customCommand);
+        if (_currentLabelType == LabelType::TTF)
+        {
+            // keeps the pages of the letters from being reused by the font atlas
+            auto frame = Director::getInstance()->getTotalFrames();
+            for (const auto& batchNode:_batchNodes)
+            {
+                if (batchNode->getTextureAtlas()->getTotalQuads() > 0)
+                    batchNode->getTexture()->setLastUsedFrame(frame);
+            }
+        }
+
+        if (!s_batchingEnabled || !canBatchQuads() || !batchQuads(renderer, transform))
+        {
+            _customCommand.init(_globalZOrder);
+            _customCommand.func = CC_CALLBACK_0(Label::onDraw, this, transform, transformUpdated);
+            renderer->addCommand(&_customCommand);
+        }
+    }
+}
+
+bool Label::canBatchQuads() const
+{
+    // the uniforms of a custom program aren't known
+    if (_labelGLProgram == nullptr || _glProgramState == nullptr || _glProgramState->getGLProgram() != _labelGLProgram)
+        return false;
+
+    for (const auto& batchNode:_batchNodes)
+    {
+        if (batchNode->getTextureAtlas()->getTotalQuads() >= Renderer::VBO_SIZE)
+            return false;
     }
+    return true;
+}
+
+bool Label::batchQuads(Renderer *renderer, const Mat4 &transform)
+{
+    // the text color of the shaders which multiply it with the vertex color is put in the vertex colors,
+    // so that the labels of any color are batched together
+    GLProgramState* glProgramState = getGLProgramState();
+    bool foldTextColor = false;
+    if (_currentLabelType == LabelType::TTF)
+    {
+        bool hasEffectColor = (_currLabelEffect == LabelEffect::OUTLINE || _currLabelEffect == LabelEffect::GLOW);
+        foldTextColor = _currLabelEffect == LabelEffect::NORMAL && (_useDistanceField || _useA8Shader);
+        glProgramState = getBatchGLProgramState(getGLProgram(), foldTextColor ? Color4B::WHITE : _textColor, _effectColor, hasEffectColor);
+        if (glProgramState == nullptr)
+            return false;
+    }
+
+    bool drawShadow = _shadowEnabled && _shadowBlurRadius <= 0;
+    size_t commandCount = drawShadow ? _batchNodes.size() * 2 : _batchNodes.size();
+    if (_batchCommands.size() < commandCount)
+    {
+        _batchCommands.resize(commandCount);
+        _batchQuads.resize(commandCount);
+    }
+
+    size_t index = 0;
+    if (drawShadow)
+    {
+        // as drawShadowWithoutBlur()
+        Color3B oldColor = _realColor;
+        GLubyte oldOPacity = _displayedOpacity;
+        _displayedOpacity = _shadowOpacity * _displayedOpacity;
+        setColor(_shadowColor);
+
+        for(const auto &child: _children)
+        {
+            child->updateTransform();
+        }
+        for (const auto& batchNode:_batchNodes)
+        {
+            addBatchCommand(renderer, index++, batchNode, _shadowTransform, glProgramState, foldTextColor);
+        }
+
+        _displayedOpacity = oldOPacity;
+        setColor(oldColor);
+    }
+
+    for(const auto &child: _children)
+    {
+        if(child->getTag() >= 0)
+            child->updateTransform();
+    }
+    for (const auto& batchNode:_batchNodes)
+    {
+        addBatchCommand(renderer, index++, batchNode, transform, glProgramState, foldTextColor);
+    }
+    return true;
+}
+
+void Label::addBatchCommand(Renderer *renderer, size_t index, SpriteBatchNode* batchNode, const Mat4 &transform, GLProgramState* glProgramState, bool foldTextColor)
+{
+    auto textureAtlas = batchNode->getTextureAtlas();
+    ssize_t count = textureAtlas->getTotalQuads();
+    if (count == 0)
+        return;
+
+    // the quads are given in world coordinates: the renderer applies the transform of the first
+    // command of a batch to the shader, so an identity one keeps the MVP label shaders working
+    auto& quads = _batchQuads[index];
+    quads.assign(textureAtlas->getQuads(), textureAtlas->getQuads() + count);
+    for (auto& quad : quads)
+    {
+        transform.transformPoint(&quad.bl.vertices);
+        transform.transformPoint(&quad.br.vertices);
+        transform.transformPoint(&quad.tl.vertices);
+        transform.transformPoint(&quad.tr.vertices);
+    }
+    if (foldTextColor)
+    {
+        // the letters may have their own color
+        auto fold = [this](Color4B& color) {
+            color.r = color.r * _textColor.r / 255;
+            color.g = color.g * _textColor.g / 255;
+            color.b = color.b * _textColor.b / 255;
+            color.a = color.a * _textColor.a / 255;
+        };
+        for (auto& quad : quads)
+        {
+            fold(quad.bl.colors);
+            fold(quad.br.colors);
+            fold(quad.tl.colors);
+            fold(quad.tr.colors);
+        }
+    }
+
+    auto& command = _batchCommands[index];
+    command.init(_globalZOrder, textureAtlas->getTexture()->getName(), glProgramState, _blendFunc, quads.data(), count, Mat4::IDENTITY);
+    renderer->addCommand(&command);
 }
 
 void Label::createSpriteWithFontDefinition()
 {
     _currentLabelType = LabelType::STRING_TEXTURE;
 
+    if (_textSprite)
+    {
+        // the texture of the previous string keeps its GL texture when the new string fits in it
+        auto texture = _textSprite->getTexture();
+        if (texture->initWithString(_originalUTF8String.c_str(),_fontDefinition))
+        {
+            Rect textureRect(0, 0, texture->getContentSize().width, texture->getContentSize().height);
+            _textSprite->setTextureRect(textureRect);
+            if (_shadowNode)
+            {
+                _shadowNode->setTextureRect(textureRect);
+            }
+            this->setContentSize(_textSprite->getContentSize());
+            return;
+        }
+
+        Node::removeChild(_textSprite,true);
+        _textSprite = nullptr;
+        if (_shadowNode)
+        {
+            Node::removeChild(_shadowNode,true);
+            _shadowNode = nullptr;
+        }
+    }
+
     auto texture = new Texture2D;
     texture->initWithString(_originalUTF8String.c_str(),_fontDefinition);
 
@@ -943,7 +1258,7 @@ void Label::updateContent()
         computeHorizontalKernings(_currentUTF16String);
     }
 
-    if (_textSprite)
+    if (_textSprite && _fontAtlas)
     {
         Node::removeChild(_textSprite,true);
         _textSprite = nullptr;
@@ -1059,6 +1374,11 @@ void Label::visit(Renderer *renderer, const Mat4 &parentTransform, bool parentTr
     {
         updateFont();
     }
+    // the labels off the scene or paused miss EVENT_PURGE_TEXTURES, their letters may use evicted glyphs
+    if (_fontAtlas && _currentLabelType == LabelType::TTF && _fontAtlas->getEvictedPageCount() != _atlasEvictedPageCount)
+    {
+        _contentDirty = true;
+    }
     if (_contentDirty)
     {
         updateContent();
@@ -1264,13 +1584,8 @@ void Label::setTextColor(const Color4B &color)
     _textColorF.a = _textColor.a / 255.0f;
 }
 
-void Label::updateColor()
+Color4B Label::getQuadColor() const
 {
-    if (nullptr == _textureAtlas)
-    {
-        return;
-    }
-
     Color4B color4( _displayedColor.r, _displayedColor.g, _displayedColor.b, _displayedOpacity );
 
     // special opacity for premultiplied textures
@@ -1280,6 +1595,17 @@ void Label::updateColor()
         color4.g *= _displayedOpacity/255.0f;
         color4.b *= _displayedOpacity/255.0f;
     }
+    return color4;
+}
+
+void Label::updateColor()
+{
+    if (nullptr == _textureAtlas)
+    {
+        return;
+    }
+
+    Color4B color4 = getQuadColor();
 
     cocos2d::TextureAtlas* textureAtlas;
     V3F_C4B_T2F_Quad *quads;
@@ -30,6 +30,7 @@
 #include "2d/CCSpriteBatchNode.h"
 #include "base/ccTypes.h"
 #include "renderer/CCCustomCommand.h"
+#include "renderer/CCQuadCommand.h"
 #include "2d/CCFontAtlas.h"
 
 NS_CC_BEGIN
@@ -80,6 +81,13 @@ class CC_DLL Label : public SpriteBatchNode, public LabelProtocol
 public:
     static const int DistanceFieldFontSize;
 
+    /** Sets whether the labels are drawn with QuadCommands, which the renderer merges in a single draw call
+     when consecutive labels share a font atlas page, a shader, its colors and a blend function.
+     The labels with a custom GLProgram are drawn alone. Enabled by default.
+     */
+    static void setBatchingEnabled(bool enabled);
+    static bool isBatchingEnabled();
+
     static Label* create();
 
     /** Creates a label with an initial string,font[font name or font file],font size, dimension in points, horizontal alignment and vertical alignment.
@@ -292,12 +300,27 @@ protected:
 
     void updateQuads();
 
+    /** Lays out a new string of a single line label again, reusing the letters and the kernings of the
+     common prefix and rewriting only the quads that changed. Returns false when a full layout is needed.
+     */
+    bool updateStringIncrementally(const std::u16string& newString);
+
     virtual void updateColor() override;
 
+    Color4B getQuadColor() const;
+
     virtual void updateShaderProgram();
 
     void drawShadowWithoutBlur();
 
+    /** Returns true if the label can be drawn through the renderer's quad batching */
+    bool canBatchQuads() const;
+    /** Adds a QuadCommand for each page, after the ones of the shadow, with the quads in world coordinates.
+     Returns false if nothing was added and the label has to be drawn alone.
+     */
+    bool batchQuads(Renderer *renderer, const Mat4 &transform);
+    void addBatchCommand(Renderer *renderer, size_t index, SpriteBatchNode* batchNode, const Mat4 &transform, GLProgramState* glProgramState, bool foldTextColor);
+
     void drawTextSprite(Renderer *renderer, bool parentTransformUpdated);
 
     void createSpriteWithFontDefinition();
@@ -317,6 +340,8 @@ protected:
 
     std::vector<SpriteBatchNode*> _batchNodes;
     FontAtlas *                   _fontAtlas;
+    // getEvictedPageCount() of the atlas when the letters were laid out
+    unsigned int                  _atlasEvictedPageCount;
     std::vector<LetterInfo>       _lettersInfo;
 
     TTFConfig _fontConfig;
@@ -358,6 +383,9 @@ protected:
     GLuint _uniformEffectColor;
     GLuint _uniformTextColor;
     CustomCommand _customCommand;   
+    // used when the label is batched, one per page and per page of the shadow
+    std::vector<QuadCommand> _batchCommands;
+    std::vector<std::vector<V3F_C4B_T2F_Quad>> _batchQuads;
 
     bool    _shadowDirty;
     bool    _shadowEnabled;
@@ -376,6 +404,8 @@ protected:
     bool _clipEnabled;
     bool _blendFuncDirty;
     bool _insideBounds;                     /// whether or not the sprite was inside bounds the previous frame
+    // the program set by updateShaderProgram(), the labels drawn with another one aren't batched
+    GLProgram* _labelGLProgram;
 
 private:
     CC_DISALLOW_COPY_AND_ASSIGN(Label);
@@ -39,6 +39,7 @@
 #include "base/ccMacros.h"
 #include "base/base64.h"
 #include "base/ZipUtils.h"
+#include "base/CCDirector.h"
 #include "renderer/CCTextureCache.h"
 #include "renderer/CCGLProgramState.h"
 #include "renderer/CCGLProgram.h"
@@ -392,6 +393,7 @@ void ParticleBatchNode::draw(Renderer *renderer, const Mat4 &transform, bool tra
         return;
     }
 
+    _textureAtlas->getTexture()->setLastUsedFrame(Director::getInstance()->getTotalFrames());
     _batchCommand.init(
                        _globalZOrder,
                        getGLProgram(),
@@ -0,0 +1,217 @@
+/****************************************************************************
+ Copyright (c) 2013-2014 Chukong Technologies Inc.
+
+ http://www.cocos2d-x.org
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#include "2d/CCParticleJobSystem.h"
+
+#include <algorithm>
+
+#include "2d/CCParticleSystem.h"
+
+NS_CC_BEGIN
+
+static ParticleJobSystem* s_sharedParticleJobSystem = nullptr;
+
+ParticleJobSystem* ParticleJobSystem::getInstance()
+{
+    if (! s_sharedParticleJobSystem)
+    {
+        s_sharedParticleJobSystem = new ParticleJobSystem();
+    }
+    return s_sharedParticleJobSystem;
+}
+
+void ParticleJobSystem::destroyInstance()
+{
+    CC_SAFE_DELETE(s_sharedParticleJobSystem);
+}
+
+ParticleJobSystem::ParticleJobSystem()
+: _threadCount(1)
+, _lastJobCount(0)
+, _nextJob(0)
+, _doneJobCount(0)
+, _busyWorkerCount(0)
+, _generation(0)
+, _needQuit(false)
+{
+    int cores = (int)std::thread::hardware_concurrency();
+    _threadCount = std::max(1, std::min(cores, CC_PARTICLE_SIMULATION_THREADS));
+}
+
+ParticleJobSystem::~ParticleJobSystem()
+{
+    wait();
+    stopWorkers();
+}
+
+void ParticleJobSystem::setThreadCount(int threadCount)
+{
+    threadCount = std::max(1, threadCount);
+    if (threadCount != _threadCount)
+    {
+        wait();
+        stopWorkers();
+        _threadCount = threadCount;
+    }
+}
+
+void ParticleJobSystem::addJob(ParticleSystem* system, float dt)
+{
+    system->retain();
+    Job job = { system, dt, false };
+    _queuedJobs.push_back(job);
+}
+
+void ParticleJobSystem::start()
+{
+    if (_queuedJobs.empty())
+    {
+        return;
+    }
+    // the jobs of a previous update, with a fixed time step
+    finishJobs();
+
+    // the workers are created with the first jobs
+    if (_workerThreads.empty())
+    {
+        _needQuit = false;
+        for (int i = 1; i < _threadCount; ++i)
+        {
+            _workerThreads.push_back(std::thread(&ParticleJobSystem::workerLoop, this));
+        }
+    }
+
+    // the biggest emitters first, so that the threads end together
+    std::stable_sort(_queuedJobs.begin(), _queuedJobs.end(), [](const Job& a, const Job& b) {
+        return a.system->getParticleCount() > b.system->getParticleCount();
+    });
+
+    {
+        std::lock_guard<std::mutex> lk(_mutex);
+        _jobs.swap(_queuedJobs);
+        _nextJob = 0;
+        _doneJobCount = 0;
+        ++_generation;
+    }
+    _workCondition.notify_all();
+}
+
+void ParticleJobSystem::wait()
+{
+    start();
+    finishJobs();
+}
+
+void ParticleJobSystem::finishJobs()
+{
+    if (_jobs.empty())
+    {
+        return;
+    }
+
+    runJobs(_jobs.data(), _jobs.size());
+
+    std::vector<Job> jobs;
+    {
+        std::unique_lock<std::mutex> lk(_mutex);
+        _doneCondition.wait(lk, [this]() { return _doneJobCount == _jobs.size() && _busyWorkerCount == 0; });
+        // a worker waking up now finds no job
+        jobs.swap(_jobs);
+    }
+
+    // back on the cocos2d thread, for the emitters to upload their quads and to be released
+    for (auto& job : jobs)
+    {
+        job.system->finishSimulation(job.removeSystem);
+        job.system->release();
+    }
+    _lastJobCount = (int)jobs.size();
+}
+
+void ParticleJobSystem::runJobs(Job* jobs, size_t count)
+{
+    // the jobs are taken one at a time, a thread simulating a big emitter doesn't hold the next ones
+    size_t index;
+    while ((index = _nextJob++) < count)
+    {
+        Job& job = jobs[index];
+        job.removeSystem = job.system->simulate(job.dt);
+
+        std::lock_guard<std::mutex> lk(_mutex);
+        if (++_doneJobCount == count)
+        {
+            _doneCondition.notify_all();
+        }
+    }
+}
+
+void ParticleJobSystem::workerLoop()
+{
+    unsigned int generation = 0;
+    Job* jobs = nullptr;
+    size_t count = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lk(_mutex);
+            _workCondition.wait(lk, [this, generation]() { return _needQuit || _generation != generation; });
+            if (_needQuit)
+            {
+                break;
+            }
+            generation = _generation;
+            jobs = _jobs.data();
+            count = _jobs.size();
+            ++_busyWorkerCount;
+        }
+
+        // woken up after the cocos2d thread took the jobs, the index of the next jobs must not be taken
+        if (count > 0)
+        {
+            runJobs(jobs, count);
+        }
+
+        {
+            std::lock_guard<std::mutex> lk(_mutex);
+            --_busyWorkerCount;
+        }
+        _doneCondition.notify_all();
+    }
+}
+
+void ParticleJobSystem::stopWorkers()
+{
+    {
+        std::lock_guard<std::mutex> lk(_mutex);
+        _needQuit = true;
+    }
+    _workCondition.notify_all();
+    for (auto& thread : _workerThreads)
+    {
+        thread.join();
+    }
+    _workerThreads.clear();
+}
+
+NS_CC_END
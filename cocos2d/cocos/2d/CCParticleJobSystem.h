@@ -0,0 +1,128 @@
+/****************************************************************************
+ Copyright (c) 2013-2014 Chukong Technologies Inc.
+
+ http://www.cocos2d-x.org
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#ifndef __CCPARTICLE_JOB_SYSTEM_H__
+#define __CCPARTICLE_JOB_SYSTEM_H__
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+#include "base/ccConfig.h"
+#include "base/CCPlatformMacros.h"
+
+NS_CC_BEGIN
+
+class ParticleSystem;
+
+/**
+ * @addtogroup particle_nodes
+ * @{
+ */
+
+/** @brief Simulates the particles of the emitters on worker threads.
+
+ The emitters updated by the scheduler queue their simulation instead of running it: their new
+ particles are emitted on the cocos2d thread, then the Director starts the jobs after the updates
+ of the frame, and the workers move the particles and write their quads. The cocos2d thread waits
+ for the jobs, simulating particles meanwhile, when an emitter queued is drawn and at the latest
+ before the renderer draws the frame.
+
+ The emitters of a ParticleBatchNode, which share the quads of the batch node, are simulated on the
+ cocos2d thread. An emitter removing itself when it has no particles left is removed at its next update.
+ @since v3.2
+ */
+class CC_DLL ParticleJobSystem
+{
+public:
+    /** returns the shared job system */
+    static ParticleJobSystem* getInstance();
+
+    /** waits for the jobs and stops the worker threads */
+    static void destroyInstance();
+
+    /** Sets the number of threads simulating the particles, the cocos2d thread included. With 1 thread the
+     emitters are simulated by their update. Default value: the number of cores, at most CC_PARTICLE_SIMULATION_THREADS
+     */
+    void setThreadCount(int threadCount);
+    int getThreadCount() const { return _threadCount; }
+
+    /** whether the updates of the emitters queue their simulation */
+    bool isEnabled() const { return _threadCount > 1; }
+
+    /** Queues the simulation of the particles of an emitter during dt, the emitter is retained until it is simulated */
+    void addJob(ParticleSystem* system, float dt);
+
+    /** Starts the jobs queued by the updates, called by the Director after the updates */
+    void start();
+
+    /** Waits for the jobs to be done, called on the cocos2d thread. The jobs queued but not started are started */
+    void wait();
+
+    /** returns the number of emitters simulated on several threads during the last frame */
+    int getLastJobCount() const { return _lastJobCount; }
+
+    ~ParticleJobSystem();
+
+private:
+    ParticleJobSystem();
+
+    struct Job
+    {
+        ParticleSystem* system;
+        float dt;
+        bool removeSystem;
+    };
+
+    void finishJobs();
+    void workerLoop();
+    void runJobs(Job* jobs, size_t count);
+    void stopWorkers();
+
+    int _threadCount;
+    int _lastJobCount;
+    std::vector<Job> _queuedJobs;
+
+    // the jobs started, read by the workers until they are all done
+    std::vector<Job> _jobs;
+    std::atomic<size_t> _nextJob;
+    size_t _doneJobCount;
+    int _busyWorkerCount;
+    unsigned int _generation;
+
+    std::vector<std::thread> _workerThreads;
+    std::mutex _mutex;
+    std::condition_variable _workCondition;
+    std::condition_variable _doneCondition;
+    bool _needQuit;
+};
+
+// end of particle_nodes group
+/// @}
+
+NS_CC_END
+
+#endif //__CCPARTICLE_JOB_SYSTEM_H__
@@ -47,6 +47,7 @@ THE SOFTWARE.
 #include <string>
 
 #include "2d/CCParticleBatchNode.h"
+#include "2d/CCParticleJobSystem.h"
 #include "renderer/CCTextureAtlas.h"
 #include "platform/CCFileUtils.h"
 #include "platform/CCImage.h"
@@ -59,11 +60,114 @@ THE SOFTWARE.
 
 #include "CCGL.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CC_PARTICLE_USE_SSE 1
+#else
+#define CC_PARTICLE_USE_SSE 0
+#endif
+
 using namespace std;
 
 
 NS_CC_BEGIN
 
+// the float arrays of ParticleData, and its array of atlas indices
+static const int PARTICLE_DATA_FLOAT_ARRAYS = 25;
+
+ParticleData::ParticleData()
+: atlasIndex(nullptr)
+, _data(nullptr)
+, _maxCount(0)
+{
+    setArrays(nullptr, 0);
+}
+
+ParticleData::~ParticleData()
+{
+    release();
+}
+
+bool ParticleData::init(int count)
+{
+    release();
+
+    // a multiple of 4 particles, so that each array starts on 16 bytes
+    size_t stride = (count + 3) & ~3;
+    _data = calloc((PARTICLE_DATA_FLOAT_ARRAYS + 1) * stride * sizeof(float) + 16, 1);
+    if (! _data)
+    {
+        return false;
+    }
+
+    float* arrays = (float*)(((uintptr_t)_data + 15) & ~(uintptr_t)15);
+    setArrays(arrays, stride);
+    _maxCount = count;
+    return true;
+}
+
+void ParticleData::release()
+{
+    CC_SAFE_FREE(_data);
+    setArrays(nullptr, 0);
+    _maxCount = 0;
+}
+
+void ParticleData::setArrays(float* arrays, size_t stride)
+{
+    float** floatArrays[PARTICLE_DATA_FLOAT_ARRAYS] = {
+        &posx, &posy, &startPosX, &startPosY,
+        &colorR, &colorG, &colorB, &colorA,
+        &deltaColorR, &deltaColorG, &deltaColorB, &deltaColorA,
+        &size, &deltaSize, &rotation, &deltaRotation, &timeToLive,
+        &modeA.dirX, &modeA.dirY, &modeA.radialAccel, &modeA.tangentialAccel,
+        &modeB.angle, &modeB.degreesPerSecond, &modeB.radius, &modeB.deltaRadius,
+    };
+    for (int i = 0; i < PARTICLE_DATA_FLOAT_ARRAYS; ++i)
+    {
+        *floatArrays[i] = arrays ? arrays + i * stride : nullptr;
+    }
+    atlasIndex = arrays ? (unsigned int*)(arrays + PARTICLE_DATA_FLOAT_ARRAYS * stride) : nullptr;
+}
+
+void ParticleData::copyParticle(int dst, int src)
+{
+    posx[dst] = posx[src];
+    posy[dst] = posy[src];
+    startPosX[dst] = startPosX[src];
+    startPosY[dst] = startPosY[src];
+
+    colorR[dst] = colorR[src];
+    colorG[dst] = colorG[src];
+    colorB[dst] = colorB[src];
+    colorA[dst] = colorA[src];
+
+    deltaColorR[dst] = deltaColorR[src];
+    deltaColorG[dst] = deltaColorG[src];
+    deltaColorB[dst] = deltaColorB[src];
+    deltaColorA[dst] = deltaColorA[src];
+
+    size[dst] = size[src];
+    deltaSize[dst] = deltaSize[src];
+
+    rotation[dst] = rotation[src];
+    deltaRotation[dst] = deltaRotation[src];
+
+    timeToLive[dst] = timeToLive[src];
+
+    atlasIndex[dst] = atlasIndex[src];
+
+    modeA.dirX[dst] = modeA.dirX[src];
+    modeA.dirY[dst] = modeA.dirY[src];
+    modeA.radialAccel[dst] = modeA.radialAccel[src];
+    modeA.tangentialAccel[dst] = modeA.tangentialAccel[src];
+
+    modeB.angle[dst] = modeB.angle[src];
+    modeB.degreesPerSecond[dst] = modeB.degreesPerSecond[src];
+    modeB.radius[dst] = modeB.radius[src];
+    modeB.deltaRadius[dst] = modeB.deltaRadius[src];
+}
+
 // ideas taken from:
 //     . The ocean spray in your face [Jeff Lander]
 //        http://www.double.co.nz/dust/col0798.pdf
@@ -86,7 +190,6 @@ ParticleSystem::ParticleSystem()
 , _isAutoRemoveOnFinish(false)
 , _plistFile("")
 , _elapsed(0)
-, _particles(nullptr)
 , _configName("")
 , _emitCounter(0)
 , _particleIdx(0)
@@ -119,6 +222,10 @@ ParticleSystem::ParticleSystem()
 , _opacityModifyRGB(false)
 , _yCoordFlipped(1)
 , _positionType(PositionType::FREE)
+, _emitterPosition(Vec2::ZERO)
+, _simulationPending(false)
+, _removeOnUpdate(false)
+, _random(rand())
 {
     modeA.gravity = Vec2::ZERO;
     modeA.speed = 0;
@@ -433,11 +540,7 @@ bool ParticleSystem::initWithTotalParticles(int numberOfParticles)
 {
     _totalParticles = numberOfParticles;
 
-    CC_SAFE_FREE(_particles);
-    
-    _particles = (tParticle*)calloc(_totalParticles, sizeof(tParticle));
-
-    if( ! _particles )
+    if( ! _particleData.init(_totalParticles) )
     {
         CCLOG("Particle system: not enough memory");
         this->release();
@@ -449,7 +552,7 @@ bool ParticleSystem::initWithTotalParticles(int numberOfParticles)
     {
         for (int i = 0; i < _totalParticles; i++)
         {
-            _particles[i].atlasIndex=i;
+            _particleData.atlasIndex[i]=i;
         }
     }
     // default, active
@@ -484,7 +587,7 @@ ParticleSystem::~ParticleSystem()
     // Since the scheduler retains the "target (in this case the ParticleSystem)
 	// it is not needed to call "unscheduleUpdate" here. In fact, it will be called in "cleanup"
     //unscheduleUpdate();
-    CC_SAFE_FREE(_particles);
+    _particleData.release();
     CC_SAFE_RELEASE(_texture);
 }
 
@@ -495,122 +598,124 @@ bool ParticleSystem::addParticle()
         return false;
     }
 
-    tParticle * particle = &_particles[ _particleCount ];
-    this->initParticle(particle);
+    this->initParticle(_particleCount);
     ++_particleCount;
 
     return true;
 }
 
-void ParticleSystem::initParticle(tParticle* particle)
+void ParticleSystem::initParticle(int index)
 {
     // timeToLive
     // no negative life. prevent division by 0
-    particle->timeToLive = _life + _lifeVar * CCRANDOM_MINUS1_1();
-    particle->timeToLive = MAX(0, particle->timeToLive);
+    _particleData.timeToLive[index] = _life + _lifeVar * _random.nextMinus1To1();
+    _particleData.timeToLive[index] = MAX(0, _particleData.timeToLive[index]);
 
     // position
-    particle->pos.x = _sourcePosition.x + _posVar.x * CCRANDOM_MINUS1_1();
+    _particleData.posx[index] = _sourcePosition.x + _posVar.x * _random.nextMinus1To1();
 
-    particle->pos.y = _sourcePosition.y + _posVar.y * CCRANDOM_MINUS1_1();
+    _particleData.posy[index] = _sourcePosition.y + _posVar.y * _random.nextMinus1To1();
 
 
     // Color
     Color4F start;
-    start.r = clampf(_startColor.r + _startColorVar.r * CCRANDOM_MINUS1_1(), 0, 1);
-    start.g = clampf(_startColor.g + _startColorVar.g * CCRANDOM_MINUS1_1(), 0, 1);
-    start.b = clampf(_startColor.b + _startColorVar.b * CCRANDOM_MINUS1_1(), 0, 1);
-    start.a = clampf(_startColor.a + _startColorVar.a * CCRANDOM_MINUS1_1(), 0, 1);
+    start.r = clampf(_startColor.r + _startColorVar.r * _random.nextMinus1To1(), 0, 1);
+    start.g = clampf(_startColor.g + _startColorVar.g * _random.nextMinus1To1(), 0, 1);
+    start.b = clampf(_startColor.b + _startColorVar.b * _random.nextMinus1To1(), 0, 1);
+    start.a = clampf(_startColor.a + _startColorVar.a * _random.nextMinus1To1(), 0, 1);
 
     Color4F end;
-    end.r = clampf(_endColor.r + _endColorVar.r * CCRANDOM_MINUS1_1(), 0, 1);
-    end.g = clampf(_endColor.g + _endColorVar.g * CCRANDOM_MINUS1_1(), 0, 1);
-    end.b = clampf(_endColor.b + _endColorVar.b * CCRANDOM_MINUS1_1(), 0, 1);
-    end.a = clampf(_endColor.a + _endColorVar.a * CCRANDOM_MINUS1_1(), 0, 1);
-
-    particle->color = start;
-    particle->deltaColor.r = (end.r - start.r) / particle->timeToLive;
-    particle->deltaColor.g = (end.g - start.g) / particle->timeToLive;
-    particle->deltaColor.b = (end.b - start.b) / particle->timeToLive;
-    particle->deltaColor.a = (end.a - start.a) / particle->timeToLive;
+    end.r = clampf(_endColor.r + _endColorVar.r * _random.nextMinus1To1(), 0, 1);
+    end.g = clampf(_endColor.g + _endColorVar.g * _random.nextMinus1To1(), 0, 1);
+    end.b = clampf(_endColor.b + _endColorVar.b * _random.nextMinus1To1(), 0, 1);
+    end.a = clampf(_endColor.a + _endColorVar.a * _random.nextMinus1To1(), 0, 1);
+
+    _particleData.colorR[index] = start.r;
+    _particleData.colorG[index] = start.g;
+    _particleData.colorB[index] = start.b;
+    _particleData.colorA[index] = start.a;
+    _particleData.deltaColorR[index] = (end.r - start.r) / _particleData.timeToLive[index];
+    _particleData.deltaColorG[index] = (end.g - start.g) / _particleData.timeToLive[index];
+    _particleData.deltaColorB[index] = (end.b - start.b) / _particleData.timeToLive[index];
+    _particleData.deltaColorA[index] = (end.a - start.a) / _particleData.timeToLive[index];
 
     // size
-    float startS = _startSize + _startSizeVar * CCRANDOM_MINUS1_1();
+    float startS = _startSize + _startSizeVar * _random.nextMinus1To1();
     startS = MAX(0, startS); // No negative value
 
-    particle->size = startS;
+    _particleData.size[index] = startS;
 
     if (_endSize == START_SIZE_EQUAL_TO_END_SIZE)
     {
-        particle->deltaSize = 0;
+        _particleData.deltaSize[index] = 0;
     }
     else
     {
-        float endS = _endSize + _endSizeVar * CCRANDOM_MINUS1_1();
+        float endS = _endSize + _endSizeVar * _random.nextMinus1To1();
         endS = MAX(0, endS); // No negative values
-        particle->deltaSize = (endS - startS) / particle->timeToLive;
+        _particleData.deltaSize[index] = (endS - startS) / _particleData.timeToLive[index];
     }
 
     // rotation
-    float startA = _startSpin + _startSpinVar * CCRANDOM_MINUS1_1();
-    float endA = _endSpin + _endSpinVar * CCRANDOM_MINUS1_1();
-    particle->rotation = startA;
-    particle->deltaRotation = (endA - startA) / particle->timeToLive;
+    float startA = _startSpin + _startSpinVar * _random.nextMinus1To1();
+    float endA = _endSpin + _endSpinVar * _random.nextMinus1To1();
+    _particleData.rotation[index] = startA;
+    _particleData.deltaRotation[index] = (endA - startA) / _particleData.timeToLive[index];
 
     // position
-    if (_positionType == PositionType::FREE)
+    if (_positionType == PositionType::FREE || _positionType == PositionType::RELATIVE)
     {
-        particle->startPos = this->convertToWorldSpace(Vec2::ZERO);
-    }
-    else if (_positionType == PositionType::RELATIVE)
-    {
-        particle->startPos = _position;
+        Vec2 startPos = getEmitterPosition();
+        _particleData.startPosX[index] = startPos.x;
+        _particleData.startPosY[index] = startPos.y;
     }
 
     // direction
-    float a = CC_DEGREES_TO_RADIANS( _angle + _angleVar * CCRANDOM_MINUS1_1() );    
+    float a = CC_DEGREES_TO_RADIANS( _angle + _angleVar * _random.nextMinus1To1() );    
 
     // Mode Gravity: A
     if (_emitterMode == Mode::GRAVITY)
     {
         Vec2 v(cosf( a ), sinf( a ));
-        float s = modeA.speed + modeA.speedVar * CCRANDOM_MINUS1_1();
+        float s = modeA.speed + modeA.speedVar * _random.nextMinus1To1();
 
         // direction
-        particle->modeA.dir = v * s ;
+        Vec2 dir = v * s;
+        _particleData.modeA.dirX[index] = dir.x;
+        _particleData.modeA.dirY[index] = dir.y;
 
         // radial accel
-        particle->modeA.radialAccel = modeA.radialAccel + modeA.radialAccelVar * CCRANDOM_MINUS1_1();
+        _particleData.modeA.radialAccel[index] = modeA.radialAccel + modeA.radialAccelVar * _random.nextMinus1To1();
  
 
         // tangential accel
-        particle->modeA.tangentialAccel = modeA.tangentialAccel + modeA.tangentialAccelVar * CCRANDOM_MINUS1_1();
+        _particleData.modeA.tangentialAccel[index] = modeA.tangentialAccel + modeA.tangentialAccelVar * _random.nextMinus1To1();
 
         // rotation is dir
         if(modeA.rotationIsDir)
-            particle->rotation = -CC_RADIANS_TO_DEGREES(particle->modeA.dir.getAngle());
+            _particleData.rotation[index] = -CC_RADIANS_TO_DEGREES(dir.getAngle());
     }
 
     // Mode Radius: B
     else 
     {
         // Set the default diameter of the particle from the source position
-        float startRadius = modeB.startRadius + modeB.startRadiusVar * CCRANDOM_MINUS1_1();
-        float endRadius = modeB.endRadius + modeB.endRadiusVar * CCRANDOM_MINUS1_1();
+        float startRadius = modeB.startRadius + modeB.startRadiusVar * _random.nextMinus1To1();
+        float endRadius = modeB.endRadius + modeB.endRadiusVar * _random.nextMinus1To1();
 
-        particle->modeB.radius = startRadius;
+        _particleData.modeB.radius[index] = startRadius;
 
         if (modeB.endRadius == START_RADIUS_EQUAL_TO_END_RADIUS)
         {
-            particle->modeB.deltaRadius = 0;
+            _particleData.modeB.deltaRadius[index] = 0;
         }
         else
         {
-            particle->modeB.deltaRadius = (endRadius - startRadius) / particle->timeToLive;
+            _particleData.modeB.deltaRadius[index] = (endRadius - startRadius) / _particleData.timeToLive[index];
         }
 
-        particle->modeB.angle = a;
-        particle->modeB.degreesPerSecond = CC_DEGREES_TO_RADIANS(modeB.rotatePerSecond + modeB.rotatePerSecondVar * CCRANDOM_MINUS1_1());
+        _particleData.modeB.angle[index] = a;
+        _particleData.modeB.degreesPerSecond[index] = CC_DEGREES_TO_RADIANS(modeB.rotatePerSecond + modeB.rotatePerSecondVar * _random.nextMinus1To1());
     }    
 }
 
@@ -630,6 +735,7 @@ void ParticleSystem::onExit()
 
 void ParticleSystem::stopSystem()
 {
+    waitForSimulation();
     _isActive = false;
     _elapsed = _duration;
     _emitCounter = 0;
@@ -637,14 +743,25 @@ void ParticleSystem::stopSystem()
 
 void ParticleSystem::resetSystem()
 {
+    waitForSimulation();
     _isActive = true;
     _elapsed = 0;
+    _emitCounter = 0;
     for (_particleIdx = 0; _particleIdx < _particleCount; ++_particleIdx)
     {
-        tParticle *p = &_particles[_particleIdx];
-        p->timeToLive = 0;
+        _particleData.timeToLive[_particleIdx] = 0;
     }
 }
+void ParticleSystem::setRandomSeed(unsigned int seed)
+{
+    _random.setSeed(seed);
+}
+
+unsigned int ParticleSystem::getRandomSeed() const
+{
+    return _random.getSeed();
+}
+
 bool ParticleSystem::isFull()
 {
     return (_particleCount == _totalParticles);
@@ -655,6 +772,15 @@ void ParticleSystem::update(float dt)
 {
     CC_PROFILER_START_CATEGORY(kProfilerCategoryParticles , "CCParticleSystem - update");
 
+    // the particles of the last update must be moved before the new ones are emitted
+    waitForSimulation();
+    if (_removeOnUpdate)
+    {
+        this->unscheduleUpdate();
+        _parent->removeChild(this, true);
+        return;
+    }
+
     if (_isActive && _emissionRate)
     {
         float rate = 1.0f / _emissionRate;
@@ -677,165 +803,283 @@ void ParticleSystem::update(float dt)
         }
     }
 
-    _particleIdx = 0;
+    _emitterPosition = getEmitterPosition();
 
-    Vec2 currentPosition = Vec2::ZERO;
-    if (_positionType == PositionType::FREE)
-    {
-        currentPosition = this->convertToWorldSpace(Vec2::ZERO);
-    }
-    else if (_positionType == PositionType::RELATIVE)
+    // the emitters of a batch node write the quads of the batch node, they are simulated here
+    if (! _batchNode && _particleCount > 0 && ParticleJobSystem::getInstance()->isEnabled())
     {
-        currentPosition = _position;
+        ParticleJobSystem::getInstance()->addJob(this, dt);
+        _simulationPending = true;
     }
-
+    else
     {
-        while (_particleIdx < _particleCount)
+        if (simulate(dt))
         {
-            tParticle *p = &_particles[_particleIdx];
+            this->unscheduleUpdate();
+            _parent->removeChild(this, true);
+            return;
+        }
+        finishSimulation(false);
+    }
 
-            // life
-            p->timeToLive -= dt;
+    CC_PROFILER_STOP_CATEGORY(kProfilerCategoryParticles , "CCParticleSystem - update");
+}
 
-            if (p->timeToLive > 0) 
-            {
-                // Mode A: gravity, direction, tangential accel & radial accel
-                if (_emitterMode == Mode::GRAVITY)
-                {
-                    Vec2 tmp, radial, tangential;
+bool ParticleSystem::simulate(float dt)
+{
+    // life
+    for (int i = 0; i < _particleCount; ++i)
+    {
+        _particleData.timeToLive[i] -= dt;
+    }
 
-                    radial = Vec2::ZERO;
-                    // radial acceleration
-                    if (p->pos.x || p->pos.y)
-                    {
-                        radial = p->pos.getNormalized();
-                    }
-                    tangential = radial;
-                    radial = radial * p->modeA.radialAccel;
-
-                    // tangential acceleration
-                    float newy = tangential.x;
-                    tangential.x = -tangential.y;
-                    tangential.y = newy;
-                    tangential = tangential * p->modeA.tangentialAccel;
-
-                    // (gravity + radial + tangential) * dt
-                    tmp = radial + tangential + modeA.gravity;
-                    tmp = tmp * dt;
-                    p->modeA.dir = p->modeA.dir + tmp;
-                    
-                    // this is cocos2d-x v3.0
-//                    if (_configName.length()>0 && _yCoordFlipped != -1)
+    // the dead particles are replaced by the last ones
+    _particleIdx = 0;
+    while (_particleIdx < _particleCount)
+    {
+        if (_particleData.timeToLive[_particleIdx] > 0)
+        {
+            ++_particleIdx;
+            continue;
+        }
 
-                    // this is cocos2d-x v3.0
-                    tmp = p->modeA.dir * dt * _yCoordFlipped;
-                    p->pos = p->pos + tmp;
-                }
+        // life < 0
+        unsigned int currentIndex = _particleData.atlasIndex[_particleIdx];
+        if( _particleIdx != _particleCount-1 )
+        {
+            _particleData.copyParticle(_particleIdx, _particleCount-1);
+        }
+        if (_batchNode)
+        {
+            //disable the switched particle
+            _batchNode->disableParticle(_atlasIndex+currentIndex);
 
-                // Mode B: radius movement
-                else 
-                {                
-                    // Update the angle and radius of the particle.
-                    p->modeB.angle += p->modeB.degreesPerSecond * dt;
-                    p->modeB.radius += p->modeB.deltaRadius * dt;
+            //switch indexes
+            _particleData.atlasIndex[_particleCount-1] = currentIndex;
+        }
 
-                    p->pos.x = - cosf(p->modeB.angle) * p->modeB.radius;
-                    p->pos.y = - sinf(p->modeB.angle) * p->modeB.radius;
-                    p->pos.y *= _yCoordFlipped;
-				}
+        --_particleCount;
 
-                // color
-                p->color.r += (p->deltaColor.r * dt);
-                p->color.g += (p->deltaColor.g * dt);
-                p->color.b += (p->deltaColor.b * dt);
-                p->color.a += (p->deltaColor.a * dt);
+        if( _particleCount == 0 && _isAutoRemoveOnFinish )
+        {
+            return true;
+        }
+    }
 
-                // size
-                p->size += (p->deltaSize * dt);
-                p->size = MAX( 0, p->size );
+    if (_particleCount > 0)
+    {
+        // Mode A: gravity, direction, tangential accel & radial accel
+        if (_emitterMode == Mode::GRAVITY)
+        {
+            updateGravityMode(dt);
+        }
+        // Mode B: radius movement
+        else
+        {
+            updateRadiusMode(dt);
+        }
+        updateCommonValues(dt);
 
-                // angle
-                p->rotation += (p->deltaRotation * dt);
+        updateParticleQuads();
+    }
+    _transformSystemDirty = false;
+    return false;
+}
 
-                //
-                // update values in quad
-                //
+void ParticleSystem::finishSimulation(bool removeOnUpdate)
+{
+    _simulationPending = false;
+    _removeOnUpdate = removeOnUpdate;
 
-                Vec2    newPos;
+    // only update gl buffer when visible
+    if (_visible && ! _batchNode)
+    {
+        postStep();
+    }
+}
 
-                if (_positionType == PositionType::FREE || _positionType == PositionType::RELATIVE)
-                {
-                    Vec2 diff = currentPosition - p->startPos;
-                    newPos = p->pos - diff;
-                } 
-                else
-                {
-                    newPos = p->pos;
-                }
+void ParticleSystem::waitForSimulation()
+{
+    if (_simulationPending)
+    {
+        ParticleJobSystem::getInstance()->wait();
+    }
+}
 
-                // translate newPos to correct position, since matrix transform isn't performed in batchnode
-                // don't update the particle with the new position information, it will interfere with the radius and tangential calculations
-                if (_batchNode)
-                {
-                    newPos.x+=_position.x;
-                    newPos.y+=_position.y;
-                }
+void ParticleSystem::updateWithNoTime(void)
+{
+    this->update(0.0f);
+}
 
-                updateQuadWithParticle(p, newPos);
-                //updateParticleImp(self, updateParticleSel, p, newPos);
+Vec2 ParticleSystem::getEmitterPosition()
+{
+    if (_positionType == PositionType::FREE)
+    {
+        return this->convertToWorldSpace(Vec2::ZERO);
+    }
+    else if (_positionType == PositionType::RELATIVE)
+    {
+        return _position;
+    }
+    return Vec2::ZERO;
+}
+
+// The particles are updated 4 at a time in the SSE versions, the arrays of ParticleData being
+// allocated for a multiple of 4 particles. The operations are done in the order of the Vec2
+// operators, so that both versions move the particles the same way.
+
+void ParticleSystem::updateGravityMode(float dt)
+{
+    float* posx = _particleData.posx;
+    float* posy = _particleData.posy;
+    float* dirX = _particleData.modeA.dirX;
+    float* dirY = _particleData.modeA.dirY;
+    const float* radialAccel = _particleData.modeA.radialAccel;
+    const float* tangentialAccel = _particleData.modeA.tangentialAccel;
+    const float yCoordFlipped = _yCoordFlipped;
+
+#if CC_PARTICLE_USE_SSE
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    const __m128 tolerance = _mm_set1_ps(MATH_TOLERANCE);
+    const __m128 gravityX = _mm_set1_ps(modeA.gravity.x);
+    const __m128 gravityY = _mm_set1_ps(modeA.gravity.y);
+    const __m128 delta = _mm_set1_ps(dt);
+    const __m128 flipped = _mm_set1_ps(yCoordFlipped);
+    for (int i = 0; i < _particleCount; i += 4)
+    {
+        __m128 x = _mm_load_ps(posx + i);
+        __m128 y = _mm_load_ps(posy + i);
+
+        // radial = pos.getNormalized(), which keeps the vectors too close to zero, or zero for the origin
+        __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)));
+        __m128 inverse = _mm_div_ps(one, length);
+        __m128 tooSmall = _mm_cmplt_ps(length, tolerance);
+        __m128 notOrigin = _mm_or_ps(_mm_cmpneq_ps(x, zero), _mm_cmpneq_ps(y, zero));
+        __m128 radialX = _mm_or_ps(_mm_and_ps(tooSmall, x), _mm_andnot_ps(tooSmall, _mm_mul_ps(x, inverse)));
+        __m128 radialY = _mm_or_ps(_mm_and_ps(tooSmall, y), _mm_andnot_ps(tooSmall, _mm_mul_ps(y, inverse)));
+        radialX = _mm_and_ps(notOrigin, radialX);
+        radialY = _mm_and_ps(notOrigin, radialY);
+
+        // tangential acceleration, perpendicular to the radial one
+        __m128 tangential = _mm_load_ps(tangentialAccel + i);
+        __m128 tangentialX = _mm_mul_ps(_mm_xor_ps(radialY, signMask), tangential);
+        __m128 tangentialY = _mm_mul_ps(radialX, tangential);
+        __m128 radial = _mm_load_ps(radialAccel + i);
+        radialX = _mm_mul_ps(radialX, radial);
+        radialY = _mm_mul_ps(radialY, radial);
+
+        // (gravity + radial + tangential) * dt
+        __m128 dx = _mm_add_ps(_mm_load_ps(dirX + i), _mm_mul_ps(_mm_add_ps(_mm_add_ps(radialX, tangentialX), gravityX), delta));
+        __m128 dy = _mm_add_ps(_mm_load_ps(dirY + i), _mm_mul_ps(_mm_add_ps(_mm_add_ps(radialY, tangentialY), gravityY), delta));
+        _mm_store_ps(dirX + i, dx);
+        _mm_store_ps(dirY + i, dy);
+
+        _mm_store_ps(posx + i, _mm_add_ps(x, _mm_mul_ps(_mm_mul_ps(dx, delta), flipped)));
+        _mm_store_ps(posy + i, _mm_add_ps(y, _mm_mul_ps(_mm_mul_ps(dy, delta), flipped)));
+    }
+#else
+    for (int i = 0; i < _particleCount; ++i)
+    {
+        Vec2 radial = Vec2::ZERO;
+        // radial acceleration
+        if (posx[i] || posy[i])
+        {
+            radial = Vec2(posx[i], posy[i]).getNormalized();
+        }
+        // tangential acceleration
+        Vec2 tangential(-radial.y, radial.x);
+        tangential = tangential * tangentialAccel[i];
+        radial = radial * radialAccel[i];
+
+        // (gravity + radial + tangential) * dt
+        Vec2 tmp = (radial + tangential + modeA.gravity) * dt;
+        dirX[i] += tmp.x;
+        dirY[i] += tmp.y;
+
+        posx[i] += dirX[i] * dt * yCoordFlipped;
+        posy[i] += dirY[i] * dt * yCoordFlipped;
+    }
+#endif
+}
 
-                // update particle counter
-                ++_particleIdx;
-            } 
-            else 
-            {
-                // life < 0
-                int currentIndex = p->atlasIndex;
-                if( _particleIdx != _particleCount-1 )
-                {
-                    _particles[_particleIdx] = _particles[_particleCount-1];
-                }
-                if (_batchNode)
-                {
-                    //disable the switched particle
-                    _batchNode->disableParticle(_atlasIndex+currentIndex);
+void ParticleSystem::updateRadiusMode(float dt)
+{
+    float* posx = _particleData.posx;
+    float* posy = _particleData.posy;
+    float* angle = _particleData.modeB.angle;
+    float* radius = _particleData.modeB.radius;
+    const float* degreesPerSecond = _particleData.modeB.degreesPerSecond;
+    const float* deltaRadius = _particleData.modeB.deltaRadius;
+    const float yCoordFlipped = _yCoordFlipped;
 
-                    //switch indexes
-                    _particles[_particleCount-1].atlasIndex = currentIndex;
-                }
+    // the sine and cosine are those of the C library in both versions
+    for (int i = 0; i < _particleCount; ++i)
+    {
+        // Update the angle and radius of the particle.
+        angle[i] += degreesPerSecond[i] * dt;
+        radius[i] += deltaRadius[i] * dt;
+    }
+    for (int i = 0; i < _particleCount; ++i)
+    {
+        posx[i] = - cosf(angle[i]) * radius[i];
+        posy[i] = - sinf(angle[i]) * radius[i] * yCoordFlipped;
+    }
+}
 
+void ParticleSystem::updateCommonValues(float dt)
+{
+    float* values[] = {
+        _particleData.colorR, _particleData.colorG, _particleData.colorB, _particleData.colorA,
+        _particleData.rotation, _particleData.size,
+    };
+    const float* deltas[] = {
+        _particleData.deltaColorR, _particleData.deltaColorG, _particleData.deltaColorB, _particleData.deltaColorA,
+        _particleData.deltaRotation, _particleData.deltaSize,
+    };
+    const int valueCount = sizeof(values) / sizeof(values[0]);
 
-                --_particleCount;
+#if CC_PARTICLE_USE_SSE
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 delta = _mm_set1_ps(dt);
+    for (int v = 0; v < valueCount; ++v)
+    {
+        float* value = values[v];
+        const float* valueDelta = deltas[v];
+        for (int i = 0; i < _particleCount; i += 4)
+        {
+            _mm_store_ps(value + i, _mm_add_ps(_mm_load_ps(value + i), _mm_mul_ps(_mm_load_ps(valueDelta + i), delta)));
+        }
+    }
 
-                if( _particleCount == 0 && _isAutoRemoveOnFinish )
-                {
-                    this->unscheduleUpdate();
-                    _parent->removeChild(this, true);
-                    return;
-                }
-            }
-        } //while
-        _transformSystemDirty = false;
+    // no negative size
+    float* size = _particleData.size;
+    for (int i = 0; i < _particleCount; i += 4)
+    {
+        _mm_store_ps(size + i, _mm_max_ps(_mm_load_ps(size + i), zero));
     }
-    
-    // only update gl buffer when visible
-    if (_visible && ! _batchNode)
+#else
+    for (int v = 0; v < valueCount; ++v)
     {
-        postStep();
+        float* value = values[v];
+        const float* valueDelta = deltas[v];
+        for (int i = 0; i < _particleCount; ++i)
+        {
+            value[i] += valueDelta[i] * dt;
+        }
     }
 
-    CC_PROFILER_STOP_CATEGORY(kProfilerCategoryParticles , "CCParticleSystem - update");
-}
-
-void ParticleSystem::updateWithNoTime(void)
-{
-    this->update(0.0f);
+    float* size = _particleData.size;
+    for (int i = 0; i < _particleCount; ++i)
+    {
+        size[i] = MAX(0, size[i]);
+    }
+#endif
 }
 
-void ParticleSystem::updateQuadWithParticle(tParticle* particle, const Vec2& newPosition)
+void ParticleSystem::updateParticleQuads()
 {
-    CC_UNUSED_PARAM(particle);
-    CC_UNUSED_PARAM(newPosition);
     // should be overridden
 }
 
@@ -847,6 +1091,7 @@ void ParticleSystem::postStep()
 // ParticleSystem - Texture protocol
 void ParticleSystem::setTexture(Texture2D* var)
 {
+    waitForSimulation();
     if (_texture != var)
     {
         CC_SAFE_RETAIN(var);
@@ -859,6 +1104,8 @@ void ParticleSystem::setTexture(Texture2D* var)
 void ParticleSystem::updateBlendFunc()
 {
     CCASSERT(! _batchNode, "Can't change blending functions when the particle is being batched");
+    // _opacityModifyRGB is read by the simulation
+    waitForSimulation();
 
     if(_texture)
     {
@@ -970,6 +1217,7 @@ bool ParticleSystem::getRotationIsDir() const
 void ParticleSystem::setGravity(const Vec2& g)
 {
     CCASSERT(_emitterMode == Mode::GRAVITY, "Particle Mode should be Gravity");
+    waitForSimulation();
     modeA.gravity = g;
 }
 
@@ -1088,6 +1336,7 @@ int ParticleSystem::getTotalParticles() const
 
 void ParticleSystem::setTotalParticles(int var)
 {
+    waitForSimulation();
     CCASSERT( var <= _allocatedParticles, "Particle: resizing particle array only supported for quads");
     _totalParticles = var;
 }
@@ -1112,6 +1361,7 @@ bool ParticleSystem::isAutoRemoveOnFinish() const
 
 void ParticleSystem::setAutoRemoveOnFinish(bool var)
 {
+    waitForSimulation();
     _isAutoRemoveOnFinish = var;
 }
 
@@ -1125,6 +1375,7 @@ ParticleBatchNode* ParticleSystem::getBatchNode(void) const
 
 void ParticleSystem::setBatchNode(ParticleBatchNode* batchNode)
 {
+    waitForSimulation();
     if( _batchNode != batchNode ) {
 
         _batchNode = batchNode; // weak reference
@@ -1133,7 +1384,7 @@ void ParticleSystem::setBatchNode(ParticleBatchNode* batchNode)
             //each particle needs a unique index
             for (int i = 0; i < _totalParticles; i++)
             {
-                _particles[i].atlasIndex=i;
+                _particleData.atlasIndex[i]=i;
             }
         }
     }
@@ -1142,24 +1393,28 @@ void ParticleSystem::setBatchNode(ParticleBatchNode* batchNode)
 //don't use a transform matrix, this is faster
 void ParticleSystem::setScale(float s)
 {
+    waitForSimulation();
     _transformSystemDirty = true;
     Node::setScale(s);
 }
 
 void ParticleSystem::setRotation(float newRotation)
 {
+    waitForSimulation();
     _transformSystemDirty = true;
     Node::setRotation(newRotation);
 }
 
 void ParticleSystem::setScaleX(float newScaleX)
 {
+    waitForSimulation();
     _transformSystemDirty = true;
     Node::setScaleX(newScaleX);
 }
 
 void ParticleSystem::setScaleY(float newScaleY)
 {
+    waitForSimulation();
     _transformSystemDirty = true;
     Node::setScaleY(newScaleY);
 }
@@ -30,6 +30,7 @@ THE SOFTWARE.
 #include "base/CCProtocols.h"
 #include "2d/CCNode.h"
 #include "base/CCValue.h"
+#include "base/CCRandomGenerator.h"
 #include "deprecated/CCString.h"
 
 NS_CC_BEGIN
@@ -42,43 +43,75 @@ NS_CC_BEGIN
 class ParticleBatchNode;
 
 /**
-Structure that contains the values of each particle
+Structure that contains the values of the particles, one array per value.
+The arrays are allocated for a multiple of 4 particles and aligned on 16 bytes, so that
+the particles are updated 4 at a time.
 */
-typedef struct sParticle {
-    Vec2     pos;
-    Vec2     startPos;
+class CC_DLL ParticleData
+{
+public:
+    float* posx;
+    float* posy;
+    float* startPosX;
+    float* startPosY;
+
+    float* colorR;
+    float* colorG;
+    float* colorB;
+    float* colorA;
 
-    Color4F    color;
-    Color4F    deltaColor;
+    float* deltaColorR;
+    float* deltaColorG;
+    float* deltaColorB;
+    float* deltaColorA;
 
-    float        size;
-    float        deltaSize;
+    float* size;
+    float* deltaSize;
 
-    float        rotation;
-    float        deltaRotation;
+    float* rotation;
+    float* deltaRotation;
 
-    float        timeToLive;
+    float* timeToLive;
 
-    unsigned int    atlasIndex;
+    unsigned int* atlasIndex;
 
     //! Mode A: gravity, direction, radial accel, tangential accel
     struct {
-        Vec2        dir;
-        float        radialAccel;
-        float        tangentialAccel;
+        float* dirX;
+        float* dirY;
+        float* radialAccel;
+        float* tangentialAccel;
     } modeA;
 
     //! Mode B: radius mode
     struct {
-        float        angle;
-        float        degreesPerSecond;
-        float        radius;
-        float        deltaRadius;
+        float* angle;
+        float* degreesPerSecond;
+        float* radius;
+        float* deltaRadius;
     } modeB;
 
-}tParticle;
+    ParticleData();
+    ~ParticleData();
+
+    /** allocates the arrays of count particles, all their values are 0 */
+    bool init(int count);
+    /** frees the arrays */
+    void release();
+
+    inline int getMaxCount() const { return _maxCount; };
 
-//typedef void (*CC_UPDATE_PARTICLE_IMP)(id, SEL, tParticle*, Vec2);
+    /** copies the values of the particle src into the particle dst */
+    void copyParticle(int dst, int src);
+
+private:
+    void setArrays(float* arrays, size_t stride);
+
+    void* _data;
+    int _maxCount;
+
+    CC_DISALLOW_COPY_AND_ASSIGN(ParticleData);
+};
 
 class Texture2D;
 
@@ -182,8 +215,8 @@ public:
 
     //! Add a particle to the emitter
     bool addParticle();
-    //! Initializes a particle
-    void initParticle(tParticle* particle);
+    //! Initializes the particle at index in the particle data
+    void initParticle(int index);
     //! stop emitting particles. Running particles will continue to run until they die
     void stopSystem();
     //! Kill all living particles.
@@ -191,8 +224,17 @@ public:
     //! whether or not the system is full
     bool isFull();
 
-    //! should be overridden by subclasses
-    virtual void updateQuadWithParticle(tParticle* particle, const Vec2& newPosition);
+    /** Sets the seed of the random values of the new particles. Each emitter has its own generator, seeded with
+     rand() when it is created. Calling resetSystem() and setting the seed again replays the same particles,
+     given the same updates, unless the emitter was full: the particles killed by resetSystem() are only removed
+     by the next update, after it emits.
+     @since v3.2
+     */
+    void setRandomSeed(unsigned int seed);
+    unsigned int getRandomSeed() const;
+
+    //! should be overridden by subclasses, updates the quads of the _particleCount living particles
+    virtual void updateParticleQuads();
     //! should be overridden by subclasses
     virtual void postStep();
 
@@ -284,7 +326,7 @@ public:
      - kParticleModeRadius: uses radius movement + rotation
      */
     inline Mode getEmitterMode() const { return _emitterMode; };
-    inline void setEmitterMode(Mode mode) { _emitterMode = mode; };
+    inline void setEmitterMode(Mode mode) { waitForSimulation(); _emitterMode = mode; };
     
     /** start size in pixels of each particle */
     inline float getStartSize() const { return _startSize; };
@@ -343,7 +385,7 @@ public:
     virtual void setTotalParticles(int totalParticles);
 
     /** does the alpha value modify color */
-    inline void setOpacityModifyRGB(bool opacityModifyRGB) { _opacityModifyRGB = opacityModifyRGB; };
+    inline void setOpacityModifyRGB(bool opacityModifyRGB) { waitForSimulation(); _opacityModifyRGB = opacityModifyRGB; };
     inline bool isOpacityModifyRGB() const { return _opacityModifyRGB; };
     CC_DEPRECATED_ATTRIBUTE inline bool getOpacityModifyRGB() const { return isOpacityModifyRGB(); }
     
@@ -351,7 +393,7 @@ public:
      @since v0.8
      */
     inline PositionType getPositionType() const { return _positionType; };
-    inline void setPositionType(PositionType type) { _positionType = type; };
+    inline void setPositionType(PositionType type) { waitForSimulation(); _positionType = type; };
     
     // Overrides
     virtual void onEnter() override;
@@ -409,6 +451,26 @@ CC_CONSTRUCTOR_ACCESS:
 protected:
     virtual void updateBlendFunc();
 
+    /** returns the position particles are emitted from, used to move the particles of the FREE and RELATIVE types */
+    Vec2 getEmitterPosition();
+
+    /** moves the particles during dt and updates their quads, on a worker thread when the simulation is a job of
+     the ParticleJobSystem. Returns true when the last particle died and the system must remove itself
+     */
+    bool simulate(float dt);
+    /** called on the cocos2d thread once the particles are simulated */
+    void finishSimulation(bool removeOnUpdate);
+    /** Waits for the job simulating the particles, before they are drawn or changed. Called by the setters of the values the
+     simulation reads: the mode, the gravity, the position type, the blending, the texture rect and the transform. The other
+     values are only read when the particles are emitted, by update() once the simulation is done.
+     */
+    void waitForSimulation();
+
+    // updates the particles of each mode, and the values common to both modes
+    void updateGravityMode(float dt);
+    void updateRadiusMode(float dt);
+    void updateCommonValues(float dt);
+
     /** whether or not the particles are using blend additive.
      If enabled, the following blending function will be used.
      @code
@@ -465,8 +527,8 @@ protected:
         float rotatePerSecondVar;
     } modeB;
 
-    //! Array of particles
-    tParticle *_particles;
+    //! Values of the particles
+    ParticleData _particleData;
 
     //Emitter name
     std::string _configName;
@@ -564,6 +626,17 @@ protected:
      */
     PositionType _positionType;
 
+    /** position of the emitter at the last update, see getEmitterPosition() */
+    Vec2 _emitterPosition;
+    /** whether a job of the ParticleJobSystem simulates the particles */
+    bool _simulationPending;
+    /** whether the last particle died in a job, the system removes itself at its next update */
+    bool _removeOnUpdate;
+    /** generator of the random values of the particles, see setRandomSeed() */
+    RandomGenerator _random;
+
+    friend class ParticleJobSystem;
+
 private:
     CC_DISALLOW_COPY_AND_ASSIGN(ParticleSystem);
 };
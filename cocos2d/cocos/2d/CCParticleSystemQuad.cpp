@@ -46,6 +46,13 @@ THE SOFTWARE.
 #include "base/CCEventListenerCustom.h"
 #include "base/CCEventDispatcher.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CC_PARTICLE_USE_SSE 1
+#else
+#define CC_PARTICLE_USE_SSE 0
+#endif
+
 NS_CC_BEGIN
 
 ParticleSystemQuad::ParticleSystemQuad()
@@ -147,6 +154,8 @@ bool ParticleSystemQuad::initWithTotalParticles(int numberOfParticles)
 // pointRect should be in Texture coordinates, not pixel coordinates
 void ParticleSystemQuad::initTexCoordsWithRect(const Rect& pointRect)
 {
+    waitForSimulation();
+
     // convert to Tex coords
 
     Rect rect = Rect(
@@ -265,41 +274,25 @@ void ParticleSystemQuad::initIndices()
     }
 }
 
-void ParticleSystemQuad::updateQuadWithParticle(tParticle* particle, const Vec2& newPosition)
+// sets the vertices and the color of the quad of a particle
+static inline void updateParticleQuad(V3F_C4B_T2F_Quad* quad, float x, float y, float size, float rotation, const Color4B& color)
 {
-    V3F_C4B_T2F_Quad *quad;
-
-    if (_batchNode)
-    {
-        V3F_C4B_T2F_Quad *batchQuads = _batchNode->getTextureAtlas()->getQuads();
-        quad = &(batchQuads[_atlasIndex+particle->atlasIndex]);
-    }
-    else
-    {
-        quad = &(_quads[_particleIdx]);
-    }
-    Color4B color = (_opacityModifyRGB)
-        ? Color4B( particle->color.r*particle->color.a*255, particle->color.g*particle->color.a*255, particle->color.b*particle->color.a*255, particle->color.a*255)
-        : Color4B( particle->color.r*255, particle->color.g*255, particle->color.b*255, particle->color.a*255);
-
     quad->bl.colors = color;
     quad->br.colors = color;
     quad->tl.colors = color;
     quad->tr.colors = color;
 
     // vertices
-    GLfloat size_2 = particle->size/2;
-    if (particle->rotation) 
+    GLfloat size_2 = size/2;
+    if (rotation) 
     {
         GLfloat x1 = -size_2;
         GLfloat y1 = -size_2;
 
         GLfloat x2 = size_2;
         GLfloat y2 = size_2;
-        GLfloat x = newPosition.x;
-        GLfloat y = newPosition.y;
 
-        GLfloat r = (GLfloat)-CC_DEGREES_TO_RADIANS(particle->rotation);
+        GLfloat r = (GLfloat)-CC_DEGREES_TO_RADIANS(rotation);
         GLfloat cr = cosf(r);
         GLfloat sr = sinf(r);
         GLfloat ax = x1 * cr - y1 * sr + x;
@@ -330,22 +323,130 @@ void ParticleSystemQuad::updateQuadWithParticle(tParticle* particle, const Vec2&
     else 
     {
         // bottom-left vertex:
-        quad->bl.vertices.x = newPosition.x - size_2;
-        quad->bl.vertices.y = newPosition.y - size_2;
+        quad->bl.vertices.x = x - size_2;
+        quad->bl.vertices.y = y - size_2;
 
         // bottom-right vertex:
-        quad->br.vertices.x = newPosition.x + size_2;
-        quad->br.vertices.y = newPosition.y - size_2;
+        quad->br.vertices.x = x + size_2;
+        quad->br.vertices.y = y - size_2;
 
         // top-left vertex:
-        quad->tl.vertices.x = newPosition.x - size_2;
-        quad->tl.vertices.y = newPosition.y + size_2;
+        quad->tl.vertices.x = x - size_2;
+        quad->tl.vertices.y = y + size_2;
 
         // top-right vertex:
-        quad->tr.vertices.x = newPosition.x + size_2;
-        quad->tr.vertices.y = newPosition.y + size_2;                
+        quad->tr.vertices.x = x + size_2;
+        quad->tr.vertices.y = y + size_2;                
     }
 }
+
+void ParticleSystemQuad::updateParticleQuads()
+{
+    if (_particleCount <= 0)
+    {
+        return;
+    }
+
+    // the particles of the FREE and RELATIVE types are moved with the emitter
+    bool moveWithEmitter = _positionType == PositionType::FREE || _positionType == PositionType::RELATIVE;
+    const Vec2& currentPosition = _emitterPosition;
+
+    V3F_C4B_T2F_Quad *quads = _quads;
+    if (_batchNode)
+    {
+        quads = _batchNode->getTextureAtlas()->getQuads() + _atlasIndex;
+    }
+
+    const float* posx = _particleData.posx;
+    const float* posy = _particleData.posy;
+    const float* startPosX = _particleData.startPosX;
+    const float* startPosY = _particleData.startPosY;
+    const float* colorR = _particleData.colorR;
+    const float* colorG = _particleData.colorG;
+    const float* colorB = _particleData.colorB;
+    const float* colorA = _particleData.colorA;
+    const float* size = _particleData.size;
+    const float* rotation = _particleData.rotation;
+    const unsigned int* atlasIndex = _particleData.atlasIndex;
+
+#if CC_PARTICLE_USE_SSE
+    // the positions and the colors of 4 particles are computed at once, then set in their quads
+    const __m128 currentX = _mm_set1_ps(currentPosition.x);
+    const __m128 currentY = _mm_set1_ps(currentPosition.y);
+    const __m128 positionX = _mm_set1_ps(_position.x);
+    const __m128 positionY = _mm_set1_ps(_position.y);
+    const __m128 maxColor = _mm_set1_ps(255.0f);
+    float x[4];
+    float y[4];
+    Color4B colors[4];
+    for (int i = 0; i < _particleCount; i += 4)
+    {
+        __m128 newX = _mm_load_ps(posx + i);
+        __m128 newY = _mm_load_ps(posy + i);
+        if (moveWithEmitter)
+        {
+            newX = _mm_sub_ps(newX, _mm_sub_ps(currentX, _mm_load_ps(startPosX + i)));
+            newY = _mm_sub_ps(newY, _mm_sub_ps(currentY, _mm_load_ps(startPosY + i)));
+        }
+        // translate newPos to correct position, since matrix transform isn't performed in batchnode
+        if (_batchNode)
+        {
+            newX = _mm_add_ps(newX, positionX);
+            newY = _mm_add_ps(newY, positionY);
+        }
+        _mm_storeu_ps(x, newX);
+        _mm_storeu_ps(y, newY);
+
+        __m128 r = _mm_load_ps(colorR + i);
+        __m128 g = _mm_load_ps(colorG + i);
+        __m128 b = _mm_load_ps(colorB + i);
+        __m128 a = _mm_load_ps(colorA + i);
+        if (_opacityModifyRGB)
+        {
+            r = _mm_mul_ps(r, a);
+            g = _mm_mul_ps(g, a);
+            b = _mm_mul_ps(b, a);
+        }
+        __m128i rb = _mm_packs_epi32(_mm_cvttps_epi32(_mm_mul_ps(r, maxColor)), _mm_cvttps_epi32(_mm_mul_ps(b, maxColor)));
+        __m128i ga = _mm_packs_epi32(_mm_cvttps_epi32(_mm_mul_ps(g, maxColor)), _mm_cvttps_epi32(_mm_mul_ps(a, maxColor)));
+        __m128i rg = _mm_unpacklo_epi16(rb, ga);
+        __m128i ba = _mm_unpackhi_epi16(rb, ga);
+        __m128i rgba = _mm_packus_epi16(_mm_unpacklo_epi32(rg, ba), _mm_unpackhi_epi32(rg, ba));
+        _mm_storeu_si128((__m128i*)colors, rgba);
+
+        int count = MIN(4, _particleCount - i);
+        for (int j = 0; j < count; ++j)
+        {
+            V3F_C4B_T2F_Quad *quad = _batchNode ? &quads[atlasIndex[i + j]] : &quads[i + j];
+            updateParticleQuad(quad, x[j], y[j], size[i + j], rotation[i + j], colors[j]);
+        }
+    }
+#else
+    for (int i = 0; i < _particleCount; ++i)
+    {
+        Vec2 newPos(posx[i], posy[i]);
+        if (moveWithEmitter)
+        {
+            Vec2 diff = currentPosition - Vec2(startPosX[i], startPosY[i]);
+            newPos = newPos - diff;
+        }
+        // translate newPos to correct position, since matrix transform isn't performed in batchnode
+        if (_batchNode)
+        {
+            newPos.x += _position.x;
+            newPos.y += _position.y;
+        }
+
+        Color4B color = (_opacityModifyRGB)
+            ? Color4B( colorR[i]*colorA[i]*255, colorG[i]*colorA[i]*255, colorB[i]*colorA[i]*255, colorA[i]*255)
+            : Color4B( colorR[i]*255, colorG[i]*255, colorB[i]*255, colorA[i]*255);
+
+        V3F_C4B_T2F_Quad *quad = _batchNode ? &quads[atlasIndex[i]] : &quads[i];
+        updateParticleQuad(quad, newPos.x, newPos.y, size[i], rotation[i], color);
+    }
+#endif
+}
+
 void ParticleSystemQuad::postStep()
 {
     glBindBuffer(GL_ARRAY_BUFFER, _buffersVBO[0]);
@@ -370,10 +471,14 @@ void ParticleSystemQuad::postStep()
 // overriding draw method
 void ParticleSystemQuad::draw(Renderer *renderer, const Mat4 &transform, bool transformUpdated)
 {
+    // the number of quads is known once the particles are simulated
+    waitForSimulation();
+
     CCASSERT( _particleIdx == 0 || _particleIdx == _particleCount, "Abnormal error in particle quad");
     //quad command
     if(_particleIdx > 0)
     {
+        _texture->setLastUsedFrame(Director::getInstance()->getTotalFrames());
         _quadCommand.init(_globalZOrder, _texture->getName(), getGLProgramState(), _blendFunc, _quads, _particleIdx, transform);
         renderer->addCommand(&_quadCommand);
     }
@@ -381,28 +486,27 @@ void ParticleSystemQuad::draw(Renderer *renderer, const Mat4 &transform, bool tr
 
 void ParticleSystemQuad::setTotalParticles(int tp)
 {
+    waitForSimulation();
+
     // If we are setting the total number of particles to a number higher
     // than what is allocated, we need to allocate new arrays
     if( tp > _allocatedParticles )
     {
         // Allocate new memory
-        size_t particlesSize = tp * sizeof(tParticle);
         size_t quadsSize = sizeof(_quads[0]) * tp * 1;
         size_t indicesSize = sizeof(_indices[0]) * tp * 6 * 1;
 
-        tParticle* particlesNew = (tParticle*)realloc(_particles, particlesSize);
+        bool particlesAllocated = _particleData.init(tp);
         V3F_C4B_T2F_Quad* quadsNew = (V3F_C4B_T2F_Quad*)realloc(_quads, quadsSize);
         GLushort* indicesNew = (GLushort*)realloc(_indices, indicesSize);
 
-        if (particlesNew && quadsNew && indicesNew)
+        if (particlesAllocated && quadsNew && indicesNew)
         {
             // Assign pointers
-            _particles = particlesNew;
             _quads = quadsNew;
             _indices = indicesNew;
 
             // Clear the memory
-            memset(_particles, 0, particlesSize);
             memset(_quads, 0, quadsSize);
             memset(_indices, 0, indicesSize);
             
@@ -411,7 +515,7 @@ void ParticleSystemQuad::setTotalParticles(int tp)
         else
         {
             // Out of memory, failed to resize some array
-            if (particlesNew) _particles = particlesNew;
+            if (! particlesAllocated) _particleData.init(_allocatedParticles);
             if (quadsNew) _quads = quadsNew;
             if (indicesNew) _indices = indicesNew;
 
@@ -426,7 +530,7 @@ void ParticleSystemQuad::setTotalParticles(int tp)
         {
             for (int i = 0; i < _totalParticles; i++)
             {
-                _particles[i].atlasIndex=i;
+                _particleData.atlasIndex[i]=i;
             }
         }
 
@@ -548,6 +652,8 @@ bool ParticleSystemQuad::allocMemory()
 
 void ParticleSystemQuad::setBatchNode(ParticleBatchNode * batchNode)
 {
+    waitForSimulation();
+
     if( _batchNode != batchNode ) 
     {
         ParticleBatchNode* oldBatch = _batchNode;
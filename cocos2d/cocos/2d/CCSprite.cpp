@@ -592,6 +592,7 @@ void Sprite::draw(Renderer *renderer, const Mat4 &transform, bool transformUpdat
 
     if(_insideBounds)
     {
+        _texture->setLastUsedFrame(Director::getInstance()->getTotalFrames());
         _quadCommand.init(_globalZOrder, _texture->getName(), getGLProgramState(), _blendFunc, &_quad, 1, transform);
         renderer->addCommand(&_quadCommand);
 #if CC_SPRITE_DEBUG_DRAW
@@ -367,6 +367,7 @@ void SpriteBatchNode::draw(Renderer *renderer, const Mat4 &transform, bool trans
     for(const auto &child: _children)
         child->updateTransform();
 
+    _textureAtlas->getTexture()->setLastUsedFrame(Director::getInstance()->getTotalFrames());
     _batchCommand.init(
                        _globalZOrder,
                        getGLProgram(),
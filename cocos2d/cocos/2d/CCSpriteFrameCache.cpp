@@ -232,34 +232,7 @@ void SpriteFrameCache::addSpriteFramesWithFile(const std::string& pszPlist)
         std::string fullPath = FileUtils::getInstance()->fullPathForFilename(pszPlist);
         ValueMap dict = FileUtils::getInstance()->getValueMapFromFile(fullPath);
 
-        string texturePath("");
-
-        if (dict.find("metadata") != dict.end())
-        {
-            ValueMap& metadataDict = dict["metadata"].asValueMap();
-            // try to read  texture file name from meta data
-            texturePath = metadataDict["textureFileName"].asString();
-        }
-
-        if (!texturePath.empty())
-        {
-            // build texture path relative to plist file
-            texturePath = FileUtils::getInstance()->fullPathFromRelativeFile(texturePath.c_str(), pszPlist);
-        }
-        else
-        {
-            // build texture path by replacing file extension
-            texturePath = pszPlist;
-
-            // remove .xxx
-            size_t startPos = texturePath.find_last_of("."); 
-            texturePath = texturePath.erase(startPos);
-
-            // append .png
-            texturePath = texturePath.append(".png");
-
-            CCLOG("cocos2d: SpriteFrameCache: Trying to use file %s as texture", texturePath.c_str());
-        }
+        string texturePath = getTextureFileName(pszPlist, dict);
 
         Texture2D *texture = Director::getInstance()->getTextureCache()->addImage(texturePath.c_str());
 
@@ -275,6 +248,61 @@ void SpriteFrameCache::addSpriteFramesWithFile(const std::string& pszPlist)
     }
 }
 
+void SpriteFrameCache::addSpriteFramesWithDictionary(const std::string& plist, ValueMap& dictionary, Texture2D *texture)
+{
+    CCASSERT(texture != nullptr, "texture should not be null");
+
+    if (_loadedFileNames->find(plist) == _loadedFileNames->end())
+    {
+        addSpriteFramesWithDictionary(dictionary, texture);
+        _loadedFileNames->insert(plist);
+    }
+}
+
+std::string SpriteFrameCache::getTextureFileName(const std::string& plist, ValueMap& dictionary)
+{
+    string texturePath("");
+
+    auto metadataIter = dictionary.find("metadata");
+    if (metadataIter != dictionary.end() && metadataIter->second.getType() == Value::Type::MAP)
+    {
+        ValueMap& metadataDict = metadataIter->second.asValueMap();
+        // try to read  texture file name from meta data
+        auto textureIter = metadataDict.find("textureFileName");
+        if (textureIter != metadataDict.end())
+        {
+            texturePath = textureIter->second.asString();
+        }
+    }
+
+    if (!texturePath.empty())
+    {
+        // build texture path relative to plist file
+        texturePath = FileUtils::getInstance()->fullPathFromRelativeFile(texturePath.c_str(), plist);
+    }
+    else
+    {
+        // build texture path by replacing file extension
+        texturePath = plist;
+
+        // remove .xxx
+        size_t startPos = texturePath.find_last_of("."); 
+        texturePath = texturePath.erase(startPos);
+
+        // append .png
+        texturePath = texturePath.append(".png");
+
+        CCLOG("cocos2d: SpriteFrameCache: Trying to use file %s as texture", texturePath.c_str());
+    }
+
+    return texturePath;
+}
+
+bool SpriteFrameCache::isSpriteFramesWithFileLoaded(const std::string& plist) const
+{
+    return _loadedFileNames->find(plist) != _loadedFileNames->end();
+}
+
 void SpriteFrameCache::addSpriteFrame(SpriteFrame* frame, const std::string& frameName)
 {
     _spriteFrames.insert(frameName, frame);
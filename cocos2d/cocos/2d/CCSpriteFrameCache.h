@@ -106,6 +106,27 @@ public:
      */
     void addSpriteFramesWithFile(const std::string&plist, Texture2D *texture);
 
+    /** Adds multiple Sprite Frames from a plist file already read into a dictionary, on another thread for instance.
+     * The texture should be the one returned by getTextureFileName(). addSpriteFramesWithFile(plist) won't read the plist again.
+     * @since v3.2
+     * @js NA
+     * @lua NA
+     */
+    void addSpriteFramesWithDictionary(const std::string& plist, ValueMap& dictionary, Texture2D *texture);
+
+    /** Returns the texture file used by addSpriteFramesWithFile(plist) for a plist read into a dictionary:
+     * the one named by its metadata, relative to the plist, or else the plist with the .png suffix.
+     * @since v3.2
+     * @js NA
+     * @lua NA
+     */
+    static std::string getTextureFileName(const std::string& plist, ValueMap& dictionary);
+
+    /** Returns whether the sprite frames of a plist were added by addSpriteFramesWithFile(plist)
+     * @since v3.2
+     */
+    bool isSpriteFramesWithFileLoaded(const std::string& plist) const;
+
     /** Adds an sprite frame with a given name.
      If the name already exists, then the contents of the old name will be replaced with the new one.
      */
@@ -23,6 +23,7 @@ cocos2d.cpp \
 2d/CCActionTween.cpp \
 2d/CCAnimation.cpp \
 2d/CCAnimationCache.cpp \
+2d/CCAssetPreloader.cpp \
 2d/CCAtlasNode.cpp \
 2d/CCClippingNode.cpp \
 2d/CCComponent.cpp \
@@ -32,6 +33,8 @@ cocos2d.cpp \
 2d/CCFont.cpp \
 2d/CCFontAtlas.cpp \
 2d/CCFontAtlasCache.cpp \
+2d/CCFontBaked.cpp \
+2d/CCFontDistanceFieldCache.cpp \
 2d/CCFontCharMap.cpp \
 2d/CCFontFNT.cpp \
 2d/CCFontFreeType.cpp \
@@ -52,6 +55,7 @@ cocos2d.cpp \
 2d/CCParallaxNode.cpp \
 2d/CCParticleBatchNode.cpp \
 2d/CCParticleExamples.cpp \
+2d/CCParticleJobSystem.cpp \
 2d/CCParticleSystem.cpp \
 2d/CCParticleSystemQuad.cpp \
 2d/CCProgressTimer.cpp \
@@ -90,6 +94,7 @@ math/TransformUtils.cpp \
 math/Vec2.cpp \
 math/Vec3.cpp \
 math/Vec4.cpp \
+base/CCAssetPack.cpp \
 base/CCAutoreleasePool.cpp \
 base/CCConfiguration.cpp \
 base/CCConsole.cpp \
@@ -114,13 +119,17 @@ base/CCEventTouch.cpp \
 base/CCIMEDispatcher.cpp \
 base/CCNS.cpp \
 base/CCProfiling.cpp \
+base/CCRandomGenerator.cpp \
+base/CCFrameStats.cpp \
 base/CCRef.cpp \
+base/CCRefAllocator.cpp \
 base/CCScheduler.cpp \
 base/CCScriptSupport.cpp \
 base/CCTouch.cpp \
 base/CCUserDefault.cpp \
 base/CCUserDefaultAndroid.cpp \
 base/CCValue.cpp \
+base/CCWorkerPool.cpp \
 base/TGAlib.cpp \
 base/ZipUtils.cpp \
 base/atitc.cpp \
@@ -146,7 +155,9 @@ renderer/CCRenderer.cpp \
 renderer/CCTexture2D.cpp \
 renderer/CCTextureAtlas.cpp \
 renderer/CCTextureCache.cpp \
+renderer/CCTextureDiskCache.cpp \
 renderer/ccGLStateCache.cpp \
+renderer/ccPixelConversion.cpp \
 renderer/ccShaders.cpp \
 deprecated/CCArray.cpp \
 deprecated/CCSet.cpp \
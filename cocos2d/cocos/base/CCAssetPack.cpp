@@ -0,0 +1,223 @@
+/****************************************************************************
+ Copyright (c) 2013-2014 Chukong Technologies Inc.
+
+ http://www.cocos2d-x.org
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#include "base/CCAssetPack.h"
+#include "base/ccMacros.h"
+#include "platform/CCFileUtils.h"
+
+#include <zlib.h>
+#include <string.h>
+
+NS_CC_BEGIN
+
+static const char PACK_MAGIC[4] = { 'C', 'C', 'P', 'K' };
+static const uint32_t PACK_VERSION = 1;
+
+struct PackHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t indexOffset;
+    uint32_t namesOffset;
+    uint32_t namesSize;
+};
+
+AssetPack* AssetPack::create(const std::string& fullPath)
+{
+    AssetPack* ret = new AssetPack();
+    if (ret->init(fullPath))
+    {
+        return ret;
+    }
+    delete ret;
+    return nullptr;
+}
+
+AssetPack::AssetPack()
+: _entries(nullptr)
+, _entryCount(0)
+, _names(nullptr)
+, _namesSize(0)
+{
+}
+
+AssetPack::~AssetPack()
+{
+}
+
+bool AssetPack::init(const std::string& fullPath)
+{
+    static_assert(sizeof(PackHeader) == 24, "the pack header must be packed");
+    static_assert(sizeof(Entry) == 32, "the pack entries must be packed");
+
+    _path = fullPath;
+    _file = std::make_shared<Data>(FileUtils::getInstance()->getMappedDataFromFile(fullPath));
+
+    const unsigned char* bytes = _file->getBytes();
+    size_t size = _file->getSize();
+    if (_file->isNull() || size < sizeof(PackHeader))
+    {
+        CCLOG("cocos2d: AssetPack: can't read %s", fullPath.c_str());
+        return false;
+    }
+
+    // the packs are written in little endian, like every platform cocos2d-x runs on
+    PackHeader header;
+    memcpy(&header, bytes, sizeof(header));
+    if (memcmp(header.magic, PACK_MAGIC, sizeof(PACK_MAGIC)) != 0 || header.version != PACK_VERSION)
+    {
+        CCLOG("cocos2d: AssetPack: %s isn't a version %u pack", fullPath.c_str(), PACK_VERSION);
+        return false;
+    }
+
+    if (header.indexOffset % 8 != 0
+        || (unsigned long long)header.indexOffset + (unsigned long long)header.entryCount * sizeof(Entry) > size
+        || (unsigned long long)header.namesOffset + header.namesSize > size)
+    {
+        CCLOG("cocos2d: AssetPack: %s is corrupted", fullPath.c_str());
+        return false;
+    }
+
+    _entries = reinterpret_cast<const Entry*>(bytes + header.indexOffset);
+    _entryCount = header.entryCount;
+    _names = reinterpret_cast<const char*>(bytes + header.namesOffset);
+    _namesSize = header.namesSize;
+
+    for (unsigned int i = 0; i < _entryCount; ++i)
+    {
+        const Entry& entry = _entries[i];
+        if ((unsigned long long)entry.nameOffset + entry.nameLength > _namesSize
+            || (unsigned long long)entry.dataOffset + entry.compressedSize > size
+            || (entry.compression == (uint16_t)Compression::STORED && entry.compressedSize != entry.size)
+            || entry.compression > (uint16_t)Compression::DEFLATE)
+        {
+            CCLOG("cocos2d: AssetPack: %s is corrupted", fullPath.c_str());
+            return false;
+        }
+    }
+
+    return true;
+}
+
+unsigned long long AssetPack::hashPath(const char* path, size_t length)
+{
+    // 64 bits FNV-1a
+    unsigned long long hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < length; ++i)
+    {
+        hash ^= (unsigned char)path[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+const AssetPack::Entry* AssetPack::findEntry(const std::string& path) const
+{
+    unsigned long long hash = hashPath(path.c_str(), path.length());
+
+    // lower bound of the hash
+    unsigned int first = 0;
+    unsigned int count = _entryCount;
+    while (count > 0)
+    {
+        unsigned int step = count / 2;
+        if (_entries[first + step].hash < hash)
+        {
+            first += step + 1;
+            count -= step + 1;
+        }
+        else
+        {
+            count = step;
+        }
+    }
+
+    // a collision is unlikely but possible
+    for (unsigned int i = first; i < _entryCount && _entries[i].hash == hash; ++i)
+    {
+        const Entry& entry = _entries[i];
+        if (entry.nameLength == path.length() && memcmp(_names + entry.nameOffset, path.c_str(), entry.nameLength) == 0)
+        {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+bool AssetPack::isFileExist(const std::string& path) const
+{
+    return findEntry(path) != nullptr;
+}
+
+Data AssetPack::getData(const std::string& path, bool forString) const
+{
+    const Entry* entry = findEntry(path);
+    if (entry == nullptr)
+    {
+        return Data::Null;
+    }
+
+    Data ret;
+    unsigned char* source = _file->getBytes() + entry->dataOffset;
+
+    if (entry->compression == (uint16_t)Compression::STORED && !forString)
+    {
+        // no copy, the data keeps the pack alive
+        std::shared_ptr<Data> file = _file;
+        ret.fastSet(source, entry->size, [file](unsigned char*, ssize_t) {});
+        return ret;
+    }
+
+    unsigned char* buffer = (unsigned char*)malloc(entry->size + (forString ? 1 : 0));
+    if (buffer == nullptr)
+    {
+        return Data::Null;
+    }
+
+    if (entry->compression == (uint16_t)Compression::STORED)
+    {
+        memcpy(buffer, source, entry->size);
+    }
+    else
+    {
+        uLongf size = entry->size;
+        if (uncompress(buffer, &size, source, entry->compressedSize) != Z_OK || size != entry->size)
+        {
+            CCLOG("cocos2d: AssetPack: can't inflate %s from %s", path.c_str(), _path.c_str());
+            free(buffer);
+            return Data::Null;
+        }
+    }
+
+    if (forString)
+    {
+        buffer[entry->size] = '\0';
+    }
+
+    ret.fastSet(buffer, entry->size);
+    return ret;
+}
+
+NS_CC_END
@@ -0,0 +1,121 @@
+/****************************************************************************
+ Copyright (c) 2013-2014 Chukong Technologies Inc.
+
+ http://www.cocos2d-x.org
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#ifndef __BASE_CCASSETPACK_H__
+#define __BASE_CCASSETPACK_H__
+
+#include "base/CCPlatformMacros.h"
+#include "base/CCData.h"
+
+#include <memory>
+#include <string>
+
+NS_CC_BEGIN
+
+/**
+ * @addtogroup platform
+ * @{
+ */
+
+/** @brief Read only archive of resources with a hashed index, built by tools/asset-pack/ccpack.py
+
+ The pack is mapped in memory once, looking up a file is a binary search in its index.
+ Files are either stored, aligned on 16 bytes so that they can be read without any copy,
+ or deflated.
+
+ FileUtils mounts a pack when a search path ends with ".ccpack":
+ @code
+ FileUtils::getInstance()->addSearchPath("data.ccpack");
+ @endcode
+ Layout, all integers are little endian:
+ - header: "CCPK", version, entry count, index offset, names offset, names size (uint32)
+ - index: one 32 bytes entry per file, sorted by the 64 bits FNV-1a hash of the path
+ - names: the paths, relative to the packed directory, '/' separated
+ - data
+ @since v3.2
+ */
+class CC_DLL AssetPack
+{
+public:
+    enum class Compression
+    {
+        STORED = 0,
+        DEFLATE = 1,
+    };
+
+    /** Opens a pack, returns nullptr if the file is missing or isn't a valid pack */
+    static AssetPack* create(const std::string& fullPath);
+
+    ~AssetPack();
+
+    /** Whether or not the pack contains a file, path is relative to the packed directory */
+    bool isFileExist(const std::string& path) const;
+
+    /** Returns the content of a file, or Data::Null if the pack doesn't contain it.
+     Stored files are returned without copy, the data keeps the pack mapped.
+     @param forString whether or not a '\0' is appended after the content, which then needs a copy.
+     */
+    Data getData(const std::string& path, bool forString = false) const;
+
+    /** Number of files in the pack */
+    unsigned int getFileCount() const { return _entryCount; }
+
+    /** Full path of the pack */
+    const std::string& getPath() const { return _path; }
+
+    /** Hash used by the index, must match the packing tool */
+    static unsigned long long hashPath(const char* path, size_t length);
+
+protected:
+    struct Entry
+    {
+        unsigned long long hash;
+        uint32_t nameOffset;
+        uint32_t nameLength;
+        uint32_t dataOffset;
+        uint32_t compressedSize;
+        uint32_t size;
+        uint16_t compression;
+        uint16_t flags;
+    };
+
+    AssetPack();
+    bool init(const std::string& fullPath);
+    const Entry* findEntry(const std::string& path) const;
+
+    std::string _path;
+    // shared with the data returned without copy
+    std::shared_ptr<Data> _file;
+    const Entry* _entries;
+    unsigned int _entryCount;
+    const char* _names;
+    uint32_t _namesSize;
+};
+
+// end of platform group
+/// @}
+
+NS_CC_END
+
+#endif // __BASE_CCASSETPACK_H__
@@ -30,6 +30,8 @@
 #include <cctype>
 #include <locale>
 #include <sstream>
+#include <limits>
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
@@ -58,7 +60,9 @@
 #include "base/CCScheduler.h"
 #include "base/CCPlatformConfig.h"
 #include "base/CCConfiguration.h"
+#include "base/CCProfiling.h"
 #include "2d/CCScene.h"
+#include "2d/CCFontBaked.h"
 #include "platform/CCFileUtils.h"
 #include "renderer/CCTextureCache.h"
 #include "CCGLView.h"
@@ -277,6 +281,7 @@ Console::Console()
         } },
         { "exit", "Close connection to the console", std::bind(&Console::commandExit, this, std::placeholders::_1, std::placeholders::_2) },
         { "fileutils", "Flush or print the FileUtils info. Args: [flush | ] ", std::bind(&Console::commandFileUtils, this, std::placeholders::_1, std::placeholders::_2) },
+        { "fontbake", "Bake a TTF or FNT font into a .ccfont file, type -h or [fontbake help] to list supported directives", std::bind(&Console::commandFontBake, this, std::placeholders::_1, std::placeholders::_2) },
         { "fps", "Turn on / off the FPS. Args: [on | off] ", [](int fd, const std::string& args) {
             if( args.compare("on")==0 || args.compare("off")==0) {
                 bool state = (args.compare("on") == 0);
@@ -291,9 +296,11 @@ Console::Console()
         { "projection", "Change or print the current projection. Args: [2d | 3d]", std::bind(&Console::commandProjection, this, std::placeholders::_1, std::placeholders::_2) },
         { "resolution", "Change or print the window resolution. Args: [width height resolution_policy | ]", std::bind(&Console::commandResolution, this, std::placeholders::_1, std::placeholders::_2) },
         { "scenegraph", "Print the scene graph", std::bind(&Console::commandSceneGraph, this, std::placeholders::_1, std::placeholders::_2) },
-        { "texture", "Flush or print the TextureCache info. Args: [flush | ] ", std::bind(&Console::commandTextures, this, std::placeholders::_1, std::placeholders::_2) },
+        { "texture", "Flush or print the TextureCache info, or set its memory budget. Args: [flush | budget MB | ] ", std::bind(&Console::commandTextures, this, std::placeholders::_1, std::placeholders::_2) },
         { "director", "director commands, type -h or [director help] to list supported directives", std::bind(&Console::commandDirector, this, std::placeholders::_1, std::placeholders::_2) },
         { "touch", "simulate touch event via console, type -h or [touch help] to list supported directives", std::bind(&Console::commandTouch, this, std::placeholders::_1, std::placeholders::_2) },
+        { "framestats", "Print, reset or export the frame time percentiles and hitches. Args: [reset | json | dump [filename] | hitch ms | ]", std::bind(&Console::commandFrameStats, this, std::placeholders::_1, std::placeholders::_2) },
+        { "trace", "Record and export trace events, type -h or [trace help] to list supported directives", std::bind(&Console::commandTrace, this, std::placeholders::_1, std::placeholders::_2) },
         { "upload", "upload file. Args: [filename base64_encoded_data]", std::bind(&Console::commandUpload, this, std::placeholders::_1) },
     };
 
@@ -573,6 +580,27 @@ void Console::commandTextures(int fd, const std::string& args)
         }
                                             );
     }
+    else if(args.compare(0, 6, "budget") == 0)
+    {
+        std::string value = args.substr(6);
+        trim(value);
+        char* end = nullptr;
+        errno = 0;
+        long mb = strtol(value.c_str(), &end, 10);
+        if (!value.empty() && *end == '\0' && errno == 0
+            && mb >= 0 && (unsigned long)mb <= (std::numeric_limits<size_t>::max)() / (1024 * 1024))
+        {
+            // 0 removes the budget
+            sched->performFunctionInCocosThread( [=](){
+                Director::getInstance()->getTextureCache()->setMemoryBudget((size_t)mb * 1024 * 1024);
+            }
+                                                );
+        }
+        else
+        {
+            mydprintf(fd, "Invalid budget: '%s', expected a size in MB, 0 for no budget\n", value.c_str());
+        }
+    }
     else if(args.length()==0)
     {
         sched->performFunctionInCocosThread( [=](){
@@ -583,7 +611,7 @@ void Console::commandTextures(int fd, const std::string& args)
     }
     else
     {
-        mydprintf(fd, "Unsupported argument: '%s'. Supported arguments: 'flush' or nothing", args.c_str());
+        mydprintf(fd, "Unsupported argument: '%s'. Supported arguments: 'flush', 'budget MB' or nothing\n", args.c_str());
     }
 }
 
@@ -633,6 +661,226 @@ void Console::commandDirector(int fd, const std::string& args)
 
 }
 
+void Console::commandTrace(int fd, const std::string& args)
+{
+    auto profiler = TraceProfiler::getInstance();
+
+    if(args =="help" || args == "-h")
+    {
+        const char help[] = "available trace directives:\n"
+                            "\tstart, start recording trace events\n"
+                            "\tstop, stop recording trace events\n"
+                            "\tclear, drop the events recorded so far\n"
+                            "\tjson, print the recorded events in the Chrome trace format\n"
+                            "\tdump [filename], write the recorded events in the Chrome trace format to a file, 'trace.json' in the writable path by default\n";
+        send(fd, help, sizeof(help) - 1,0);
+    }
+    else if(args == "start")
+    {
+        profiler->setEnabled(true);
+    }
+    else if(args == "stop")
+    {
+        profiler->setEnabled(false);
+    }
+    else if(args == "clear")
+    {
+        profiler->clear();
+    }
+    else if(args == "json")
+    {
+        // the JSON document is bigger than what mydprintf can handle
+        std::string json = profiler->exportChromeTrace();
+        size_t sent = 0;
+        while (sent < json.size())
+        {
+            auto ret = send(fd, json.data() + sent, json.size() - sent, 0);
+            if (ret <= 0)
+                break;
+            sent += ret;
+        }
+    }
+    else if(args.compare(0, 4, "dump") == 0)
+    {
+        std::string filename = args.substr(4);
+        trim(filename);
+        if (filename.empty())
+        {
+            filename = _writablePath + "trace.json";
+        }
+
+        if (profiler->dumpChromeTrace(filename))
+            mydprintf(fd, "Trace written to: %s\n", filename.c_str());
+        else
+            mydprintf(fd, "Can't write trace to: %s\n", filename.c_str());
+    }
+    else if(args.length() == 0)
+    {
+        mydprintf(fd, "Trace recording is: %s\n", profiler->isEnabled() ? "on" : "off");
+    }
+    else
+    {
+        mydprintf(fd, "Unsupported argument: '%s'. Supported arguments: 'start', 'stop', 'clear', 'json', 'dump [filename]' or nothing\n", args.c_str());
+    }
+}
+
+void Console::commandFrameStats(int fd, const std::string& args)
+{
+    Scheduler *sched = Director::getInstance()->getScheduler();
+
+    // the stats are written by the cocos2d thread, read them there
+    if(args =="help" || args == "-h")
+    {
+        const char help[] = "available framestats directives:\n"
+                            "\treset, drop the statistics collected so far\n"
+                            "\tjson, print the statistics as JSON, in microseconds\n"
+                            "\tdump [filename], write the JSON statistics to a file, 'framestats.json' in the writable path by default\n"
+                            "\thitch ms, count the frames longer than ms milliseconds as hitches\n";
+        send(fd, help, sizeof(help) - 1,0);
+    }
+    else if(args == "reset")
+    {
+        sched->performFunctionInCocosThread( [](){
+            Director::getInstance()->getFrameStats().reset();
+        } );
+    }
+    else if(args == "json")
+    {
+        sched->performFunctionInCocosThread( [=](){
+            mydprintf(fd, "%s", Director::getInstance()->getFrameStats().exportJSON().c_str());
+            sendPrompt(fd);
+        } );
+    }
+    else if(args.compare(0, 4, "dump") == 0)
+    {
+        std::string filename = args.substr(4);
+        trim(filename);
+        if (filename.empty())
+        {
+            filename = _writablePath + "framestats.json";
+        }
+
+        sched->performFunctionInCocosThread( [=](){
+            std::string json = Director::getInstance()->getFrameStats().exportJSON();
+            FILE* fp = fopen(filename.c_str(), "wb");
+            if (fp)
+            {
+                fwrite(json.data(), 1, json.size(), fp);
+                fclose(fp);
+                mydprintf(fd, "Frame stats written to: %s\n", filename.c_str());
+            }
+            else
+            {
+                mydprintf(fd, "Can't write frame stats to: %s\n", filename.c_str());
+            }
+            sendPrompt(fd);
+        } );
+    }
+    else if(args.compare(0, 5, "hitch") == 0)
+    {
+        std::string value = args.substr(5);
+        trim(value);
+        float ms = std::atof(value.c_str());
+        if (ms > 0)
+        {
+            sched->performFunctionInCocosThread( [=](){
+                Director::getInstance()->getFrameStats().setHitchThreshold(ms / 1000.0f);
+            } );
+        }
+        else
+        {
+            mydprintf(fd, "Invalid hitch threshold: '%s'\n", value.c_str());
+        }
+    }
+    else if(args.length() == 0)
+    {
+        sched->performFunctionInCocosThread( [=](){
+            mydprintf(fd, "%s", Director::getInstance()->getFrameStats().getSummary().c_str());
+            sendPrompt(fd);
+        } );
+    }
+    else
+    {
+        mydprintf(fd, "Unsupported argument: '%s'. Supported arguments: 'reset', 'json', 'dump [filename]', 'hitch ms' or nothing\n", args.c_str());
+    }
+}
+
+void Console::commandFontBake(int fd, const std::string& args)
+{
+    auto argv = split(args,' ');
+    argv.erase(std::remove(argv.begin(), argv.end(), std::string()), argv.end());
+
+    if(argv.empty() || args == "help" || args == "-h")
+    {
+        const char help[] = "available fontbake directives:\n"
+                            "\tttf font size output [ascii | nehe | charsfile] [df | outline size]: bake the ASCII glyphs, the NeHe ones or the ones of the UTF-8 charsfile of a TTF font\n"
+                            "\tfnt font output: bake a BMFont\n"
+                            "\tthe output is written in the writable path unless its path is absolute\n";
+        send(fd, help, sizeof(help) - 1,0);
+        return;
+    }
+
+    auto outputPath = [](const std::string& output) {
+        auto fileUtils = FileUtils::getInstance();
+        return fileUtils->isAbsolutePath(output) ? output : fileUtils->getWritablePath() + output;
+    };
+
+    // the fonts are baked on the cocos thread, which uses FreeType and the FileUtils cache
+    Scheduler *sched = Director::getInstance()->getScheduler();
+    if(argv[0] == "fnt" && argv.size() == 3)
+    {
+        std::string font = argv[1];
+        std::string output = outputPath(argv[2]);
+        sched->performFunctionInCocosThread( [=](){
+            bool ok = FontBaked::bakeFNT(font, output);
+            mydprintf(fd, "%s %s\n", ok ? "Baked" : "Failed to bake", output.c_str());
+            sendPrompt(fd);
+        }
+                                            );
+    }
+    else if(argv[0] == "ttf" && argv.size() >= 4 && isFloat(argv[2]))
+    {
+        std::string font = argv[1];
+        int size = std::atoi(argv[2].c_str());
+        std::string output = outputPath(argv[3]);
+        GlyphCollection glyphs = GlyphCollection::ASCII;
+        std::string charsFile;
+        bool distanceField = false;
+        int outline = 0;
+        for (size_t i = 4; i < argv.size(); ++i)
+        {
+            if (argv[i] == "ascii")
+                glyphs = GlyphCollection::ASCII;
+            else if (argv[i] == "nehe")
+                glyphs = GlyphCollection::NEHE;
+            else if (argv[i] == "df")
+                distanceField = true;
+            else if (argv[i] == "outline" && i + 1 < argv.size() && isFloat(argv[i + 1]))
+                outline = std::atoi(argv[++i].c_str());
+            else
+            {
+                glyphs = GlyphCollection::CUSTOM;
+                charsFile = argv[i];
+            }
+        }
+        sched->performFunctionInCocosThread( [=](){
+            std::string chars;
+            if (glyphs == GlyphCollection::CUSTOM)
+            {
+                chars = FileUtils::getInstance()->getStringFromFile(charsFile);
+            }
+            bool ok = FontBaked::bakeTTF(font, size, glyphs, chars.empty() ? nullptr : chars.c_str(), distanceField, outline, output);
+            mydprintf(fd, "%s %s\n", ok ? "Baked" : "Failed to bake", output.c_str());
+            sendPrompt(fd);
+        }
+                                            );
+    }
+    else
+    {
+        mydprintf(fd, "Unsupported argument: '%s'. Type 'fontbake help' to list the supported directives\n", args.c_str());
+    }
+}
+
 void Console::commandTouch(int fd, const std::string& args)
 {
     if(args =="help" || args == "-h")
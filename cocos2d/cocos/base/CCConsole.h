@@ -120,6 +120,9 @@ protected:
     void commandProjection(int fd, const std::string &args);
     void commandDirector(int fd, const std::string &args);
     void commandTouch(int fd, const std::string &args);
+    void commandTrace(int fd, const std::string &args);
+    void commandFrameStats(int fd, const std::string &args);
+    void commandFontBake(int fd, const std::string &args);
     void commandUpload(int fd);
     // file descriptor: socket, console, etc.
     int _listenfd;
@@ -72,6 +72,7 @@ Data& Data::operator= (const Data& other)
 Data& Data::operator= (Data&& other)
 {
     CCLOGINFO("In the move assignment of Data.");
+    clear();
     move(other);
     return *this;
 }
@@ -80,9 +81,11 @@ void Data::move(Data& other)
 {
     _bytes = other._bytes;
     _size = other._size;
+    _releaseCallback = std::move(other._releaseCallback);
     
     other._bytes = nullptr;
     other._size = 0;
+    other._releaseCallback = nullptr;
 }
 
 bool Data::isNull() const
@@ -116,11 +119,28 @@ void Data::fastSet(unsigned char* bytes, const ssize_t size)
 {
     _bytes = bytes;
     _size = size;
+    _releaseCallback = nullptr;
+}
+
+void Data::fastSet(unsigned char* bytes, const ssize_t size, const ReleaseCallback& releaseCallback)
+{
+    _bytes = bytes;
+    _size = size;
+    _releaseCallback = releaseCallback;
 }
 
 void Data::clear()
 {
-    free(_bytes);
+    if (_releaseCallback)
+    {
+        if (_bytes)
+            _releaseCallback(_bytes, _size);
+        _releaseCallback = nullptr;
+    }
+    else
+    {
+        free(_bytes);
+    }
     _bytes = nullptr;
     _size = 0;
 }
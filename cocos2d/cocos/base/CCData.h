@@ -30,6 +30,7 @@
 #include <stdint.h> // for ssize_t on android
 #include <string>   // for ssize_t on linux
 #include "CCStdC.h" // for ssize_t on window
+#include <functional>
 
 NS_CC_BEGIN
 
@@ -37,6 +38,9 @@ class CC_DLL Data
 {
 public:
     static const Data Null;
+
+    /** Called instead of 'free' to release a buffer set with fastSet(bytes, size, releaseCallback) */
+    typedef std::function<void(unsigned char* bytes, ssize_t size)> ReleaseCallback;
     
     Data();
     Data(const Data& other);
@@ -73,6 +77,13 @@ public:
      *  @see Data::copy
      */
     void fastSet(unsigned char* bytes, const ssize_t size);
+
+    /** Fast set a buffer which isn't allocated by 'malloc', e.g. a memory mapped file.
+     *  @param releaseCallback Called with the buffer and its size when the data is cleared or destroyed.
+     *  @note Copying the data copies the bytes in a buffer allocated by 'malloc', moving it keeps the buffer.
+     *  @since v3.2
+     */
+    void fastSet(unsigned char* bytes, const ssize_t size, const ReleaseCallback& releaseCallback);
     
     /** Clears data, free buffer and reset data size */
     void clear();
@@ -86,6 +97,7 @@ private:
 private:
     unsigned char* _bytes;
     ssize_t _size;
+    ReleaseCallback _releaseCallback;
 };
 
 NS_CC_END
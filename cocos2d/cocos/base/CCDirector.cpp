@@ -42,6 +42,7 @@ THE SOFTWARE.
 #include "2d/CCAnimationCache.h"
 #include "2d/CCTransition.h"
 #include "2d/CCFontFreeType.h"
+#include "2d/CCParticleJobSystem.h"
 #include "renderer/CCGLProgramCache.h"
 #include "renderer/CCGLProgramStateCache.h"
 #include "renderer/CCTextureCache.h"
@@ -53,6 +54,9 @@ THE SOFTWARE.
 #include "base/ccMacros.h"
 #include "base/CCEventDispatcher.h"
 #include "base/CCEventCustom.h"
+#if CC_ENABLE_REF_ALLOCATOR
+#include "base/CCRefAllocator.h"
+#endif
 #include "base/CCConsole.h"
 #include "base/CCTouch.h"
 #include "base/CCAutoreleasePool.h"
@@ -118,10 +122,20 @@ bool Director::init(void)
     // FPS
     _accumDt = 0.0f;
     _frameRate = 0.0f;
-    _FPSLabel = _drawnBatchesLabel = _drawnVerticesLabel = nullptr;
+    _FPSLabel = _drawnBatchesLabel = _drawnVerticesLabel = _frameTimeLabel = nullptr;
+#if CC_ENABLE_REF_ALLOCATOR
+    _refAllocationsLabel = nullptr;
+#endif
     _totalFrames = _frames = 0;
     _lastUpdate = new struct timeval;
 
+    // fixed time step
+    _fixedTimeStep = 0.0f;
+    _fixedTimeStepAccumulator = 0.0;
+    _maxFixedStepsPerFrame = 5;
+    _unthrottled = false;
+    _renderingEnabled = true;
+
     // paused ?
     _paused = false;
 
@@ -169,7 +183,11 @@ Director::~Director(void)
 
     CC_SAFE_RELEASE(_FPSLabel);
     CC_SAFE_RELEASE(_drawnVerticesLabel);
+    CC_SAFE_RELEASE(_frameTimeLabel);
     CC_SAFE_RELEASE(_drawnBatchesLabel);
+#if CC_ENABLE_REF_ALLOCATOR
+    CC_SAFE_RELEASE(_refAllocationsLabel);
+#endif
 
     CC_SAFE_RELEASE(_runningScene);
     CC_SAFE_RELEASE(_notificationNode);
@@ -253,11 +271,16 @@ void Director::setGLDefaultValues()
 // Draw the Scene
 void Director::drawScene()
 {
+    CC_TRACE_SCOPE("drawScene", "director");
+
+    _frameStats.beginFrame();
+
     // calculate "global" dt
     calculateDeltaTime();
     
     // skip one flame when _deltaTime equal to zero.
-    if(_deltaTime < FLT_EPSILON)
+    // an unthrottled frame doesn't depend on the wall clock, it is never skipped
+    if(_deltaTime < FLT_EPSILON && !(_unthrottled && _fixedTimeStep > 0))
     {
         return;
     }
@@ -270,8 +293,30 @@ void Director::drawScene()
     //tick before glClear: issue #533
     if (! _paused)
     {
-        _scheduler->update(_deltaTime);
-        _eventDispatcher->dispatchEvent(_eventAfterUpdate);
+        CC_TRACE_SCOPE("scheduler", "director");
+        _frameStats.beginPhase(FrameStats::Phase::UPDATE);
+        if (_fixedTimeStep > 0)
+        {
+            updateFixedTimeStep();
+        }
+        else
+        {
+            _scheduler->update(_deltaTime);
+            _eventDispatcher->dispatchEvent(_eventAfterUpdate);
+            ParticleJobSystem::getInstance()->start();
+        }
+        _frameStats.endPhase(FrameStats::Phase::UPDATE);
+    }
+
+    if (! _renderingEnabled)
+    {
+        ParticleJobSystem::getInstance()->wait();
+        if (_nextScene)
+        {
+            setNextScene();
+        }
+        _totalFrames++;
+        return;
     }
 
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -288,8 +333,11 @@ void Director::drawScene()
     // draw the scene
     if (_runningScene)
     {
+        CC_TRACE_SCOPE("visit", "director");
+        _frameStats.beginPhase(FrameStats::Phase::VISIT);
         _runningScene->visit(_renderer, Mat4::IDENTITY, false);
         _eventDispatcher->dispatchEvent(_eventAfterVisit);
+        _frameStats.endPhase(FrameStats::Phase::VISIT);
     }
 
     // draw the notifications node
@@ -303,7 +351,14 @@ void Director::drawScene()
         showStats();
     }
 
-    _renderer->render();
+    {
+        CC_TRACE_SCOPE("render", "director");
+        _frameStats.beginPhase(FrameStats::Phase::RENDER);
+        // the quads of the emitters that weren't drawn must be written before the next frame
+        ParticleJobSystem::getInstance()->wait();
+        _renderer->render();
+        _frameStats.endPhase(FrameStats::Phase::RENDER);
+    }
     _eventDispatcher->dispatchEvent(_eventAfterDraw);
 
     popMatrix(MATRIX_STACK_TYPE::MATRIX_STACK_MODELVIEW);
@@ -313,7 +368,10 @@ void Director::drawScene()
     // swap buffers
     if (_openGLView)
     {
+        CC_TRACE_SCOPE("swap", "director");
+        _frameStats.beginPhase(FrameStats::Phase::SWAP);
         _openGLView->swapBuffers();
+        _frameStats.endPhase(FrameStats::Phase::SWAP);
     }
 
     if (_displayStats)
@@ -357,8 +415,67 @@ void Director::calculateDeltaTime()
 }
 float Director::getDeltaTime() const
 {
+    if (_fixedTimeStep > 0)
+    {
+        return _fixedTimeStep;
+    }
     return _deltaTime;
 }
+
+void Director::updateFixedTimeStep()
+{
+    unsigned int steps = 1;
+
+    if (! _unthrottled)
+    {
+        _fixedTimeStepAccumulator += _deltaTime;
+        steps = (unsigned int)(_fixedTimeStepAccumulator / _fixedTimeStep);
+        if (steps > _maxFixedStepsPerFrame)
+        {
+            // too far behind: drop the backlog instead of spiraling down
+            _fixedTimeStepAccumulator -= (steps - _maxFixedStepsPerFrame) * (double)_fixedTimeStep;
+            steps = _maxFixedStepsPerFrame;
+        }
+        _fixedTimeStepAccumulator -= steps * (double)_fixedTimeStep;
+    }
+
+    for (unsigned int i = 0; i < steps; ++i)
+    {
+        _scheduler->update(_fixedTimeStep);
+        _eventDispatcher->dispatchEvent(_eventAfterUpdate);
+        ParticleJobSystem::getInstance()->start();
+    }
+}
+
+void Director::setFixedTimeStep(float step, unsigned int maxStepsPerFrame)
+{
+    CCASSERT(step >= 0, "fixed time step should not be negative");
+    CCASSERT(maxStepsPerFrame > 0, "at least one step per frame is needed");
+
+    _fixedTimeStep = step;
+    _maxFixedStepsPerFrame = maxStepsPerFrame;
+    _fixedTimeStepAccumulator = 0.0;
+
+    // the wait between frames depends on the mode
+    setAnimationInterval(_animationInterval);
+}
+
+float Director::getFixedTimeStepAlpha() const
+{
+    if (_fixedTimeStep <= 0 || _unthrottled)
+    {
+        return 0.0f;
+    }
+    return (float)(_fixedTimeStepAccumulator / _fixedTimeStep);
+}
+
+void Director::setUnthrottled(bool unthrottled)
+{
+    _unthrottled = unthrottled;
+    _fixedTimeStepAccumulator = 0.0;
+
+    setAnimationInterval(_animationInterval);
+}
 void Director::setOpenGLView(GLView *openGLView)
 {
     CCASSERT(openGLView, "opengl view should not be null");
@@ -430,6 +547,11 @@ void Director::setViewport()
 void Director::setNextDeltaTimeZero(bool nextDeltaTimeZero)
 {
     _nextDeltaTimeZero = nextDeltaTimeZero;
+    if (nextDeltaTimeZero)
+    {
+        // the interval would include the pause, it isn't a hitch
+        _frameStats.skipNextFrameInterval();
+    }
 }
    
 void Director::initMatrixStack()
@@ -950,6 +1072,10 @@ void Director::purgeDirector()
     CC_SAFE_RELEASE_NULL(_FPSLabel);
     CC_SAFE_RELEASE_NULL(_drawnBatchesLabel);
     CC_SAFE_RELEASE_NULL(_drawnVerticesLabel);
+    CC_SAFE_RELEASE_NULL(_frameTimeLabel);
+#if CC_ENABLE_REF_ALLOCATOR
+    CC_SAFE_RELEASE_NULL(_refAllocationsLabel);
+#endif
 
     // purge bitmap cache
     FontFNT::purgeCachedData();
@@ -958,6 +1084,7 @@ void Director::purgeDirector()
 
     // purge all managed caches
     DrawPrimitives::free();
+    ParticleJobSystem::destroyInstance();
     AnimationCache::destroyInstance();
     SpriteFrameCache::destroyInstance();
     GLProgramCache::destroyInstance();
@@ -1073,6 +1200,13 @@ void Director::showStats()
 
             sprintf(buffer, "%.1f / %.3f", _frameRate, _secondsPerFrame);
             _FPSLabel->setString(buffer);
+
+            if (_frameTimeLabel)
+            {
+                const auto& frames = _frameStats.getHistogram(FrameStats::Phase::FRAME);
+                sprintf(buffer, "p99:%5.1f max:%5.1f", frames.getPercentile(99) / 1000.0f, frames.getMax() / 1000.0f);
+                _frameTimeLabel->setString(buffer);
+            }
         }
 
         auto currentCalls = (unsigned long)_renderer->getDrawnBatches();
@@ -1091,6 +1225,25 @@ void Director::showStats()
 
         Mat4 identity = Mat4::IDENTITY;
 
+        if (_frameTimeLabel)
+        {
+            _frameTimeLabel->visit(_renderer, identity, false);
+        }
+
+#if CC_ENABLE_REF_ALLOCATOR
+        if (_refAllocationsLabel)
+        {
+            static unsigned int prevAllocs = 0;
+            auto currentAllocs = RefAllocator::getInstance()->getLastFrameStats().allocations;
+            if (currentAllocs != prevAllocs) {
+                sprintf(buffer, "Ref allocs:%6u", currentAllocs);
+                _refAllocationsLabel->setString(buffer);
+                prevAllocs = currentAllocs;
+            }
+            _refAllocationsLabel->visit(_renderer, identity, false);
+        }
+#endif
+
         _drawnVerticesLabel->visit(_renderer, identity, false);
         _drawnBatchesLabel->visit(_renderer, identity, false);
         _FPSLabel->visit(_renderer, identity, false);
@@ -1099,10 +1252,7 @@ void Director::showStats()
 
 void Director::calculateMPF()
 {
-    struct timeval now;
-    gettimeofday(&now, nullptr);
-    
-    _secondsPerFrame = (now.tv_sec - _lastUpdate->tv_sec) + (now.tv_usec - _lastUpdate->tv_usec) / 1000000.0f;
+    _secondsPerFrame = _frameStats.getCurrentFrameElapsed();
 }
 
 // returns the FPS image data pointer and len
@@ -1122,6 +1272,10 @@ void Director::createStatsLabel()
         CC_SAFE_RELEASE_NULL(_FPSLabel);
         CC_SAFE_RELEASE_NULL(_drawnBatchesLabel);
         CC_SAFE_RELEASE_NULL(_drawnVerticesLabel);
+        CC_SAFE_RELEASE_NULL(_frameTimeLabel);
+#if CC_ENABLE_REF_ALLOCATOR
+        CC_SAFE_RELEASE_NULL(_refAllocationsLabel);
+#endif
         _textureCache->removeTextureForKey("/cc_fps_images");
         FileUtils::getInstance()->purgeCachedEntries();
     }
@@ -1170,6 +1324,19 @@ void Director::createStatsLabel()
     _drawnVerticesLabel->initWithString("00000", texture, 12, 32, '.');
     _drawnVerticesLabel->setScale(scaleFactor);
 
+    _frameTimeLabel = LabelAtlas::create();
+    _frameTimeLabel->retain();
+    _frameTimeLabel->setIgnoreContentScaleFactor(true);
+    _frameTimeLabel->initWithString("00.0", texture, 12, 32, '.');
+    _frameTimeLabel->setScale(scaleFactor);
+
+#if CC_ENABLE_REF_ALLOCATOR
+    _refAllocationsLabel = LabelAtlas::create();
+    _refAllocationsLabel->retain();
+    _refAllocationsLabel->setIgnoreContentScaleFactor(true);
+    _refAllocationsLabel->initWithString("00000", texture, 12, 32, '.');
+    _refAllocationsLabel->setScale(scaleFactor);
+#endif
 
     Texture2D::setDefaultAlphaPixelFormat(currentFormat);
 
@@ -1177,6 +1344,10 @@ void Director::createStatsLabel()
     _drawnVerticesLabel->setPosition(Vec2(0, height_spacing*2) + CC_DIRECTOR_STATS_POSITION);
     _drawnBatchesLabel->setPosition(Vec2(0, height_spacing*1) + CC_DIRECTOR_STATS_POSITION);
     _FPSLabel->setPosition(Vec2(0, height_spacing*0)+CC_DIRECTOR_STATS_POSITION);
+    _frameTimeLabel->setPosition(Vec2(0, height_spacing*3) + CC_DIRECTOR_STATS_POSITION);
+#if CC_ENABLE_REF_ALLOCATOR
+    _refAllocationsLabel->setPosition(Vec2(0, height_spacing*4) + CC_DIRECTOR_STATS_POSITION);
+#endif
 }
 
 void Director::setContentScaleFactor(float scaleFactor)
@@ -1241,7 +1412,8 @@ void DisplayLinkDirector::startAnimation()
 
     _invalid = false;
 
-    Application::getInstance()->setAnimationInterval(_animationInterval);
+    // unthrottled fixed time steps run as fast as possible
+    Application::getInstance()->setAnimationInterval(_unthrottled && _fixedTimeStep > 0 ? 0 : _animationInterval);
     
     // fix issue #3509, skip one fps to avoid incorrect time calculation.
     setNextDeltaTimeZero(true);
@@ -1260,6 +1432,10 @@ void DisplayLinkDirector::mainLoop()
      
         // release the objects
         PoolManager::getInstance()->getCurrentPool()->clear();
+
+#if CC_ENABLE_REF_ALLOCATOR
+        RefAllocator::getInstance()->beginFrame();
+#endif
     }
 }
 
@@ -38,6 +38,7 @@ THE SOFTWARE.
 #include "2d/CCLabelAtlas.h"
 #include <stack>
 #include "math/CCMath.h"
+#include "base/CCFrameStats.h"
 
 NS_CC_BEGIN
 
@@ -166,6 +167,12 @@ public:
     /** seconds per frame */
     inline float getSecondsPerFrame() { return _secondsPerFrame; }
 
+    /** Frame time histograms, per phase percentiles and hitch count.
+     They are always collected, whether or not the stats are displayed.
+     @since v3.2
+     */
+    inline FrameStats& getFrameStats() { return _frameStats; }
+
     /** Get the GLView, where everything is rendered
     * @js NA
     * @lua NA
@@ -396,8 +403,41 @@ public:
     Console* getConsole() const { return _console; }
 #endif
 
-    /* Gets delta time since last tick to main loop */
+    /* Gets delta time since last tick to main loop.
+     In fixed time step mode, returns the fixed time step.
+     */
 	float getDeltaTime() const;
+
+    /** Updates the Scheduler, and so the actions and the physics, with a constant delta time.
+     The elapsed time is accumulated and as many steps as needed to catch up are run every frame,
+     at most maxStepsPerFrame, the remaining backlog is dropped after a spike.
+     The update rate is then independent of the render rate set by setAnimationInterval().
+     @param step the fixed delta time in seconds, 0 restores the variable delta time.
+     @since v3.2
+     */
+    void setFixedTimeStep(float step, unsigned int maxStepsPerFrame = 5);
+    /** Returns the fixed time step, 0 if the delta time is variable */
+    inline float getFixedTimeStep() const { return _fixedTimeStep; }
+    /** Whether or not the delta time is fixed */
+    inline bool isFixedTimeStep() const { return _fixedTimeStep > 0; }
+
+    /** Fraction of a fixed step not simulated yet, between 0 and 1.
+     Use it to interpolate between the two last simulated states when rendering.
+     */
+    float getFixedTimeStepAlpha() const;
+
+    /** Runs exactly one fixed step per frame, whatever the wall clock time, and doesn't wait
+     between frames. Meant for reproducible automated tests and for benchmarks of the game logic.
+     Only used in fixed time step mode.
+     */
+    void setUnthrottled(bool unthrottled);
+    inline bool isUnthrottled() const { return _unthrottled; }
+
+    /** Whether or not the scene is visited, rendered and the buffers swapped.
+     Disable it to run the game logic headless. Enabled by default.
+     */
+    inline void setRenderingEnabled(bool enabled) { _renderingEnabled = enabled; }
+    inline bool isRenderingEnabled() const { return _renderingEnabled; }
     
     /**
      *  get Frame Rate
@@ -418,6 +458,9 @@ protected:
     /** calculates delta time since last time it was called */    
     void calculateDeltaTime();
 
+    /** runs the scheduler with the fixed time step as many times as needed to catch up */
+    void updateFixedTimeStep();
+
     //textureCache creation or release
     void initTextureCache();
     void destroyTextureCache();
@@ -440,6 +483,13 @@ protected:
         
     /* delta time since last tick to main loop */
 	float _deltaTime;
+
+    /* fixed time step mode: step, elapsed time not simulated yet and catch up limit */
+    float _fixedTimeStep;
+    double _fixedTimeStepAccumulator;
+    unsigned int _maxFixedStepsPerFrame;
+    bool _unthrottled;
+    bool _renderingEnabled;
     
     /* The GLView, where everything is rendered */
     GLView *_openGLView;
@@ -460,6 +510,10 @@ protected:
     LabelAtlas *_FPSLabel;
     LabelAtlas *_drawnBatchesLabel;
     LabelAtlas *_drawnVerticesLabel;
+    LabelAtlas *_frameTimeLabel;
+#if CC_ENABLE_REF_ALLOCATOR
+    LabelAtlas *_refAllocationsLabel;
+#endif
     
     /** Whether or not the Director is paused */
     bool _paused;
@@ -468,6 +522,9 @@ protected:
     unsigned int _totalFrames;
     unsigned int _frames;
     float _secondsPerFrame;
+
+    /* monotonic frame time statistics */
+    FrameStats _frameStats;
     
     /* The running scene */
     Scene *_runningScene;
@@ -25,14 +25,77 @@
 #include "base/CCEventCustom.h"
 #include "base/ccMacros.h"
 #include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
 
 NS_CC_BEGIN
 
+namespace
+{
+    struct EventNameRegistry
+    {
+        std::mutex mutex;
+        // Keys of an unordered_map keep their address on rehash, so the names can be referenced directly.
+        std::unordered_map<std::string, int> ids;
+        std::vector<const std::string*> names;
+    };
+    
+    EventNameRegistry& getEventNameRegistry()
+    {
+        static EventNameRegistry registry;
+        return registry;
+    }
+}
+
 EventCustom::EventCustom(const std::string& eventName)
 : Event(Type::CUSTOM)
 , _userData(nullptr)
-, _eventName(eventName)
+, _eventID(getEventIDForName(eventName))
+, _eventName(nullptr)
+{
+}
+
+EventCustom::EventCustom(int eventID)
+: Event(Type::CUSTOM)
+, _userData(nullptr)
+, _eventID(eventID)
+, _eventName(nullptr)
+{
+}
+
+const std::string& EventCustom::getEventName() const
+{
+    // Resolved lazily, dispatching by ID doesn't need the name nor the registry lock.
+    if (_eventName == nullptr)
+    {
+        _eventName = &getEventNameForID(_eventID);
+    }
+    return *_eventName;
+}
+
+int EventCustom::getEventIDForName(const std::string& eventName)
+{
+    auto& registry = getEventNameRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    
+    auto iter = registry.ids.find(eventName);
+    if (iter != registry.ids.end())
+        return iter->second;
+    
+    int eventID = static_cast<int>(registry.names.size());
+    iter = registry.ids.insert(std::make_pair(eventName, eventID)).first;
+    registry.names.push_back(&iter->first);
+    return eventID;
+}
+
+const std::string& EventCustom::getEventNameForID(int eventID)
 {
+    auto& registry = getEventNameRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    
+    CCASSERT(eventID >= 0 && eventID < static_cast<int>(registry.names.size()), "Invalid custom event ID!");
+    return *registry.names[eventID];
 }
 
 NS_CC_END
@@ -35,17 +35,33 @@ public:
     /** Constructor */
     EventCustom(const std::string& eventName);
     
+    /** Constructor with an event ID returned by `getEventIDForName`, it neither hashes nor allocates */
+    explicit EventCustom(int eventID);
+    
     /** Sets user data */
     inline void setUserData(void* data) { _userData = data; };
     
     /** Gets user data */
     inline void* getUserData() const { return _userData; };
     
-    /** Gets event name */
-    inline const std::string& getEventName() const { return _eventName; };
+    /** Gets event name, it is looked up the first time it is asked for */
+    const std::string& getEventName() const;
+    
+    /** Gets the interned event ID */
+    inline int getEventID() const { return _eventID; };
+    
+    /** Interns an event name and returns its ID.
+     *  The same name always returns the same ID, IDs are small integers starting from 0.
+     */
+    static int getEventIDForName(const std::string& eventName);
+    
+    /** Gets the event name of an interned event ID */
+    static const std::string& getEventNameForID(int eventID);
+    
 protected:
     void* _userData;       ///< User data
-    std::string _eventName;
+    int _eventID;
+    mutable const std::string* _eventName;
 };
 
 NS_CC_END
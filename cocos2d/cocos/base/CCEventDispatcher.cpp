@@ -105,7 +105,9 @@ static EventListener::ListenerID __getListenerID(Event* event)
 EventDispatcher::EventListenerVector::EventListenerVector() :
  _fixedListeners(nullptr),
  _sceneGraphListeners(nullptr),
- _gt0Index(0)
+ _gt0Index(0),
+ _dirtyFlag(DirtyFlag::NONE),
+ _customEventID(-1)
 {
 }
 
@@ -455,6 +457,17 @@ void EventDispatcher::forceAddEventListener(EventListener* listener)
         
         listeners = new EventListenerVector();
         _listenerMap.insert(std::make_pair(listenerID, listeners));
+        
+        if (listener->getType() == EventListener::Type::CUSTOM)
+        {
+            int eventID = static_cast<EventListenerCustom*>(listener)->getEventID();
+            if (eventID >= static_cast<int>(_customListeners.size()))
+            {
+                _customListeners.resize(eventID + 1, nullptr);
+            }
+            _customListeners[eventID] = listeners;
+            listeners->setCustomEventID(eventID);
+        }
     }
     else
     {
@@ -585,6 +598,13 @@ EventListenerCustom* EventDispatcher::addCustomEventListener(const std::string &
     return listener;
 }
 
+EventListenerCustom* EventDispatcher::addCustomEventListener(int eventID, const std::function<void(EventCustom*)>& callback)
+{
+    EventListenerCustom *listener = EventListenerCustom::create(eventID, callback);
+    addEventListenerWithFixedPriority(listener, 1);
+    return listener;
+}
+
 void EventDispatcher::removeEventListener(EventListener* listener)
 {
     if (listener == nullptr)
@@ -656,10 +676,7 @@ void EventDispatcher::removeEventListener(EventListener* listener)
 
         if (iter->second->empty())
         {
-            _priorityDirtyFlagMap.erase(listener->getListenerID());
-            auto list = iter->second;
-            iter = _listenerMap.erase(iter);
-            CC_SAFE_DELETE(list);
+            iter = eraseListeners(iter);
         }
         else
         {
@@ -793,14 +810,10 @@ void EventDispatcher::dispatchEvent(Event* event)
         return;
     }
     
-    auto listenerID = __getListenerID(event);
-    
-    sortEventListeners(listenerID);
-    
-    auto iter = _listenerMap.find(listenerID);
-    if (iter != _listenerMap.end())
+    auto listeners = getListenersForEvent(event);
+    if (listeners)
     {
-        auto listeners = iter->second;
+        sortEventListeners(listeners);
         
         auto onEvent = [&event](EventListener* listener) -> bool{
             event->setCurrentTarget(listener->getAssociatedNode());
@@ -821,12 +834,20 @@ void EventDispatcher::dispatchCustomEvent(const std::string &eventName, void *op
     dispatchEvent(&ev);
 }
 
+void EventDispatcher::dispatchCustomEvent(int eventID, void *optionalUserData)
+{
+    // Nobody listens to this event, no need to build it.
+    if (!_isEnabled || getCustomListeners(eventID) == nullptr)
+        return;
+    
+    EventCustom ev(eventID);
+    ev.setUserData(optionalUserData);
+    dispatchEvent(&ev);
+}
+
 
 void EventDispatcher::dispatchTouchEvent(EventTouch* event)
 {
-    sortEventListeners(EventListenerTouchOneByOne::LISTENER_ID);
-    sortEventListeners(EventListenerTouchAllAtOnce::LISTENER_ID);
-    
     auto oneByOneListeners = getListeners(EventListenerTouchOneByOne::LISTENER_ID);
     auto allAtOnceListeners = getListeners(EventListenerTouchAllAtOnce::LISTENER_ID);
     
@@ -834,6 +855,11 @@ void EventDispatcher::dispatchTouchEvent(EventTouch* event)
     if (nullptr == oneByOneListeners && nullptr == allAtOnceListeners)
         return;
     
+    if (oneByOneListeners)
+        sortEventListeners(oneByOneListeners);
+    if (allAtOnceListeners)
+        sortEventListeners(allAtOnceListeners);
+    
     bool isNeedsMutableSet = (oneByOneListeners && allAtOnceListeners);
     
     const std::vector<Touch*>& originalTouches = event->getTouches();
@@ -1015,75 +1041,71 @@ void EventDispatcher::dispatchTouchEvent(EventTouch* event)
     updateListeners(event);
 }
 
-void EventDispatcher::updateListeners(Event* event)
+void EventDispatcher::cleanUnregisteredListeners(EventListenerVector* listeners)
 {
-    CCASSERT(_inDispatch > 0, "If program goes here, there should be event in dispatch.");
+    if (listeners == nullptr)
+        return;
     
-    auto onUpdateListeners = [this](const EventListener::ListenerID& listenerID)
+    auto fixedPriorityListeners = listeners->getFixedPriorityListeners();
+    auto sceneGraphPriorityListeners = listeners->getSceneGraphPriorityListeners();
+    
+    if (sceneGraphPriorityListeners)
     {
-        auto listenersIter = _listenerMap.find(listenerID);
-        if (listenersIter == _listenerMap.end())
-            return;
-
-        auto listeners = listenersIter->second;
-        
-        auto fixedPriorityListeners = listeners->getFixedPriorityListeners();
-        auto sceneGraphPriorityListeners = listeners->getSceneGraphPriorityListeners();
-        
-        if (sceneGraphPriorityListeners)
+        for (auto iter = sceneGraphPriorityListeners->begin(); iter != sceneGraphPriorityListeners->end();)
         {
-            for (auto iter = sceneGraphPriorityListeners->begin(); iter != sceneGraphPriorityListeners->end();)
+            auto l = *iter;
+            if (!l->isRegistered())
             {
-                auto l = *iter;
-                if (!l->isRegistered())
-                {
-                    iter = sceneGraphPriorityListeners->erase(iter);
-                    l->release();
-                }
-                else
-                {
-                    ++iter;
-                }
+                iter = sceneGraphPriorityListeners->erase(iter);
+                l->release();
             }
-        }
-        
-        if (fixedPriorityListeners)
-        {
-            for (auto iter = fixedPriorityListeners->begin(); iter != fixedPriorityListeners->end();)
+            else
             {
-                auto l = *iter;
-                if (!l->isRegistered())
-                {
-                    iter = fixedPriorityListeners->erase(iter);
-                    l->release();
-                }
-                else
-                {
-                    ++iter;
-                }
+                ++iter;
             }
         }
-        
-        if (sceneGraphPriorityListeners && sceneGraphPriorityListeners->empty())
+    }
+    
+    if (fixedPriorityListeners)
+    {
+        for (auto iter = fixedPriorityListeners->begin(); iter != fixedPriorityListeners->end();)
         {
-            listeners->clearSceneGraphListeners();
+            auto l = *iter;
+            if (!l->isRegistered())
+            {
+                iter = fixedPriorityListeners->erase(iter);
+                l->release();
+            }
+            else
+            {
+                ++iter;
+            }
         }
+    }
+    
+    if (sceneGraphPriorityListeners && sceneGraphPriorityListeners->empty())
+    {
+        listeners->clearSceneGraphListeners();
+    }
 
-        if (fixedPriorityListeners && fixedPriorityListeners->empty())
-        {
-            listeners->clearFixedListeners();
-        }
-    };
+    if (fixedPriorityListeners && fixedPriorityListeners->empty())
+    {
+        listeners->clearFixedListeners();
+    }
+}
 
+void EventDispatcher::updateListeners(Event* event)
+{
+    CCASSERT(_inDispatch > 0, "If program goes here, there should be event in dispatch.");
     
     if (event->getType() == Event::Type::TOUCH)
     {
-        onUpdateListeners(EventListenerTouchOneByOne::LISTENER_ID);
-        onUpdateListeners(EventListenerTouchAllAtOnce::LISTENER_ID);
+        cleanUnregisteredListeners(getListeners(EventListenerTouchOneByOne::LISTENER_ID));
+        cleanUnregisteredListeners(getListeners(EventListenerTouchAllAtOnce::LISTENER_ID));
     }
     else
     {
-        onUpdateListeners(__getListenerID(event));
+        cleanUnregisteredListeners(getListenersForEvent(event));
     }
     
     if (_inDispatch > 1)
@@ -1095,9 +1117,7 @@ void EventDispatcher::updateListeners(Event* event)
     {
         if (iter->second->empty())
         {
-            _priorityDirtyFlagMap.erase(iter->first);
-            delete iter->second;
-            iter = _listenerMap.erase(iter);
+            iter = eraseListeners(iter);
         }
         else
         {
@@ -1135,24 +1155,18 @@ void EventDispatcher::updateDirtyFlagForSceneGraph()
     }
 }
 
-void EventDispatcher::sortEventListeners(const EventListener::ListenerID& listenerID)
+void EventDispatcher::sortEventListeners(EventListenerVector* listeners)
 {
-    DirtyFlag dirtyFlag = DirtyFlag::NONE;
-    
-    auto dirtyIter = _priorityDirtyFlagMap.find(listenerID);
-    if (dirtyIter != _priorityDirtyFlagMap.end())
-    {
-        dirtyFlag = dirtyIter->second;
-    }
+    DirtyFlag dirtyFlag = listeners->getDirtyFlag();
     
     if (dirtyFlag != DirtyFlag::NONE)
     {
         // Clear the dirty flag first, if `rootNode` is nullptr, then set its dirty flag of scene graph priority
-        dirtyIter->second = DirtyFlag::NONE;
+        listeners->setDirtyFlag(DirtyFlag::NONE);
 
         if ((int)dirtyFlag & (int)DirtyFlag::FIXED_PRIORITY)
         {
-            sortEventListenersOfFixedPriority(listenerID);
+            sortEventListenersOfFixedPriority(listeners);
         }
         
         if ((int)dirtyFlag & (int)DirtyFlag::SCENE_GRAPH_PRIORITY)
@@ -1160,22 +1174,18 @@ void EventDispatcher::sortEventListeners(const EventListener::ListenerID& listen
             auto rootNode = Director::getInstance()->getRunningScene();
             if (rootNode)
             {
-                sortEventListenersOfSceneGraphPriority(listenerID, rootNode);
+                sortEventListenersOfSceneGraphPriority(listeners, rootNode);
             }
             else
             {
-                dirtyIter->second = DirtyFlag::SCENE_GRAPH_PRIORITY;
+                listeners->setDirtyFlag(DirtyFlag::SCENE_GRAPH_PRIORITY);
             }
         }
     }
 }
 
-void EventDispatcher::sortEventListenersOfSceneGraphPriority(const EventListener::ListenerID& listenerID, Node* rootNode)
+void EventDispatcher::sortEventListenersOfSceneGraphPriority(EventListenerVector* listeners, Node* rootNode)
 {
-    auto listeners = getListeners(listenerID);
-    
-    if (listeners == nullptr)
-        return;
     auto sceneGraphListeners = listeners->getSceneGraphPriorityListeners();
     
     if (sceneGraphListeners == nullptr)
@@ -1201,13 +1211,8 @@ void EventDispatcher::sortEventListenersOfSceneGraphPriority(const EventListener
 #endif
 }
 
-void EventDispatcher::sortEventListenersOfFixedPriority(const EventListener::ListenerID& listenerID)
+void EventDispatcher::sortEventListenersOfFixedPriority(EventListenerVector* listeners)
 {
-    auto listeners = getListeners(listenerID);
-
-    if (listeners == nullptr)
-        return;
-    
     auto fixedListeners = listeners->getFixedPriorityListeners();
     if (fixedListeners == nullptr)
         return;
@@ -1249,6 +1254,28 @@ EventDispatcher::EventListenerVector* EventDispatcher::getListeners(const EventL
     return nullptr;
 }
 
+EventDispatcher::EventListenerVector* EventDispatcher::getListenersForEvent(Event* event)
+{
+    if (event->getType() == Event::Type::CUSTOM)
+    {
+        return getCustomListeners(static_cast<EventCustom*>(event)->getEventID());
+    }
+    
+    return getListeners(__getListenerID(event));
+}
+
+std::unordered_map<EventListener::ListenerID, EventDispatcher::EventListenerVector*>::iterator EventDispatcher::eraseListeners(std::unordered_map<EventListener::ListenerID, EventListenerVector*>::iterator iter)
+{
+    auto listeners = iter->second;
+    if (listeners->getCustomEventID() >= 0)
+    {
+        _customListeners[listeners->getCustomEventID()] = nullptr;
+    }
+    
+    delete listeners;
+    return _listenerMap.erase(iter);
+}
+
 void EventDispatcher::removeEventListenersForListenerID(const EventListener::ListenerID& listenerID)
 {
     auto listenerItemIter = _listenerMap.find(listenerID);
@@ -1289,13 +1316,12 @@ void EventDispatcher::removeEventListenersForListenerID(const EventListener::Lis
         
         // Remove the dirty flag according the 'listenerID'.
         // No need to check whether the dispatcher is dispatching event.
-        _priorityDirtyFlagMap.erase(listenerID);
+        listeners->setDirtyFlag(DirtyFlag::NONE);
         
         if (!_inDispatch)
         {
             listeners->clear();
-            delete listeners;
-            _listenerMap.erase(listenerItemIter);
+            eraseListeners(listenerItemIter);
         }
     }
     
@@ -1347,6 +1373,11 @@ void EventDispatcher::removeCustomEventListeners(const std::string& customEventN
     removeEventListenersForListenerID(customEventName);
 }
 
+void EventDispatcher::removeCustomEventListeners(int eventID)
+{
+    removeEventListenersForListenerID(EventCustom::getEventNameForID(eventID));
+}
+
 void EventDispatcher::removeAllEventListeners()
 {
     bool cleanMap = true;
@@ -1372,6 +1403,7 @@ void EventDispatcher::removeAllEventListeners()
     if (!_inDispatch && cleanMap)
     {
         _listenerMap.clear();
+        _customListeners.clear();
     }
 }
 
@@ -1403,15 +1435,11 @@ void EventDispatcher::setDirtyForNode(Node* node)
 
 void EventDispatcher::setDirty(const EventListener::ListenerID& listenerID, DirtyFlag flag)
 {    
-    auto iter = _priorityDirtyFlagMap.find(listenerID);
-    if (iter == _priorityDirtyFlagMap.end())
-    {
-        _priorityDirtyFlagMap.insert(std::make_pair(listenerID, flag));
-    }
-    else
+    auto listeners = getListeners(listenerID);
+    if (listeners)
     {
-        int ret = (int)flag | (int)iter->second;
-        iter->second = (DirtyFlag) ret;
+        int ret = (int)flag | (int)listeners->getDirtyFlag();
+        listeners->setDirtyFlag((DirtyFlag) ret);
     }
 }
 
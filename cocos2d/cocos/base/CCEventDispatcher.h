@@ -80,6 +80,11 @@ public:
      */
     EventListenerCustom* addCustomEventListener(const std::string &eventName, const std::function<void(EventCustom*)>& callback);
 
+    /** Adds a Custom event listener with an event ID returned by `EventCustom::getEventIDForName`.
+     It will use a fixed priority of 1.
+     */
+    EventListenerCustom* addCustomEventListener(int eventID, const std::function<void(EventCustom*)>& callback);
+
     /////////////////////////////////////////////
     
     // Removes event listener
@@ -98,6 +103,9 @@ public:
     /** Removes all custom listeners with the same event name */
     void removeCustomEventListeners(const std::string& customEventName);
 
+    /** Removes all custom listeners with the same event ID */
+    void removeCustomEventListeners(int eventID);
+
     /** Removes all listeners */
     void removeAllEventListeners();
 
@@ -133,6 +141,12 @@ public:
     /** Dispatches a Custom Event with a event name an optional user data */
     void dispatchCustomEvent(const std::string &eventName, void *optionalUserData = nullptr);
 
+    /** Dispatches a Custom Event with an event ID returned by `EventCustom::getEventIDForName` and an optional user data.
+     *  The listeners are looked up in a flat table, so it neither hashes the event name nor allocates.
+     *  It returns immediately if nobody listens to the event.
+     */
+    void dispatchCustomEvent(int eventID, void *optionalUserData = nullptr);
+
     /////////////////////////////////////////////
     
     /** Constructor of EventDispatcher */
@@ -156,6 +170,15 @@ protected:
     /** Sets the dirty flag for a node. */
     void setDirtyForNode(Node* node);
     
+    /// Priority dirty flag
+    enum class DirtyFlag
+    {
+        NONE = 0,
+        FIXED_PRIORITY = 1 << 0,
+        SCENE_GRAPH_PRIORITY = 1 << 1,
+        ALL = FIXED_PRIORITY | SCENE_GRAPH_PRIORITY
+    };
+    
     /**
      *  The vector to store event listeners with scene graph based priority and fixed priority.
      */
@@ -176,10 +199,16 @@ protected:
         inline std::vector<EventListener*>* getSceneGraphPriorityListeners() const { return _sceneGraphListeners; };
         inline ssize_t getGt0Index() const { return _gt0Index; };
         inline void setGt0Index(ssize_t index) { _gt0Index = index; };
+        inline DirtyFlag getDirtyFlag() const { return _dirtyFlag; };
+        inline void setDirtyFlag(DirtyFlag flag) { _dirtyFlag = flag; };
+        inline int getCustomEventID() const { return _customEventID; };
+        inline void setCustomEventID(int eventID) { _customEventID = eventID; };
     private:
         std::vector<EventListener*>* _fixedListeners;
         std::vector<EventListener*>* _sceneGraphListeners;
         ssize_t _gt0Index;
+        DirtyFlag _dirtyFlag;
+        int _customEventID;
     };
     
     /** Adds an event listener with item
@@ -197,6 +226,18 @@ protected:
     /** Gets event the listener list for the event listener type. */
     EventListenerVector* getListeners(const EventListener::ListenerID& listenerID);
     
+    /** Gets the listener list for the custom event ID from the flat table, returns nullptr if there isn't any. */
+    inline EventListenerVector* getCustomListeners(int eventID) const
+    {
+        return (eventID >= 0 && eventID < static_cast<int>(_customListeners.size())) ? _customListeners[eventID] : nullptr;
+    }
+    
+    /** Gets the listener list that an event should be dispatched to. Custom events are looked up by their ID. */
+    EventListenerVector* getListenersForEvent(Event* event);
+    
+    /** Erases a listener list from the listener map and the custom event table, and deletes it. */
+    std::unordered_map<EventListener::ListenerID, EventListenerVector*>::iterator eraseListeners(std::unordered_map<EventListener::ListenerID, EventListenerVector*>::iterator iter);
+    
     /** Update dirty flag */
     void updateDirtyFlagForSceneGraph();
     
@@ -204,19 +245,22 @@ protected:
     void removeEventListenersForListenerID(const EventListener::ListenerID& listenerID);
     
     /** Sort event listener */
-    void sortEventListeners(const EventListener::ListenerID& listenerID);
+    void sortEventListeners(EventListenerVector* listeners);
     
     /** Sorts the listeners of specified type by scene graph priority */
-    void sortEventListenersOfSceneGraphPriority(const EventListener::ListenerID& listenerID, Node* rootNode);
+    void sortEventListenersOfSceneGraphPriority(EventListenerVector* listeners, Node* rootNode);
     
     /** Sorts the listeners of specified type by fixed priority */
-    void sortEventListenersOfFixedPriority(const EventListener::ListenerID& listenerID);
+    void sortEventListenersOfFixedPriority(EventListenerVector* listeners);
     
     /** Updates all listeners
      *  1) Removes all listener items that have been marked as 'removed' when dispatching event.
      *  2) Adds all listener items that have been marked as 'added' when dispatching event.
      */
     void updateListeners(Event* event);
+    
+    /** Removes the listener items that have been marked as 'removed' from a listener list. */
+    void cleanUnregisteredListeners(EventListenerVector* listeners);
 
     /** Touch event needs to be processed different with other events since it needs support ALL_AT_ONCE and ONE_BY_NONE mode. */
     void dispatchTouchEvent(EventTouch* event);
@@ -230,15 +274,6 @@ protected:
     /** Dispatches event to listeners with a specified listener type */
     void dispatchEventToListeners(EventListenerVector* listeners, const std::function<bool(EventListener*)>& onEvent);
     
-    /// Priority dirty flag
-    enum class DirtyFlag
-    {
-        NONE = 0,
-        FIXED_PRIORITY = 1 << 0,
-        SCENE_GRAPH_PRIORITY = 1 << 1,
-        ALL = FIXED_PRIORITY | SCENE_GRAPH_PRIORITY
-    };
-    
     /** Sets the dirty flag for a specified listener ID */
     void setDirty(const EventListener::ListenerID& listenerID, DirtyFlag flag);
     
@@ -248,8 +283,8 @@ protected:
     /** Listeners map */
     std::unordered_map<EventListener::ListenerID, EventListenerVector*> _listenerMap;
     
-    /** The map of dirty flag */
-    std::unordered_map<EventListener::ListenerID, DirtyFlag> _priorityDirtyFlagMap;
+    /** Custom event listeners indexed by interned event ID, they are also owned by `_listenerMap` */
+    std::vector<EventListenerVector*> _customListeners;
     
     /** The map of node and event listeners */
     std::unordered_map<Node*, std::vector<EventListener*>*> _nodeListenersMap;
@@ -29,6 +29,7 @@ NS_CC_BEGIN
 
 EventListenerCustom::EventListenerCustom()
 : _onCustomEvent(nullptr)
+, _eventID(-1)
 {
 }
 
@@ -46,11 +47,17 @@ EventListenerCustom* EventListenerCustom::create(const std::string& eventName, c
     return ret;
 }
 
+EventListenerCustom* EventListenerCustom::create(int eventID, const std::function<void(EventCustom*)>& callback)
+{
+    return create(EventCustom::getEventNameForID(eventID), callback);
+}
+
 bool EventListenerCustom::init(const ListenerID& listenerId, const std::function<void(EventCustom*)>& callback)
 {
     bool ret = false;
     
     _onCustomEvent = callback;
+    _eventID = EventCustom::getEventIDForName(listenerId);
     
     auto listener = [this](Event* event){
         if (_onCustomEvent != nullptr)
@@ -58,6 +58,12 @@ public:
      */
     static EventListenerCustom* create(const std::string& eventName, const std::function<void(EventCustom*)>& callback);
     
+    /** Creates an event listener with an event ID returned by `EventCustom::getEventIDForName` and callback. */
+    static EventListenerCustom* create(int eventID, const std::function<void(EventCustom*)>& callback);
+    
+    /** Gets the interned ID of the event this listener listens to. */
+    inline int getEventID() const { return _eventID; };
+    
     /// Overrides
     virtual bool checkAvailable() override;
     virtual EventListenerCustom* clone() override;
@@ -71,6 +77,7 @@ CC_CONSTRUCTOR_ACCESS:
     
 protected:
     std::function<void(EventCustom*)> _onCustomEvent;
+    int _eventID;
     
     friend class LuaEventListenerCustom;
 };
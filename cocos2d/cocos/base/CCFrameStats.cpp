@@ -0,0 +1,273 @@
+/****************************************************************************
+ Copyright (c) 2013-2014 Chukong Technologies Inc.
+
+ http://www.cocos2d-x.org
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#include "base/CCFrameStats.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+NS_CC_BEGIN
+
+// Values below 2^(SUB_BUCKET_BITS + 1) have their own bucket.
+static const int SUB_BUCKET_BITS = 5;
+static const int SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+static const int LINEAR_BUCKET_COUNT = SUB_BUCKET_COUNT * 2;
+static const int BUCKET_COUNT = LINEAR_BUCKET_COUNT + (32 - SUB_BUCKET_BITS - 1) * SUB_BUCKET_COUNT;
+
+static int getHighestBit(unsigned int value)
+{
+    int bit = 0;
+    while (value >>= 1)
+        ++bit;
+    return bit;
+}
+
+FrameTimeHistogram::FrameTimeHistogram()
+: _buckets(BUCKET_COUNT, 0)
+{
+    reset();
+}
+
+int FrameTimeHistogram::getBucketIndex(unsigned int value)
+{
+    if (value < LINEAR_BUCKET_COUNT)
+        return value;
+
+    int highestBit = getHighestBit(value);
+    int shift = highestBit - SUB_BUCKET_BITS;
+    int subBucket = (value >> shift) - SUB_BUCKET_COUNT;
+    return LINEAR_BUCKET_COUNT + (highestBit - SUB_BUCKET_BITS - 1) * SUB_BUCKET_COUNT + subBucket;
+}
+
+unsigned int FrameTimeHistogram::getBucketUpperBound(int index)
+{
+    if (index < LINEAR_BUCKET_COUNT)
+        return index;
+
+    int range = (index - LINEAR_BUCKET_COUNT) / SUB_BUCKET_COUNT;
+    int subBucket = (index - LINEAR_BUCKET_COUNT) % SUB_BUCKET_COUNT;
+    int shift = range + 1;
+    unsigned long long lowerBound = (unsigned long long)(SUB_BUCKET_COUNT + subBucket) << shift;
+    unsigned long long upperBound = lowerBound + (1ULL << shift) - 1;
+    return upperBound > 0xffffffffULL ? 0xffffffffU : (unsigned int)upperBound;
+}
+
+void FrameTimeHistogram::record(unsigned int microseconds)
+{
+    ++_buckets[getBucketIndex(microseconds)];
+    ++_count;
+    _total += microseconds;
+    if (microseconds < _min)
+        _min = microseconds;
+    if (microseconds > _max)
+        _max = microseconds;
+}
+
+void FrameTimeHistogram::reset()
+{
+    std::fill(_buckets.begin(), _buckets.end(), 0);
+    _count = 0;
+    _min = 0xffffffffU;
+    _max = 0;
+    _total = 0;
+}
+
+double FrameTimeHistogram::getMean() const
+{
+    return _count ? (double)_total / _count : 0.0;
+}
+
+unsigned int FrameTimeHistogram::getPercentile(float percentile) const
+{
+    if (_count == 0)
+        return 0;
+
+    unsigned long long target = (unsigned long long)(percentile / 100.0 * _count + 0.5);
+    if (target < 1)
+        target = 1;
+    if (target > _count)
+        target = _count;
+
+    unsigned long long seen = 0;
+    for (int i = 0; i < BUCKET_COUNT; ++i)
+    {
+        seen += _buckets[i];
+        if (seen >= target)
+        {
+            unsigned int bound = getBucketUpperBound(i);
+            return bound < _max ? bound : _max;
+        }
+    }
+    return _max;
+}
+
+// implementation of FrameStats
+
+FrameStats::FrameStats()
+: _hasLastFrame(false)
+, _hitchThreshold(1000000 / 30)
+, _hitchCount(0)
+{
+    memset(_lastDurations, 0, sizeof(_lastDurations));
+}
+
+unsigned int FrameStats::toMicroseconds(const Clock::duration& duration)
+{
+    auto count = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+    if (count < 0)
+        return 0;
+    return count > 0xffffffffLL ? 0xffffffffU : (unsigned int)count;
+}
+
+void FrameStats::beginFrame()
+{
+    auto now = Clock::now();
+    auto& frameStart = _phaseStarts[(int)Phase::FRAME];
+
+    if (_hasLastFrame)
+    {
+        unsigned int interval = toMicroseconds(now - frameStart);
+        _lastDurations[(int)Phase::FRAME] = interval;
+        _histograms[(int)Phase::FRAME].record(interval);
+        if (interval > _hitchThreshold)
+            ++_hitchCount;
+    }
+
+    frameStart = now;
+    _hasLastFrame = true;
+}
+
+void FrameStats::skipNextFrameInterval()
+{
+    _hasLastFrame = false;
+}
+
+void FrameStats::beginPhase(Phase phase)
+{
+    _phaseStarts[(int)phase] = Clock::now();
+}
+
+void FrameStats::endPhase(Phase phase)
+{
+    unsigned int duration = toMicroseconds(Clock::now() - _phaseStarts[(int)phase]);
+    _lastDurations[(int)phase] = duration;
+    _histograms[(int)phase].record(duration);
+}
+
+void FrameStats::setHitchThreshold(float seconds)
+{
+    _hitchThreshold = (unsigned int)(seconds * 1000000);
+}
+
+float FrameStats::getCurrentFrameElapsed() const
+{
+    return toMicroseconds(Clock::now() - _phaseStarts[(int)Phase::FRAME]) / 1000000.0f;
+}
+
+float FrameStats::getLastDuration(Phase phase) const
+{
+    return _lastDurations[(int)phase] / 1000000.0f;
+}
+
+void FrameStats::reset()
+{
+    for (auto& histogram : _histograms)
+    {
+        histogram.reset();
+    }
+    memset(_lastDurations, 0, sizeof(_lastDurations));
+    _hitchCount = 0;
+    _hasLastFrame = false;
+}
+
+const char* FrameStats::getPhaseName(Phase phase)
+{
+    switch (phase)
+    {
+        case Phase::FRAME: return "frame";
+        case Phase::UPDATE: return "update";
+        case Phase::VISIT: return "visit";
+        case Phase::RENDER: return "render";
+        case Phase::SWAP: return "swap";
+        default: return "unknown";
+    }
+}
+
+std::string FrameStats::getSummary() const
+{
+    char buf[256];
+    std::string ret;
+
+    snprintf(buf, sizeof(buf), "%-9s %8s %8s %8s %8s %8s %8s\n", "phase(ms)", "count", "mean", "p50", "p95", "p99", "max");
+    ret += buf;
+
+    for (int i = 0; i < (int)Phase::COUNT; ++i)
+    {
+        const auto& histogram = _histograms[i];
+        snprintf(buf, sizeof(buf), "%-9s %8u %8.2f %8.2f %8.2f %8.2f %8.2f\n",
+                 getPhaseName((Phase)i),
+                 histogram.getCount(),
+                 histogram.getMean() / 1000.0,
+                 histogram.getPercentile(50) / 1000.0,
+                 histogram.getPercentile(95) / 1000.0,
+                 histogram.getPercentile(99) / 1000.0,
+                 histogram.getMax() / 1000.0);
+        ret += buf;
+    }
+
+    snprintf(buf, sizeof(buf), "hitches (> %.2f ms): %u\n", _hitchThreshold / 1000.0, _hitchCount);
+    ret += buf;
+    return ret;
+}
+
+std::string FrameStats::exportJSON() const
+{
+    char buf[256];
+    std::string ret;
+
+    snprintf(buf, sizeof(buf), "{\"unit\":\"us\",\"hitchThreshold\":%u,\"hitches\":%u,\"phases\":{", _hitchThreshold, _hitchCount);
+    ret += buf;
+
+    for (int i = 0; i < (int)Phase::COUNT; ++i)
+    {
+        const auto& histogram = _histograms[i];
+        snprintf(buf, sizeof(buf), "%s\"%s\":{\"count\":%u,\"mean\":%.1f,\"min\":%u,\"p50\":%u,\"p95\":%u,\"p99\":%u,\"max\":%u}",
+                 i > 0 ? "," : "",
+                 getPhaseName((Phase)i),
+                 histogram.getCount(),
+                 histogram.getMean(),
+                 histogram.getMin(),
+                 histogram.getPercentile(50),
+                 histogram.getPercentile(95),
+                 histogram.getPercentile(99),
+                 histogram.getMax());
+        ret += buf;
+    }
+
+    ret += "}}\n";
+    return ret;
+}
+
+NS_CC_END
@@ -0,0 +1,162 @@
+/****************************************************************************
+ Copyright (c) 2013-2014 Chukong Technologies Inc.
+
+ http://www.cocos2d-x.org
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#ifndef __BASE_CCFRAMESTATS_H__
+#define __BASE_CCFRAMESTATS_H__
+
+#include "base/CCPlatformMacros.h"
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+NS_CC_BEGIN
+
+/**
+ * @addtogroup global
+ * @{
+ */
+
+/** Histogram of durations in microseconds with a bounded relative error, in the spirit of HdrHistogram.
+
+ Values below 64µs have their own bucket, larger values are grouped in power of two ranges split in 32
+ linear sub-buckets, so a percentile is never off by more than ~3% whatever the magnitude.
+ Recording is O(1) and never allocates.
+ */
+class CC_DLL FrameTimeHistogram
+{
+public:
+    FrameTimeHistogram();
+
+    /** records a duration */
+    void record(unsigned int microseconds);
+
+    /** drops all the recorded durations */
+    void reset();
+
+    /** number of recorded durations */
+    inline unsigned int getCount() const { return _count; }
+
+    /** smallest recorded duration, 0 if nothing was recorded */
+    inline unsigned int getMin() const { return _count ? _min : 0; }
+
+    /** largest recorded duration */
+    inline unsigned int getMax() const { return _max; }
+
+    /** average of the recorded durations */
+    double getMean() const;
+
+    /** duration below which `percentile` percent of the recorded durations are, e.g. getPercentile(99) */
+    unsigned int getPercentile(float percentile) const;
+
+protected:
+    static int getBucketIndex(unsigned int value);
+    static unsigned int getBucketUpperBound(int index);
+
+    std::vector<unsigned int> _buckets;
+    unsigned int _count;
+    unsigned int _min;
+    unsigned int _max;
+    unsigned long long _total;
+};
+
+/** Frame time statistics of the Director
+
+ Measured with a monotonic clock, it keeps a FrameTimeHistogram of the frame intervals and of every
+ phase of Director::drawScene, and counts the hitches: frames longer than a configurable threshold.
+ */
+class CC_DLL FrameStats
+{
+public:
+    enum class Phase
+    {
+        FRAME,      ///< interval between two frames
+        UPDATE,     ///< scheduler update
+        VISIT,      ///< scene graph visit
+        RENDER,     ///< renderer
+        SWAP,       ///< buffer swap
+        COUNT
+    };
+
+    FrameStats();
+
+    /** called at the beginning of every frame, records the interval since the previous one */
+    void beginFrame();
+
+    /** the interval between the previous frame and the next one won't be recorded, e.g. after a pause */
+    void skipNextFrameInterval();
+
+    /** starts timing a phase of the current frame */
+    void beginPhase(Phase phase);
+
+    /** stops timing a phase of the current frame and records its duration */
+    void endPhase(Phase phase);
+
+    /** sets the duration in seconds above which a frame is counted as a hitch. 1/30s by default */
+    void setHitchThreshold(float seconds);
+    inline float getHitchThreshold() const { return _hitchThreshold / 1000000.0f; }
+
+    /** number of frames longer than the hitch threshold */
+    inline unsigned int getHitchCount() const { return _hitchCount; }
+
+    /** histogram of a phase */
+    inline const FrameTimeHistogram& getHistogram(Phase phase) const { return _histograms[(int)phase]; }
+
+    /** seconds elapsed since the last call to beginFrame() */
+    float getCurrentFrameElapsed() const;
+
+    /** duration in seconds of the last recorded phase */
+    float getLastDuration(Phase phase) const;
+
+    /** drops all the statistics */
+    void reset();
+
+    /** human readable summary: percentiles, max and hitches of every phase in milliseconds */
+    std::string getSummary() const;
+
+    /** JSON document with the same data as the summary, meant to be compared between CI runs */
+    std::string exportJSON() const;
+
+    /** name of a phase as used in the summary and the JSON document */
+    static const char* getPhaseName(Phase phase);
+
+protected:
+    typedef std::chrono::steady_clock Clock;
+
+    static unsigned int toMicroseconds(const Clock::duration& duration);
+
+    FrameTimeHistogram _histograms[(int)Phase::COUNT];
+    Clock::time_point _phaseStarts[(int)Phase::COUNT];
+    unsigned int _lastDurations[(int)Phase::COUNT];
+    bool _hasLastFrame;
+    unsigned int _hitchThreshold;
+    unsigned int _hitchCount;
+};
+
+// end of global group
+/// @}
+
+NS_CC_END
+
+#endif // __BASE_CCFRAMESTATS_H__
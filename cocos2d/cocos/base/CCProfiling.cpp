@@ -25,7 +25,10 @@ THE SOFTWARE.
 ****************************************************************************/
 #include "base/CCProfiling.h"
 
+#include <algorithm>
 #include <chrono>
+#include <stdio.h>
+#include "base/ccMacros.h"
 
 using namespace std;
 
@@ -182,5 +185,283 @@ void ProfilingResetTimingBlock(const char *timerName)
     timer->reset();
 }
 
+// implementation of TraceProfiler
+
+TraceProfiler* TraceProfiler::getInstance()
+{
+    // Never destroyed, loader threads may still record events during exit.
+    static TraceProfiler* s_sharedTraceProfiler = new TraceProfiler();
+    return s_sharedTraceProfiler;
+}
+
+TraceProfiler::TraceProfiler()
+: _origin(chrono::steady_clock::now())
+, _enabled(false)
+, _clearTime(0)
+, _threadCount(0)
+, _exitedEventCount(0)
+{
+}
+
+long long TraceProfiler::now() const
+{
+    return chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - _origin).count();
+}
+
+void TraceProfiler::setEnabled(bool enabled)
+{
+    _enabled.store(enabled, memory_order_relaxed);
+}
+
+// The name is kept aside until the thread records its first event, so that naming a thread doesn't allocate its buffer.
+static std::string& getCurrentThreadName()
+{
+    static thread_local std::string s_threadName;
+    return s_threadName;
+}
+
+struct TraceProfiler::ThreadBufferOwner
+{
+    ThreadBuffer* buffer;
+    ~ThreadBufferOwner();
+};
+
+// Trivially destructible, so it can still be read by the destructors of the other thread_local objects of the thread.
+static thread_local bool s_threadBufferReleased = false;
+
+TraceProfiler::ThreadBufferOwner::~ThreadBufferOwner()
+{
+    s_threadBufferReleased = true;
+    if (buffer)
+    {
+        TraceProfiler::getInstance()->releaseThreadBuffer(buffer);
+    }
+}
+
+TraceProfiler::ThreadBuffer* TraceProfiler::getThreadBuffer(bool create)
+{
+    if (s_threadBufferReleased)
+    {
+        return nullptr;
+    }
+
+    static thread_local ThreadBufferOwner s_owner = { nullptr };
+    if (s_owner.buffer == nullptr && create)
+    {
+        auto buffer = new ThreadBuffer();
+        buffer->events.reset(new Event[EVENTS_PER_THREAD]());
+        buffer->count.store(0, memory_order_relaxed);
+
+        lock_guard<mutex> lock(_buffersMutex);
+        buffer->tid = ++_threadCount;
+        buffer->name = getCurrentThreadName();
+        if (buffer->name.empty())
+        {
+            char name[32];
+            snprintf(name, sizeof(name), "thread %d", buffer->tid);
+            buffer->name = name;
+        }
+        _buffers.push_back(buffer);
+        s_owner.buffer = buffer;
+    }
+    return s_owner.buffer;
+}
+
+void TraceProfiler::releaseThreadBuffer(ThreadBuffer* buffer)
+{
+    // the thread is exiting, nothing writes the buffer anymore
+    ExitedThread thread;
+    thread.tid = buffer->tid;
+    size_t count = buffer->count.load(memory_order_relaxed);
+    size_t begin = count > EVENTS_PER_THREAD ? count - EVENTS_PER_THREAD : 0;
+    long long clearTime = _clearTime.load(memory_order_relaxed);
+    thread.events.reserve(count - begin);
+    for (size_t i = begin; i < count; ++i)
+    {
+        const Event& event = buffer->events[i % EVENTS_PER_THREAD];
+        RecordedEvent recorded = {
+            event.name.load(memory_order_relaxed),
+            event.category.load(memory_order_relaxed),
+            event.start.load(memory_order_relaxed),
+            event.duration.load(memory_order_relaxed)
+        };
+        if (recorded.start >= clearTime)
+            thread.events.push_back(recorded);
+    }
+
+    {
+        lock_guard<mutex> lock(_buffersMutex);
+        thread.name = buffer->name;
+        _buffers.erase(std::find(_buffers.begin(), _buffers.end(), buffer));
+
+        if (!thread.events.empty())
+        {
+            _exitedEventCount += thread.events.size();
+            _exitedThreads.push_back(std::move(thread));
+            // the events of the threads which exited first are dropped
+            while (_exitedEventCount > EVENTS_PER_THREAD)
+            {
+                _exitedEventCount -= _exitedThreads.front().events.size();
+                _exitedThreads.erase(_exitedThreads.begin());
+            }
+        }
+    }
+    delete buffer;
+}
+
+void TraceProfiler::setCurrentThreadName(const char* name)
+{
+    getCurrentThreadName() = name;
+
+    auto buffer = getThreadBuffer(false);
+    if (buffer)
+    {
+        lock_guard<mutex> lock(_buffersMutex);
+        buffer->name = name;
+    }
+}
+
+void TraceProfiler::recordEvent(const char* name, const char* category, long long start, long long duration)
+{
+    auto buffer = getThreadBuffer();
+    if (buffer == nullptr)
+        return;
+    size_t index = buffer->count.load(memory_order_relaxed);
+    Event& event = buffer->events[index % EVENTS_PER_THREAD];
+    // mark the slot as being written, the fields must not be stored before the mark
+    event.sequence.store(0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    event.name.store(name, memory_order_relaxed);
+    event.category.store(category, memory_order_relaxed);
+    event.start.store(start, memory_order_relaxed);
+    event.duration.store(duration, memory_order_relaxed);
+    // publish the event to exportChromeTrace
+    event.sequence.store(index + 1, memory_order_release);
+    buffer->count.store(index + 1, memory_order_release);
+}
+
+void TraceProfiler::clear()
+{
+    // Buffers belong to their threads, just hide the events older than now.
+    _clearTime.store(now(), memory_order_relaxed);
+
+    lock_guard<mutex> lock(_buffersMutex);
+    _exitedThreads.clear();
+    _exitedEventCount = 0;
+}
+
+static void appendJSONString(std::string& out, const char* str)
+{
+    out += '"';
+    for (const char* c = str ? str : ""; *c; ++c)
+    {
+        switch (*c)
+        {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(*c) < 0x20)
+                {
+                    char escaped[8];
+                    snprintf(escaped, sizeof(escaped), "\\u%04x", *c);
+                    out += escaped;
+                }
+                else
+                    out += *c;
+                break;
+        }
+    }
+    out += '"';
+}
+
+void TraceProfiler::appendEvent(std::string& out, int tid, const char* name, const char* category, long long start, long long duration)
+{
+    char buf[128];
+    out += ",{\"name\":";
+    appendJSONString(out, name);
+    out += ",\"cat\":";
+    appendJSONString(out, category);
+    snprintf(buf, sizeof(buf), ",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%lld,\"dur\":%lld}", tid, start, duration);
+    out += buf;
+}
+
+std::string TraceProfiler::exportChromeTrace() const
+{
+    char buf[256];
+    std::string out = "{\"traceEvents\":[";
+    bool first = true;
+    long long clearTime = _clearTime.load(memory_order_relaxed);
+
+    lock_guard<mutex> lock(_buffersMutex);
+    for (const auto& buffer : _buffers)
+    {
+        if (!first)
+            out += ",";
+        first = false;
+        snprintf(buf, sizeof(buf), "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":", buffer->tid);
+        out += buf;
+        appendJSONString(out, buffer->name.c_str());
+        out += "}}";
+
+        size_t count = buffer->count.load(memory_order_acquire);
+        size_t begin = count > EVENTS_PER_THREAD ? count - EVENTS_PER_THREAD : 0;
+        for (size_t i = begin; i < count; ++i)
+        {
+            // The owner thread may be overwriting the slot after wrapping around: copy it and
+            // drop the copy unless the slot still holds event i before and after.
+            const Event& event = buffer->events[i % EVENTS_PER_THREAD];
+            if (event.sequence.load(memory_order_acquire) != i + 1)
+                continue;
+            const char* name = event.name.load(memory_order_relaxed);
+            const char* category = event.category.load(memory_order_relaxed);
+            long long start = event.start.load(memory_order_relaxed);
+            long long duration = event.duration.load(memory_order_relaxed);
+            atomic_thread_fence(memory_order_acquire);
+            if (event.sequence.load(memory_order_relaxed) != i + 1)
+                continue;
+
+            if (start < clearTime)
+                continue;
+
+            appendEvent(out, buffer->tid, name, category, start, duration);
+        }
+    }
+    for (const auto& thread : _exitedThreads)
+    {
+        if (!first)
+            out += ",";
+        first = false;
+        snprintf(buf, sizeof(buf), "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":", thread.tid);
+        out += buf;
+        appendJSONString(out, thread.name.c_str());
+        out += "}}";
+
+        for (const auto& event : thread.events)
+        {
+            appendEvent(out, thread.tid, event.name, event.category, event.start, event.duration);
+        }
+    }
+    out += "],\"displayTimeUnit\":\"ms\"}\n";
+    return out;
+}
+
+bool TraceProfiler::dumpChromeTrace(const std::string& filename) const
+{
+    std::string json = exportChromeTrace();
+
+    FILE* fp = fopen(filename.c_str(), "wb");
+    if (fp == nullptr)
+    {
+        CCLOG("TraceProfiler: can't open %s for writing", filename.c_str());
+        return false;
+    }
+
+    size_t written = fwrite(json.data(), 1, json.size(), fp);
+    fclose(fp);
+    return written == json.size();
+}
+
 NS_CC_END
 
@@ -28,6 +28,10 @@ THE SOFTWARE.
 
 #include <string>
 #include <chrono>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
 #include "base/ccConfig.h"
 #include "base/CCRef.h"
 #include "base/CCMap.h"
@@ -147,6 +151,148 @@ extern void ProfilingBeginTimingBlock(const char *timerName);
 extern void ProfilingEndTimingBlock(const char *timerName);
 extern void ProfilingResetTimingBlock(const char *timerName);
 
+/** TraceProfiler
+ Always available, low overhead instrumentation of scoped blocks.
+
+ Unlike Profiler, it is not compiled out: when it is disabled a trace scope only costs a relaxed atomic load.
+ When it is enabled, every thread records complete events (name, category, start, duration) into its own
+ ring buffer without locking, the oldest events being overwritten once the buffer is full.
+ The buffer of a thread is freed when the thread exits, its last events are kept for the export, at most
+ EVENTS_PER_THREAD for all the exited threads.
+ The events can be exported in the Chrome trace event format and opened in chrome://tracing.
+
+ Names and categories are stored as pointers, they must be string literals or outlive the recorded events.
+
+ Usage:
+    CC_TRACE_SCOPE("render", "director");
+ Or from the console:
+    trace start | stop | clear | json | dump [filename]
+ */
+class CC_DLL TraceProfiler
+{
+public:
+    /** Number of events kept by each thread */
+    static const size_t EVENTS_PER_THREAD = 8 * 1024;
+
+    /** returns the singleton
+     * @js NA
+     * @lua NA
+     */
+    static TraceProfiler* getInstance();
+
+    /** enables or disables the recording of events */
+    void setEnabled(bool enabled);
+    /** whether or not events are recorded */
+    inline bool isEnabled() const { return _enabled.load(std::memory_order_relaxed); }
+
+    /** sets the name shown in the trace for the calling thread, the name is copied */
+    void setCurrentThreadName(const char* name);
+
+    /** records a complete event for the calling thread, times are in microseconds as returned by `now` */
+    void recordEvent(const char* name, const char* category, long long start, long long duration);
+
+    /** drops the events recorded so far */
+    void clear();
+
+    /** returns the recorded events as a Chrome trace JSON document */
+    std::string exportChromeTrace() const;
+
+    /** writes the Chrome trace JSON document to a file, returns false if the file can't be written */
+    bool dumpChromeTrace(const std::string& filename) const;
+
+    /** microseconds elapsed since the profiler was created, from a monotonic clock */
+    long long now() const;
+
+protected:
+    // A slot of a ring buffer. Its owner thread may overwrite it while it's exported, so the fields are
+    // atomics and `sequence` (the event index + 1, 0 while it's written) tells whether a copy is torn.
+    struct Event
+    {
+        std::atomic<size_t> sequence;
+        std::atomic<const char*> name;
+        std::atomic<const char*> category;
+        std::atomic<long long> start;
+        std::atomic<long long> duration;
+    };
+
+    struct ThreadBuffer
+    {
+        int tid;
+        std::string name;
+        std::unique_ptr<Event[]> events;
+        std::atomic<size_t> count;
+    };
+
+    // the events of a thread which exited, copied out of its buffer
+    struct RecordedEvent
+    {
+        const char* name;
+        const char* category;
+        long long start;
+        long long duration;
+    };
+
+    struct ExitedThread
+    {
+        int tid;
+        std::string name;
+        std::vector<RecordedEvent> events;
+    };
+
+    // releases the buffer of its thread when the thread exits
+    struct ThreadBufferOwner;
+
+    TraceProfiler();
+    /** returns the buffer of the calling thread, nullptr once the thread is exiting */
+    ThreadBuffer* getThreadBuffer(bool create = true);
+    /** called when the thread owning the buffer exits: keeps its events and frees it */
+    void releaseThreadBuffer(ThreadBuffer* buffer);
+    static void appendEvent(std::string& out, int tid, const char* name, const char* category, long long start, long long duration);
+
+    std::chrono::steady_clock::time_point _origin;
+    std::atomic<bool> _enabled;
+    std::atomic<long long> _clearTime;
+
+    mutable std::mutex _buffersMutex;
+    std::vector<ThreadBuffer*> _buffers;
+    int _threadCount;
+    std::vector<ExitedThread> _exitedThreads;
+    size_t _exitedEventCount;
+};
+
+/** records the lifetime of the object as a TraceProfiler event */
+class CC_DLL ScopedTrace
+{
+public:
+    ScopedTrace(const char* name, const char* category)
+    : _name(name)
+    , _category(category)
+    , _start(-1)
+    {
+        auto profiler = TraceProfiler::getInstance();
+        if (profiler->isEnabled())
+            _start = profiler->now();
+    }
+
+    ~ScopedTrace()
+    {
+        if (_start >= 0)
+        {
+            auto profiler = TraceProfiler::getInstance();
+            profiler->recordEvent(_name, _category, _start, profiler->now() - _start);
+        }
+    }
+
+private:
+    const char* _name;
+    const char* _category;
+    long long _start;
+};
+
+#define CC_TRACE_CONCAT_(__a__, __b__) __a__##__b__
+#define CC_TRACE_CONCAT(__a__, __b__) CC_TRACE_CONCAT_(__a__, __b__)
+#define CC_TRACE_SCOPE(__name__, __category__) cocos2d::ScopedTrace CC_TRACE_CONCAT(__ccTraceScope, __LINE__)(__name__, __category__)
+
 /*
  * cocos2d profiling categories
  * used to enable / disable profilers with granularity
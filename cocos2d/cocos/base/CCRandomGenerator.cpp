@@ -0,0 +1,162 @@
+/****************************************************************************
+ Copyright (c) 2013-2014 Chukong Technologies Inc.
+
+ http://www.cocos2d-x.org
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#include "base/CCRandomGenerator.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CC_RANDOM_USE_SSE 1
+#else
+#define CC_RANDOM_USE_SSE 0
+#endif
+
+NS_CC_BEGIN
+
+RandomGenerator::RandomGenerator(uint32_t seed)
+{
+    setSeed(seed);
+}
+
+void RandomGenerator::setSeed(uint32_t seed)
+{
+    _seed = seed;
+
+    // the states are spread from the seed by splitmix64, xorshift128 needs states that aren't all 0
+    uint64_t x = seed;
+    for (int i = 0; i < 16; i += 2)
+    {
+        x += 0x9E3779B97F4A7C15ull;
+        uint64_t z = x;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        z ^= z >> 31;
+        _state[i] = (uint32_t)z;
+        _state[i + 1] = (uint32_t)(z >> 32);
+    }
+    for (int i = 0; i < 4; ++i)
+    {
+        if ((_state[i] | _state[4 + i] | _state[8 + i] | _state[12 + i]) == 0)
+        {
+            _state[i] = 1;
+        }
+    }
+    _blockIndex = 4;
+}
+
+#if CC_RANDOM_USE_SSE
+
+// the 4 generators in a step: t = x ^ (x << 11); x = y; y = z; z = w; w = w ^ (w >> 19) ^ t ^ (t >> 8)
+static inline __m128i xorshift128(__m128i* state)
+{
+    __m128i t = _mm_xor_si128(state[0], _mm_slli_epi32(state[0], 11));
+    __m128i w = state[3];
+    state[0] = state[1];
+    state[1] = state[2];
+    state[2] = w;
+    w = _mm_xor_si128(_mm_xor_si128(w, _mm_srli_epi32(w, 19)), _mm_xor_si128(t, _mm_srli_epi32(t, 8)));
+    state[3] = w;
+    return w;
+}
+
+void RandomGenerator::generateBlock()
+{
+    __m128i state[4];
+    for (int i = 0; i < 4; ++i)
+    {
+        state[i] = _mm_loadu_si128((const __m128i*)(_state + i * 4));
+    }
+    _mm_storeu_si128((__m128i*)_block, xorshift128(state));
+    for (int i = 0; i < 4; ++i)
+    {
+        _mm_storeu_si128((__m128i*)(_state + i * 4), state[i]);
+    }
+    _blockIndex = 0;
+}
+
+void RandomGenerator::fillMinus1To1(float* values, int count)
+{
+    int i = 0;
+    // the numbers left from the last block first
+    while (i < count && _blockIndex < 4)
+    {
+        values[i++] = nextMinus1To1();
+    }
+
+    if (count - i >= 4)
+    {
+        __m128i state[4];
+        for (int j = 0; j < 4; ++j)
+        {
+            state[j] = _mm_loadu_si128((const __m128i*)(_state + j * 4));
+        }
+        const __m128 scale = _mm_set1_ps(1.0f / 8388608.0f);
+        const __m128 one = _mm_set1_ps(1.0f);
+        for (; count - i >= 4; i += 4)
+        {
+            __m128i bits = _mm_srli_epi32(xorshift128(state), 8);
+            _mm_storeu_ps(values + i, _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(bits), scale), one));
+        }
+        for (int j = 0; j < 4; ++j)
+        {
+            _mm_storeu_si128((__m128i*)(_state + j * 4), state[j]);
+        }
+    }
+
+    for (; i < count; ++i)
+    {
+        values[i] = nextMinus1To1();
+    }
+}
+
+#else
+
+void RandomGenerator::generateBlock()
+{
+    uint32_t* x = _state;
+    uint32_t* y = _state + 4;
+    uint32_t* z = _state + 8;
+    uint32_t* w = _state + 12;
+    for (int i = 0; i < 4; ++i)
+    {
+        uint32_t t = x[i] ^ (x[i] << 11);
+        x[i] = y[i];
+        y[i] = z[i];
+        z[i] = w[i];
+        w[i] = w[i] ^ (w[i] >> 19) ^ t ^ (t >> 8);
+        _block[i] = w[i];
+    }
+    _blockIndex = 0;
+}
+
+void RandomGenerator::fillMinus1To1(float* values, int count)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        values[i] = nextMinus1To1();
+    }
+}
+
+#endif
+
+NS_CC_END
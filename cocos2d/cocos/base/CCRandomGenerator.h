@@ -0,0 +1,96 @@
+/****************************************************************************
+ Copyright (c) 2013-2014 Chukong Technologies Inc.
+
+ http://www.cocos2d-x.org
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#ifndef __BASE_CCRANDOMGENERATOR_H__
+#define __BASE_CCRANDOMGENERATOR_H__
+
+#include "base/CCPlatformMacros.h"
+
+#include <stdint.h>
+
+NS_CC_BEGIN
+
+/**
+ * @addtogroup global
+ * @{
+ */
+
+/** @brief Fast generator of pseudo random numbers, with its own state.
+
+ It runs 4 xorshift128 generators side by side, which give 4 numbers at a time and are updated with SSE2
+ when available. The numbers are handed out in the order of the generators, so a seed gives the same
+ sequence on all the platforms, whether the numbers are drawn one by one or in batches.
+ Not thread safe: each thread, or each emitter, uses its own generator.
+ @since v3.2
+ */
+class CC_DLL RandomGenerator
+{
+public:
+    explicit RandomGenerator(uint32_t seed = 0);
+
+    /** restarts the sequence of numbers of the seed */
+    void setSeed(uint32_t seed);
+    inline uint32_t getSeed() const { return _seed; }
+
+    /** returns a random 32 bits integer */
+    inline uint32_t next()
+    {
+        if (_blockIndex == 4)
+        {
+            generateBlock();
+        }
+        return _block[_blockIndex++];
+    }
+
+    /** returns a random float in [0, 1), as CCRANDOM_0_1() */
+    inline float next0To1()
+    {
+        return (next() >> 8) * (1.0f / 16777216.0f);
+    }
+
+    /** returns a random float in [-1, 1), as CCRANDOM_MINUS1_1() */
+    inline float nextMinus1To1()
+    {
+        return (next() >> 8) * (1.0f / 8388608.0f) - 1.0f;
+    }
+
+    /** fills values with count random floats in [-1, 1), the ones nextMinus1To1() would have returned */
+    void fillMinus1To1(float* values, int count);
+
+private:
+    void generateBlock();
+
+    uint32_t _seed;
+    // x, y, z and w of each of the 4 generators
+    uint32_t _state[16];
+    uint32_t _block[4];
+    int _blockIndex;
+};
+
+// end of global group
+/// @}
+
+NS_CC_END
+
+#endif // __BASE_CCRANDOMGENERATOR_H__
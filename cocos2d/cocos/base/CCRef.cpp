@@ -28,6 +28,10 @@ THE SOFTWARE.
 #include "base/ccMacros.h"
 #include "base/CCScriptSupport.h"
 
+#if CC_ENABLE_REF_ALLOCATOR
+#include "base/CCRefAllocator.h"
+#endif
+
 #if CC_USE_MEM_LEAK_DETECTION
 #include <algorithm>    // std::find
 #endif
@@ -144,6 +148,38 @@ unsigned int Ref::getReferenceCount() const
     return _referenceCount;
 }
 
+#if CC_ENABLE_REF_ALLOCATOR
+
+void* Ref::operator new(std::size_t size)
+{
+    return RefAllocator::getInstance()->allocate(size);
+}
+
+void* Ref::operator new(std::size_t size, const std::nothrow_t&) throw()
+{
+    try
+    {
+        return RefAllocator::getInstance()->allocate(size);
+    }
+    catch (const std::bad_alloc&)
+    {
+        return nullptr;
+    }
+}
+
+void Ref::operator delete(void* ptr, std::size_t size)
+{
+    RefAllocator::getInstance()->deallocate(ptr, size);
+}
+
+void Ref::operator delete(void* ptr, const std::nothrow_t&) throw()
+{
+    // the size isn't given to a placement delete
+    RefAllocator::getInstance()->deallocate(ptr);
+}
+
+#endif // #if CC_ENABLE_REF_ALLOCATOR
+
 #if CC_USE_MEM_LEAK_DETECTION
 
 static std::list<Ref*> __refAllocationList;
@@ -29,6 +29,9 @@ THE SOFTWARE.
 #include "base/CCPlatformMacros.h"
 #include "base/ccConfig.h"
 
+#include <cstddef>
+#include <new>
+
 #define CC_USE_MEM_LEAK_DETECTION 0
 
 NS_CC_BEGIN
@@ -130,6 +133,36 @@ public:
      */
     virtual ~Ref();
 
+#if CC_ENABLE_REF_ALLOCATOR
+    /**
+     * Allocates Refs and their subclasses from RefAllocator's size-class slabs.
+     * @js NA
+     * @lua NA
+     */
+    static void* operator new(std::size_t size);
+    
+    /**
+     * Non-throwing version used by the `create()` factories.
+     * @js NA
+     * @lua NA
+     */
+    static void* operator new(std::size_t size, const std::nothrow_t&) throw();
+    
+    /**
+     * Gives the block back to RefAllocator, `size` is the size of the dynamic type since the destructor is virtual.
+     * @js NA
+     * @lua NA
+     */
+    static void operator delete(void* ptr, std::size_t size);
+    
+    /**
+     * Called instead of the above when the constructor of an object created by the non-throwing `new` throws.
+     * @js NA
+     * @lua NA
+     */
+    static void operator delete(void* ptr, const std::nothrow_t&) throw();
+#endif
+
 protected:
     /// count of references
     unsigned int _referenceCount;
@@ -0,0 +1,312 @@
+/****************************************************************************
+ Copyright (c) 2013-2014 Chukong Technologies Inc.
+
+ http://www.cocos2d-x.org
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#include "base/CCRefAllocator.h"
+#include "base/ccMacros.h"
+
+#include <new>
+#include <string.h>
+
+NS_CC_BEGIN
+
+static inline size_t getSizeClassIndex(size_t size)
+{
+    return (size + RefAllocator::GRANULARITY - 1) / RefAllocator::GRANULARITY - 1;
+}
+
+// Set once the cache of the thread is destroyed. Refs released after that, during the static destruction
+// of the main thread for instance, go straight to the shared free lists.
+static thread_local bool s_threadCacheDestroyed = false;
+
+struct RefAllocator::ThreadCache
+{
+    FreeBlock* freeLists[SIZE_CLASS_COUNT];
+    unsigned int counts[SIZE_CLASS_COUNT];
+    
+    ThreadCache()
+    {
+        memset(freeLists, 0, sizeof(freeLists));
+        memset(counts, 0, sizeof(counts));
+    }
+    
+    // The blocks of an exiting thread go back to the shared free lists.
+    ~ThreadCache()
+    {
+        auto allocator = RefAllocator::getInstance();
+        for (size_t i = 0; i < SIZE_CLASS_COUNT; ++i)
+        {
+            FreeBlock* first = freeLists[i];
+            if (first == nullptr)
+                continue;
+            
+            FreeBlock* last = first;
+            while (last->next)
+            {
+                last = last->next;
+            }
+            allocator->releaseBlocks(i, first, last);
+        }
+        s_threadCacheDestroyed = true;
+    }
+};
+
+RefAllocator* RefAllocator::getInstance()
+{
+    static RefAllocator* s_sharedRefAllocator = new RefAllocator();
+    return s_sharedRefAllocator;
+}
+
+RefAllocator::ThreadCache* RefAllocator::getThreadCache()
+{
+    if (s_threadCacheDestroyed)
+        return nullptr;
+    
+    static thread_local ThreadCache s_threadCache;
+    return &s_threadCache;
+}
+
+RefAllocator::RefAllocator()
+{
+    for (auto& sizeClass : _sizeClasses)
+    {
+        sizeClass.freeList = nullptr;
+        sizeClass.slabCursor = nullptr;
+        sizeClass.slabEnd = nullptr;
+    }
+    
+    for (auto counters : { &_frameCounters, &_totalCounters })
+    {
+        counters->allocations.store(0);
+        counters->deallocations.store(0);
+        counters->heapAllocations.store(0);
+        counters->slabs.store(0);
+    }
+    memset(&_lastFrameStats, 0, sizeof(_lastFrameStats));
+}
+
+RefAllocator::~RefAllocator()
+{
+    for (auto& slab : _slabs)
+    {
+        free(slab.first);
+    }
+}
+
+void RefAllocator::countEvent(std::atomic<unsigned int> Counters::*counter)
+{
+    (_frameCounters.*counter).fetch_add(1, std::memory_order_relaxed);
+    (_totalCounters.*counter).fetch_add(1, std::memory_order_relaxed);
+}
+
+void* RefAllocator::allocate(size_t size)
+{
+    countEvent(&Counters::allocations);
+    
+    if (size == 0 || size > MAX_BLOCK_SIZE)
+    {
+        countEvent(&Counters::heapAllocations);
+        return ::operator new(size);
+    }
+    
+    size_t index = getSizeClassIndex(size);
+    ThreadCache* cache = getThreadCache();
+    if (cache == nullptr)
+    {
+        FreeBlock* block = nullptr;
+        fetchBlocks(index, block, 1);
+        return block;
+    }
+    
+    FreeBlock*& freeList = cache->freeLists[index];
+    if (freeList == nullptr)
+    {
+        cache->counts[index] = fetchBlocks(index, freeList, THREAD_CACHE_BATCH);
+    }
+    
+    FreeBlock* block = freeList;
+    freeList = block->next;
+    --cache->counts[index];
+    return block;
+}
+
+unsigned int RefAllocator::fetchBlocks(size_t index, FreeBlock*& list, unsigned int count)
+{
+    size_t blockSize = (index + 1) * GRANULARITY;
+    SizeClass& sizeClass = _sizeClasses[index];
+    unsigned int fetched = 0;
+    
+    std::lock_guard<std::mutex> lock(sizeClass.mutex);
+    
+    while (fetched < count && sizeClass.freeList)
+    {
+        FreeBlock* block = sizeClass.freeList;
+        sizeClass.freeList = block->next;
+        block->next = list;
+        list = block;
+        ++fetched;
+    }
+    
+    while (fetched < count)
+    {
+        if (sizeClass.slabCursor == nullptr || sizeClass.slabCursor + blockSize > sizeClass.slabEnd)
+        {
+            char* slab = allocateSlab(index);
+            if (slab == nullptr)
+            {
+                if (fetched == 0)
+                {
+                    throw std::bad_alloc();
+                }
+                break;
+            }
+            
+            // The tail of the previous slab is lost, it's smaller than one block.
+            sizeClass.slabCursor = slab;
+            sizeClass.slabEnd = slab + SLAB_SIZE;
+        }
+        
+        FreeBlock* block = reinterpret_cast<FreeBlock*>(sizeClass.slabCursor);
+        sizeClass.slabCursor += blockSize;
+        block->next = list;
+        list = block;
+        ++fetched;
+    }
+    
+    return fetched;
+}
+
+void RefAllocator::releaseBlocks(size_t index, FreeBlock* first, FreeBlock* last)
+{
+    SizeClass& sizeClass = _sizeClasses[index];
+    
+    std::lock_guard<std::mutex> lock(sizeClass.mutex);
+    last->next = sizeClass.freeList;
+    sizeClass.freeList = first;
+}
+
+char* RefAllocator::allocateSlab(size_t index)
+{
+    char* slab = static_cast<char*>(malloc(SLAB_SIZE));
+    if (slab == nullptr)
+        return nullptr;
+    
+    countEvent(&Counters::slabs);
+    
+    std::lock_guard<std::mutex> lock(_slabsMutex);
+    _slabs[slab] = index;
+    return slab;
+}
+
+void RefAllocator::deallocate(void* ptr)
+{
+    if (ptr == nullptr)
+        return;
+    
+    // The blocks which aren't in a slab were allocated from the heap, deallocate(ptr, 0) deletes them.
+    size_t size = 0;
+    {
+        std::lock_guard<std::mutex> lock(_slabsMutex);
+        char* block = static_cast<char*>(ptr);
+        auto it = _slabs.upper_bound(block);
+        if (it != _slabs.begin())
+        {
+            --it;
+            if (block < it->first + SLAB_SIZE)
+                size = (it->second + 1) * GRANULARITY;
+        }
+    }
+    deallocate(ptr, size);
+}
+
+void RefAllocator::deallocate(void* ptr, size_t size)
+{
+    if (ptr == nullptr)
+        return;
+    
+    countEvent(&Counters::deallocations);
+    
+    if (size == 0 || size > MAX_BLOCK_SIZE)
+    {
+        ::operator delete(ptr);
+        return;
+    }
+    
+    size_t index = getSizeClassIndex(size);
+    FreeBlock* block = static_cast<FreeBlock*>(ptr);
+    ThreadCache* cache = getThreadCache();
+    if (cache == nullptr)
+    {
+        releaseBlocks(index, block, block);
+        return;
+    }
+    
+    block->next = cache->freeLists[index];
+    cache->freeLists[index] = block;
+    
+    // Too many free blocks on this thread, give a batch back to the other threads.
+    if (++cache->counts[index] > THREAD_CACHE_SIZE)
+    {
+        FreeBlock* first = cache->freeLists[index];
+        FreeBlock* last = first;
+        for (unsigned int i = 1; i < THREAD_CACHE_BATCH; ++i)
+        {
+            last = last->next;
+        }
+        cache->freeLists[index] = last->next;
+        cache->counts[index] -= THREAD_CACHE_BATCH;
+        releaseBlocks(index, first, last);
+    }
+}
+
+RefAllocator::Stats RefAllocator::toStats(const Counters& counters)
+{
+    Stats stats;
+    stats.allocations = counters.allocations.load(std::memory_order_relaxed);
+    stats.deallocations = counters.deallocations.load(std::memory_order_relaxed);
+    stats.heapAllocations = counters.heapAllocations.load(std::memory_order_relaxed);
+    stats.slabs = counters.slabs.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void RefAllocator::beginFrame()
+{
+    std::lock_guard<std::mutex> lock(_statsMutex);
+    _lastFrameStats.allocations = _frameCounters.allocations.exchange(0, std::memory_order_relaxed);
+    _lastFrameStats.deallocations = _frameCounters.deallocations.exchange(0, std::memory_order_relaxed);
+    _lastFrameStats.heapAllocations = _frameCounters.heapAllocations.exchange(0, std::memory_order_relaxed);
+    _lastFrameStats.slabs = _frameCounters.slabs.exchange(0, std::memory_order_relaxed);
+}
+
+RefAllocator::Stats RefAllocator::getLastFrameStats() const
+{
+    std::lock_guard<std::mutex> lock(_statsMutex);
+    return _lastFrameStats;
+}
+
+RefAllocator::Stats RefAllocator::getTotalStats() const
+{
+    return toStats(_totalCounters);
+}
+
+NS_CC_END
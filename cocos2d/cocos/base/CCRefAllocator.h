@@ -0,0 +1,154 @@
+/****************************************************************************
+ Copyright (c) 2013-2014 Chukong Technologies Inc.
+
+ http://www.cocos2d-x.org
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#ifndef __BASE_CCREFALLOCATOR_H__
+#define __BASE_CCREFALLOCATOR_H__
+
+#include "base/CCPlatformMacros.h"
+#include "base/ccConfig.h"
+
+#include <atomic>
+#include <map>
+#include <mutex>
+
+NS_CC_BEGIN
+
+/**
+ * @addtogroup base_nodes
+ * @{
+ */
+
+/**
+ * Size-class slab allocator used by Ref::operator new/delete when CC_ENABLE_REF_ALLOCATOR is enabled.
+ *
+ * Requests are rounded up to a multiple of GRANULARITY bytes. Every size class carves its blocks out of
+ * SLAB_SIZE byte slabs and keeps the freed blocks in an intrusive free list, so a block released by an
+ * autorelease pool at the end of a frame is handed out again to the next `create()` of the same size.
+ * Requests larger than MAX_BLOCK_SIZE go to the global heap.
+ *
+ * Slabs are never returned to the system, the memory footprint is the peak number of live objects per size class.
+ * The allocator is thread safe since Refs such as Image and Texture2D are also created by loader threads.
+ * Every thread keeps up to THREAD_CACHE_SIZE free blocks per size class and trades them with the shared free
+ * lists THREAD_CACHE_BATCH blocks at a time, under a lock per size class, so threads rarely wait for each other.
+ */
+class CC_DLL RefAllocator
+{
+public:
+    /** Allocation statistics */
+    struct Stats
+    {
+        unsigned int allocations;       ///< number of allocations
+        unsigned int deallocations;     ///< number of deallocations
+        unsigned int heapAllocations;   ///< number of allocations too big for the slabs
+        unsigned int slabs;             ///< number of slabs allocated from the system
+    };
+    
+    static const size_t GRANULARITY = 16;
+    static const size_t MAX_BLOCK_SIZE = 1024;
+    static const size_t SLAB_SIZE = 64 * 1024;
+    static const unsigned int THREAD_CACHE_SIZE = 64;
+    static const unsigned int THREAD_CACHE_BATCH = 32;
+    
+    /** Returns the shared allocator. It's never destroyed, since Refs may be released during static destruction. */
+    static RefAllocator* getInstance();
+    
+    /** Allocates `size` bytes */
+    void* allocate(size_t size);
+    
+    /** Deallocates a block returned by `allocate`, `size` must be the size it was allocated with */
+    void deallocate(void* ptr, size_t size);
+    
+    /** Deallocates a block returned by `allocate` whose size isn't known, e.g. from a placement delete.
+     Slower, the slab of the block is looked up.
+     */
+    void deallocate(void* ptr);
+    
+    /** Starts a new frame: the counters of the current frame become the ones of the last frame. */
+    void beginFrame();
+    
+    /** Gets the statistics of the last complete frame */
+    Stats getLastFrameStats() const;
+    
+    /** Gets the statistics since the allocator was created */
+    Stats getTotalStats() const;
+    
+private:
+    RefAllocator();
+    ~RefAllocator();
+    
+    struct FreeBlock
+    {
+        FreeBlock* next;
+    };
+    
+    struct SizeClass
+    {
+        std::mutex mutex;
+        FreeBlock* freeList;
+        char* slabCursor;
+        char* slabEnd;
+    };
+    
+    struct Counters
+    {
+        std::atomic<unsigned int> allocations;
+        std::atomic<unsigned int> deallocations;
+        std::atomic<unsigned int> heapAllocations;
+        std::atomic<unsigned int> slabs;
+    };
+    
+    struct ThreadCache;
+    friend struct ThreadCache;
+    
+    static const size_t SIZE_CLASS_COUNT = MAX_BLOCK_SIZE / GRANULARITY;
+    
+    static ThreadCache* getThreadCache();
+    
+    /** Moves up to `count` blocks of the size class to a free list, returns the number of blocks moved */
+    unsigned int fetchBlocks(size_t index, FreeBlock*& list, unsigned int count);
+    /** Gives a null terminated list of blocks back to the size class */
+    void releaseBlocks(size_t index, FreeBlock* first, FreeBlock* last);
+    char* allocateSlab(size_t index);
+    
+    void countEvent(std::atomic<unsigned int> Counters::*counter);
+    static Stats toStats(const Counters& counters);
+    
+    SizeClass _sizeClasses[SIZE_CLASS_COUNT];
+    
+    std::mutex _slabsMutex;
+    // the slabs and the index of the size class they belong to
+    std::map<char*, size_t> _slabs;
+    
+    Counters _frameCounters;
+    Counters _totalCounters;
+    mutable std::mutex _statsMutex;
+    Stats _lastFrameStats;
+};
+
+// end of base_nodes group
+/// @}
+
+NS_CC_END
+
+#endif // __BASE_CCREFALLOCATOR_H__
@@ -0,0 +1,121 @@
+/****************************************************************************
+ Copyright (c) 2013-2014 Chukong Technologies Inc.
+
+ http://www.cocos2d-x.org
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#include "base/CCWorkerPool.h"
+#include "base/ccConfig.h"
+
+#include <algorithm>
+#include <thread>
+
+NS_CC_BEGIN
+
+WorkerPool* WorkerPool::getInstance()
+{
+    // never destroyed, its threads are waiting for jobs
+    static WorkerPool* s_sharedPool = nullptr;
+    static std::once_flag s_created;
+    std::call_once(s_created, []() {
+        int threadCount = std::min((int)std::thread::hardware_concurrency(), std::max(CC_IMAGE_DECODE_THREADS, CC_FONT_DISTANCE_FIELD_THREADS));
+        s_sharedPool = new WorkerPool(std::max(threadCount - 1, 0));
+    });
+    return s_sharedPool;
+}
+
+WorkerPool::WorkerPool(int threadCount)
+: _threadCount(threadCount)
+{
+    for (int i = 0; i < threadCount; ++i)
+    {
+        std::thread(&WorkerPool::workerLoop, this).detach();
+    }
+}
+
+void WorkerPool::run(int count, int bandCount, const std::function<void(int, int)>& work)
+{
+    if (bandCount <= 1 || _threadCount == 0)
+    {
+        work(0, count);
+        return;
+    }
+
+    Job job;
+    job.work = &work;
+    job.count = count;
+    job.bandCount = bandCount;
+    job.nextBand = 0;
+    job.activeWorkers = 0;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _jobs.push_back(&job);
+    }
+    _jobAdded.notify_all();
+
+    runBands(&job);
+
+    // all the bands are taken, wait for the workers still running some
+    std::unique_lock<std::mutex> lock(_mutex);
+    removeJob(&job);
+    _workerDone.wait(lock, [&job]() { return job.activeWorkers == 0; });
+}
+
+void WorkerPool::runBands(Job* job)
+{
+    int band;
+    while ((band = job->nextBand.fetch_add(1)) < job->bandCount)
+    {
+        (*job->work)((int)((long long)job->count * band / job->bandCount), (int)((long long)job->count * (band + 1) / job->bandCount));
+    }
+}
+
+void WorkerPool::removeJob(Job* job)
+{
+    auto iter = std::find(_jobs.begin(), _jobs.end(), job);
+    if (iter != _jobs.end())
+    {
+        _jobs.erase(iter);
+    }
+}
+
+void WorkerPool::workerLoop()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (true)
+    {
+        _jobAdded.wait(lock, [this]() { return !_jobs.empty(); });
+
+        Job* job = _jobs.front();
+        ++job->activeWorkers;
+        lock.unlock();
+        runBands(job);
+        lock.lock();
+
+        removeJob(job);
+        if (--job->activeWorkers == 0)
+        {
+            _workerDone.notify_all();
+        }
+    }
+}
+
+NS_CC_END
@@ -0,0 +1,94 @@
+/****************************************************************************
+ Copyright (c) 2013-2014 Chukong Technologies Inc.
+
+ http://www.cocos2d-x.org
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#ifndef __BASE_CCWORKERPOOL_H__
+#define __BASE_CCWORKERPOOL_H__
+
+#include "base/CCPlatformMacros.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+NS_CC_BEGIN
+
+/**
+ * @addtogroup global
+ * @{
+ */
+
+/** @brief Threads shared by the engine to split a work in bands, like the software texture decoders do.
+
+ The works run at the same time, from the TextureCache loading threads for instance, share the same
+ threads instead of starting their own. The thread calling run() takes bands of its work too, so a work
+ is done even when the workers are busy with other ones.
+ @since v3.2
+ */
+class CC_DLL WorkerPool
+{
+public:
+    /** Returns the shared pool, its threads are started by the first call and wait for works until the process exits.
+     There are as many as the cores, at most the largest of CC_IMAGE_DECODE_THREADS and CC_FONT_DISTANCE_FIELD_THREADS, minus one.
+     */
+    static WorkerPool* getInstance();
+
+    /** Calls work(first, last) for bandCount bands splitting [0, count[ and returns when they are all done.
+     The bands are run on the calling thread and on the threads of the pool, at the same time.
+     */
+    void run(int count, int bandCount, const std::function<void(int, int)>& work);
+
+    /** Number of threads of the pool, the calling thread not included */
+    int getThreadCount() const { return _threadCount; }
+
+private:
+    struct Job
+    {
+        const std::function<void(int, int)>* work;
+        int count;
+        int bandCount;
+        std::atomic<int> nextBand;
+        int activeWorkers;
+    };
+
+    explicit WorkerPool(int threadCount);
+
+    static void runBands(Job* job);
+    void removeJob(Job* job);
+    void workerLoop();
+
+    int _threadCount;
+    std::mutex _mutex;
+    std::condition_variable _jobAdded;
+    std::condition_variable _workerDone;
+    std::vector<Job*> _jobs;
+};
+
+// end of global group
+/// @}
+
+NS_CC_END
+
+#endif // __BASE_CCWORKERPOOL_H__
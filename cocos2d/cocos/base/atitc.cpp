@@ -24,6 +24,49 @@
 
 #include "atitc.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CC_ATITC_USE_SSE 1
+#else
+#define CC_ATITC_USE_SSE 0
+#endif
+
+#if CC_ATITC_USE_SSE
+// The values below are computed in the high 16 bits of the 32 bits lane of every pixel of a block row.
+
+// 2 bits color index of the 4 pixels of a block row, from the 8 bits of the row
+static inline __m128i atitc_row_color_indices(uint32_t rowBits)
+{
+    __m128i v = _mm_mullo_epi16(_mm_set1_epi16((short)rowBits), _mm_set_epi16(1 << 8, 0, 1 << 10, 0, 1 << 12, 0, 1 << 14, 0));
+    return _mm_srli_epi16(v, 14);
+}
+
+// explicit alpha of the 4 pixels of a block row, from the 16 bits of the row, already shifted to the alpha byte
+static inline __m128i atitc_row_explicit_alpha(uint32_t rowBits)
+{
+    __m128i v = _mm_mullo_epi16(_mm_set1_epi16((short)rowBits), _mm_set_epi16(1, 0, 1 << 4, 0, 1 << 8, 0, 1 << 12, 0));
+    v = _mm_srli_epi16(v, 12);
+    return _mm_mullo_epi16(v, _mm_set1_epi16(0x1100));
+}
+
+// 3 bits interpolated alpha code of the 4 pixels of a block row, from the 12 bits of the row
+static inline __m128i atitc_row_alpha_codes(uint32_t rowBits)
+{
+    __m128i v = _mm_mullo_epi16(_mm_set1_epi16((short)rowBits), _mm_set_epi16(1 << 4, 0, 1 << 7, 0, 1 << 10, 0, 1 << 13, 0));
+    return _mm_srli_epi16(v, 13);
+}
+
+// values[index] in every lane, indices in [0, 3] as returned by the functions above
+static inline __m128i atitc_select(__m128i indices, const __m128i values[4])
+{
+    __m128i ret = _mm_and_si128(_mm_cmpeq_epi32(indices, _mm_setzero_si128()), values[0]);
+    ret = _mm_or_si128(ret, _mm_and_si128(_mm_cmpeq_epi32(indices, _mm_set1_epi32(1 << 16)), values[1]));
+    ret = _mm_or_si128(ret, _mm_and_si128(_mm_cmpeq_epi32(indices, _mm_set1_epi32(2 << 16)), values[2]));
+    ret = _mm_or_si128(ret, _mm_and_si128(_mm_cmpeq_epi32(indices, _mm_set1_epi32(3 << 16)), values[3]));
+    return ret;
+}
+#endif
+
 //Decode ATITC encode block to 4x4 RGB32 pixels
 static void atitc_decode_block(uint8_t **blockData,
                               uint32_t *decodeBlockData,
@@ -119,6 +162,22 @@ static void atitc_decode_block(uint8_t **blockData,
         // read the flowing 48bit indices (16*3)
         alpha >>= 16;
         
+#if CC_ATITC_USE_SSE
+        // only the codes 0, 1, 4 and 5 are used
+        const __m128i colorValues[4] = { _mm_set1_epi32(colors[0]), _mm_set1_epi32(colors[1]), _mm_set1_epi32(colors[2]), _mm_set1_epi32(colors[3]) };
+        const __m128i alphaValues[4] = { _mm_set1_epi32(alphaArray[0] << 24), _mm_set1_epi32(alphaArray[1] << 24), _mm_set1_epi32(alphaArray[4] << 24), _mm_set1_epi32(alphaArray[5] << 24) };
+        for (int y = 0; y < 4; ++y)
+        {
+            __m128i codes = _mm_and_si128(atitc_row_alpha_codes((uint32_t)alpha & 0xfff), _mm_set1_epi32(5 << 16));
+            // 4 and 5 to 2 and 3
+            codes = _mm_sub_epi32(codes, _mm_and_si128(_mm_srli_epi32(codes, 1), _mm_set1_epi32(2 << 16)));
+            __m128i pixels = _mm_add_epi32(atitc_select(codes, alphaValues), atitc_select(atitc_row_color_indices(pixelsIndex & 0xff), colorValues));
+            _mm_storeu_si128((__m128i*)decodeBlockData, pixels);
+            pixelsIndex >>= 8;
+            alpha >>= 12;
+            decodeBlockData += stride;
+        }
+#else
         for (int y = 0; y < 4; ++y)
         {
             for (int x = 0; x < 4; ++x)
@@ -129,11 +188,23 @@ static void atitc_decode_block(uint8_t **blockData,
             }
             decodeBlockData += stride;
         }
+#endif
     } //if (atc_interpolated_alpha == comFlag)
     else
     {
         /* atc_rgb atc_explicit_alpha use explicit alpha */
         
+#if CC_ATITC_USE_SSE
+        const __m128i colorValues[4] = { _mm_set1_epi32(colors[0]), _mm_set1_epi32(colors[1]), _mm_set1_epi32(colors[2]), _mm_set1_epi32(colors[3]) };
+        for (int y = 0; y < 4; ++y)
+        {
+            __m128i pixels = _mm_add_epi32(atitc_row_explicit_alpha((uint32_t)alpha & 0xffff), atitc_select(atitc_row_color_indices(pixelsIndex & 0xff), colorValues));
+            _mm_storeu_si128((__m128i*)decodeBlockData, pixels);
+            pixelsIndex >>= 8;
+            alpha >>= 16;
+            decodeBlockData += stride;
+        }
+#else
         for (int y = 0; y < 4; ++y)
         {
             for (int x = 0; x < 4; ++x)
@@ -146,19 +217,25 @@ static void atitc_decode_block(uint8_t **blockData,
             }
             decodeBlockData += stride;
         }
+#endif
     }
 }
 
-//Decode ATITC encode data to RGB32
-void atitc_decode(uint8_t *encodeData,             //in_data
+//Decode the block rows [firstBlockRow, lastBlockRow) of ATITC encode data to RGB32,
+//encodeData and decodeData point to the start of the whole image
+void atitc_decode_rows(uint8_t *encodeData,             //in_data
                  uint8_t *decodeData,              //out_data
                  const int pixelsWidth,
                  const int pixelsHeight,
+                 int firstBlockRow,
+                 int lastBlockRow,
                  ATITCDecodeFlag decodeFlag)
 {
-    uint32_t *decodeBlockData = (uint32_t *)decodeData;
+    int blockSize = (decodeFlag == ATITCDecodeFlag::ATC_RGB) ? 8 : 16;
+    encodeData += firstBlockRow * (pixelsWidth / 4) * blockSize;
+    uint32_t *decodeBlockData = (uint32_t *)decodeData + firstBlockRow * 4 * pixelsWidth;
     
-    for (int block_y = 0; block_y < pixelsHeight / 4; ++block_y, decodeBlockData += 3 * pixelsWidth)   //stride = 3*width
+    for (int block_y = firstBlockRow; block_y < lastBlockRow; ++block_y, decodeBlockData += 3 * pixelsWidth)   //stride = 3*width
     {
         for (int block_x = 0; block_x < pixelsWidth / 4; ++block_x, decodeBlockData += 4)            //skip 4 pixels
         {
@@ -192,4 +269,12 @@ void atitc_decode(uint8_t *encodeData,             //in_data
     }//for block_y
 }
 
-
+//Decode ATITC encode data to RGB32
+void atitc_decode(uint8_t *encodeData,             //in_data
+                 uint8_t *decodeData,              //out_data
+                 const int pixelsWidth,
+                 const int pixelsHeight,
+                 ATITCDecodeFlag decodeFlag)
+{
+    atitc_decode_rows(encodeData, decodeData, pixelsWidth, pixelsHeight, 0, pixelsHeight / 4, decodeFlag);
+}
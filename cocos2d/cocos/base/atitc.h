@@ -44,5 +44,17 @@ void atitc_decode(uint8_t *encode_data,
                   );
 
 
+//Decode the block rows [firstBlockRow, lastBlockRow) of ATITC encode data to RGB32,
+//the data pointers are the start of the whole image, so that rows can be decoded in parallel
+void atitc_decode_rows(uint8_t *encode_data,
+                 uint8_t *decode_data,
+                 const int pixelsWidth,
+                 const int pixelsHeight,
+                 int firstBlockRow,
+                 int lastBlockRow,
+                 ATITCDecodeFlag decodeFlag
+                 );
+
+
 #endif /* defined(COCOS2DX_PLATFORM_THIRDPARTY_ATITC_) */
 
@@ -262,6 +262,50 @@ To enable set it to a value different than 0. Disabled by default.
 #define CC_ENABLE_PROFILERS 0
 #endif
 
+/** @def CC_ENABLE_REF_ALLOCATOR
+ If enabled, Ref and all its subclasses (actions, nodes, sprites, touches, events...) are allocated from
+ size-class slabs managed by RefAllocator instead of the global heap. Freed blocks are recycled by the
+ following allocations of the same size, so creating and autoreleasing short lived objects every frame
+ doesn't hit malloc/free any more. The per-frame allocation count is displayed with the other director stats.
+ 
+ To enable set it to a value different than 0. Disabled by default.
+ */
+#ifndef CC_ENABLE_REF_ALLOCATOR
+#define CC_ENABLE_REF_ALLOCATOR 0
+#endif
+
+/** @def CC_IMAGE_DECODE_THREADS
+ Maximum number of threads, the calling thread included, that decode ETC1, S3TC and ATITC textures
+ when the GPU doesn't support them. The image is split in bands of 4x4 blocks rows, small images are
+ decoded on the calling thread only. The other threads are the ones of the WorkerPool.
+ 
+ To decode on the calling thread only set it to 1. Default value: 4
+ */
+#ifndef CC_IMAGE_DECODE_THREADS
+#define CC_IMAGE_DECODE_THREADS 4
+#endif
+
+/** @def CC_FONT_DISTANCE_FIELD_THREADS
+ Maximum number of threads, the calling thread included, that compute the distance fields of the new
+ glyphs of a distance field label. A few glyphs are computed on the calling thread only. The other
+ threads are the ones of the WorkerPool.
+ 
+ To compute them on the calling thread only set it to 1. Default value: 4
+ */
+#ifndef CC_FONT_DISTANCE_FIELD_THREADS
+#define CC_FONT_DISTANCE_FIELD_THREADS 4
+#endif
+
+/** @def CC_PARTICLE_SIMULATION_THREADS
+ Maximum number of threads, the cocos2d thread included, that simulate the particles of the emitters.
+ The emitters updated in a frame are simulated in parallel after the updates, see ParticleJobSystem.
+ 
+ To simulate the particles in the update of their emitter set it to 1. Default value: 4
+ */
+#ifndef CC_PARTICLE_SIMULATION_THREADS
+#define CC_PARTICLE_SIMULATION_THREADS 4
+#endif
+
 /** Enable Lua engine debug log */
 #ifndef CC_LUA_ENGINE_DEBUG
 #define CC_LUA_ENGINE_DEBUG 0
@@ -16,6 +16,13 @@
 
 #include <string.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CC_ETC1_USE_SSE 1
+#else
+#define CC_ETC1_USE_SSE 0
+#endif
+
 /* From http://www.khronos.org/registry/gles/extensions/OES/OES_compressed_ETC1_RGB8_texture.txt
 
  The number of bits that represent a 4x4 texel block is 64 bits if
@@ -194,42 +201,126 @@ void decode_subblock(etc1_byte* pOut, int r, int g, int b, const int* table,
     }
 }
 
-// Input is an ETC1 compressed version of the data.
-// Output is a 4 x 4 square of 3-byte pixels in form R, G, B
+typedef struct {
+    int r[2], g[2], b[2];
+    const int* table[2];
+    bool flipped;
+    etc1_uint32 low;
+} etc1_block_colors;
 
-void etc1_decode_block(const etc1_byte* pIn, etc1_byte* pOut) {
+static
+void etc1_decode_block_colors(const etc1_byte* pIn, etc1_block_colors* pColors) {
     etc1_uint32 high = (pIn[0] << 24) | (pIn[1] << 16) | (pIn[2] << 8) | pIn[3];
-    etc1_uint32 low = (pIn[4] << 24) | (pIn[5] << 16) | (pIn[6] << 8) | pIn[7];
-    int r1, r2, g1, g2, b1, b2;
+    pColors->low = (pIn[4] << 24) | (pIn[5] << 16) | (pIn[6] << 8) | pIn[7];
     if (high & 2) {
         // differential
         int rBase = high >> 27;
         int gBase = high >> 19;
         int bBase = high >> 11;
-        r1 = convert5To8(rBase);
-        r2 = convertDiff(rBase, high >> 24);
-        g1 = convert5To8(gBase);
-        g2 = convertDiff(gBase, high >> 16);
-        b1 = convert5To8(bBase);
-        b2 = convertDiff(bBase, high >> 8);
+        pColors->r[0] = convert5To8(rBase);
+        pColors->r[1] = convertDiff(rBase, high >> 24);
+        pColors->g[0] = convert5To8(gBase);
+        pColors->g[1] = convertDiff(gBase, high >> 16);
+        pColors->b[0] = convert5To8(bBase);
+        pColors->b[1] = convertDiff(bBase, high >> 8);
     } else {
         // not differential
-        r1 = convert4To8(high >> 28);
-        r2 = convert4To8(high >> 24);
-        g1 = convert4To8(high >> 20);
-        g2 = convert4To8(high >> 16);
-        b1 = convert4To8(high >> 12);
-        b2 = convert4To8(high >> 8);
+        pColors->r[0] = convert4To8(high >> 28);
+        pColors->r[1] = convert4To8(high >> 24);
+        pColors->g[0] = convert4To8(high >> 20);
+        pColors->g[1] = convert4To8(high >> 16);
+        pColors->b[0] = convert4To8(high >> 12);
+        pColors->b[1] = convert4To8(high >> 8);
     }
     int tableIndexA = 7 & (high >> 5);
     int tableIndexB = 7 & (high >> 2);
-    const int* tableA = kModifierTable + tableIndexA * 4;
-    const int* tableB = kModifierTable + tableIndexB * 4;
-    bool flipped = (high & 1) != 0;
-    decode_subblock(pOut, r1, g1, b1, tableA, low, false, flipped);
-    decode_subblock(pOut, r2, g2, b2, tableB, low, true, flipped);
+    pColors->table[0] = kModifierTable + tableIndexA * 4;
+    pColors->table[1] = kModifierTable + tableIndexB * 4;
+    pColors->flipped = (high & 1) != 0;
 }
 
+// Input is an ETC1 compressed version of the data.
+// Output is a 4 x 4 square of 3-byte pixels in form R, G, B
+
+void etc1_decode_block(const etc1_byte* pIn, etc1_byte* pOut) {
+    etc1_block_colors colors;
+    etc1_decode_block_colors(pIn, &colors);
+    decode_subblock(pOut, colors.r[0], colors.g[0], colors.b[0], colors.table[0], colors.low, false, colors.flipped);
+    decode_subblock(pOut, colors.r[1], colors.g[1], colors.b[1], colors.table[1], colors.low, true, colors.flipped);
+}
+
+#if CC_ETC1_USE_SSE
+// Same as etc1_decode_block, with the 16 pixels in two vectors of 8 16-bit lanes, pixel x + 4 * y in lane x + 4 * (y & 1).
+// pOut must have room for ETC1_DECODED_BLOCK_SIZE + 2 bytes.
+static
+void etc1_decode_block_sse(const etc1_byte* pIn, etc1_byte* pOut) {
+    etc1_block_colors colors;
+    etc1_decode_block_colors(pIn, &colors);
+
+    // the bit of the modifier index of pixel (x, y) in each half of `low` is y + 4 * x
+    const __m128i bitsTop = _mm_set_epi16(1 << 13, 1 << 9, 1 << 5, 1 << 1, 1 << 12, 1 << 8, 1 << 4, 1 << 0);
+    const __m128i bitsBottom = _mm_set_epi16((short) (1 << 15), 1 << 11, 1 << 7, 1 << 3, 1 << 14, 1 << 10, 1 << 6, 1 << 2);
+    const __m128i lsbs = _mm_set1_epi16((short) (colors.low & 0xffff));
+    const __m128i msbs = _mm_set1_epi16((short) (colors.low >> 16));
+    const __m128i one = _mm_set1_epi16(1);
+    const __m128i two = _mm_set1_epi16(2);
+
+    // lanes of the second sub block: the two right columns, or the bottom half when flipped
+    const __m128i rightColumns = _mm_set_epi16(-1, -1, 0, 0, -1, -1, 0, 0);
+    const __m128i secondTop = colors.flipped ? _mm_setzero_si128() : rightColumns;
+    const __m128i secondBottom = colors.flipped ? _mm_set1_epi16(-1) : rightColumns;
+
+    __m128i channels[2][3];
+    for (int half = 0; half < 2; ++half) {
+        const __m128i bits = half ? bitsBottom : bitsTop;
+        const __m128i second = half ? secondBottom : secondTop;
+
+        __m128i index = _mm_and_si128(_mm_cmpeq_epi16(_mm_and_si128(lsbs, bits), bits), one);
+        index = _mm_or_si128(index, _mm_and_si128(_mm_cmpeq_epi16(_mm_and_si128(msbs, bits), bits), two));
+
+        __m128i delta = _mm_setzero_si128();
+        for (int i = 0; i < 4; ++i) {
+            __m128i modifier = _mm_or_si128(_mm_and_si128(second, _mm_set1_epi16((short) colors.table[1][i])),
+                    _mm_andnot_si128(second, _mm_set1_epi16((short) colors.table[0][i])));
+            delta = _mm_or_si128(delta, _mm_and_si128(_mm_cmpeq_epi16(index, _mm_set1_epi16((short) i)), modifier));
+        }
+
+        const int* bases[3] = { colors.r, colors.g, colors.b };
+        for (int c = 0; c < 3; ++c) {
+            __m128i base = _mm_or_si128(_mm_and_si128(second, _mm_set1_epi16((short) bases[c][1])),
+                    _mm_andnot_si128(second, _mm_set1_epi16((short) bases[c][0])));
+            channels[half][c] = _mm_add_epi16(base, delta);
+        }
+    }
+
+    // packus clamps to [0, 255] like clamp()
+    __m128i r = _mm_packus_epi16(channels[0][0], channels[1][0]);
+    __m128i g = _mm_packus_epi16(channels[0][1], channels[1][1]);
+    __m128i b = _mm_packus_epi16(channels[0][2], channels[1][2]);
+
+    // R G B 0 pixels, one row of the block per vector
+    __m128i rg = _mm_unpacklo_epi8(r, g);
+    __m128i b0 = _mm_unpacklo_epi8(b, _mm_setzero_si128());
+    __m128i rgHigh = _mm_unpackhi_epi8(r, g);
+    __m128i b0High = _mm_unpackhi_epi8(b, _mm_setzero_si128());
+    __m128i rows[4] = {
+        _mm_unpacklo_epi16(rg, b0),
+        _mm_unpackhi_epi16(rg, b0),
+        _mm_unpacklo_epi16(rgHigh, b0High),
+        _mm_unpackhi_epi16(rgHigh, b0High)
+    };
+
+    // drop the 4th byte of every pixel: 6 bytes in each 64-bit half, written with overlapping stores
+    const __m128i evenPixels = _mm_set_epi32(0, -1, 0, -1);
+    for (int y = 0; y < 4; ++y) {
+        __m128i packed = _mm_or_si128(_mm_and_si128(rows[y], evenPixels),
+                _mm_srli_epi64(_mm_andnot_si128(evenPixels, rows[y]), 8));
+        _mm_storel_epi64((__m128i*) (pOut + 12 * y), packed);
+        _mm_storel_epi64((__m128i*) (pOut + 12 * y + 6), _mm_srli_si128(packed, 8));
+    }
+}
+#endif
+
 typedef struct {
     etc1_uint32 high;
     etc1_uint32 low;
@@ -517,7 +608,8 @@ int etc1_encode_image(const etc1_byte* pIn, etc1_uint32 width, etc1_uint32 heigh
     static const unsigned short kYMask[] = { 0x0, 0xf, 0xff, 0xfff, 0xffff };
     static const unsigned short kXMask[] = { 0x0, 0x1111, 0x3333, 0x7777,
             0xffff };
-    etc1_byte block[ETC1_DECODED_BLOCK_SIZE];
+    // the SSE decoder writes 2 bytes past the block
+    etc1_byte block[ETC1_DECODED_BLOCK_SIZE + 2];
     etc1_byte encoded[ETC1_ENCODED_BLOCK_SIZE];
 
     etc1_uint32 encodedWidth = (width + 3) & ~3;
@@ -568,6 +660,17 @@ int etc1_encode_image(const etc1_byte* pIn, etc1_uint32 width, etc1_uint32 heigh
 int etc1_decode_image(const etc1_byte* pIn, etc1_byte* pOut,
         etc1_uint32 width, etc1_uint32 height,
         etc1_uint32 pixelSize, etc1_uint32 stride) {
+    return etc1_decode_image_rows(pIn, pOut, width, height, pixelSize, stride,
+            0, (height + 3) >> 2);
+}
+
+// Decode the rows of blocks [firstBlockRow, lastBlockRow) of an image.
+// pIn and pOut point to the start of the whole image.
+
+int etc1_decode_image_rows(const etc1_byte* pIn, etc1_byte* pOut,
+        etc1_uint32 width, etc1_uint32 height,
+        etc1_uint32 pixelSize, etc1_uint32 stride,
+        etc1_uint32 firstBlockRow, etc1_uint32 lastBlockRow) {
     if (pixelSize < 2 || pixelSize > 3) {
         return -1;
     }
@@ -575,8 +678,13 @@ int etc1_decode_image(const etc1_byte* pIn, etc1_byte* pOut,
 
     etc1_uint32 encodedWidth = (width + 3) & ~3;
     etc1_uint32 encodedHeight = (height + 3) & ~3;
+    etc1_uint32 yLast = lastBlockRow * 4;
+    if (yLast > encodedHeight) {
+        yLast = encodedHeight;
+    }
+    pIn += firstBlockRow * (encodedWidth >> 2) * ETC1_ENCODED_BLOCK_SIZE;
 
-    for (etc1_uint32 y = 0; y < encodedHeight; y += 4) {
+    for (etc1_uint32 y = firstBlockRow * 4; y < yLast; y += 4) {
         etc1_uint32 yEnd = height - y;
         if (yEnd > 4) {
             yEnd = 4;
@@ -586,7 +694,11 @@ int etc1_decode_image(const etc1_byte* pIn, etc1_byte* pOut,
             if (xEnd > 4) {
                 xEnd = 4;
             }
+#if CC_ETC1_USE_SSE
+            etc1_decode_block_sse(pIn, block);
+#else
             etc1_decode_block(pIn, block);
+#endif
             pIn += ETC1_ENCODED_BLOCK_SIZE;
             for (etc1_uint32 cy = 0; cy < yEnd; cy++) {
                 const etc1_byte* q = block + (cy * 4) * 3;
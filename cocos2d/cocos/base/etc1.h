@@ -79,6 +79,16 @@ int etc1_decode_image(const etc1_byte* pIn, etc1_byte* pOut,
         etc1_uint32 width, etc1_uint32 height,
         etc1_uint32 pixelSize, etc1_uint32 stride);
 
+// Decode the rows of 4x4 blocks [firstBlockRow, lastBlockRow) of an image.
+// pIn and pOut point to the start of the whole encoded and decoded image,
+// so that separate rows can be decoded concurrently.
+// returns non-zero if there is an error.
+
+int etc1_decode_image_rows(const etc1_byte* pIn, etc1_byte* pOut,
+        etc1_uint32 width, etc1_uint32 height,
+        etc1_uint32 pixelSize, etc1_uint32 stride,
+        etc1_uint32 firstBlockRow, etc1_uint32 lastBlockRow);
+
 // Size of a PKM header, in bytes.
 
 #define ETC_PKM_HEADER_SIZE 16
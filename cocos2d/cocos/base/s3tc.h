@@ -44,5 +44,17 @@ enum class S3TCDecodeFlag
                  );
 
 
+//Decode the block rows [firstBlockRow, lastBlockRow) of S3TC encode data to RGB32,
+//the data pointers are the start of the whole image, so that rows can be decoded in parallel
+void s3tc_decode_rows(uint8_t *encode_data,
+                 uint8_t *decode_data,
+                 const int pixelsWidth,
+                 const int pixelsHeight,
+                 int firstBlockRow,
+                 int lastBlockRow,
+                 S3TCDecodeFlag decodeFlag
+                 );
+
+
 #endif /* defined(COCOS2DX_PLATFORM_THIRDPARTY_S3TC_) */
 
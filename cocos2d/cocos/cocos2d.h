@@ -43,6 +43,7 @@ THE SOFTWARE.
 #include "base/CCVector.h"
 #include "base/CCMap.h"
 #include "base/CCAutoreleasePool.h"
+#include "base/CCRefAllocator.h"
 #include "base/CCNS.h"
 #include "base/CCData.h"
 #include "base/CCValue.h"
@@ -54,7 +55,11 @@ THE SOFTWARE.
 #include "base/CCScheduler.h"
 #include "base/base64.h"
 #include "base/ZipUtils.h"
+#include "base/CCAssetPack.h"
 #include "base/CCProfiling.h"
+#include "base/CCRandomGenerator.h"
+#include "base/CCFrameStats.h"
+#include "base/CCWorkerPool.h"
 #include "base/CCConsole.h"
 #include "base/ccUTF8.h"
 #include "base/CCUserDefault.h"
@@ -114,6 +119,7 @@ THE SOFTWARE.
 #include "2d/CCLabelBMFont.h"
 #include "2d/CCLabel.h"
 #include "2d/CCFontFNT.h"
+#include "2d/CCFontBaked.h"
 #include "2d/CCLayer.h"
 #include "2d/CCScene.h"
 #include "2d/CCTransition.h"
@@ -130,6 +136,7 @@ THE SOFTWARE.
 #include "2d/CCParticleSystem.h"
 #include "2d/CCParticleExamples.h"
 #include "2d/CCParticleSystemQuad.h"
+#include "2d/CCParticleJobSystem.h"
 
 // 2d utils
 #include "2d/CCGrabber.h"
@@ -149,9 +156,11 @@ THE SOFTWARE.
 #include "renderer/CCGLProgramCache.h"
 #include "renderer/CCGLProgramState.h"
 #include "renderer/ccGLStateCache.h"
+#include "renderer/ccPixelConversion.h"
 #include "renderer/ccShaders.h"
 #include "renderer/CCTexture2D.h"
 #include "renderer/CCTextureCache.h"
+#include "renderer/CCTextureDiskCache.h"
 
 // physics
 #include "physics/CCPhysicsBody.h"
@@ -238,6 +247,7 @@ THE SOFTWARE.
 #include "2d/CCSpriteBatchNode.h"
 #include "2d/CCSpriteFrame.h"
 #include "2d/CCSpriteFrameCache.h"
+#include "2d/CCAssetPreloader.h"
 
 // text_input_node
 #include "2d/CCTextFieldTTF.h"
@@ -222,7 +222,7 @@ Node* CCBReader::readNodeGraphFromFile(const char *pCCBFileName, Ref *pOwner, co
 
     std::string strPath = FileUtils::getInstance()->fullPathForFilename(strCCBFileName.c_str());
 
-    auto dataPtr = std::make_shared<Data>(FileUtils::getInstance()->getDataFromFile(strPath));
+    auto dataPtr = std::make_shared<Data>(FileUtils::getInstance()->getMappedDataFromFile(strPath));
     
     Node *ret =  this->readNodeGraphFromData(dataPtr, pOwner, parentSize);
     
@@ -47,6 +47,7 @@
 #include "base/CCDirector.h"
 #include "base/CCEventDispatcher.h"
 #include "base/CCEventCustom.h"
+#include "base/CCProfiling.h"
 
 #include <algorithm>
 
@@ -892,6 +893,7 @@ void PhysicsWorld::update(float delta)
     _updateTime += delta;
     if (++_updateRateCount >= _updateRate)
     {
+        CC_TRACE_SCOPE("PhysicsWorld::step", "physics");
         _info->step(_updateTime * _speed);
         for (auto& body : _bodies)
         {
@@ -26,15 +26,30 @@ THE SOFTWARE.
 #include "CCFileUtils.h"
 
 #include <stack>
+#include <algorithm>
 
 #include "base/CCData.h"
 #include "base/ccMacros.h"
+#include "base/CCAssetPack.h"
 #include "base/CCDirector.h"
 #include "platform/CCSAXParser.h"
 
 #include "tinyxml2.h"
 #include "unzip.h"
 
+#if (CC_TARGET_PLATFORM != CC_PLATFORM_WIN32) && (CC_TARGET_PLATFORM != CC_PLATFORM_WINRT) && (CC_TARGET_PLATFORM != CC_PLATFORM_WP8)
+#define CC_FILEUTILS_USE_MMAP 1
+#define CC_FILEUTILS_USE_DIRENT 1
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#else
+#define CC_FILEUTILS_USE_MMAP 0
+#define CC_FILEUTILS_USE_DIRENT 0
+#endif
+
 
 using namespace std;
 
@@ -482,6 +497,7 @@ void FileUtils::destroyInstance()
 }
 
 FileUtils::FileUtils()
+: _searchPathPrefetchEnabled(true)
 {
 }
 
@@ -499,7 +515,297 @@ bool FileUtils::init()
 
 void FileUtils::purgeCachedEntries()
 {
-    _fullPathCache.clear();
+    clearFullPathCache();
+}
+
+FileUtils::FullPathCacheShard& FileUtils::getFullPathCacheShard(const std::string& filename) const
+{
+    return _fullPathCache[std::hash<std::string>()(filename) % FULL_PATH_CACHE_SHARDS];
+}
+
+bool FileUtils::getCachedFullPath(const std::string& filename, std::string* fullPath) const
+{
+    auto& shard = getFullPathCacheShard(filename);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto it = shard.fullPaths.find(filename);
+    if (it == shard.fullPaths.end())
+    {
+        return false;
+    }
+    if (fullPath)
+    {
+        *fullPath = it->second;
+    }
+    return true;
+}
+
+void FileUtils::addCachedFullPath(const std::string& filename, const std::string& fullPath) const
+{
+    auto& shard = getFullPathCacheShard(filename);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.fullPaths.insert(std::make_pair(filename, fullPath));
+}
+
+void FileUtils::clearFullPathCache()
+{
+    for (auto& shard : _fullPathCache)
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.fullPaths.clear();
+    }
+
+    // the directories may have changed too
+    std::lock_guard<std::mutex> lock(_directoryListingsMutex);
+    _directoryListings.clear();
+}
+
+std::unordered_map<std::string, std::string> FileUtils::getFullPathCache() const
+{
+    std::unordered_map<std::string, std::string> fullPathCache;
+    for (auto& shard : _fullPathCache)
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        fullPathCache.insert(shard.fullPaths.begin(), shard.fullPaths.end());
+    }
+    return fullPathCache;
+}
+
+void FileUtils::setSearchPathPrefetchEnabled(bool enabled)
+{
+    _searchPathPrefetchEnabled = enabled;
+
+    std::lock_guard<std::mutex> lock(_directoryListingsMutex);
+    _directoryListings.clear();
+}
+
+bool FileUtils::DirectoryListing::lookup(const std::string& path, bool* found) const
+{
+    // Drops the "." components and the empty ones of "a//b". ".." depends on the directories it goes through,
+    // and the letters of a case insensitive file system are only folded here when they are ASCII.
+    std::string key;
+    key.reserve(path.length());
+    size_t begin = 0;
+    while (begin < path.length())
+    {
+        size_t end = path.find('/', begin);
+        if (end == std::string::npos)
+        {
+            end = path.length();
+        }
+        size_t length = end - begin;
+        if (length == 2 && path[begin] == '.' && path[begin + 1] == '.')
+        {
+            return false;
+        }
+        if (length > 0 && ! (length == 1 && path[begin] == '.'))
+        {
+            if (! key.empty())
+            {
+                key += '/';
+            }
+            key.append(path, begin, length);
+        }
+        begin = end + 1;
+    }
+    if (key.empty() || path[path.length() - 1] == '/')
+    {
+        return false;
+    }
+
+    if (! caseSensitive)
+    {
+        for (auto& c : key)
+        {
+            if (static_cast<unsigned char>(c) >= 0x80)
+            {
+                return false;
+            }
+            c = tolower(static_cast<unsigned char>(c));
+        }
+    }
+
+    for (const auto& directory : unlistedDirectories)
+    {
+        if (key.compare(0, directory.length(), directory) == 0)
+        {
+            return false;
+        }
+    }
+
+    *found = entries.count(key) != 0;
+    return true;
+}
+
+#if CC_FILEUTILS_USE_DIRENT
+// Lists the files and sub directories of a directory, recursively. The directories nested too deep are added
+// to `unlistedDirectories`. Returns false if the directory can't be listed or if there are too many files.
+static bool listDirectory(const std::string& root, const std::string& relativeDirectory, int depth,
+                          std::unordered_set<std::string>* entries, std::vector<std::string>* unlistedDirectories)
+{
+    static const int MAX_DEPTH = 8;
+    static const size_t MAX_FILES = 64 * 1024;
+
+    if (depth > MAX_DEPTH)
+    {
+        unlistedDirectories->push_back(relativeDirectory);
+        return true;
+    }
+
+    DIR* dir = opendir((root + relativeDirectory).c_str());
+    if (dir == nullptr)
+    {
+        return false;
+    }
+
+    bool ret = true;
+    struct dirent* entry = nullptr;
+    while (ret && (entry = readdir(dir)) != nullptr)
+    {
+        const char* name = entry->d_name;
+        if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')))
+        {
+            continue;
+        }
+
+        std::string path = relativeDirectory + name;
+        bool isDirectory = false;
+#ifdef _DIRENT_HAVE_D_TYPE
+        if (entry->d_type != DT_UNKNOWN && entry->d_type != DT_LNK)
+        {
+            isDirectory = (entry->d_type == DT_DIR);
+        }
+        else
+#endif
+        {
+            struct stat st;
+            isDirectory = (stat((root + path).c_str(), &st) == 0 && S_ISDIR(st.st_mode));
+        }
+
+        entries->insert(path);
+        ret = entries->size() <= MAX_FILES;
+        if (ret && isDirectory)
+        {
+            ret = listDirectory(root, path + "/", depth + 1, entries, unlistedDirectories);
+        }
+    }
+    closedir(dir);
+
+    return ret;
+}
+
+// Flips the case of the letters of an entry, the file system is case insensitive if it still finds it.
+static bool isCaseSensitive(const std::string& root, const std::unordered_set<std::string>& entries)
+{
+    for (const auto& entry : entries)
+    {
+        std::string flipped = entry;
+        bool hasLetter = false;
+        for (auto& c : flipped)
+        {
+            unsigned char letter = static_cast<unsigned char>(c);
+            if (isupper(letter))
+            {
+                c = tolower(letter);
+                hasLetter = true;
+            }
+            else if (islower(letter))
+            {
+                c = toupper(letter);
+                hasLetter = true;
+            }
+        }
+        
+        if (hasLetter && entries.count(flipped) == 0)
+        {
+            struct stat st;
+            return stat((root + flipped).c_str(), &st) != 0;
+        }
+    }
+    // no letter to compare, the case doesn't matter
+    return true;
+}
+
+static std::string toLowerASCII(const std::string& str)
+{
+    std::string ret = str;
+    for (auto& c : ret)
+    {
+        c = tolower(static_cast<unsigned char>(c));
+    }
+    return ret;
+}
+#endif
+
+std::shared_ptr<const FileUtils::DirectoryListing> FileUtils::getDirectoryListing(const std::string& directory, std::string* relativeDirectory)
+{
+#if CC_FILEUTILS_USE_DIRENT
+    if (! _searchPathPrefetchEnabled)
+    {
+        return nullptr;
+    }
+
+    const std::string* searchPath = nullptr;
+    for (const auto& path : _searchPathArray)
+    {
+        if (directory.compare(0, path.length(), path) == 0)
+        {
+            searchPath = &path;
+            break;
+        }
+    }
+    if (searchPath == nullptr || ! isAbsolutePath(*searchPath) || (*searchPath)[0] != '/')
+    {
+        return nullptr;
+    }
+
+    std::shared_ptr<const DirectoryListing> listing;
+    {
+        std::lock_guard<std::mutex> lock(_directoryListingsMutex);
+
+        auto it = _directoryListings.find(*searchPath);
+        if (it != _directoryListings.end())
+        {
+            listing = it->second;
+        }
+        else
+        {
+            // downloaded files may be added to the writable path at any time
+            std::string writablePath = getWritablePath();
+            if (writablePath.empty() || searchPath->compare(0, writablePath.length(), writablePath) != 0)
+            {
+                auto files = std::make_shared<DirectoryListing>();
+                if (listDirectory(*searchPath, "", 0, &files->entries, &files->unlistedDirectories))
+                {
+                    files->caseSensitive = isCaseSensitive(*searchPath, files->entries);
+                    if (! files->caseSensitive)
+                    {
+                        std::unordered_set<std::string> entries;
+                        for (const auto& entry : files->entries)
+                        {
+                            entries.insert(toLowerASCII(entry));
+                        }
+                        files->entries.swap(entries);
+                        for (auto& directory : files->unlistedDirectories)
+                        {
+                            directory = toLowerASCII(directory);
+                        }
+                    }
+                    listing = files;
+                }
+            }
+            _directoryListings[*searchPath] = listing;
+        }
+    }
+
+    if (listing && relativeDirectory)
+    {
+        *relativeDirectory = directory.substr(searchPath->length());
+    }
+    return listing;
+#else
+    return nullptr;
+#endif
 }
 
 static Data getData(const std::string& filename, bool forString)
@@ -522,6 +828,14 @@ static Data getData(const std::string& filename, bool forString)
     {
         // Read the file from hardware
         std::string fullPath = FileUtils::getInstance()->fullPathForFilename(filename);
+
+        std::string entryPath;
+        std::shared_ptr<AssetPack> pack = FileUtils::getInstance()->getAssetPackForPath(fullPath, &entryPath);
+        if (pack)
+        {
+            return pack->getData(entryPath, forString);
+        }
+
         FILE *fp = fopen(fullPath.c_str(), mode);
         CC_BREAK_IF(!fp);
         fseek(fp,0,SEEK_END);
@@ -571,6 +885,52 @@ Data FileUtils::getDataFromFile(const std::string& filename)
     return getData(filename, false);
 }
 
+Data FileUtils::getMappedDataFromFile(const std::string& filename)
+{
+#if CC_FILEUTILS_USE_MMAP
+    // below a few pages, reading is cheaper than mapping
+    static const off_t MIN_MAPPED_SIZE = 16 * 1024;
+
+    std::string fullPath = fullPathForFilename(filename);
+
+    std::string entryPath;
+    std::shared_ptr<AssetPack> pack = getAssetPackForPath(fullPath, &entryPath);
+    if (pack)
+    {
+        // stored entries are views of the mapped pack
+        return pack->getData(entryPath);
+    }
+
+    if (isAbsolutePath(fullPath))
+    {
+        int fd = open(fullPath.c_str(), O_RDONLY);
+        if (fd >= 0)
+        {
+            struct stat st;
+            void* bytes = MAP_FAILED;
+            if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size >= MIN_MAPPED_SIZE)
+            {
+                // private mapping: writes are copied on write and never reach the file
+                bytes = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+            }
+            // the mapping stays valid once the file is closed
+            close(fd);
+
+            if (bytes != MAP_FAILED)
+            {
+                Data ret;
+                ret.fastSet((unsigned char*)bytes, st.st_size, [](unsigned char* mapped, ssize_t size) {
+                    munmap(mapped, size);
+                });
+                return ret;
+            }
+        }
+    }
+#endif
+
+    return getDataFromFile(filename);
+}
+
 unsigned char* FileUtils::getFileData(const std::string& filename, const char* mode, ssize_t *size)
 {
     unsigned char * buffer = nullptr;
@@ -674,6 +1034,24 @@ std::string FileUtils::getPathForFilename(const std::string& filename, const std
     std::string path = searchPath;
     path += file_path;
     path += resolutionDirectory;
+
+    std::string entryPath;
+    std::shared_ptr<AssetPack> pack = getAssetPackForPath(path, &entryPath);
+    if (pack)
+    {
+        // the search path is an asset pack, look the file up in its index
+        entryPath += file;
+        return pack->isFileExist(entryPath) ? path + file : "";
+    }
+
+    std::string relativeDirectory;
+    auto listing = getDirectoryListing(path, &relativeDirectory);
+    bool found = false;
+    if (listing && listing->lookup(relativeDirectory + file, &found))
+    {
+        // no system call, even if the file isn't there
+        return found ? path + file : "";
+    }
     
     path = getFullPathForDirectoryAndFilename(path, file);
     
@@ -695,10 +1073,10 @@ std::string FileUtils::fullPathForFilename(const std::string &filename)
     }
 
     // Already Cached ?
-    auto cacheIter = _fullPathCache.find(filename);
-    if( cacheIter != _fullPathCache.end() )
+    std::string cachedPath;
+    if (getCachedFullPath(filename, &cachedPath))
     {
-        return cacheIter->second;
+        return cachedPath;
     }
     
     // Get the new file name.
@@ -715,7 +1093,7 @@ std::string FileUtils::fullPathForFilename(const std::string &filename)
             if (fullpath.length() > 0)
             {
                 // Using the filename passed in as key.
-                _fullPathCache.insert(std::make_pair(filename, fullpath));
+                addCachedFullPath(filename, fullpath);
                 return fullpath;
             }
         }
@@ -736,7 +1114,7 @@ std::string FileUtils::fullPathFromRelativeFile(const std::string &filename, con
 void FileUtils::setSearchResolutionsOrder(const std::vector<std::string>& searchResolutionsOrder)
 {
     bool existDefault = false;
-    _fullPathCache.clear();
+    clearFullPathCache();
     _searchResolutionsOrderArray.clear();
     for(auto iter = searchResolutionsOrder.cbegin(); iter != searchResolutionsOrder.cend(); ++iter)
     {
@@ -782,7 +1160,7 @@ void FileUtils::setSearchPaths(const std::vector<std::string>& searchPaths)
 {
     bool existDefaultRootPath = false;
     
-    _fullPathCache.clear();
+    clearFullPathCache();
     _searchPathArray.clear();
     for (auto iter = searchPaths.cbegin(); iter != searchPaths.cend(); ++iter)
     {
@@ -810,6 +1188,8 @@ void FileUtils::setSearchPaths(const std::vector<std::string>& searchPaths)
         //CCLOG("Default root path doesn't exist, adding it.");
         _searchPathArray.push_back(_defaultResRootPath);
     }
+
+    updateAssetPacks();
 }
 
 void FileUtils::addSearchPath(const std::string &searchpath)
@@ -824,11 +1204,71 @@ void FileUtils::addSearchPath(const std::string &searchpath)
         path += "/";
     }
     _searchPathArray.push_back(path);
+
+    updateAssetPacks();
+}
+
+void FileUtils::updateAssetPacks()
+{
+    static const std::string PACK_EXTENSION = ".ccpack/";
+
+    std::vector<std::pair<std::string, std::shared_ptr<AssetPack>>> packs;
+    {
+        std::lock_guard<std::mutex> lock(_assetPacksMutex);
+        packs = _assetPacks;
+    }
+
+    std::vector<std::pair<std::string, std::shared_ptr<AssetPack>>> mountedPacks;
+    for (const auto& searchPath : _searchPathArray)
+    {
+        if (searchPath.length() <= PACK_EXTENSION.length()
+            || searchPath.compare(searchPath.length() - PACK_EXTENSION.length(), PACK_EXTENSION.length(), PACK_EXTENSION) != 0)
+        {
+            continue;
+        }
+
+        // keep the packs which are already open
+        auto it = std::find_if(packs.begin(), packs.end(), [&](const std::pair<std::string, std::shared_ptr<AssetPack>>& mounted) {
+            return mounted.first == searchPath;
+        });
+        if (it != packs.end())
+        {
+            mountedPacks.push_back(*it);
+            continue;
+        }
+
+        AssetPack* pack = AssetPack::create(searchPath.substr(0, searchPath.length() - 1));
+        if (pack)
+        {
+            mountedPacks.push_back(std::make_pair(searchPath, std::shared_ptr<AssetPack>(pack)));
+        }
+    }
+
+    // the packs which aren't searched anymore are closed once the readers which got them release them
+    std::lock_guard<std::mutex> lock(_assetPacksMutex);
+    _assetPacks.swap(mountedPacks);
+}
+
+std::shared_ptr<AssetPack> FileUtils::getAssetPackForPath(const std::string& fullPath, std::string* entryPath) const
+{
+    std::lock_guard<std::mutex> lock(_assetPacksMutex);
+    for (const auto& mounted : _assetPacks)
+    {
+        if (fullPath.compare(0, mounted.first.length(), mounted.first) == 0)
+        {
+            if (entryPath)
+            {
+                *entryPath = fullPath.substr(mounted.first.length());
+            }
+            return mounted.second;
+        }
+    }
+    return nullptr;
 }
 
 void FileUtils::setFilenameLookupDictionary(const ValueMap& filenameLookupDict)
 {
-    _fullPathCache.clear();    
+    clearFullPathCache();    
     _filenameLookupDict = filenameLookupDict;
 }
 
@@ -873,12 +1313,17 @@ bool FileUtils::isFileExist(const std::string& filename) const
     // If filename is absolute path, we don't need to consider 'search paths' and 'resolution orders'.
     if (isAbsolutePath(filename))
     {
+        std::string entryPath;
+        std::shared_ptr<AssetPack> pack = getAssetPackForPath(filename, &entryPath);
+        if (pack)
+        {
+            return pack->isFileExist(entryPath);
+        }
         return isFileExistInternal(filename);
     }
     
     // Already Cached ?
-    auto cacheIter = _fullPathCache.find(filename);
-    if( cacheIter != _fullPathCache.end() )
+    if (getCachedFullPath(filename, nullptr))
     {
         return true;
     }
@@ -897,7 +1342,7 @@ bool FileUtils::isFileExist(const std::string& filename) const
             if (!fullpath.empty())
             {
                 // Using the filename passed in as key.
-                const_cast<FileUtils*>(this)->_fullPathCache.insert(std::make_pair(filename, fullpath));
+                addCachedFullPath(filename, fullpath);
                 return true;
             }
         }
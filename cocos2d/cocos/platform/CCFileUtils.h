@@ -28,6 +28,9 @@ THE SOFTWARE.
 #include <string>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
+#include <memory>
+#include <mutex>
 
 #include "base/CCPlatformMacros.h"
 #include "base/ccTypes.h"
@@ -36,6 +39,8 @@ THE SOFTWARE.
 
 NS_CC_BEGIN
 
+class AssetPack;
+
 /**
  * @addtogroup platform
  * @{
@@ -88,6 +93,16 @@ public:
      *  @return A data object.
      */
     virtual Data getDataFromFile(const std::string& filename);
+
+    /**
+     *  Creates binary data mapping a file in memory instead of reading it, where the platform allows it.
+     *  The pages are loaded on demand and shared with the file system cache, so the file isn't copied
+     *  into a buffer before being parsed. Writing to the bytes doesn't modify the file.
+     *  Falls back to getDataFromFile() for small files and files which can't be mapped, e.g. in an apk.
+     *  @return A data object.
+     *  @since v3.2
+     */
+    virtual Data getMappedDataFromFile(const std::string& filename);
     
     /**
      *  Gets resource file data
@@ -253,6 +268,9 @@ public:
      *        	If "/mnt/sdcard/" and "resources-large" were set to the search paths vector,
      *        	"resources-large" will be converted to "assets/resources-large" since it was a relative path.
      *
+     *  A search path ending with ".ccpack" mounts an AssetPack: the files it contains are found as if it were a directory,
+     *  and are read from the pack by getDataFromFile, getMappedDataFromFile and getStringFromFile.
+     *
      *  @param searchPaths The array contains search paths.
      *  @see fullPathForFilename(const char*)
      *  @since v2.1
@@ -328,8 +346,29 @@ public:
      */
     virtual ValueVector getValueVectorFromFile(const std::string& filename);
 
-    /** Returns the full path cache */
-    const std::unordered_map<std::string, std::string>& getFullPathCache() const { return _fullPathCache; }
+    /** Returns a copy of the full path cache, taken on each call since the cache is shared with the loading threads */
+    std::unordered_map<std::string, std::string> getFullPathCache() const;
+
+    /**
+     *  Sets whether or not the content of the search path directories is listed once, the first time a file is searched in them,
+     *  so that looking a file up costs no system call, especially when it isn't in the directory.
+     *  The search paths in the writable path are never listed, since their content may change at any time.
+     *  Paths with "..", non ASCII names on case insensitive file systems and directories nested too deep
+     *  are still looked up with the file system.
+     *  Call purgeCachedEntries() after adding files to a listed directory. Enabled by default.
+     *  @since v3.2
+     */
+    void setSearchPathPrefetchEnabled(bool enabled);
+    bool isSearchPathPrefetchEnabled() const { return _searchPathPrefetchEnabled; }
+
+    /**
+     *  Returns the asset pack mounted as the search path a full path starts with, nullptr if none.
+     *  It is safe to call from any thread, the pack stays open while the returned pointer is held
+     *  even if its search path is removed meanwhile.
+     *  @param entryPath The path relative to the pack, set if a pack is found.
+     *  @since v3.2
+     */
+    std::shared_ptr<AssetPack> getAssetPackForPath(const std::string& fullPath, std::string* entryPath) const;
 
 protected:
     /**
@@ -417,8 +456,60 @@ protected:
     /**
      *  The full path cache. When a file is found, it will be added into this cache. 
      *  This variable is used for improving the performance of file search.
+     *  The files are looked up from the loading threads too, the cache is split in shards
+     *  with their own lock, chosen by the hash of the file name, to keep the contention low.
+     */
+    struct FullPathCacheShard
+    {
+        std::mutex mutex;
+        std::unordered_map<std::string, std::string> fullPaths;
+    };
+    static const int FULL_PATH_CACHE_SHARDS = 16;
+    mutable FullPathCacheShard _fullPathCache[FULL_PATH_CACHE_SHARDS];
+
+    FullPathCacheShard& getFullPathCacheShard(const std::string& filename) const;
+    bool getCachedFullPath(const std::string& filename, std::string* fullPath) const;
+    void addCachedFullPath(const std::string& filename, const std::string& fullPath) const;
+    void clearFullPathCache();
+
+    /**
+     *  The files and directories of a search path directory, relative to it, listed the first time it is searched.
+     */
+    struct DirectoryListing
+    {
+        /** Lower case on case insensitive file systems */
+        std::unordered_set<std::string> entries;
+        /** The directories nested too deep to be listed, with a trailing slash */
+        std::vector<std::string> unlistedDirectories;
+        bool caseSensitive;
+        
+        /**
+         *  Looks a path relative to the directory up, returns false if the listing can't tell
+         *  whether the file system would find it, in which case the file system must be asked.
+         */
+        bool lookup(const std::string& path, bool* found) const;
+    };
+    /** A null listing means the directory couldn't be listed and is searched with the file system. */
+    std::unordered_map<std::string, std::shared_ptr<const DirectoryListing>> _directoryListings;
+    mutable std::mutex _directoryListingsMutex;
+    bool _searchPathPrefetchEnabled;
+
+    /**
+     *  Returns the listing of the search path a directory starts with, listing it if needed, nullptr if it can't be listed.
+     *  @param relativeDirectory The directory relative to the search path, set if a listing is returned.
+     */
+    std::shared_ptr<const DirectoryListing> getDirectoryListing(const std::string& directory, std::string* relativeDirectory);
+
+    /**
+     *  Opens the asset packs of the search paths and closes the packs which aren't searched anymore.
+     */
+    void updateAssetPacks();
+
+    /**
+     *  The mounted asset packs, with the search path they are mounted as.
      */
-    std::unordered_map<std::string, std::string> _fullPathCache;
+    std::vector<std::pair<std::string, std::shared_ptr<AssetPack>>> _assetPacks;
+    mutable std::mutex _assetPacksMutex;
     
     /**
      *  The singleton pointer of FileUtils.
@@ -28,6 +28,10 @@ THE SOFTWARE.
 
 #include <string>
 #include <ctype.h>
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <atomic>
 
 #include "base/CCData.h"
 
@@ -58,7 +62,9 @@ extern "C"
 #include "CCFileUtils.h"
 #include "base/CCConfiguration.h"
 #include "base/ccUtils.h"
+#include "renderer/ccPixelConversion.h"
 #include "base/ZipUtils.h"
+#include "base/CCWorkerPool.h"
 #if (CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID)
 #include "android/CCFileUtilsAndroid.h"
 #endif
@@ -389,13 +395,83 @@ Image::Image()
 , _preMulti(false)
 , _numberOfMipmaps(0)
 , _hasPremultipliedAlpha(true)
+, _decodeFormat(Texture2D::PixelFormat::AUTO)
+, _decodePremultiplyAlpha(false)
+, _dataAllocator(nullptr)
+, _dataOwned(true)
 {
 
 }
 
 Image::~Image()
 {
-    CC_SAFE_FREE(_data);
+    if (_dataOwned)
+    {
+        CC_SAFE_FREE(_data);
+    }
+}
+
+void Image::setDecodeFormat(Texture2D::PixelFormat format, bool premultiplyAlpha)
+{
+    _decodeFormat = format;
+    _decodePremultiplyAlpha = premultiplyAlpha;
+}
+
+void Image::setDataAllocator(const DataAllocator& allocator)
+{
+    _dataAllocator = allocator;
+}
+
+unsigned char* Image::allocateData(ssize_t dataLen)
+{
+    if (_dataAllocator)
+    {
+        return _dataAllocator(dataLen);
+    }
+    return static_cast<unsigned char*>(malloc(dataLen * sizeof(unsigned char)));
+}
+
+void Image::convertToDecodeFormat()
+{
+    if (isCompressed() || _numberOfMipmaps > 1)
+    {
+        return;
+    }
+
+    if (_decodePremultiplyAlpha && _renderFormat == Texture2D::PixelFormat::RGBA8888 && _hasPremultipliedAlpha && !_preMulti)
+    {
+        PixelConversion::premultiplyAlpha(_data, _dataLen / 4);
+        _preMulti = true;
+    }
+
+    Texture2D::PixelFormat format = Texture2D::getConvertedPixelFormat(_renderFormat, _decodeFormat);
+    if (format == _renderFormat)
+    {
+        return;
+    }
+
+    auto& formatInfo = Texture2D::getPixelFormatInfoMap();
+    ssize_t dataLen = _dataLen / (formatInfo.at(_renderFormat).bpp / 8) * (formatInfo.at(format).bpp / 8);
+    unsigned char* data = allocateData(dataLen);
+    if (data == nullptr)
+    {
+        return;
+    }
+    Texture2D::convertDataToFormat(_data, _dataLen, _renderFormat, format, data);
+
+    if (_dataOwned)
+    {
+        free(_data);
+    }
+    _data = data;
+    _dataLen = dataLen;
+    _dataOwned = (_dataAllocator == nullptr);
+    _renderFormat = format;
+    if (_numberOfMipmaps == 1)
+    {
+        _mipmaps[0].address = _data;
+        _mipmaps[0].len = static_cast<int>(_dataLen);
+    }
 }
 
 bool Image::initWithImageFile(const std::string& path)
@@ -413,17 +489,11 @@ bool Image::initWithImageFile(const std::string& path)
     int size = 4 * (iSurf->w * iSurf->h);
     ret = initWithRawData((const unsigned char*)iSurf->pixels, size, iSurf->w, iSurf->h, 8, true);
 
-    unsigned int *tmp = (unsigned int *)_data;
-    int nrPixels = iSurf->w * iSurf->h;
-    for(int i = 0; i < nrPixels; i++)
-    {
-        unsigned char *p = _data + i * 4;
-        tmp[i] = CC_RGB_PREMULTIPLY_ALPHA( p[0], p[1], p[2], p[3] );
-    }
+    PixelConversion::premultiplyAlpha(_data, iSurf->w * iSurf->h);
 
     SDL_FreeSurface(iSurf);
 #else
-    Data data = FileUtils::getInstance()->getDataFromFile(_filePath);
+    Data data = FileUtils::getInstance()->getMappedDataFromFile(_filePath);
 
     if (!data.isNull())
     {
@@ -439,7 +509,7 @@ bool Image::initWithImageFileThreadSafe(const std::string& fullpath)
     bool ret = false;
     _filePath = fullpath;
 
-    Data data = FileUtils::getInstance()->getDataFromFile(fullpath);
+    Data data = FileUtils::getInstance()->getMappedDataFromFile(fullpath);
 
     if (!data.isNull())
     {
@@ -521,6 +591,11 @@ bool Image::initWithImageData(const unsigned char * data, ssize_t dataLen)
                 break;
             }
         }
+
+        if (ret)
+        {
+            convertToDecodeFormat();
+        }
         
         if(unpackedData != data)
         {
@@ -751,8 +826,6 @@ bool Image::initWithJpgData(const unsigned char * data, ssize_t dataLen)
 	struct MyErrorMgr jerr;
     /* libjpeg data structure for storing one row, that is, scanline of an image */
     JSAMPROW row_pointer[1] = {0};
-    unsigned long location = 0;
-    unsigned int i = 0;
 
     bool bRet = false;
     do 
@@ -801,21 +874,33 @@ bool Image::initWithJpgData(const unsigned char * data, ssize_t dataLen)
         _width  = cinfo.output_width;
         _height = cinfo.output_height;
         _preMulti = false;
-        row_pointer[0] = static_cast<unsigned char*>(malloc(cinfo.output_width*cinfo.output_components * sizeof(unsigned char)));
-        CC_BREAK_IF(! row_pointer[0]);
 
-        _dataLen = cinfo.output_width*cinfo.output_height*cinfo.output_components;
-        _data = static_cast<unsigned char*>(malloc(_dataLen * sizeof(unsigned char)));
+        /* rows are converted to the decode format as soon as they are read */
+        Texture2D::PixelFormat fileFormat = _renderFormat;
+        _renderFormat = Texture2D::getConvertedPixelFormat(fileFormat, _decodeFormat);
+        ssize_t rowBytes = cinfo.output_width*cinfo.output_components;
+        ssize_t outRowBytes = cinfo.output_width * (Texture2D::getPixelFormatInfoMap().at(_renderFormat).bpp / 8);
+        if (_renderFormat != fileFormat)
+        {
+            row_pointer[0] = static_cast<unsigned char*>(malloc(rowBytes * sizeof(unsigned char)));
+            CC_BREAK_IF(! row_pointer[0]);
+        }
+
+        _dataLen = outRowBytes * cinfo.output_height;
+        _data = allocateData(_dataLen);
+        _dataOwned = (_dataAllocator == nullptr);
         CC_BREAK_IF(! _data);
 
         /* now actually read the jpeg into the raw buffer */
-        /* read one scan line at a time */
+        /* read one scan line at a time, straight into the image when there is nothing to convert */
         while( cinfo.output_scanline < cinfo.output_height )
         {
-            jpeg_read_scanlines( &cinfo, row_pointer, 1 );
-            for( i=0; i<cinfo.output_width*cinfo.output_components;i++) 
+            unsigned char* out = _data + cinfo.output_scanline * outRowBytes;
+            JSAMPROW row = row_pointer[0] ? row_pointer[0] : out;
+            jpeg_read_scanlines( &cinfo, &row, 1 );
+            if (row != out)
             {
-                _data[location++] = row_pointer[0][i];
+                Texture2D::convertDataToFormat(row, rowBytes, fileFormat, _renderFormat, out);
             }
         }
 
@@ -913,6 +998,8 @@ bool Image::initWithPngData(const unsigned char * data, ssize_t dataLen)
         if (bit_depth < 8) {
             png_set_packing(png_ptr);
         }
+        // interlaced images are decoded in several passes by png_read_image
+        png_set_interlace_handling(png_ptr);
         // update info
         png_read_update_info(png_ptr, info_ptr);
         bit_depth = png_get_bit_depth(png_ptr, info_ptr);
@@ -936,37 +1023,82 @@ bool Image::initWithPngData(const unsigned char * data, ssize_t dataLen)
             break;
         }
 
+        // rows are premultiplied and converted to the decode format as soon as they are read
+        Texture2D::PixelFormat fileFormat = _renderFormat;
+        bool premultiply = _decodePremultiplyAlpha && fileFormat == Texture2D::PixelFormat::RGBA8888;
+        _renderFormat = Texture2D::getConvertedPixelFormat(fileFormat, _decodeFormat);
+
         // read png data
-        png_size_t rowbytes;
-        png_bytep* row_pointers = (png_bytep*)malloc( sizeof(png_bytep) * _height );
+        png_size_t rowbytes = png_get_rowbytes(png_ptr, info_ptr);
+        png_size_t outRowBytes = _width * (Texture2D::getPixelFormatInfoMap().at(_renderFormat).bpp / 8);
 
-        rowbytes = png_get_rowbytes(png_ptr, info_ptr);
+        _dataLen = outRowBytes * _height;
+        _data = allocateData(_dataLen);
+        _dataOwned = (_dataAllocator == nullptr);
+        CC_BREAK_IF(!_data);
 
-        _dataLen = rowbytes * _height;
-        _data = static_cast<unsigned char*>(malloc(_dataLen * sizeof(unsigned char)));
-        if(!_data)
+        if (png_get_interlace_type(png_ptr, info_ptr) == PNG_INTERLACE_NONE)
         {
-            if (row_pointers != nullptr)
+            // decode straight into the image when the format doesn't change
+            unsigned char* rowData = nullptr;
+            if (_renderFormat != fileFormat)
             {
-                free(row_pointers);
+                rowData = static_cast<unsigned char*>(malloc(rowbytes * sizeof(unsigned char)));
+                CC_BREAK_IF(!rowData);
+            }
+
+            for (int i = 0; i < _height; ++i)
+            {
+                unsigned char* out = _data + i * outRowBytes;
+                unsigned char* row = rowData ? rowData : out;
+                png_read_row(png_ptr, row, nullptr);
+                if (premultiply)
+                {
+                    PixelConversion::premultiplyAlpha(row, _width);
+                }
+                if (row != out)
+                {
+                    Texture2D::convertDataToFormat(row, rowbytes, fileFormat, _renderFormat, out);
+                }
             }
-            break;
-        }
 
-        for (unsigned short i = 0; i < _height; ++i)
+            if (rowData != nullptr)
+            {
+                free(rowData);
+            }
+        }
+        else
         {
-            row_pointers[i] = _data + i*rowbytes;
+            // the rows of interlaced images are complete after the last pass only
+            unsigned char* pixels = _data;
+            if (_renderFormat != fileFormat)
+            {
+                pixels = static_cast<unsigned char*>(malloc(rowbytes * _height * sizeof(unsigned char)));
+                CC_BREAK_IF(!pixels);
+            }
+
+            png_bytep* row_pointers = (png_bytep*)malloc( sizeof(png_bytep) * _height );
+            for (int i = 0; i < _height; ++i)
+            {
+                row_pointers[i] = pixels + i*rowbytes;
+            }
+            png_read_image(png_ptr, row_pointers);
+            free(row_pointers);
+
+            if (premultiply)
+            {
+                PixelConversion::premultiplyAlpha(pixels, _width * _height);
+            }
+            if (pixels != _data)
+            {
+                Texture2D::convertDataToFormat(pixels, rowbytes * _height, fileFormat, _renderFormat, _data);
+                free(pixels);
+            }
         }
-        png_read_image(png_ptr, row_pointers);
 
         png_read_end(png_ptr, nullptr);
 
-        _preMulti = false;
-
-        if (row_pointers != nullptr)
-        {
-            free(row_pointers);
-        }
+        _preMulti = premultiply;
 
         bRet = true;
     } while (0);
@@ -1151,6 +1283,18 @@ bool Image::initWithTiffData(const unsigned char * data, ssize_t dataLen)
 
 namespace
 {
+    // bands smaller than this are not worth a thread
+    const int MIN_BLOCK_ROWS_PER_THREAD = 16;
+
+    // calls decodeRows(firstBlockRow, lastBlockRow) over at most CC_IMAGE_DECODE_THREADS bands of the image, on the calling
+    // thread and on the threads of the WorkerPool, the software decoders write every band to its own rows of the output
+    void decodeBlockRowsInParallel(int blockRows, const std::function<void(int, int)>& decodeRows)
+    {
+        int threadCount = std::min((int)std::thread::hardware_concurrency(), CC_IMAGE_DECODE_THREADS);
+        int bandCount = std::min(threadCount, blockRows / MIN_BLOCK_ROWS_PER_THREAD);
+        WorkerPool::getInstance()->run(blockRows, bandCount, decodeRows);
+    }
+    
     bool testFormatForPvr2TCSupport(PVR2TexturePixelFormat format)
     {
         if (!Configuration::getInstance()->supportsPVRTC())
@@ -1476,7 +1620,16 @@ bool Image::initWithETCData(const unsigned char * data, ssize_t dataLen)
         _dataLen =  _width * _height * bytePerPixel;
         _data = static_cast<unsigned char*>(malloc(_dataLen * sizeof(unsigned char)));
         
-        if (etc1_decode_image(static_cast<const unsigned char*>(data) + ETC_PKM_HEADER_SIZE, static_cast<etc1_byte*>(_data), _width, _height, bytePerPixel, stride) != 0)
+        const etc1_byte* encodeData = static_cast<const unsigned char*>(data) + ETC_PKM_HEADER_SIZE;
+        std::atomic<int> failed(0);
+        decodeBlockRowsInParallel((_height + 3) / 4, [&](int firstBlockRow, int lastBlockRow) {
+            if (etc1_decode_image_rows(encodeData, static_cast<etc1_byte*>(_data), _width, _height, bytePerPixel, stride, firstBlockRow, lastBlockRow) != 0)
+            {
+                failed = 1;
+            }
+        });
+        
+        if (failed)
         {
             _dataLen = 0;
             if (_data != nullptr)
@@ -1671,23 +1824,29 @@ bool Image::initWithS3TCData(const unsigned char * data, ssize_t dataLen)
             int bytePerPixel = 4;
             unsigned int stride = width * bytePerPixel;
 
-            std::vector<unsigned char> decodeImageData(stride * height);
-            if (FOURCC_DXT1 == header->ddsd.DUMMYUNIONNAMEN4.ddpfPixelFormat.fourCC)
+            S3TCDecodeFlag decodeFlag = S3TCDecodeFlag::DXT1;
+            if (FOURCC_DXT3 == header->ddsd.DUMMYUNIONNAMEN4.ddpfPixelFormat.fourCC)
             {
-                s3tc_decode(pixelData + encodeOffset, &decodeImageData[0], width, height, S3TCDecodeFlag::DXT1);
-            }
-            else if (FOURCC_DXT3 == header->ddsd.DUMMYUNIONNAMEN4.ddpfPixelFormat.fourCC)
-            {
-                s3tc_decode(pixelData + encodeOffset, &decodeImageData[0], width, height, S3TCDecodeFlag::DXT3);
+                decodeFlag = S3TCDecodeFlag::DXT3;
             }
             else if (FOURCC_DXT5 == header->ddsd.DUMMYUNIONNAMEN4.ddpfPixelFormat.fourCC)
             {
-                s3tc_decode(pixelData + encodeOffset, &decodeImageData[0], width, height, S3TCDecodeFlag::DXT5);
+                decodeFlag = S3TCDecodeFlag::DXT5;
             }
             
+            // decode straight into the mipmap, the pixels of partial blocks are left black
             _mipmaps[i].address = (unsigned char *)_data + decodeOffset;
             _mipmaps[i].len = (stride * height);
-            memcpy((void *)_mipmaps[i].address, (void *)&decodeImageData[0], _mipmaps[i].len);
+            if ((width | height) & 3)
+            {
+                memset((void *)_mipmaps[i].address, 0, _mipmaps[i].len);
+            }
+            
+            unsigned char *encodeData = pixelData + encodeOffset;
+            unsigned char *decodeData = (unsigned char *)_mipmaps[i].address;
+            decodeBlockRowsInParallel(height / 4, [=](int firstBlockRow, int lastBlockRow) {
+                s3tc_decode_rows(encodeData, decodeData, width, height, firstBlockRow, lastBlockRow, decodeFlag);
+            });
             decodeOffset += stride * height;
         }
         
@@ -1805,25 +1964,32 @@ bool Image::initWithATITCData(const unsigned char *data, ssize_t dataLen)
             unsigned int stride = width * bytePerPixel;
             _renderFormat = Texture2D::PixelFormat::RGBA8888;
             
-            std::vector<unsigned char> decodeImageData(stride * height);
+            ATITCDecodeFlag decodeFlag = ATITCDecodeFlag::ATC_RGB;
             switch (header->glInternalFormat)
             {
-                case CC_GL_ATC_RGB_AMD:
-                    atitc_decode(pixelData + encodeOffset, &decodeImageData[0], width, height, ATITCDecodeFlag::ATC_RGB);
-                    break;
                 case CC_GL_ATC_RGBA_EXPLICIT_ALPHA_AMD:
-                    atitc_decode(pixelData + encodeOffset, &decodeImageData[0], width, height, ATITCDecodeFlag::ATC_EXPLICIT_ALPHA);
+                    decodeFlag = ATITCDecodeFlag::ATC_EXPLICIT_ALPHA;
                     break;
                 case CC_GL_ATC_RGBA_INTERPOLATED_ALPHA_AMD:
-                    atitc_decode(pixelData + encodeOffset, &decodeImageData[0], width, height, ATITCDecodeFlag::ATC_INTERPOLATED_ALPHA);
+                    decodeFlag = ATITCDecodeFlag::ATC_INTERPOLATED_ALPHA;
                     break;
                 default:
                     break;
             }
-
+            
+            // decode straight into the mipmap, the pixels of partial blocks are left black
             _mipmaps[i].address = (unsigned char *)_data + decodeOffset;
             _mipmaps[i].len = (stride * height);
-            memcpy((void *)_mipmaps[i].address, (void *)&decodeImageData[0], _mipmaps[i].len);
+            if ((width | height) & 3)
+            {
+                memset((void *)_mipmaps[i].address, 0, _mipmaps[i].len);
+            }
+            
+            unsigned char *encodeData = pixelData + encodeOffset;
+            unsigned char *decodeData = (unsigned char *)_mipmaps[i].address;
+            decodeBlockRowsInParallel(height / 4, [=](int firstBlockRow, int lastBlockRow) {
+                atitc_decode_rows(encodeData, decodeData, width, height, firstBlockRow, lastBlockRow, decodeFlag);
+            });
             decodeOffset += stride * height;
         }
 
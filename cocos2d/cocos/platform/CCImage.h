@@ -29,6 +29,8 @@ THE SOFTWARE.
 #include "base/CCRef.h"
 #include "renderer/CCTexture2D.h"
 
+#include <functional>
+
 // premultiply alpha, or the effect will wrong when want to use other pixel format in Texture2D,
 // such as RGB888, RGB5A1
 #define CC_RGB_PREMULTIPLY_ALPHA(vr, vg, vb, va) \
@@ -111,6 +113,25 @@ public:
     */
     bool initWithImageData(const unsigned char * data, ssize_t dataLen);
 
+    /** Allocates the buffer of dataLen bytes an image decodes its pixels into. The image doesn't free it. */
+    typedef std::function<unsigned char*(ssize_t dataLen)> DataAllocator;
+
+    /**
+    @brief Sets the pixel format the next initWithImageFile() or initWithImageData() converts the pixels to.
+    PNG and JPG images are decoded row by row, every row is premultiplied and converted as soon as it is decoded,
+    so the pixels are never held in a full size buffer in the format of the file. The other formats are converted
+    once decoded, compressed images and images with mipmaps are not converted.
+    @param format  the format, resolved like Texture2D::initWithImage() does, see Texture2D::getConvertedPixelFormat().
+                   AUTO, the default, keeps the format of the file.
+    @param premultiplyAlpha  premultiplies the alpha of RGBA8888 pixels before the conversion, unless they are already.
+    */
+    void setDecodeFormat(Texture2D::PixelFormat format, bool premultiplyAlpha = false);
+
+    /** Sets the allocator of the buffer PNG, JPG and converted images are decoded into, e.g. to take buffers from a pool.
+     nullptr, the default, mallocs the buffer and the image frees it.
+     */
+    void setDataAllocator(const DataAllocator& allocator);
+
     // @warning kFmtRawData only support RGBA8888
     bool initWithRawData(const unsigned char * data, ssize_t dataLen, int width, int height, int bitsPerComponent, bool preMulti = false);
 
@@ -154,6 +175,10 @@ protected:
 
     bool saveImageToPNG(const std::string& filePath, bool isToRGB = true);
     bool saveImageToJPG(const std::string& filePath);
+
+    unsigned char* allocateData(ssize_t dataLen);
+    // premultiplies and converts the decoded pixels as asked by setDecodeFormat()
+    void convertToDecodeFormat();
     
 protected:
     /**
@@ -173,6 +198,11 @@ protected:
     // false if we cann't auto detect the image is premultiplied or not.
     bool _hasPremultipliedAlpha;
     std::string _filePath;
+    Texture2D::PixelFormat _decodeFormat;
+    bool _decodePremultiplyAlpha;
+    DataAllocator _dataAllocator;
+    // false if _data comes from _dataAllocator
+    bool _dataOwned;
 
 
 protected:
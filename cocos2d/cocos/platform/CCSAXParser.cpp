@@ -116,7 +116,7 @@ bool SAXParser::parse(const char* xmlData, size_t dataLength)
 bool SAXParser::parse(const std::string& filename)
 {
     bool ret = false;
-    Data data = FileUtils::getInstance()->getDataFromFile(filename);
+    Data data = FileUtils::getInstance()->getMappedDataFromFile(filename);
     if (!data.isNull())
     {
         ret = parse((const char*)data.getBytes(), data.getSize());
@@ -28,6 +28,7 @@ THE SOFTWARE.
 
 #include "CCFileUtilsAndroid.h"
 #include "platform/CCCommon.h"
+#include "base/CCAssetPack.h"
 #include "jni/Java_org_cocos2dx_lib_Cocos2dxHelper.h"
 #include "android/asset_manager.h"
 #include "android/asset_manager_jni.h"
@@ -144,6 +145,13 @@ Data FileUtilsAndroid::getData(const std::string& filename, bool forString)
     unsigned char* data = nullptr;
     ssize_t size = 0;
     string fullPath = fullPathForFilename(filename);
+
+    string entryPath;
+    std::shared_ptr<AssetPack> pack = getAssetPackForPath(fullPath, &entryPath);
+    if (pack)
+    {
+        return pack->getData(entryPath, forString);
+    }
     
     if (fullPath[0] != '/')
     {
@@ -33,6 +33,7 @@ THE SOFTWARE.
 #include <algorithm>
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include <string>
 #include <sstream>
 #include <fontconfig/fontconfig.h>
@@ -46,6 +47,26 @@ using namespace std;
 // as FcFontMatch is quite an expensive call, cache the results of getFontFile
 static std::map<std::string, std::string> fontCache;
 
+// the bitmaps of the glyphs are kept across the strings, up to this size in bytes
+static const size_t MAX_CACHED_GLYPHS_SIZE = 4 * 1024 * 1024;
+
+struct CachedGlyph {
+    int glyphWidth;
+    int bearingX;
+    int bearingY;
+    int horizAdvance;
+
+    int bitmapWidth;
+    int bitmapRows;
+    std::vector<unsigned char> bitmap;
+};
+
+struct CachedFace {
+    FT_Face face;
+    int id;
+    FT_UInt pixelSize;
+};
+
 struct LineBreakGlyph {
     FT_UInt glyphIndex;
     int paintPosition;
@@ -119,10 +140,14 @@ public:
 		libError = FT_Init_FreeType( &library );
 		FcInit();
 		_data = NULL;
+		cachedGlyphsSize = 0;
 		reset();
 	}
 
 	~BitmapDC() {
+		for (auto& item : faces) {
+			FT_Done_Face(item.second.face);
+		}
 		FT_Done_FreeType(library);
 		FcFini();
 		
@@ -178,7 +203,8 @@ public:
     	return false;
     }
 
-	bool divideString(FT_Face face, const char* sText, int iMaxWidth, int iMaxHeight) {
+	bool divideString(const CachedFace& cachedFace, const char* sText, int iMaxWidth, int iMaxHeight) {
+		FT_Face face = cachedFace.face;
 		const char* pText = sText;
 		textLines.clear();
 		iMaxLineWidth = 0;
@@ -211,12 +237,13 @@ public:
             }
 
 			glyphIndex = FT_Get_Char_Index(face, unicode);
-			if (FT_Load_Glyph(face, glyphIndex, FT_LOAD_DEFAULT)) {
+			const CachedGlyph* cachedGlyph = getGlyph(cachedFace, glyphIndex);
+			if (cachedGlyph == nullptr) {
 				return false;
 			}
 
 			if (isspace(unicode)) {
-				currentPaintPosition += face->glyph->metrics.horiAdvance >> 6;
+				currentPaintPosition += cachedGlyph->horizAdvance;
 				prevGlyphIndex = glyphIndex;
 				prevCharacter = unicode;
 				lastBreakIndex = currentLine.glyphs.size();
@@ -225,9 +252,9 @@ public:
 
 			LineBreakGlyph glyph;
 			glyph.glyphIndex = glyphIndex;
-			glyph.glyphWidth = face->glyph->metrics.width >> 6;
-			glyph.bearingX = face->glyph->metrics.horiBearingX >> 6;
-			glyph.horizAdvance = face->glyph->metrics.horiAdvance >> 6;
+			glyph.glyphWidth = cachedGlyph->glyphWidth;
+			glyph.bearingX = cachedGlyph->bearingX;
+			glyph.horizAdvance = cachedGlyph->horizAdvance;
 			glyph.kerning = 0;
 
 			if (prevGlyphIndex != 0 && hasKerning) {
@@ -369,33 +396,95 @@ public:
     	return family_name;
     }
 
-	bool getBitmap(const char *text, int nWidth, int nHeight, Device::TextAlign eAlignMask, const char * pFontName, float fontSize) {
-		if (libError) {
-			return false;
+	/**
+	 * the faces stay open, loading a font file for every string is slow
+	 */
+	CachedFace* getFace(const std::string& fontfile) {
+		auto it = faces.find(fontfile);
+		if (it != faces.end()) {
+			return &it->second;
 		}
 
 		FT_Face face;
-		std::string fontfile = getFontFile(pFontName);
 		if ( FT_New_Face(library, fontfile.c_str(), 0, &face) ) {
-			//no valid font found use default
-			if ( FT_New_Face(library, "/usr/share/fonts/truetype/freefont/FreeSerif.ttf", 0, &face) ) {
-				return false;
-			}
+			return nullptr;
 		}
-
 		//select utf8 charmap
 		if ( FT_Select_Charmap(face, FT_ENCODING_UNICODE) ) {
 			FT_Done_Face(face);
-			return false;
+			return nullptr;
 		}
 
-		if ( FT_Set_Pixel_Sizes(face, fontSize, fontSize) ) {
-			FT_Done_Face(face);
+		CachedFace& cachedFace = faces[fontfile];
+		cachedFace.face = face;
+		cachedFace.id = (int)faces.size();
+		cachedFace.pixelSize = 0;
+		return &cachedFace;
+	}
+
+	/**
+	 * the metrics and the bitmap of a glyph of the face at its current size
+	 */
+	const CachedGlyph* getGlyph(const CachedFace& cachedFace, FT_UInt glyphIndex) {
+		unsigned long long key = ((unsigned long long)cachedFace.id << 48) | ((unsigned long long)cachedFace.pixelSize << 32) | glyphIndex;
+		auto it = glyphs.find(key);
+		if (it != glyphs.end()) {
+			return &it->second;
+		}
+
+		FT_Face face = cachedFace.face;
+		if (FT_Load_Glyph(face, glyphIndex, FT_LOAD_RENDER)) {
+			return nullptr;
+		}
+
+		if (cachedGlyphsSize > MAX_CACHED_GLYPHS_SIZE) {
+			glyphs.clear();
+			cachedGlyphsSize = 0;
+		}
+
+		CachedGlyph& glyph = glyphs[key];
+		glyph.glyphWidth = face->glyph->metrics.width >> 6;
+		glyph.bearingX = face->glyph->metrics.horiBearingX >> 6;
+		glyph.bearingY = face->glyph->metrics.horiBearingY >> 6;
+		glyph.horizAdvance = face->glyph->metrics.horiAdvance >> 6;
+
+		FT_Bitmap& bitmap = face->glyph->bitmap;
+		glyph.bitmapWidth = bitmap.width;
+		glyph.bitmapRows = bitmap.rows;
+		glyph.bitmap.resize(bitmap.width * bitmap.rows);
+		for (int y = 0; y < (int)bitmap.rows; ++y) {
+			memcpy(&glyph.bitmap[y * bitmap.width], bitmap.buffer + y * bitmap.pitch, bitmap.width);
+		}
+		cachedGlyphsSize += sizeof(CachedGlyph) + glyph.bitmap.size();
+		return &glyph;
+	}
+
+	bool getBitmap(const char *text, int nWidth, int nHeight, Device::TextAlign eAlignMask, const char * pFontName, float fontSize) {
+		if (libError) {
 			return false;
 		}
 
-		if ( divideString(face, text, nWidth, nHeight) == false ) {
-			FT_Done_Face(face);
+		std::string fontfile = getFontFile(pFontName);
+		CachedFace* cachedFace = getFace(fontfile);
+		if ( cachedFace == nullptr ) {
+			//no valid font found use default
+			cachedFace = getFace("/usr/share/fonts/truetype/freefont/FreeSerif.ttf");
+			if ( cachedFace == nullptr ) {
+				return false;
+			}
+		}
+
+		FT_Face face = cachedFace->face;
+		FT_UInt pixelSize = (FT_UInt)fontSize;
+		if ( cachedFace->pixelSize != pixelSize ) {
+			if ( FT_Set_Pixel_Sizes(face, pixelSize, pixelSize) ) {
+				cachedFace->pixelSize = 0;
+				return false;
+			}
+			cachedFace->pixelSize = pixelSize;
+		}
+
+		if ( divideString(*cachedFace, text, nWidth, nHeight) == false ) {
 			return false;
 		}
 
@@ -422,17 +511,17 @@ public:
 
 			int glyphCount = textLines.at(line).glyphs.size();
 			for (int i = 0; i < glyphCount; i++) {
-				LineBreakGlyph glyph = textLines.at(line).glyphs.at(i);
+				const LineBreakGlyph& glyph = textLines.at(line).glyphs.at(i);
 
-				if (FT_Load_Glyph(face, glyph.glyphIndex, FT_LOAD_RENDER)) {
+				const CachedGlyph* cachedGlyph = getGlyph(*cachedFace, glyph.glyphIndex);
+				if (cachedGlyph == nullptr) {
 					continue;
 				}
 
-				FT_Bitmap& bitmap = face->glyph->bitmap;
-				int yoffset = iCurYCursor - (face->glyph->metrics.horiBearingY >> 6);
+				int yoffset = iCurYCursor - cachedGlyph->bearingY;
 				int xoffset = iCurXCursor + glyph.paintPosition;
 
-				for (int y = 0; y < bitmap.rows; ++y) {
+				for (int y = 0; y < cachedGlyph->bitmapRows; ++y) {
                     int iY = yoffset + y;
                     if (iY>=iMaxLineHeight) {
                         //exceed the height truncate
@@ -440,10 +529,10 @@ public:
                     }
                     iY *= iMaxLineWidth;
 
-                    int bitmap_y = y * bitmap.width;
+                    int bitmap_y = y * cachedGlyph->bitmapWidth;
 
-					for (int x = 0; x < bitmap.width; ++x) {
-						unsigned char cTemp = bitmap.buffer[bitmap_y + x];
+					for (int x = 0; x < cachedGlyph->bitmapWidth; ++x) {
+						unsigned char cTemp = cachedGlyph->bitmap[bitmap_y + x];
 						if (cTemp == 0) {
 							continue;
 						}
@@ -459,13 +548,14 @@ public:
 			iCurYCursor += lineHeight;
 		}
 
-		//  free face
-		FT_Done_Face(face);
 		return true;
 	}
 
 public:
 	FT_Library library;
+	std::map<std::string, CachedFace> faces;
+	std::unordered_map<unsigned long long, CachedGlyph> glyphs;
+	size_t cachedGlyphsSize;
 
 	unsigned char *_data;
 	int libError;
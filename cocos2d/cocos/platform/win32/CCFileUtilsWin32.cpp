@@ -28,6 +28,7 @@ THE SOFTWARE.
 
 #include "CCFileUtilsWin32.h"
 #include "platform/CCCommon.h"
+#include "base/CCAssetPack.h"
 #include <Shlobj.h>
 
 using namespace std;
@@ -144,6 +145,13 @@ static Data getData(const std::string& filename, bool forString)
         // read the file from hardware
         std::string fullPath = FileUtils::getInstance()->fullPathForFilename(filename);
 
+        std::string entryPath;
+        std::shared_ptr<AssetPack> pack = FileUtils::getInstance()->getAssetPackForPath(fullPath, &entryPath);
+        if (pack)
+        {
+            return pack->getData(entryPath, forString);
+        }
+
         WCHAR wszBuf[CC_MAX_PATH] = {0};
         MultiByteToWideChar(CP_UTF8, 0, fullPath.c_str(), -1, wszBuf, sizeof(wszBuf)/sizeof(wszBuf[0]));
 
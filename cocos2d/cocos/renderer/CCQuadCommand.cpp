@@ -73,13 +73,18 @@ QuadCommand::~QuadCommand()
 void QuadCommand::generateMaterialID()
 {
 
+    int glProgram = (int)_glProgramState->getGLProgram()->getProgram();
     if(_glProgramState->getUniformCount() > 0)
     {
-        _materialID = QuadCommand::MATERIAL_ID_DO_NOT_BATCH;
+        // the commands sharing a program state have the same uniform values, they are batched together
+        intptr_t glProgramState = reinterpret_cast<intptr_t>(_glProgramState);
+        int intArray[6] = { glProgram, (int)_textureID, (int)_blendType.src, (int)_blendType.dst,
+            (int)(glProgramState & 0xffffffff), (int)((int64_t)glProgramState >> 32) };
+
+        _materialID = XXH32((const void*)intArray, sizeof(intArray), 0);
     }
     else
     {
-        int glProgram = (int)_glProgramState->getGLProgram()->getProgram();
         int intArray[4] = { glProgram, (int)_textureID, (int)_blendType.src, (int)_blendType.dst};
 
         _materialID = XXH32((const void*)intArray, sizeof(intArray), 0);
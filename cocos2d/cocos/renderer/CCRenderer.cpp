@@ -296,7 +296,11 @@ void Renderer::visitRenderQueue(const RenderQueue& queue)
             _batchedQuadCommands.push_back(cmd);
             
             memcpy(_quads + _numQuads, cmd->getQuads(), sizeof(V3F_C4B_T2F_Quad) * cmd->getQuadCount());
-            convertToWorldCoordinates(_quads + _numQuads, cmd->getQuadCount(), cmd->getModelView());
+            // the quads of an identity transform are already in world coordinates, e.g. the ones of the labels
+            if (!cmd->getModelView().isIdentity())
+            {
+                convertToWorldCoordinates(_quads + _numQuads, cmd->getQuadCount(), cmd->getModelView());
+            }
             
             _numQuads += cmd->getQuadCount();
 
@@ -44,6 +44,7 @@ THE SOFTWARE.
 #include "base/CCDirector.h"
 #include "renderer/CCGLProgram.h"
 #include "renderer/ccGLStateCache.h"
+#include "renderer/ccPixelConversion.h"
 #include "renderer/CCGLProgramCache.h"
 
 #include "deprecated/CCString.h"
@@ -151,7 +152,9 @@ void Texture2D::convertAI88ToRGB888(const unsigned char* data, ssize_t dataLen,
 // IIIIIIII -> RRRRRRRRGGGGGGGGGBBBBBBBBAAAAAAAA
 void Texture2D::convertI8ToRGBA8888(const unsigned char* data, ssize_t dataLen, unsigned char* outData)
 {
-    for (ssize_t i = 0; i < dataLen; ++i)
+    ssize_t converted = PixelConversion::convertI8ToRGBA8888(data, dataLen, outData);
+    outData += converted * 4;
+    for (ssize_t i = converted; i < dataLen; ++i)
     {
         *outData++ = data[i];     //R
         *outData++ = data[i];     //G
@@ -163,7 +166,9 @@ void Texture2D::convertI8ToRGBA8888(const unsigned char* data, ssize_t dataLen,
 // IIIIIIIIAAAAAAAA -> RRRRRRRRGGGGGGGGBBBBBBBBAAAAAAAA
 void Texture2D::convertAI88ToRGBA8888(const unsigned char* data, ssize_t dataLen, unsigned char* outData)
 {
-    for (ssize_t i = 0, l = dataLen - 1; i < l; i += 2)
+    ssize_t converted = PixelConversion::convertAI88ToRGBA8888(data, dataLen / 2, outData);
+    outData += converted * 4;
+    for (ssize_t i = converted * 2, l = dataLen - 1; i < l; i += 2)
     {
         *outData++ = data[i];     //R
         *outData++ = data[i];     //G
@@ -175,8 +180,9 @@ void Texture2D::convertAI88ToRGBA8888(const unsigned char* data, ssize_t dataLen
 // IIIIIIII -> RRRRRGGGGGGBBBBB
 void Texture2D::convertI8ToRGB565(const unsigned char* data, ssize_t dataLen, unsigned char* outData)
 {
-    unsigned short* out16 = (unsigned short*)outData;
-    for (int i = 0; i < dataLen; ++i)
+    ssize_t converted = PixelConversion::convertI8ToRGB565(data, dataLen, outData);
+    unsigned short* out16 = (unsigned short*)outData + converted;
+    for (ssize_t i = converted; i < dataLen; ++i)
     {
         *out16++ = (data[i] & 0x00F8) << 8    //R
             | (data[i] & 0x00FC) << 3         //G
@@ -187,8 +193,9 @@ void Texture2D::convertI8ToRGB565(const unsigned char* data, ssize_t dataLen, un
 // IIIIIIIIAAAAAAAA -> RRRRRGGGGGGBBBBB
 void Texture2D::convertAI88ToRGB565(const unsigned char* data, ssize_t dataLen, unsigned char* outData)
 {
-    unsigned short* out16 = (unsigned short*)outData;
-    for (ssize_t i = 0, l = dataLen - 1; i < l; i += 2)
+    ssize_t converted = PixelConversion::convertAI88ToRGB565(data, dataLen / 2, outData);
+    unsigned short* out16 = (unsigned short*)outData + converted;
+    for (ssize_t i = converted * 2, l = dataLen - 1; i < l; i += 2)
     {
         *out16++ = (data[i] & 0x00F8) << 8    //R
             | (data[i] & 0x00FC) << 3         //G
@@ -199,8 +206,9 @@ void Texture2D::convertAI88ToRGB565(const unsigned char* data, ssize_t dataLen,
 // IIIIIIII -> RRRRGGGGBBBBAAAA
 void Texture2D::convertI8ToRGBA4444(const unsigned char* data, ssize_t dataLen, unsigned char* outData)
 {
-    unsigned short* out16 = (unsigned short*)outData;
-    for (ssize_t i = 0; i < dataLen; ++i)
+    ssize_t converted = PixelConversion::convertI8ToRGBA4444(data, dataLen, outData);
+    unsigned short* out16 = (unsigned short*)outData + converted;
+    for (ssize_t i = converted; i < dataLen; ++i)
     {
         *out16++ = (data[i] & 0x00F0) << 8    //R
         | (data[i] & 0x00F0) << 4             //G
@@ -212,8 +220,9 @@ void Texture2D::convertI8ToRGBA4444(const unsigned char* data, ssize_t dataLen,
 // IIIIIIIIAAAAAAAA -> RRRRGGGGBBBBAAAA
 void Texture2D::convertAI88ToRGBA4444(const unsigned char* data, ssize_t dataLen, unsigned char* outData)
 {
-    unsigned short* out16 = (unsigned short*)outData;
-    for (ssize_t i = 0, l = dataLen - 1; i < l; i += 2)
+    ssize_t converted = PixelConversion::convertAI88ToRGBA4444(data, dataLen / 2, outData);
+    unsigned short* out16 = (unsigned short*)outData + converted;
+    for (ssize_t i = converted * 2, l = dataLen - 1; i < l; i += 2)
     {
         *out16++ = (data[i] & 0x00F0) << 8    //R
         | (data[i] & 0x00F0) << 4             //G
@@ -225,8 +234,9 @@ void Texture2D::convertAI88ToRGBA4444(const unsigned char* data, ssize_t dataLen
 // IIIIIIII -> RRRRRGGGGGBBBBBA
 void Texture2D::convertI8ToRGB5A1(const unsigned char* data, ssize_t dataLen, unsigned char* outData)
 {
-    unsigned short* out16 = (unsigned short*)outData;
-    for (int i = 0; i < dataLen; ++i)
+    ssize_t converted = PixelConversion::convertI8ToRGB5A1(data, dataLen, outData);
+    unsigned short* out16 = (unsigned short*)outData + converted;
+    for (ssize_t i = converted; i < dataLen; ++i)
     {
         *out16++ = (data[i] & 0x00F8) << 8    //R
             | (data[i] & 0x00F8) << 3         //G
@@ -238,8 +248,9 @@ void Texture2D::convertI8ToRGB5A1(const unsigned char* data, ssize_t dataLen, un
 // IIIIIIIIAAAAAAAA -> RRRRRGGGGGBBBBBA
 void Texture2D::convertAI88ToRGB5A1(const unsigned char* data, ssize_t dataLen, unsigned char* outData)
 {
-    unsigned short* out16 = (unsigned short*)outData;
-    for (ssize_t i = 0, l = dataLen - 1; i < l; i += 2)
+    ssize_t converted = PixelConversion::convertAI88ToRGB5A1(data, dataLen / 2, outData);
+    unsigned short* out16 = (unsigned short*)outData + converted;
+    for (ssize_t i = converted * 2, l = dataLen - 1; i < l; i += 2)
     {
         *out16++ = (data[i] & 0x00F8) << 8    //R
             | (data[i] & 0x00F8) << 3         //G
@@ -251,8 +262,9 @@ void Texture2D::convertAI88ToRGB5A1(const unsigned char* data, ssize_t dataLen,
 // IIIIIIII -> IIIIIIIIAAAAAAAA
 void Texture2D::convertI8ToAI88(const unsigned char* data, ssize_t dataLen, unsigned char* outData)
 {
-    unsigned short* out16 = (unsigned short*)outData;
-    for (ssize_t i = 0; i < dataLen; ++i)
+    ssize_t converted = PixelConversion::convertI8ToAI88(data, dataLen, outData);
+    unsigned short* out16 = (unsigned short*)outData + converted;
+    for (ssize_t i = converted; i < dataLen; ++i)
     {
         *out16++ = 0xFF00     //A
         | data[i];            //I
@@ -262,7 +274,9 @@ void Texture2D::convertI8ToAI88(const unsigned char* data, ssize_t dataLen, unsi
 // IIIIIIIIAAAAAAAA -> AAAAAAAA
 void Texture2D::convertAI88ToA8(const unsigned char* data, ssize_t dataLen, unsigned char* outData)
 {
-    for (ssize_t i = 1; i < dataLen; i += 2)
+    ssize_t converted = PixelConversion::convertAI88ToA8(data, dataLen / 2, outData);
+    outData += converted;
+    for (ssize_t i = converted * 2 + 1; i < dataLen; i += 2)
     {
         *outData++ = data[i]; //A
     }
@@ -271,7 +285,9 @@ void Texture2D::convertAI88ToA8(const unsigned char* data, ssize_t dataLen, unsi
 // IIIIIIIIAAAAAAAA -> IIIIIIII
 void Texture2D::convertAI88ToI8(const unsigned char* data, ssize_t dataLen, unsigned char* outData)
 {
-    for (ssize_t i = 0, l = dataLen - 1; i < l; i += 2)
+    ssize_t converted = PixelConversion::convertAI88ToI8(data, dataLen / 2, outData);
+    outData += converted;
+    for (ssize_t i = converted * 2, l = dataLen - 1; i < l; i += 2)
     {
         *outData++ = data[i]; //R
     }
@@ -315,8 +331,9 @@ void Texture2D::convertRGB888ToRGB565(const unsigned char* data, ssize_t dataLen
 // RRRRRRRRGGGGGGGGBBBBBBBBAAAAAAAA -> RRRRRGGGGGGBBBBB
 void Texture2D::convertRGBA8888ToRGB565(const unsigned char* data, ssize_t dataLen, unsigned char* outData)
 {
-    unsigned short* out16 = (unsigned short*)outData;
-    for (ssize_t i = 0, l = dataLen - 3; i < l; i += 4)
+    ssize_t converted = PixelConversion::convertRGBA8888ToRGB565(data, dataLen / 4, outData);
+    unsigned short* out16 = (unsigned short*)outData + converted;
+    for (ssize_t i = converted * 4, l = dataLen - 3; i < l; i += 4)
     {
         *out16++ = (data[i] & 0x00F8) << 8    //R
             | (data[i + 1] & 0x00FC) << 3     //G
@@ -336,7 +353,9 @@ void Texture2D::convertRGB888ToI8(const unsigned char* data, ssize_t dataLen, un
 // RRRRRRRRGGGGGGGGBBBBBBBBAAAAAAAA -> IIIIIIII
 void Texture2D::convertRGBA8888ToI8(const unsigned char* data, ssize_t dataLen, unsigned char* outData)
 {
-    for (ssize_t i = 0, l = dataLen - 3; i < l; i += 4)
+    ssize_t converted = PixelConversion::convertRGBA8888ToI8(data, dataLen / 4, outData);
+    outData += converted;
+    for (ssize_t i = converted * 4, l = dataLen - 3; i < l; i += 4)
     {
         *outData++ = (data[i] * 299 + data[i + 1] * 587 + data[i + 2] * 114 + 500) / 1000;  //I =  (R*299 + G*587 + B*114 + 500) / 1000
     }
@@ -345,7 +364,9 @@ void Texture2D::convertRGBA8888ToI8(const unsigned char* data, ssize_t dataLen,
 // RRRRRRRRGGGGGGGGBBBBBBBBAAAAAAAA -> AAAAAAAA
 void Texture2D::convertRGBA8888ToA8(const unsigned char* data, ssize_t dataLen, unsigned char* outData)
 {
-    for (ssize_t i = 0, l = dataLen -3; i < l; i += 4)
+    ssize_t converted = PixelConversion::convertRGBA8888ToA8(data, dataLen / 4, outData);
+    outData += converted;
+    for (ssize_t i = converted * 4, l = dataLen -3; i < l; i += 4)
     {
         *outData++ = data[i + 3]; //A
     }
@@ -365,7 +386,9 @@ void Texture2D::convertRGB888ToAI88(const unsigned char* data, ssize_t dataLen,
 // RRRRRRRRGGGGGGGGBBBBBBBBAAAAAAAA -> IIIIIIIIAAAAAAAA
 void Texture2D::convertRGBA8888ToAI88(const unsigned char* data, ssize_t dataLen, unsigned char* outData)
 {
-    for (ssize_t i = 0, l = dataLen - 3; i < l; i += 4)
+    ssize_t converted = PixelConversion::convertRGBA8888ToAI88(data, dataLen / 4, outData);
+    outData += converted * 2;
+    for (ssize_t i = converted * 4, l = dataLen - 3; i < l; i += 4)
     {
         *outData++ = (data[i] * 299 + data[i + 1] * 587 + data[i + 2] * 114 + 500) / 1000;  //I =  (R*299 + G*587 + B*114 + 500) / 1000
         *outData++ = data[i + 3];
@@ -388,8 +411,9 @@ void Texture2D::convertRGB888ToRGBA4444(const unsigned char* data, ssize_t dataL
 // RRRRRRRRGGGGGGGGBBBBBBBBAAAAAAAA -> RRRRGGGGBBBBAAAA
 void Texture2D::convertRGBA8888ToRGBA4444(const unsigned char* data, ssize_t dataLen, unsigned char* outData)
 {
-    unsigned short* out16 = (unsigned short*)outData;
-    for (ssize_t i = 0, l = dataLen - 3; i < l; i += 4)
+    ssize_t converted = PixelConversion::convertRGBA8888ToRGBA4444(data, dataLen / 4, outData);
+    unsigned short* out16 = (unsigned short*)outData + converted;
+    for (ssize_t i = converted * 4, l = dataLen - 3; i < l; i += 4)
     {
         *out16++ = (data[i] & 0x00F0) << 8    //R
         | (data[i + 1] & 0x00F0) << 4         //G
@@ -414,8 +438,9 @@ void Texture2D::convertRGB888ToRGB5A1(const unsigned char* data, ssize_t dataLen
 // RRRRRRRRGGGGGGGGBBBBBBBB -> RRRRRGGGGGBBBBBA
 void Texture2D::convertRGBA8888ToRGB5A1(const unsigned char* data, ssize_t dataLen, unsigned char* outData)
 {
-    unsigned short* out16 = (unsigned short*)outData;
-    for (ssize_t i = 0, l = dataLen - 2; i < l; i += 4)
+    ssize_t converted = PixelConversion::convertRGBA8888ToRGB5A1(data, dataLen / 4, outData);
+    unsigned short* out16 = (unsigned short*)outData + converted;
+    for (ssize_t i = converted * 4, l = dataLen - 2; i < l; i += 4)
     {
         *out16++ = (data[i] & 0x00F8) << 8    //R
             | (data[i + 1] & 0x00F8) << 3     //G
@@ -437,6 +462,7 @@ Texture2D::Texture2D()
 , _hasMipmaps(false)
 , _shaderProgram(nullptr)
 , _antialiasEnabled(true)
+, _lastUsedFrame(0)
 {
 }
 
@@ -542,6 +568,17 @@ bool Texture2D::initWithData(const void *data, ssize_t dataLen, Texture2D::Pixel
     _maxT = contentSize.height / (float)(pixelsHigh);
 }
 
+bool Texture2D::initWithData(const void *data, ssize_t dataLen, Texture2D::PixelFormat pixelFormat, int pixelsWide, int pixelsHigh, const Size& contentSize, bool premultipliedAlpha)
+{
+    if (! initWithData(data, dataLen, pixelFormat, pixelsWide, pixelsHigh, contentSize))
+    {
+        return false;
+    }
+
+    _hasPremultipliedAlpha = premultipliedAlpha;
+    return true;
+}
+
 bool Texture2D::initWithMipmaps(MipmapInfo* mipmaps, int mipmapsNum, PixelFormat pixelFormat, int pixelsWide, int pixelsHigh)
 {
     // cocos2d-x is currently calling this multiple times on the same Texture2D
@@ -774,7 +811,16 @@ bool Texture2D::initWithImage(Image *image, PixelFormat format)
         unsigned char* outTempData = nullptr;
         ssize_t outTempDataLen = 0;
 
-        pixelFormat = convertDataToFormat(tempData, tempDataLen, renderFormat, pixelFormat, &outTempData, &outTempDataLen);
+        if (renderFormat == pixelFormat)
+        {
+            // the image was decoded in the format already, see Image::setDecodeFormat()
+            outTempData = tempData;
+            outTempDataLen = tempDataLen;
+        }
+        else
+        {
+            pixelFormat = convertDataToFormat(tempData, tempDataLen, renderFormat, pixelFormat, &outTempData, &outTempDataLen);
+        }
 
         initWithData(outTempData, outTempDataLen, pixelFormat, imageWidth, imageHeight, imageSize);
 
@@ -786,20 +832,11 @@ bool Texture2D::initWithImage(Image *image, PixelFormat format)
         }
 
         // set the premultiplied tag
-        if (!image->hasPremultipliedAlpha())
-        {
-            if (image->getFileType() == Image::Format::PVR)
-            {
-                _hasPremultipliedAlpha = _PVRHaveAlphaPremultiplied;
-            }else
-            {
-                CCLOG("wanning: We cann't find the data is premultiplied or not, we will assume it's false.");
-                _hasPremultipliedAlpha = false;
-            }
-        }else
+        if (!image->hasPremultipliedAlpha() && image->getFileType() != Image::Format::PVR)
         {
-            _hasPremultipliedAlpha = image->isPremultipliedAlpha();
+            CCLOG("wanning: We cann't find the data is premultiplied or not, we will assume it's false.");
         }
+        _hasPremultipliedAlpha = isImagePremultipliedAlpha(image);
         return true;
     }
 }
@@ -1048,6 +1085,91 @@ Texture2D::PixelFormat Texture2D::convertDataToFormat(const unsigned char* data,
     }
 }
 
+Texture2D::DataConverter Texture2D::getDataConverter(PixelFormat originFormat, PixelFormat format)
+{
+    switch (originFormat)
+    {
+    case PixelFormat::I8:
+        switch (format)
+        {
+        case PixelFormat::RGBA8888: return convertI8ToRGBA8888;
+        case PixelFormat::RGB888:   return convertI8ToRGB888;
+        case PixelFormat::RGB565:   return convertI8ToRGB565;
+        case PixelFormat::AI88:     return convertI8ToAI88;
+        case PixelFormat::RGBA4444: return convertI8ToRGBA4444;
+        case PixelFormat::RGB5A1:   return convertI8ToRGB5A1;
+        default:                    return nullptr;
+        }
+    case PixelFormat::AI88:
+        switch (format)
+        {
+        case PixelFormat::RGBA8888: return convertAI88ToRGBA8888;
+        case PixelFormat::RGB888:   return convertAI88ToRGB888;
+        case PixelFormat::RGB565:   return convertAI88ToRGB565;
+        case PixelFormat::A8:       return convertAI88ToA8;
+        case PixelFormat::I8:       return convertAI88ToI8;
+        case PixelFormat::RGBA4444: return convertAI88ToRGBA4444;
+        case PixelFormat::RGB5A1:   return convertAI88ToRGB5A1;
+        default:                    return nullptr;
+        }
+    case PixelFormat::RGB888:
+        switch (format)
+        {
+        case PixelFormat::RGBA8888: return convertRGB888ToRGBA8888;
+        case PixelFormat::RGB565:   return convertRGB888ToRGB565;
+        case PixelFormat::I8:       return convertRGB888ToI8;
+        case PixelFormat::AI88:     return convertRGB888ToAI88;
+        case PixelFormat::RGBA4444: return convertRGB888ToRGBA4444;
+        case PixelFormat::RGB5A1:   return convertRGB888ToRGB5A1;
+        default:                    return nullptr;
+        }
+    case PixelFormat::RGBA8888:
+        switch (format)
+        {
+        case PixelFormat::RGB888:   return convertRGBA8888ToRGB888;
+        case PixelFormat::RGB565:   return convertRGBA8888ToRGB565;
+        case PixelFormat::A8:       return convertRGBA8888ToA8;
+        case PixelFormat::I8:       return convertRGBA8888ToI8;
+        case PixelFormat::AI88:     return convertRGBA8888ToAI88;
+        case PixelFormat::RGBA4444: return convertRGBA8888ToRGBA4444;
+        case PixelFormat::RGB5A1:   return convertRGBA8888ToRGB5A1;
+        default:                    return nullptr;
+        }
+    default:
+        return nullptr;
+    }
+}
+
+Texture2D::PixelFormat Texture2D::getConvertedPixelFormat(PixelFormat originFormat, PixelFormat format)
+{
+    return getDataConverter(originFormat, format) ? format : originFormat;
+}
+
+Texture2D::PixelFormat Texture2D::convertDataToFormat(const unsigned char* data, ssize_t dataLen, PixelFormat originFormat, PixelFormat format, unsigned char* outData)
+{
+    DataConverter converter = getDataConverter(originFormat, format);
+    if (converter == nullptr)
+    {
+        if (outData != data)
+        {
+            memcpy(outData, data, dataLen);
+        }
+        return originFormat;
+    }
+
+    converter(data, dataLen, outData);
+    return format;
+}
+
+bool Texture2D::isImagePremultipliedAlpha(Image* image)
+{
+    if (image->hasPremultipliedAlpha())
+    {
+        return image->isPremultipliedAlpha();
+    }
+    return image->getFileType() == Image::Format::PVR && _PVRHaveAlphaPremultiplied;
+}
+
 // implementation Texture2D (Text)
 bool Texture2D::initWithString(const char *text, const std::string& fontName, float fontSize, const Size& dimensions/* = Size(0, 0)*/, TextHAlignment hAlignment/* =  TextHAlignment::CENTER */, TextVAlignment vAlignment/* =  TextVAlignment::TOP */)
 {
@@ -1130,7 +1252,47 @@ bool Texture2D::initWithString(const char *text, const FontDefinition& textDefin
     Size  imageSize = Size((float)imageWidth, (float)imageHeight);
     pixelFormat = convertDataToFormat(outData.getBytes(), imageWidth*imageHeight*4, PixelFormat::RGBA8888, pixelFormat, &outTempData, &outTempDataLen);
 
-    ret = initWithData(outTempData, outTempDataLen, pixelFormat, imageWidth, imageHeight, imageSize);
+    // a texture already holding a string is updated in place when the new one fits in it,
+    // instead of creating a GL texture for every string. The GL textures are gone while reloading them
+    bool reuseTexture = _name != 0 && !_hasMipmaps && pixelFormat == _pixelFormat
+        && imageWidth <= _pixelsWide && imageHeight <= _pixelsHigh
+        && imageWidth * imageHeight * 4 >= _pixelsWide * _pixelsHigh;
+#if CC_ENABLE_CACHE_TEXTURE_DATA
+    reuseTexture = reuseTexture && !VolatileTextureMgr::_isReloading;
+#endif
+
+    if (reuseTexture)
+    {
+        // with a row and a column of transparent texels around the string, so that the bilinear filtering
+        // doesn't pick the previous one
+        int bytesPerPixel = _pixelFormatInfoTables.at(pixelFormat).bpp / 8;
+        int uploadWidth = MIN(imageWidth + 1, _pixelsWide);
+        int uploadHeight = MIN(imageHeight + 1, _pixelsHigh);
+        unsigned char* uploadData = outTempData;
+        if (uploadWidth != imageWidth || uploadHeight != imageHeight)
+        {
+            uploadData = (unsigned char*)calloc(uploadWidth * uploadHeight * bytesPerPixel, 1);
+            for (int y = 0; y < imageHeight; ++y)
+            {
+                memcpy(uploadData + y * uploadWidth * bytesPerPixel, outTempData + y * imageWidth * bytesPerPixel, imageWidth * bytesPerPixel);
+            }
+        }
+
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        ret = updateWithData(uploadData, 0, 0, uploadWidth, uploadHeight);
+        if (uploadData != outTempData)
+        {
+            free(uploadData);
+        }
+
+        _contentSize = imageSize;
+        _maxS = imageWidth / (float)_pixelsWide;
+        _maxT = imageHeight / (float)_pixelsHigh;
+    }
+    else
+    {
+        ret = initWithData(outTempData, outTempDataLen, pixelFormat, imageWidth, imageHeight, imageSize);
+    }
 
     if (outTempData != nullptr && outTempData != outData.getBytes())
     {
@@ -1394,6 +1556,17 @@ unsigned int Texture2D::getBitsPerPixelForFormat() const
 	return this->getBitsPerPixelForFormat(_pixelFormat);
 }
 
+size_t Texture2D::getMemorySize() const
+{
+    size_t bytes = (size_t)_pixelsWide * _pixelsHigh * getBitsPerPixelForFormat() / 8;
+    // the mipmap chain adds a third of the base level
+    if (_hasMipmaps)
+    {
+        bytes += bytes / 3;
+    }
+    return bytes;
+}
+
 const Texture2D::PixelFormatInfoMap& Texture2D::getPixelFormatInfoMap()
 {
     return _pixelFormatInfoTables;
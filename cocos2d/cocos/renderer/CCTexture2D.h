@@ -209,6 +209,13 @@ public:
      */
     bool initWithData(const void *data, ssize_t dataLen, Texture2D::PixelFormat pixelFormat, int pixelsWide, int pixelsHigh, const Size& contentSize);
 
+    /** Initializes with a texture2d with data whose alpha is premultiplied or not, like the data of an image
+     * @since v3.2
+     * @js NA
+     * @lua NA
+     */
+    bool initWithData(const void *data, ssize_t dataLen, Texture2D::PixelFormat pixelFormat, int pixelsWide, int pixelsHigh, const Size& contentSize, bool premultipliedAlpha);
+
     /** Initializes with mipmaps */
     bool initWithMipmaps(MipmapInfo* mipmaps, int mipmapsNum, Texture2D::PixelFormat pixelFormat, int pixelsWide, int pixelsHigh);
 
@@ -242,7 +249,9 @@ public:
 
     /** Initializes a texture from a string with dimensions, alignment, font name and font size */
     bool initWithString(const char *text,  const std::string &fontName, float fontSize, const Size& dimensions = Size(0, 0), TextHAlignment hAlignment = TextHAlignment::CENTER, TextVAlignment vAlignment = TextVAlignment::TOP);
-    /** Initializes a texture from a string using a text definition*/
+    /** Initializes a texture from a string using a text definition.
+     An initialized texture keeps its GL texture when the new string fits in it.
+     */
     bool initWithString(const char *text, const FontDefinition& textDefinition);
 
     /** sets the min filter, mag filter, wrap s and wrap t texture parameters.
@@ -309,6 +318,18 @@ public:
     unsigned int getBitsPerPixelForFormat(Texture2D::PixelFormat format) const;
     CC_DEPRECATED_ATTRIBUTE unsigned int bitsPerPixelForFormat(Texture2D::PixelFormat format) const { return getBitsPerPixelForFormat(format); };
 
+    /** Returns the memory used by the texture on the GPU, in bytes, mipmaps included
+     @since v3.2
+     */
+    size_t getMemorySize() const;
+
+    /** Stamps the texture with the frame it was last drawn or loaded in.
+     The nodes drawing the texture call it, the TextureCache evicts the least recently used textures first.
+     @since v3.2
+     */
+    void setLastUsedFrame(unsigned int frame) { _lastUsedFrame = frame; }
+    unsigned int getLastUsedFrame() const { return _lastUsedFrame; }
+
     /** content size */
     const Size& getContentSizeInPixels();
 
@@ -344,11 +365,32 @@ public:
     
 public:
     static const PixelFormatInfoMap& getPixelFormatInfoMap();
+
+    /** Returns the pixel format data in originFormat is converted to when format is asked, like initWithImage() does.
+     It is originFormat when format is AUTO or the conversion isn't supported.
+     */
+    static PixelFormat getConvertedPixelFormat(PixelFormat originFormat, PixelFormat format);
+
+    /** Converts dataLen bytes of pixels in originFormat to getConvertedPixelFormat(originFormat, format) into outData.
+     outData is provided by the caller and must be large enough for the converted pixels, so images can be converted
+     row by row while they are decoded. Copies the data when there is nothing to convert.
+     @return the pixel format of outData
+     */
+    static PixelFormat convertDataToFormat(const unsigned char* data, ssize_t dataLen, PixelFormat originFormat, PixelFormat format, unsigned char* outData);
+
+    /** Returns whether initWithImage() marks the texture of an uncompressed image as premultiplied.
+     Images without their own flag are premultiplied when they are PVR and PVRImagesHavePremultipliedAlpha(true) was set.
+     */
+    static bool isImagePremultipliedAlpha(Image* image);
     
 private:
 
     /**convert functions*/
 
+    typedef void (*DataConverter)(const unsigned char* data, ssize_t dataLen, unsigned char* outData);
+    /** the conversion from originFormat to format, nullptr if it isn't supported */
+    static DataConverter getDataConverter(PixelFormat originFormat, PixelFormat format);
+
     /**
     Convert the format to the format param you specified, if the format is PixelFormat::Automatic, it will detect it automatically and convert to the closest format for you.
     It will return the converted format to you. if the outData != data, you must delete it manually.
@@ -427,6 +469,9 @@ protected:
     static const PixelFormatInfoMap _pixelFormatInfoTables;
 
     bool _antialiasEnabled;
+
+    /** frame the texture was last drawn or loaded in */
+    unsigned int _lastUsedFrame;
 };
 
 
@@ -31,6 +31,8 @@ THE SOFTWARE.
 #include <stack>
 #include <cctype>
 #include <list>
+#include <algorithm>
+#include <chrono>
 
 #include "renderer/CCTexture2D.h"
 #include "base/ccMacros.h"
@@ -38,6 +40,7 @@ THE SOFTWARE.
 #include "base/CCScheduler.h"
 #include "platform/CCFileUtils.h"
 #include "base/ccUtils.h"
+#include "base/CCProfiling.h"
 
 #include "deprecated/CCString.h"
 
@@ -59,12 +62,17 @@ TextureCache * TextureCache::getInstance()
 }
 
 TextureCache::TextureCache()
-: _loadingThread(nullptr)
-, _asyncStructQueue(nullptr)
-, _imageInfoQueue(nullptr)
+: _asyncDecodeThreadCount(0)
+, _asyncUploadBudget(1.0f / 240)
+, _asyncSequence(0)
 , _needQuit(false)
 , _asyncRefCount(0)
+, _memoryBudget(0)
+, _evictedTextureCount(0)
+, _evictedBytes(0)
 {
+    unsigned int cores = std::thread::hardware_concurrency();
+    _asyncDecodeThreadCount = MIN(MAX(cores, 2u) - 1, 4u);
 }
 
 TextureCache::~TextureCache()
@@ -74,7 +82,16 @@ TextureCache::~TextureCache()
     for( auto it=_textures.begin(); it!=_textures.end(); ++it)
         (it->second)->release();
 
-    CC_SAFE_DELETE(_loadingThread);
+    // the loading threads were joined by waitForQuit(), release what they left
+    for (auto& asyncStruct : _asyncStructQueue)
+    {
+        delete asyncStruct;
+    }
+    for (auto& asyncStruct : _imageInfoQueue)
+    {
+        CC_SAFE_RELEASE(asyncStruct->image);
+        delete asyncStruct;
+    }
 }
 
 void TextureCache::destroyInstance()
@@ -96,6 +113,11 @@ std::string TextureCache::getDescription() const
 }
 
 void TextureCache::addImageAsync(const std::string &path, const std::function<void(Texture2D*)>& callback)
+{
+    addImageAsync(path, callback, 0);
+}
+
+void TextureCache::addImageAsync(const std::string &path, const std::function<void(Texture2D*)>& callback, int priority)
 {
     Texture2D *texture = nullptr;
 
@@ -111,16 +133,34 @@ void TextureCache::addImageAsync(const std::string &path, const std::function<vo
         return;
     }
 
-    // lazy init
-    if (_asyncStructQueue == nullptr)
-    {             
-        _asyncStructQueue = new queue<AsyncStruct*>();
-        _imageInfoQueue   = new deque<ImageInfo*>();        
+    // already in flight: don't decode it twice
+    auto asyncIt = _asyncStructs.find(fullpath);
+    if (asyncIt != _asyncStructs.end())
+    {
+        AsyncStruct *data = asyncIt->second;
+        data->callbacks.push_back(callback);
 
-        // create a new thread to load images
-        _loadingThread = new std::thread(&TextureCache::loadImage, this);
+        if (priority > data->priority)
+        {
+            _asyncStructQueueMutex.lock();
+            data->priority = priority;
+            // no-op if it is already being decoded
+            std::make_heap(_asyncStructQueue.begin(), _asyncStructQueue.end(), AsyncStructCompare());
+            _asyncStructQueueMutex.unlock();
+        }
+        return;
+    }
 
+    // lazy init
+    if (_loadingThreads.empty())
+    {
         _needQuit = false;
+
+        // create the threads to decode images
+        for (unsigned int i = 0; i < _asyncDecodeThreadCount; ++i)
+        {
+            _loadingThreads.push_back(std::thread(&TextureCache::loadImage, this));
+        }
     }
 
     if (0 == _asyncRefCount)
@@ -131,161 +171,213 @@ void TextureCache::addImageAsync(const std::string &path, const std::function<vo
     ++_asyncRefCount;
 
     // generate async struct
-    AsyncStruct *data = new AsyncStruct(fullpath, callback);
+    AsyncStruct *data = new AsyncStruct(fullpath, priority, _asyncSequence++, Texture2D::getDefaultAlphaPixelFormat(), _diskCache);
+    data->callbacks.push_back(callback);
+    _asyncStructs[fullpath] = data;
 
     // add async struct into queue
     _asyncStructQueueMutex.lock();
-    _asyncStructQueue->push(data);
+    _asyncStructQueue.push_back(data);
+    std::push_heap(_asyncStructQueue.begin(), _asyncStructQueue.end(), AsyncStructCompare());
     _asyncStructQueueMutex.unlock();
 
     _sleepCondition.notify_one();
 }
 
+void TextureCache::unbindImageAsync(const std::string& path)
+{
+    std::string fullpath = FileUtils::getInstance()->fullPathForFilename(path);
+
+    auto it = _asyncStructs.find(fullpath);
+    if (it == _asyncStructs.end())
+        return;
+
+    // the request stays in flight until a loading thread hands it back, it will be dropped then
+    it->second->cancelled = true;
+    it->second->callbacks.clear();
+    _asyncStructs.erase(it);
+}
+
+void TextureCache::unbindAllImageAsync()
+{
+    for (auto& asyncStruct : _asyncStructs)
+    {
+        asyncStruct.second->cancelled = true;
+        asyncStruct.second->callbacks.clear();
+    }
+    _asyncStructs.clear();
+}
+
+void TextureCache::setAsyncDecodeThreadCount(unsigned int count)
+{
+    CCASSERT(_loadingThreads.empty(), "the loading threads are already running");
+    _asyncDecodeThreadCount = MAX(count, 1u);
+}
+
 void TextureCache::loadImage()
 {
     AsyncStruct *asyncStruct = nullptr;
 
+    TraceProfiler::getInstance()->setCurrentThreadName("TextureCache loader");
+
     while (true)
     {
-        std::queue<AsyncStruct*> *pQueue = _asyncStructQueue;
-        _asyncStructQueueMutex.lock();
-        if (pQueue->empty())
         {
-            _asyncStructQueueMutex.unlock();
-            if (_needQuit) {
+            std::unique_lock<std::mutex> lk(_asyncStructQueueMutex);
+            _sleepCondition.wait(lk, [this]() { return _needQuit || !_asyncStructQueue.empty(); });
+            if (_needQuit)
+            {
                 break;
             }
-            else {
-                std::unique_lock<std::mutex> lk(_sleepMutex);
-                _sleepCondition.wait(lk);
-                continue;
-            }
-        }
-        else
-        {
-            asyncStruct = pQueue->front();
-            pQueue->pop();
-            _asyncStructQueueMutex.unlock();
-        }        
 
-        Image *image = nullptr;
-        bool generateImage = false;
+            std::pop_heap(_asyncStructQueue.begin(), _asyncStructQueue.end(), AsyncStructCompare());
+            asyncStruct = _asyncStructQueue.back();
+            _asyncStructQueue.pop_back();
+        }
 
-        auto it = _textures.find(asyncStruct->filename);
-        if( it == _textures.end() )
+        if (! asyncStruct->cancelled && asyncStruct->diskCache)
         {
-           _imageInfoMutex.lock();
-           ImageInfo *imageInfo;
-           size_t pos = 0;
-           size_t infoSize = _imageInfoQueue->size();
-           for (; pos < infoSize; pos++)
-           {
-               imageInfo = (*_imageInfoQueue)[pos];
-               if(imageInfo->asyncStruct->filename.compare(asyncStruct->filename))
-                   break;
-           }
-           _imageInfoMutex.unlock();
-           if(infoSize == 0 || pos < infoSize)
-               generateImage = true;
+            CC_TRACE_SCOPE("TextureCache::loadCachedImage", "texture");
+            asyncStruct->diskCache->load(asyncStruct->filename, asyncStruct->pixelFormat, &asyncStruct->diskCacheEntry);
         }
 
-        if (generateImage)
+        if (! asyncStruct->cancelled && asyncStruct->diskCacheEntry.texels == nullptr)
         {
+            CC_TRACE_SCOPE("TextureCache::decodeImage", "texture");
             const std::string& filename = asyncStruct->filename;
-            // generate image      
-            image = new Image();
+            // generate image
+            Image *image = new Image();
+            if (image)
+            {
+                image->setDecodeFormat(asyncStruct->pixelFormat);
+            }
             if (image && !image->initWithImageFileThreadSafe(filename))
             {
-                CC_SAFE_RELEASE(image);
+                CC_SAFE_RELEASE_NULL(image);
                 CCLOG("can not load %s", filename.c_str());
-                continue;
             }
-        }    
-
-        // generate image info
-        ImageInfo *imageInfo = new ImageInfo();
-        imageInfo->asyncStruct = asyncStruct;
-        imageInfo->image = image;
+            if (image && asyncStruct->diskCache)
+            {
+                asyncStruct->diskCache->save(filename, asyncStruct->pixelFormat, image);
+            }
+            asyncStruct->image = image;
+        }
 
-        // put the image info into the queue
+        // hand it back to the cocos2d thread, even if it failed, to release the request
         _imageInfoMutex.lock();
-        _imageInfoQueue->push_back(imageInfo);
+        _imageInfoQueue.push_back(asyncStruct);
         _imageInfoMutex.unlock();
     }
-    
-	if(_asyncStructQueue != nullptr)
-    {
-        delete _asyncStructQueue;
-	    _asyncStructQueue = nullptr;
-        delete _imageInfoQueue;
-	    _imageInfoQueue = nullptr;
-    }
 }
 
 void TextureCache::addImageAsyncCallBack(float dt)
 {
-    // the image is generated in loading thread
-    std::deque<ImageInfo*> *imagesQueue = _imageInfoQueue;
+    // the images are decoded by the loading threads, upload as many as the budget allows
+    auto start = std::chrono::steady_clock::now();
 
-    _imageInfoMutex.lock();
-    if (imagesQueue->empty())
-    {
-        _imageInfoMutex.unlock();
-    }
-    else
+    while (true)
     {
-        ImageInfo *imageInfo = imagesQueue->front();
-        imagesQueue->pop_front();
+        AsyncStruct *asyncStruct = nullptr;
+
+        _imageInfoMutex.lock();
+        if (! _imageInfoQueue.empty())
+        {
+            asyncStruct = _imageInfoQueue.front();
+            _imageInfoQueue.pop_front();
+        }
         _imageInfoMutex.unlock();
 
-        AsyncStruct *asyncStruct = imageInfo->asyncStruct;
-        Image *image = imageInfo->image;
+        if (asyncStruct == nullptr)
+        {
+            break;
+        }
 
+        Image *image = asyncStruct->image;
         const std::string& filename = asyncStruct->filename;
 
-        Texture2D *texture = nullptr;
-        if (image)
+        if (! asyncStruct->cancelled)
         {
-            // generate texture in render thread
-            texture = new Texture2D();
+            _asyncStructs.erase(filename);
+        }
 
-            texture->initWithImage(image);
+        const TextureDiskCache::Entry& entry = asyncStruct->diskCacheEntry;
+        if ((image || entry.texels) && ! asyncStruct->cancelled)
+        {
+            Texture2D *texture = nullptr;
+
+            // it may have been loaded synchronously in the meantime
+            auto it = _textures.find(filename);
+            if (it != _textures.end())
+            {
+                texture = it->second;
+                texture->setLastUsedFrame(Director::getInstance()->getTotalFrames());
+            }
+            else
+            {
+                CC_TRACE_SCOPE("TextureCache::uploadTexture", "texture");
+                // generate texture in render thread
+                texture = new Texture2D();
+
+                if (image)
+                {
+                    texture->initWithImage(image, asyncStruct->pixelFormat);
+                }
+                else
+                {
+                    texture->initWithData(entry.texels, entry.texelsLen, entry.pixelFormat, entry.pixelsWide, entry.pixelsHigh,
+                                          Size((float)entry.pixelsWide, (float)entry.pixelsHigh), entry.premultipliedAlpha);
+                }
 
 #if CC_ENABLE_CACHE_TEXTURE_DATA
-            // cache the texture file name
-            VolatileTextureMgr::addImageTexture(texture, filename);
+                // cache the texture file name
+                VolatileTextureMgr::addImageTexture(texture, filename);
 #endif
-            // cache the texture. retain it, since it is added in the map
-            _textures.insert( std::make_pair(filename, texture) );
-            texture->retain();
+                // cache the texture. retain it, since it is added in the map
+                _textures.insert( std::make_pair(filename, texture) );
+                texture->setLastUsedFrame(Director::getInstance()->getTotalFrames());
+                texture->retain();
 
-            texture->autorelease();
-        }
-        else
-        {
-            auto it = _textures.find(asyncStruct->filename);
-            if(it != _textures.end())
-                texture = it->second;
+                texture->autorelease();
+            }
+
+            for (const auto& callback : asyncStruct->callbacks)
+            {
+                if (callback)
+                {
+                    callback(texture);
+                }
+            }
+
+            applyMemoryBudget();
         }
-        
-        if (asyncStruct->callback)
+        else if (! asyncStruct->cancelled)
         {
-            asyncStruct->callback(texture);
+            // the image couldn't be loaded, let the callers know
+            for (const auto& callback : asyncStruct->callbacks)
+            {
+                if (callback)
+                {
+                    callback(nullptr);
+                }
+            }
         }
-        
-        if(image)
-        {
-            image->release();
-        }       
+
+        CC_SAFE_RELEASE(image);
         delete asyncStruct;
-        delete imageInfo;
 
         --_asyncRefCount;
-        if (0 == _asyncRefCount)
+
+        std::chrono::duration<float> elapsed = std::chrono::steady_clock::now() - start;
+        if (elapsed.count() > _asyncUploadBudget)
         {
-            Director::getInstance()->getScheduler()->unschedule(schedule_selector(TextureCache::addImageAsyncCallBack), this);
+            break;
         }
     }
+
+    if (0 == _asyncRefCount)
+    {
+        Director::getInstance()->getScheduler()->unschedule(schedule_selector(TextureCache::addImageAsyncCallBack), this);
+    }
 }
 
 Texture2D * TextureCache::addImage(const std::string &path)
@@ -303,22 +395,47 @@ Texture2D * TextureCache::addImage(const std::string &path)
     }
     auto it = _textures.find(fullpath);
     if( it != _textures.end() )
+    {
         texture = it->second;
+        texture->setLastUsedFrame(Director::getInstance()->getTotalFrames());
+    }
 
     if (! texture)
     {
+        CC_TRACE_SCOPE("TextureCache::addImage", "texture");
         // all images are handled by UIImage except PVR extension that is handled by our own handler
         do 
         {
-            image = new Image();
-            CC_BREAK_IF(nullptr == image);
+            Texture2D::PixelFormat pixelFormat = Texture2D::getDefaultAlphaPixelFormat();
+            TextureDiskCache::Entry entry;
+            bool bRet = false;
 
-            bool bRet = image->initWithImageFile(fullpath);
-            CC_BREAK_IF(!bRet);
+            if (_diskCache && _diskCache->load(fullpath, pixelFormat, &entry))
+            {
+                // decoded and converted at a previous launch
+                texture = new Texture2D();
+                bRet = texture->initWithData(entry.texels, entry.texelsLen, entry.pixelFormat, entry.pixelsWide, entry.pixelsHigh,
+                                             Size((float)entry.pixelsWide, (float)entry.pixelsHigh), entry.premultipliedAlpha);
+            }
+            else
+            {
+                image = new Image();
+                CC_BREAK_IF(nullptr == image);
 
-            texture = new Texture2D();
+                // convert the rows while decoding, rather than the whole image once decoded
+                image->setDecodeFormat(pixelFormat);
+                bRet = image->initWithImageFile(fullpath);
+                CC_BREAK_IF(!bRet);
 
-            if( texture && texture->initWithImage(image) )
+                texture = new Texture2D();
+                bRet = texture->initWithImage(image);
+                if (bRet && _diskCache)
+                {
+                    _diskCache->save(fullpath, pixelFormat, image);
+                }
+            }
+
+            if( bRet )
             {
 #if CC_ENABLE_CACHE_TEXTURE_DATA
                 // cache the texture file name
@@ -326,6 +443,9 @@ Texture2D * TextureCache::addImage(const std::string &path)
 #endif
                 // texture already retained, no need to re-retain it
                 _textures.insert( std::make_pair(fullpath, texture) );
+                texture->setLastUsedFrame(Director::getInstance()->getTotalFrames());
+
+                applyMemoryBudget();
             }
             else
             {
@@ -350,6 +470,7 @@ Texture2D* TextureCache::addImage(Image *image, const std::string &key)
         auto it = _textures.find(key);
         if( it != _textures.end() ) {
             texture = it->second;
+            texture->setLastUsedFrame(Director::getInstance()->getTotalFrames());
             break;
         }
 
@@ -360,9 +481,12 @@ Texture2D* TextureCache::addImage(Image *image, const std::string &key)
         if(texture)
         {
             _textures.insert( std::make_pair(key, texture) );
+            texture->setLastUsedFrame(Director::getInstance()->getTotalFrames());
             texture->retain();
 
             texture->autorelease();
+
+            applyMemoryBudget();
         }
         else
         {
@@ -404,6 +528,8 @@ bool TextureCache::reloadTexture(const std::string& fileName)
             Image* image = new Image();
             CC_BREAK_IF(nullptr == image);
 
+            // convert the rows while decoding, rather than the whole image once decoded
+            image->setDecodeFormat(Texture2D::getDefaultAlphaPixelFormat());
             bool bRet = image->initWithImageFile(fullpath);
             CC_BREAK_IF(!bRet);
             
@@ -473,6 +599,90 @@ void TextureCache::removeTextureForKey(const std::string &textureKeyName)
     }
 }
 
+void TextureCache::setDiskCacheEnabled(bool enabled)
+{
+    if (! enabled)
+    {
+        // the pending asynchronous loads keep the cache they were requested with
+        _diskCache.reset();
+    }
+    else if (! _diskCache)
+    {
+        _diskCache = std::make_shared<TextureDiskCache>(FileUtils::getInstance()->getWritablePath() + "texturecache/");
+    }
+}
+
+void TextureCache::setMemoryBudget(size_t bytes)
+{
+    _memoryBudget = bytes;
+    applyMemoryBudget();
+}
+
+size_t TextureCache::getTotalMemorySize() const
+{
+    size_t totalBytes = 0;
+    for (const auto& entry : _textures)
+    {
+        totalBytes += entry.second->getMemorySize();
+    }
+    return totalBytes;
+}
+
+void TextureCache::applyMemoryBudget()
+{
+    if (_memoryBudget == 0)
+    {
+        return;
+    }
+
+    size_t totalBytes = getTotalMemorySize();
+    if (totalBytes <= _memoryBudget)
+    {
+        return;
+    }
+
+    // only the cache retains the unused textures, the ones used in this frame may be about to be retained
+    unsigned int frame = Director::getInstance()->getTotalFrames();
+    std::vector<std::unordered_map<std::string, Texture2D*>::iterator> unused;
+    for (auto it = _textures.begin(); it != _textures.end(); ++it)
+    {
+        Texture2D *tex = it->second;
+        if (tex->getReferenceCount() == 1 && tex->getLastUsedFrame() != frame)
+        {
+            unused.push_back(it);
+        }
+    }
+
+    std::sort(unused.begin(), unused.end(), [](const std::unordered_map<std::string, Texture2D*>::iterator& a,
+                                               const std::unordered_map<std::string, Texture2D*>::iterator& b) {
+        return a->second->getLastUsedFrame() < b->second->getLastUsedFrame();
+    });
+
+    for (const auto& it : unused)
+    {
+        if (totalBytes <= _memoryBudget)
+        {
+            break;
+        }
+
+        Texture2D *tex = it->second;
+        size_t bytes = tex->getMemorySize();
+        CCLOG("cocos2d: TextureCache: evicting texture: %s (%lu KB)", it->first.c_str(), (unsigned long)(bytes / 1024));
+
+        totalBytes -= bytes;
+        _evictedBytes += bytes;
+        ++_evictedTextureCount;
+
+        tex->release();
+        _textures.erase(it);
+    }
+
+    if (totalBytes > _memoryBudget)
+    {
+        CCLOG("cocos2d: TextureCache: the textures in use need %lu KB, over the budget of %lu KB", (unsigned long)(totalBytes / 1024), (unsigned long)(_memoryBudget / 1024));
+    }
+}
+
 Texture2D* TextureCache::getTextureForKey(const std::string &textureKeyName) const
 {
     std::string key = textureKeyName;
@@ -498,10 +708,17 @@ void TextureCache::reloadAllTextures()
 
 void TextureCache::waitForQuit()
 {
-    // notify sub thread to quick
+    // notify sub threads to quit
+    _asyncStructQueueMutex.lock();
     _needQuit = true;
-    _sleepCondition.notify_one();
-    if (_loadingThread) _loadingThread->join();
+    _asyncStructQueueMutex.unlock();
+    _sleepCondition.notify_all();
+
+    for (auto& thread : _loadingThreads)
+    {
+        thread.join();
+    }
+    _loadingThreads.clear();
 }
 
 std::string TextureCache::getCachedTextureInfo() const
@@ -510,7 +727,7 @@ std::string TextureCache::getCachedTextureInfo() const
     char buftmp[4096];
 
     unsigned int count = 0;
-    unsigned int totalBytes = 0;
+    size_t totalBytes = 0;
 
     for( auto it = _textures.begin(); it != _textures.end(); ++it ) {
 
@@ -519,8 +736,8 @@ std::string TextureCache::getCachedTextureInfo() const
 
         Texture2D* tex = it->second;
         unsigned int bpp = tex->getBitsPerPixelForFormat();
-        // Each texture takes up width * height * bytesPerPixel bytes.
-        auto bytes = tex->getPixelsWide() * tex->getPixelsHigh() * bpp / 8;
+        // Each texture takes up width * height * bytesPerPixel bytes, and a third more with mipmaps.
+        auto bytes = tex->getMemorySize();
         totalBytes += bytes;
         count++;
         snprintf(buftmp,sizeof(buftmp)-1,"\"%s\" rc=%lu id=%lu %lu x %lu @ %ld bpp => %lu KB\n",
@@ -538,6 +755,20 @@ std::string TextureCache::getCachedTextureInfo() const
     snprintf(buftmp, sizeof(buftmp)-1, "TextureCache dumpDebugInfo: %ld textures, for %lu KB (%.2f MB)\n", (long)count, (long)totalBytes / 1024, totalBytes / (1024.0f*1024.0f));
     buffer += buftmp;
 
+    if (_memoryBudget > 0)
+    {
+        snprintf(buftmp, sizeof(buftmp)-1, "TextureCache budget: %.2f MB (%.1f%% used), %u textures evicted, for %.2f MB\n",
+                 _memoryBudget / (1024.0f*1024.0f),
+                 totalBytes * 100.0f / _memoryBudget,
+                 _evictedTextureCount,
+                 _evictedBytes / (1024.0f*1024.0f));
+    }
+    else
+    {
+        snprintf(buftmp, sizeof(buftmp)-1, "TextureCache budget: none\n");
+    }
+    buffer += buftmp;
+
     return buffer;
 }
 
@@ -624,6 +855,24 @@ void VolatileTextureMgr::addDataTexture(Texture2D *tt, void* data, int dataLen,
     vt->_cashedImageType = VolatileTexture::kImageData;
     vt->_textureData = data;
     vt->_dataLen = dataLen;
+    vt->_data.clear();
+    vt->_pixelFormat = pixelFormat;
+    vt->_textureSize = contentSize;
+}
+
+void VolatileTextureMgr::addDataTexture(Texture2D *tt, Data data, Texture2D::PixelFormat pixelFormat, const Size& contentSize)
+{
+    if (_isReloading)
+    {
+        return;
+    }
+
+    VolatileTexture *vt = findVolotileTexture(tt);
+
+    vt->_cashedImageType = VolatileTexture::kImageData;
+    vt->_data = std::move(data);
+    vt->_textureData = vt->_data.getBytes();
+    vt->_dataLen = (int)vt->_data.getSize();
     vt->_pixelFormat = pixelFormat;
     vt->_textureSize = contentSize;
 }
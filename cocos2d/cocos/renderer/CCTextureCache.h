@@ -34,11 +34,15 @@ THE SOFTWARE.
 #include <condition_variable>
 #include <queue>
 #include <string>
+#include <vector>
+#include <atomic>
 #include <unordered_map>
 #include <functional>
+#include <memory>
 
 #include "base/CCRef.h"
 #include "renderer/CCTexture2D.h"
+#include "renderer/CCTextureDiskCache.h"
 #include "platform/CCImage.h"
 
 #if CC_ENABLE_CACHE_TEXTURE_DATA
@@ -114,11 +118,65 @@ public:
     * If the file image was not previously loaded, it will create a new Texture2D object and it will return it.
     * Otherwise it will load a texture in a new thread, and when the image is loaded, the callback will be called with the Texture2D as a parameter.
     * The callback will be called from the main thread, so it is safe to create any cocos2d object from the callback.
+    * If the image can't be loaded, the callback is called with nullptr.
     * Supported image extensions: .png, .jpg
     * @since v0.8
     */
     virtual void addImageAsync(const std::string &filepath, const std::function<void(Texture2D*)>& callback);
 
+    /* Same as addImageAsync(filepath, callback), the pending images with the highest priority are decoded first.
+    * Requesting an image which is already being loaded doesn't decode it twice: the callback is added to the pending request,
+    * whose priority is raised if needed.
+    * @since v3.2
+    */
+    void addImageAsync(const std::string &filepath, const std::function<void(Texture2D*)>& callback, int priority);
+
+    /* Cancels the pending asynchronous loading of an image, its callbacks won't be called.
+    * @since v3.2
+    */
+    void unbindImageAsync(const std::string &filepath);
+
+    /* Cancels all the pending asynchronous loadings.
+    * @since v3.2
+    */
+    void unbindAllImageAsync();
+
+    /** Sets the number of threads decoding the images loaded asynchronously.
+    * Must be called before the first call to addImageAsync. By default, one less than the number of cores, between 1 and 4.
+    * @since v3.2
+    */
+    void setAsyncDecodeThreadCount(unsigned int count);
+    unsigned int getAsyncDecodeThreadCount() const { return _asyncDecodeThreadCount; }
+
+    /** Sets how long, in seconds, the decoded images may be uploaded to the GPU every frame.
+    * At least one texture is uploaded per frame whatever the budget. 4ms by default.
+    * @since v3.2
+    */
+    void setAsyncUploadBudget(float seconds) { _asyncUploadBudget = seconds; }
+    float getAsyncUploadBudget() const { return _asyncUploadBudget; }
+
+    /** Sets the memory, in bytes, the cached textures may use. 0, the default, means no limit.
+    * When a texture is added past the budget, the unused textures (the ones removeUnusedTextures would remove) are removed,
+    * the least recently drawn first, until the cache fits in the budget again. The textures used in the current frame are kept.
+    * A removed texture is loaded again by the next addImage of its file.
+    * @since v3.2
+    */
+    void setMemoryBudget(size_t bytes);
+    size_t getMemoryBudget() const { return _memoryBudget; }
+
+    /** Enables the on-disk cache of the decoded images, in the "texturecache" directory of the writable path. See TextureDiskCache.
+    * addImage and addImageAsync then map the texels cached at a previous launch instead of decoding the images.
+    * Disabled by default.
+    * @since v3.2
+    */
+    void setDiskCacheEnabled(bool enabled);
+    bool isDiskCacheEnabled() const { return _diskCache != nullptr; }
+
+    /** Returns the memory, in bytes, used by the cached textures
+    * @since v3.2
+    */
+    size_t getTotalMemorySize() const;
+
     /** Returns a Texture2D object given an Image.
     * If the image was not previously loaded, it will create a new Texture2D object and it will return it.
     * Otherwise it will return a reference of a previously loaded image.
@@ -180,40 +238,67 @@ public:
 private:
     void addImageAsyncCallBack(float dt);
     void loadImage();
+    // removes the least recently used unused textures until the cache fits in the memory budget
+    void applyMemoryBudget();
 
 public:
     struct AsyncStruct
     {
     public:
-        AsyncStruct(const std::string& fn, std::function<void(Texture2D*)> f) : filename(fn), callback(f) {}
+        AsyncStruct(const std::string& fn, int p, unsigned int s, Texture2D::PixelFormat f, const std::shared_ptr<TextureDiskCache>& c) : filename(fn), priority(p), sequence(s), pixelFormat(f), diskCache(c), image(nullptr), cancelled(false) {}
 
         std::string filename;
-        std::function<void(Texture2D*)> callback;
+        std::vector<std::function<void(Texture2D*)>> callbacks;
+        int priority;
+        unsigned int sequence;
+        // the default alpha pixel format when the image was requested
+        Texture2D::PixelFormat pixelFormat;
+        // the disk cache when the image was requested, if enabled
+        std::shared_ptr<TextureDiskCache> diskCache;
+        // written by the decoding thread, the image or its disk cache entry
+        Image *image;
+        TextureDiskCache::Entry diskCacheEntry;
+        std::atomic<bool> cancelled;
     };
 
 protected:
-    typedef struct _ImageInfo
+    // orders the pending requests by priority, then first come first served
+    struct AsyncStructCompare
     {
-        AsyncStruct *asyncStruct;
-        Image        *image;
-    } ImageInfo;
-    
-    std::thread* _loadingThread;
+        bool operator()(const AsyncStruct* a, const AsyncStruct* b) const
+        {
+            return a->priority < b->priority || (a->priority == b->priority && a->sequence > b->sequence);
+        }
+    };
 
-    std::queue<AsyncStruct*>* _asyncStructQueue;
-    std::deque<ImageInfo*>* _imageInfoQueue;
+    std::vector<std::thread> _loadingThreads;
+    unsigned int _asyncDecodeThreadCount;
+    float _asyncUploadBudget;
 
+    // requests waiting to be decoded, a heap ordered by AsyncStructCompare
+    std::vector<AsyncStruct*> _asyncStructQueue;
     std::mutex _asyncStructQueueMutex;
+    std::condition_variable _sleepCondition;
+
+    // decoded requests waiting to be uploaded
+    std::deque<AsyncStruct*> _imageInfoQueue;
     std::mutex _imageInfoMutex;
 
-    std::mutex _sleepMutex;
-    std::condition_variable _sleepCondition;
+    // the requests in flight by file name, only used by the cocos2d thread
+    std::unordered_map<std::string, AsyncStruct*> _asyncStructs;
+    unsigned int _asyncSequence;
 
     bool _needQuit;
 
     int _asyncRefCount;
 
     std::unordered_map<std::string, Texture2D*> _textures;
+
+    std::shared_ptr<TextureDiskCache> _diskCache;
+
+    size_t _memoryBudget;
+    unsigned int _evictedTextureCount;
+    size_t _evictedBytes;
 };
 
 #if CC_ENABLE_CACHE_TEXTURE_DATA
@@ -246,6 +331,8 @@ protected:
 
     void *_textureData;
     int  _dataLen;
+    // owns _textureData when it was given as Data
+    Data _data;
     Size _textureSize;
     Texture2D::PixelFormat _pixelFormat;
 
@@ -263,6 +350,8 @@ public:
     static void addImageTexture(Texture2D *tt, const std::string& imageFileName);
     static void addStringTexture(Texture2D *tt, const char* text, const FontDefinition& fontDefinition);
     static void addDataTexture(Texture2D *tt, void* data, int dataLen, Texture2D::PixelFormat pixelFormat, const Size& contentSize);
+    /** the texture keeps the data, a data set with Data::fastSet(bytes, size, releaseCallback) is kept without copy when it is moved in */
+    static void addDataTexture(Texture2D *tt, Data data, Texture2D::PixelFormat pixelFormat, const Size& contentSize);
     static void addImage(Texture2D *tt, Image *image);
 
     static void setHasMipmaps(Texture2D *t, bool hasMipmaps);
@@ -0,0 +1,295 @@
+/****************************************************************************
+ Copyright (c) 2013-2014 Chukong Technologies Inc.
+
+ http://www.cocos2d-x.org
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#include "renderer/CCTextureDiskCache.h"
+
+#include <atomic>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_WIN32) || (CC_TARGET_PLATFORM == CC_PLATFORM_WINRT) || (CC_TARGET_PLATFORM == CC_PLATFORM_WP8)
+#include <direct.h>
+#endif
+
+#include "base/CCConfiguration.h"
+#include "platform/CCImage.h"
+#include "platform/CCFileUtils.h"
+#include "xxhash.h"
+
+NS_CC_BEGIN
+
+namespace
+{
+    const char ENTRY_MAGIC[4] = { 'C', 'C', 'T', 'X' };
+    // 2: premultipliedAlpha is the flag initWithImage() gives PVR images too
+    const uint32_t ENTRY_VERSION = 2;
+    // the texels start at a multiple of it in the file, for the mapped texels to be aligned
+    const size_t TEXELS_ALIGNMENT = 16;
+
+    // followed by the path of the image, padding, and the texels
+    struct EntryHeader
+    {
+        char magic[4];
+        uint32_t version;
+        uint32_t requestedFormat;
+        uint32_t pixelFormat;
+        int32_t pixelsWide;
+        int32_t pixelsHigh;
+        uint32_t premultipliedAlpha;
+        uint32_t pathLength;
+        int64_t sourceModificationTime;
+        int64_t sourceSize;
+        int64_t texelsLength;
+    };
+
+    // makes the names of the files being written unique, across threads
+    std::atomic<unsigned int> s_tempFileCount(0);
+
+    bool getRegularFileInfo(const std::string& path, int64_t* modificationTime, int64_t* size)
+    {
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0 || (st.st_mode & S_IFMT) != S_IFREG)
+        {
+            return false;
+        }
+        *modificationTime = st.st_mtime;
+        *size = st.st_size;
+        return true;
+    }
+
+    size_t getTexelsOffset(size_t pathLength)
+    {
+        size_t offset = sizeof(EntryHeader) + pathLength;
+        return (offset + TEXELS_ALIGNMENT - 1) / TEXELS_ALIGNMENT * TEXELS_ALIGNMENT;
+    }
+
+    Texture2D::PixelFormat resolveFormat(Texture2D::PixelFormat format)
+    {
+        return format == Texture2D::PixelFormat::NONE ? Texture2D::getDefaultAlphaPixelFormat() : format;
+    }
+}
+
+TextureDiskCache::TextureDiskCache(const std::string& directory)
+: _directory(directory)
+{
+    if (!_directory.empty() && _directory.back() != '/')
+    {
+        _directory += '/';
+    }
+
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_WIN32) || (CC_TARGET_PLATFORM == CC_PLATFORM_WINRT) || (CC_TARGET_PLATFORM == CC_PLATFORM_WP8)
+    int ret = _mkdir(_directory.c_str());
+#else
+    int ret = mkdir(_directory.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
+#endif
+    if (ret != 0 && errno != EEXIST)
+    {
+        CCLOG("cocos2d: TextureDiskCache: can't create the directory %s", _directory.c_str());
+    }
+}
+
+std::string TextureDiskCache::getEntryPath(const std::string& fullpath, Texture2D::PixelFormat format) const
+{
+    // a path colliding with another one replaces its entries, the path is checked when reading them
+    char name[32];
+    snprintf(name, sizeof(name), "%08x-%d.tex", XXH32(fullpath.c_str(), (int)fullpath.size(), 0), (int)format);
+    return _directory + name;
+}
+
+bool TextureDiskCache::load(const std::string& fullpath, Texture2D::PixelFormat format, Entry* entry) const
+{
+    CCASSERT(entry != nullptr, "TextureDiskCache: entry MUST not be nil");
+
+    format = resolveFormat(format);
+
+    int64_t sourceModificationTime = 0;
+    int64_t sourceSize = 0;
+    if (!FileUtils::getInstance()->isAbsolutePath(fullpath) || !getRegularFileInfo(fullpath, &sourceModificationTime, &sourceSize))
+    {
+        return false;
+    }
+
+    std::string entryPath = getEntryPath(fullpath, format);
+    int64_t entryModificationTime = 0;
+    int64_t entrySize = 0;
+    if (!getRegularFileInfo(entryPath, &entryModificationTime, &entrySize) || entrySize < (int64_t)sizeof(EntryHeader))
+    {
+        return false;
+    }
+
+    Data data = FileUtils::getInstance()->getMappedDataFromFile(entryPath);
+    if (data.getSize() < (ssize_t)sizeof(EntryHeader))
+    {
+        return false;
+    }
+
+    EntryHeader header;
+    memcpy(&header, data.getBytes(), sizeof(header));
+    if (memcmp(header.magic, ENTRY_MAGIC, sizeof(ENTRY_MAGIC)) != 0
+        || header.version != ENTRY_VERSION
+        || header.requestedFormat != (uint32_t)format
+        || header.pathLength != fullpath.size()
+        || (size_t)data.getSize() < sizeof(header) + header.pathLength
+        || memcmp(data.getBytes() + sizeof(header), fullpath.c_str(), header.pathLength) != 0)
+    {
+        // an entry of another version, or of a colliding path
+        return false;
+    }
+
+    if (header.sourceModificationTime != sourceModificationTime || header.sourceSize != sourceSize)
+    {
+        CCLOG("cocos2d: TextureDiskCache: %s changed, removing its entry", fullpath.c_str());
+        remove(entryPath.c_str());
+        return false;
+    }
+
+    auto info = Texture2D::getPixelFormatInfoMap().find((Texture2D::PixelFormat)header.pixelFormat);
+    size_t texelsOffset = getTexelsOffset(header.pathLength);
+    if (info == Texture2D::getPixelFormatInfoMap().end()
+        || header.pixelsWide <= 0 || header.pixelsHigh <= 0
+        || header.texelsLength != (int64_t)header.pixelsWide * header.pixelsHigh * info->second.bpp / 8
+        || (int64_t)data.getSize() != (int64_t)texelsOffset + header.texelsLength)
+    {
+        CCLOG("cocos2d: TextureDiskCache: invalid entry for %s, removing it", fullpath.c_str());
+        remove(entryPath.c_str());
+        return false;
+    }
+
+    entry->data = std::move(data);
+    entry->texels = entry->data.getBytes() + texelsOffset;
+    entry->texelsLen = (ssize_t)header.texelsLength;
+    entry->pixelFormat = (Texture2D::PixelFormat)header.pixelFormat;
+    entry->pixelsWide = header.pixelsWide;
+    entry->pixelsHigh = header.pixelsHigh;
+    entry->premultipliedAlpha = header.premultipliedAlpha != 0;
+    return true;
+}
+
+bool TextureDiskCache::save(const std::string& fullpath, Texture2D::PixelFormat format, Image* image) const
+{
+    CCASSERT(image != nullptr, "TextureDiskCache: image MUST not be nil");
+
+    format = resolveFormat(format);
+
+    // the compressed images are read as they are uploaded already
+    if (image->isCompressed() || image->getNumberOfMipmaps() > 1 || image->getData() == nullptr)
+    {
+        return false;
+    }
+
+    int maxTextureSize = Configuration::getInstance()->getMaxTextureSize();
+    if (image->getWidth() > maxTextureSize || image->getHeight() > maxTextureSize)
+    {
+        return false;
+    }
+
+    int64_t sourceModificationTime = 0;
+    int64_t sourceSize = 0;
+    if (!FileUtils::getInstance()->isAbsolutePath(fullpath) || !getRegularFileInfo(fullpath, &sourceModificationTime, &sourceSize))
+    {
+        return false;
+    }
+
+    // convert the texels as Texture2D::initWithImage() does
+    unsigned char* texels = image->getData();
+    ssize_t texelsLen = image->getDataLen();
+    Texture2D::PixelFormat pixelFormat = Texture2D::getConvertedPixelFormat(image->getRenderFormat(), format);
+    if (pixelFormat != image->getRenderFormat())
+    {
+        auto info = Texture2D::getPixelFormatInfoMap().find(pixelFormat);
+        CCASSERT(info != Texture2D::getPixelFormatInfoMap().end(), "TextureDiskCache: unknown pixel format");
+        texelsLen = (ssize_t)image->getWidth() * image->getHeight() * info->second.bpp / 8;
+        texels = (unsigned char*)malloc(texelsLen);
+        if (texels == nullptr)
+        {
+            return false;
+        }
+        Texture2D::convertDataToFormat(image->getData(), image->getDataLen(), image->getRenderFormat(), format, texels);
+    }
+
+    EntryHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, ENTRY_MAGIC, sizeof(ENTRY_MAGIC));
+    header.version = ENTRY_VERSION;
+    header.requestedFormat = (uint32_t)format;
+    header.pixelFormat = (uint32_t)pixelFormat;
+    header.pixelsWide = image->getWidth();
+    header.pixelsHigh = image->getHeight();
+    header.premultipliedAlpha = Texture2D::isImagePremultipliedAlpha(image);
+    header.pathLength = (uint32_t)fullpath.size();
+    header.sourceModificationTime = sourceModificationTime;
+    header.sourceSize = sourceSize;
+    header.texelsLength = texelsLen;
+
+    // written aside then renamed, the readers only see complete entries
+    std::string entryPath = getEntryPath(fullpath, format);
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), ".%u.tmp", s_tempFileCount++);
+    std::string tempPath = entryPath + suffix;
+
+    bool ret = false;
+    FILE* fp = fopen(tempPath.c_str(), "wb");
+    if (fp)
+    {
+        static const char padding[TEXELS_ALIGNMENT] = { 0 };
+        size_t paddingLen = getTexelsOffset(fullpath.size()) - sizeof(header) - fullpath.size();
+
+        ret = fwrite(&header, sizeof(header), 1, fp) == 1
+            && fwrite(fullpath.c_str(), fullpath.size(), 1, fp) == 1
+            && (paddingLen == 0 || fwrite(padding, paddingLen, 1, fp) == 1)
+            && fwrite(texels, texelsLen, 1, fp) == 1;
+        ret = (fclose(fp) == 0) && ret;
+
+        if (ret)
+        {
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_WIN32) || (CC_TARGET_PLATFORM == CC_PLATFORM_WINRT) || (CC_TARGET_PLATFORM == CC_PLATFORM_WP8)
+            // rename doesn't replace an existing file there
+            remove(entryPath.c_str());
+#endif
+            ret = rename(tempPath.c_str(), entryPath.c_str()) == 0;
+        }
+        if (!ret)
+        {
+            remove(tempPath.c_str());
+        }
+    }
+
+    if (!ret)
+    {
+        CCLOG("cocos2d: TextureDiskCache: can't write the entry of %s", fullpath.c_str());
+    }
+
+    if (texels != image->getData())
+    {
+        free(texels);
+    }
+
+    return ret;
+}
+
+NS_CC_END
@@ -0,0 +1,96 @@
+/****************************************************************************
+ Copyright (c) 2013-2014 Chukong Technologies Inc.
+
+ http://www.cocos2d-x.org
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#ifndef __CCTEXTURE_DISK_CACHE_H__
+#define __CCTEXTURE_DISK_CACHE_H__
+
+#include <string>
+
+#include "base/CCData.h"
+#include "renderer/CCTexture2D.h"
+
+NS_CC_BEGIN
+
+class Image;
+
+/**
+ * @addtogroup textures
+ * @{
+ */
+
+/** @brief On-disk cache of the decoded images, in the pixel format of their texture.
+
+ The next launch maps the texels from the cache file instead of decoding the image and converting it.
+ An entry is keyed by the path of the image, its modification time and size, and the requested pixel format,
+ the entries whose image changed since are removed when read.
+ Only the images of the file system are cached, not the ones read from the apk or from an asset pack.
+ The methods may be called from any thread.
+ @since v3.2
+ */
+class CC_DLL TextureDiskCache
+{
+public:
+    /** The texels of a cached image */
+    struct Entry
+    {
+        Entry() : texels(nullptr), texelsLen(0), pixelFormat(Texture2D::PixelFormat::NONE), pixelsWide(0), pixelsHigh(0), premultipliedAlpha(false) {}
+
+        // the mapped cache file, texels point into it
+        Data data;
+        const unsigned char* texels;
+        ssize_t texelsLen;
+        Texture2D::PixelFormat pixelFormat;
+        int pixelsWide;
+        int pixelsHigh;
+        bool premultipliedAlpha;
+    };
+
+    /** Creates a cache storing its entries in directory, created if needed */
+    explicit TextureDiskCache(const std::string& directory);
+
+    const std::string& getDirectory() const { return _directory; }
+
+    /** Reads the entry of the image at fullpath, requested in pixel format format.
+     Returns false if it isn't cached, or if the image changed since it was.
+     */
+    bool load(const std::string& fullpath, Texture2D::PixelFormat format, Entry* entry) const;
+
+    /** Caches an image decoded from the file at fullpath, converted to format as Texture2D::initWithImage(image, format) would.
+     The compressed images and the ones with mipmaps, already in a GPU format, are not cached.
+     Returns false if the image wasn't cached.
+     */
+    bool save(const std::string& fullpath, Texture2D::PixelFormat format, Image* image) const;
+
+protected:
+    std::string getEntryPath(const std::string& fullpath, Texture2D::PixelFormat format) const;
+
+    std::string _directory;
+};
+
+// end of textures group
+/// @}
+
+NS_CC_END
+
+#endif //__CCTEXTURE_DISK_CACHE_H__
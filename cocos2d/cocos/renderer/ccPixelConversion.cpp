@@ -0,0 +1,598 @@
+/****************************************************************************
+ Copyright (c) 2013-2014 Chukong Technologies Inc.
+
+ http://www.cocos2d-x.org
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#include "renderer/ccPixelConversion.h"
+#include "platform/CCImage.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CC_PIXEL_CONVERSION_SSE2 1
+#include <emmintrin.h>
+#else
+#define CC_PIXEL_CONVERSION_SSE2 0
+#endif
+
+// the AVX2 kernels are compiled for AVX2 whatever the flags of the file, they are only called if the CPU supports it
+#if CC_PIXEL_CONVERSION_SSE2 && (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define CC_PIXEL_CONVERSION_AVX2 1
+#define CC_TARGET_AVX2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#else
+#define CC_PIXEL_CONVERSION_AVX2 0
+#endif
+
+NS_CC_BEGIN
+
+namespace PixelConversion {
+
+static SIMDLevel detectSIMDLevel()
+{
+#if CC_PIXEL_CONVERSION_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return SIMDLevel::AVX2;
+    }
+#endif
+#if CC_PIXEL_CONVERSION_SSE2
+    return SIMDLevel::SSE2;
+#else
+    return SIMDLevel::NONE;
+#endif
+}
+
+static SIMDLevel s_supportedLevel = detectSIMDLevel();
+static SIMDLevel s_level = s_supportedLevel;
+
+SIMDLevel getSupportedSIMDLevel()
+{
+    return s_supportedLevel;
+}
+
+SIMDLevel getSIMDLevel()
+{
+    return s_level;
+}
+
+void setSIMDLevel(SIMDLevel level)
+{
+    s_level = (int)level < (int)s_supportedLevel ? level : s_supportedLevel;
+}
+
+#if CC_PIXEL_CONVERSION_SSE2
+
+//////////////////////////////////////////////////////////////////////////
+// SSE2
+
+// packs two vectors of 32 bits lanes holding 16 bits values, without saturation
+static inline __m128i pack32To16(__m128i a, __m128i b)
+{
+    a = _mm_srai_epi32(_mm_slli_epi32(a, 16), 16);
+    b = _mm_srai_epi32(_mm_slli_epi32(b, 16), 16);
+    return _mm_packs_epi32(a, b);
+}
+
+// RGBA8888 pixels (R in the low byte) -> RRRRRGGGGGGBBBBB in 32 bits lanes
+static inline __m128i rgba8888ToRGB565(__m128i p)
+{
+    __m128i r = _mm_slli_epi32(_mm_and_si128(p, _mm_set1_epi32(0xF8)), 8);
+    __m128i g = _mm_srli_epi32(_mm_and_si128(p, _mm_set1_epi32(0xFC00)), 5);
+    __m128i b = _mm_srli_epi32(_mm_and_si128(p, _mm_set1_epi32(0xF80000)), 19);
+    return _mm_or_si128(_mm_or_si128(r, g), b);
+}
+
+static inline __m128i rgba8888ToRGBA4444(__m128i p)
+{
+    __m128i r = _mm_slli_epi32(_mm_and_si128(p, _mm_set1_epi32(0xF0)), 8);
+    __m128i g = _mm_srli_epi32(_mm_and_si128(p, _mm_set1_epi32(0xF000)), 4);
+    __m128i b = _mm_srli_epi32(_mm_and_si128(p, _mm_set1_epi32(0xF00000)), 16);
+    __m128i a = _mm_srli_epi32(p, 28);
+    return _mm_or_si128(_mm_or_si128(r, g), _mm_or_si128(b, a));
+}
+
+static inline __m128i rgba8888ToRGB5A1(__m128i p)
+{
+    __m128i r = _mm_slli_epi32(_mm_and_si128(p, _mm_set1_epi32(0xF8)), 8);
+    __m128i g = _mm_srli_epi32(_mm_and_si128(p, _mm_set1_epi32(0xF800)), 5);
+    __m128i b = _mm_srli_epi32(_mm_and_si128(p, _mm_set1_epi32(0xF80000)), 18);
+    __m128i a = _mm_srli_epi32(p, 31);
+    return _mm_or_si128(_mm_or_si128(r, g), _mm_or_si128(b, a));
+}
+
+// (R*299 + G*587 + B*114 + 500) / 1000 in 32 bits lanes
+static inline __m128i rgba8888ToI(__m128i p)
+{
+    // R and G, then B and 1, in the 16 bits halves of every lane
+    __m128i rg = _mm_or_si128(_mm_and_si128(p, _mm_set1_epi32(0xFF)), _mm_slli_epi32(_mm_and_si128(p, _mm_set1_epi32(0xFF00)), 8));
+    __m128i b1 = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(p, 16), _mm_set1_epi32(0xFF)), _mm_set1_epi32(0x10000));
+    __m128i sum = _mm_add_epi32(_mm_madd_epi16(rg, _mm_set1_epi32(299 | (587 << 16))),
+                                _mm_madd_epi16(b1, _mm_set1_epi32(114 | (500 << 16))));
+
+    // x / 1000 == (x * 268436) >> 28 for every x below 493999, the sum is at most 255500
+    const __m128i magic = _mm_set1_epi32(268436);
+    __m128i even = _mm_srli_epi64(_mm_mul_epu32(sum, magic), 28);
+    __m128i odd = _mm_slli_epi64(_mm_srli_epi64(_mm_mul_epu32(_mm_srli_epi64(sum, 32), magic), 28), 32);
+    return _mm_or_si128(_mm_and_si128(even, _mm_set_epi32(0, -1, 0, -1)), odd);
+}
+
+template <__m128i (*convert)(__m128i)>
+static ssize_t convertRGBA8888To16SSE2(const unsigned char* data, ssize_t pixels, unsigned char* outData)
+{
+    ssize_t i = 0;
+    for (; i + 8 <= pixels; i += 8)
+    {
+        __m128i p0 = _mm_loadu_si128((const __m128i*)(data + i * 4));
+        __m128i p1 = _mm_loadu_si128((const __m128i*)(data + i * 4 + 16));
+        _mm_storeu_si128((__m128i*)(outData + i * 2), pack32To16(convert(p0), convert(p1)));
+    }
+    return i;
+}
+
+// 16 bits lanes I -> 16 bits formats
+static inline __m128i iToRGB565(__m128i i)
+{
+    __m128i i5 = _mm_and_si128(i, _mm_set1_epi16(0xF8));
+    __m128i i6 = _mm_and_si128(i, _mm_set1_epi16(0xFC));
+    return _mm_or_si128(_mm_or_si128(_mm_slli_epi16(i5, 8), _mm_slli_epi16(i6, 3)), _mm_srli_epi16(i5, 3));
+}
+
+static inline __m128i iaToRGBA4444(__m128i i, __m128i a)
+{
+    __m128i i4 = _mm_and_si128(i, _mm_set1_epi16(0xF0));
+    return _mm_or_si128(_mm_or_si128(_mm_slli_epi16(i4, 8), _mm_slli_epi16(i4, 4)),
+                        _mm_or_si128(i4, _mm_srli_epi16(_mm_and_si128(a, _mm_set1_epi16(0xF0)), 4)));
+}
+
+static inline __m128i iaToRGB5A1(__m128i i, __m128i a)
+{
+    __m128i i5 = _mm_and_si128(i, _mm_set1_epi16(0xF8));
+    return _mm_or_si128(_mm_or_si128(_mm_slli_epi16(i5, 8), _mm_slli_epi16(i5, 3)),
+                        _mm_or_si128(_mm_srli_epi16(i5, 2), _mm_srli_epi16(_mm_and_si128(a, _mm_set1_epi16(0x80)), 7)));
+}
+
+static ssize_t convertRGBA8888ToA8SSE2(const unsigned char* data, ssize_t pixels, unsigned char* outData)
+{
+    ssize_t i = 0;
+    for (; i + 8 <= pixels; i += 8)
+    {
+        __m128i p0 = _mm_srli_epi32(_mm_loadu_si128((const __m128i*)(data + i * 4)), 24);
+        __m128i p1 = _mm_srli_epi32(_mm_loadu_si128((const __m128i*)(data + i * 4 + 16)), 24);
+        __m128i a = _mm_packs_epi32(p0, p1);
+        _mm_storel_epi64((__m128i*)(outData + i), _mm_packus_epi16(a, a));
+    }
+    return i;
+}
+
+static ssize_t convertRGBA8888ToI8SSE2(const unsigned char* data, ssize_t pixels, unsigned char* outData)
+{
+    ssize_t i = 0;
+    for (; i + 8 <= pixels; i += 8)
+    {
+        __m128i p0 = rgba8888ToI(_mm_loadu_si128((const __m128i*)(data + i * 4)));
+        __m128i p1 = rgba8888ToI(_mm_loadu_si128((const __m128i*)(data + i * 4 + 16)));
+        __m128i l = _mm_packs_epi32(p0, p1);
+        _mm_storel_epi64((__m128i*)(outData + i), _mm_packus_epi16(l, l));
+    }
+    return i;
+}
+
+static ssize_t convertRGBA8888ToAI88SSE2(const unsigned char* data, ssize_t pixels, unsigned char* outData)
+{
+    ssize_t i = 0;
+    const __m128i alphaMask = _mm_set1_epi32(0xFF00);
+    for (; i + 8 <= pixels; i += 8)
+    {
+        __m128i p0 = _mm_loadu_si128((const __m128i*)(data + i * 4));
+        __m128i p1 = _mm_loadu_si128((const __m128i*)(data + i * 4 + 16));
+        p0 = _mm_or_si128(rgba8888ToI(p0), _mm_and_si128(_mm_srli_epi32(p0, 16), alphaMask));
+        p1 = _mm_or_si128(rgba8888ToI(p1), _mm_and_si128(_mm_srli_epi32(p1, 16), alphaMask));
+        _mm_storeu_si128((__m128i*)(outData + i * 2), pack32To16(p0, p1));
+    }
+    return i;
+}
+
+static ssize_t convertI8ToRGBA8888SSE2(const unsigned char* data, ssize_t pixels, unsigned char* outData)
+{
+    ssize_t i = 0;
+    const __m128i ff = _mm_set1_epi8((char)0xFF);
+    for (; i + 16 <= pixels; i += 16)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i*)(data + i));
+        __m128i iiLo = _mm_unpacklo_epi8(x, x);
+        __m128i iaLo = _mm_unpacklo_epi8(x, ff);
+        __m128i iiHi = _mm_unpackhi_epi8(x, x);
+        __m128i iaHi = _mm_unpackhi_epi8(x, ff);
+        unsigned char* out = outData + i * 4;
+        _mm_storeu_si128((__m128i*)(out), _mm_unpacklo_epi16(iiLo, iaLo));
+        _mm_storeu_si128((__m128i*)(out + 16), _mm_unpackhi_epi16(iiLo, iaLo));
+        _mm_storeu_si128((__m128i*)(out + 32), _mm_unpacklo_epi16(iiHi, iaHi));
+        _mm_storeu_si128((__m128i*)(out + 48), _mm_unpackhi_epi16(iiHi, iaHi));
+    }
+    return i;
+}
+
+static ssize_t convertI8ToAI88SSE2(const unsigned char* data, ssize_t pixels, unsigned char* outData)
+{
+    ssize_t i = 0;
+    const __m128i ff = _mm_set1_epi8((char)0xFF);
+    for (; i + 16 <= pixels; i += 16)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i*)(data + i));
+        _mm_storeu_si128((__m128i*)(outData + i * 2), _mm_unpacklo_epi8(x, ff));
+        _mm_storeu_si128((__m128i*)(outData + i * 2 + 16), _mm_unpackhi_epi8(x, ff));
+    }
+    return i;
+}
+
+// I8 -> 16 bits formats, the alpha is opaque
+template <int FORMAT>
+static ssize_t convertI8To16SSE2(const unsigned char* data, ssize_t pixels, unsigned char* outData)
+{
+    ssize_t i = 0;
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i opaque = _mm_set1_epi16(0xFF);
+    for (; i + 16 <= pixels; i += 16)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i*)(data + i));
+        __m128i lo = _mm_unpacklo_epi8(x, zero);
+        __m128i hi = _mm_unpackhi_epi8(x, zero);
+        if (FORMAT == 0)
+        {
+            lo = iToRGB565(lo);
+            hi = iToRGB565(hi);
+        }
+        else if (FORMAT == 1)
+        {
+            lo = iaToRGBA4444(lo, opaque);
+            hi = iaToRGBA4444(hi, opaque);
+        }
+        else
+        {
+            lo = iaToRGB5A1(lo, opaque);
+            hi = iaToRGB5A1(hi, opaque);
+        }
+        _mm_storeu_si128((__m128i*)(outData + i * 2), lo);
+        _mm_storeu_si128((__m128i*)(outData + i * 2 + 16), hi);
+    }
+    return i;
+}
+
+static ssize_t convertAI88ToRGBA8888SSE2(const unsigned char* data, ssize_t pixels, unsigned char* outData)
+{
+    ssize_t i = 0;
+    const __m128i intensityMask = _mm_set1_epi16(0xFF);
+    for (; i + 8 <= pixels; i += 8)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(data + i * 2));
+        __m128i intensity = _mm_and_si128(v, intensityMask);
+        __m128i ii = _mm_or_si128(intensity, _mm_slli_epi16(intensity, 8));
+        _mm_storeu_si128((__m128i*)(outData + i * 4), _mm_unpacklo_epi16(ii, v));
+        _mm_storeu_si128((__m128i*)(outData + i * 4 + 16), _mm_unpackhi_epi16(ii, v));
+    }
+    return i;
+}
+
+// AI88 -> 16 bits formats
+template <int FORMAT>
+static ssize_t convertAI88To16SSE2(const unsigned char* data, ssize_t pixels, unsigned char* outData)
+{
+    ssize_t i = 0;
+    const __m128i intensityMask = _mm_set1_epi16(0xFF);
+    for (; i + 8 <= pixels; i += 8)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(data + i * 2));
+        __m128i intensity = _mm_and_si128(v, intensityMask);
+        __m128i alpha = _mm_srli_epi16(v, 8);
+        __m128i out;
+        if (FORMAT == 0)
+            out = iToRGB565(intensity);
+        else if (FORMAT == 1)
+            out = iaToRGBA4444(intensity, alpha);
+        else
+            out = iaToRGB5A1(intensity, alpha);
+        _mm_storeu_si128((__m128i*)(outData + i * 2), out);
+    }
+    return i;
+}
+
+// AI88 -> one of its channels
+template <bool ALPHA>
+static ssize_t convertAI88To8SSE2(const unsigned char* data, ssize_t pixels, unsigned char* outData)
+{
+    ssize_t i = 0;
+    const __m128i intensityMask = _mm_set1_epi16(0xFF);
+    for (; i + 16 <= pixels; i += 16)
+    {
+        __m128i v0 = _mm_loadu_si128((const __m128i*)(data + i * 2));
+        __m128i v1 = _mm_loadu_si128((const __m128i*)(data + i * 2 + 16));
+        if (ALPHA)
+        {
+            v0 = _mm_srli_epi16(v0, 8);
+            v1 = _mm_srli_epi16(v1, 8);
+        }
+        else
+        {
+            v0 = _mm_and_si128(v0, intensityMask);
+            v1 = _mm_and_si128(v1, intensityMask);
+        }
+        _mm_storeu_si128((__m128i*)(outData + i), _mm_packus_epi16(v0, v1));
+    }
+    return i;
+}
+
+// two RGBA8888 pixels in 16 bits lanes -> premultiplied
+static inline __m128i premultiply16(__m128i p)
+{
+    const __m128i alphaLanes = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+    __m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(p, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+    // c * (a + 1) fits in 16 bits
+    __m128i product = _mm_srli_epi16(_mm_mullo_epi16(p, _mm_add_epi16(alpha, _mm_set1_epi16(1))), 8);
+    return _mm_or_si128(_mm_andnot_si128(alphaLanes, product), _mm_and_si128(alphaLanes, p));
+}
+
+static ssize_t premultiplyAlphaSSE2(unsigned char* data, ssize_t pixels)
+{
+    ssize_t i = 0;
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 4 <= pixels; i += 4)
+    {
+        __m128i p = _mm_loadu_si128((const __m128i*)(data + i * 4));
+        __m128i lo = premultiply16(_mm_unpacklo_epi8(p, zero));
+        __m128i hi = premultiply16(_mm_unpackhi_epi8(p, zero));
+        _mm_storeu_si128((__m128i*)(data + i * 4), _mm_packus_epi16(lo, hi));
+    }
+    return i;
+}
+
+#endif // CC_PIXEL_CONVERSION_SSE2
+
+#if CC_PIXEL_CONVERSION_AVX2
+
+//////////////////////////////////////////////////////////////////////////
+// AVX2, only for the conversions of RGBA8888 atlases to 16 bits formats and the premultiplication
+
+CC_TARGET_AVX2 static inline __m256i rgba8888ToRGB565AVX2(__m256i p)
+{
+    __m256i r = _mm256_slli_epi32(_mm256_and_si256(p, _mm256_set1_epi32(0xF8)), 8);
+    __m256i g = _mm256_srli_epi32(_mm256_and_si256(p, _mm256_set1_epi32(0xFC00)), 5);
+    __m256i b = _mm256_srli_epi32(_mm256_and_si256(p, _mm256_set1_epi32(0xF80000)), 19);
+    return _mm256_or_si256(_mm256_or_si256(r, g), b);
+}
+
+CC_TARGET_AVX2 static inline __m256i rgba8888ToRGBA4444AVX2(__m256i p)
+{
+    __m256i r = _mm256_slli_epi32(_mm256_and_si256(p, _mm256_set1_epi32(0xF0)), 8);
+    __m256i g = _mm256_srli_epi32(_mm256_and_si256(p, _mm256_set1_epi32(0xF000)), 4);
+    __m256i b = _mm256_srli_epi32(_mm256_and_si256(p, _mm256_set1_epi32(0xF00000)), 16);
+    __m256i a = _mm256_srli_epi32(p, 28);
+    return _mm256_or_si256(_mm256_or_si256(r, g), _mm256_or_si256(b, a));
+}
+
+CC_TARGET_AVX2 static inline __m256i rgba8888ToRGB5A1AVX2(__m256i p)
+{
+    __m256i r = _mm256_slli_epi32(_mm256_and_si256(p, _mm256_set1_epi32(0xF8)), 8);
+    __m256i g = _mm256_srli_epi32(_mm256_and_si256(p, _mm256_set1_epi32(0xF800)), 5);
+    __m256i b = _mm256_srli_epi32(_mm256_and_si256(p, _mm256_set1_epi32(0xF80000)), 18);
+    __m256i a = _mm256_srli_epi32(p, 31);
+    return _mm256_or_si256(_mm256_or_si256(r, g), _mm256_or_si256(b, a));
+}
+
+template <int FORMAT>
+CC_TARGET_AVX2 static ssize_t convertRGBA8888To16AVX2(const unsigned char* data, ssize_t pixels, unsigned char* outData)
+{
+    ssize_t i = 0;
+    for (; i + 16 <= pixels; i += 16)
+    {
+        __m256i p0 = _mm256_loadu_si256((const __m256i*)(data + i * 4));
+        __m256i p1 = _mm256_loadu_si256((const __m256i*)(data + i * 4 + 32));
+        if (FORMAT == 0)
+        {
+            p0 = rgba8888ToRGB565AVX2(p0);
+            p1 = rgba8888ToRGB565AVX2(p1);
+        }
+        else if (FORMAT == 1)
+        {
+            p0 = rgba8888ToRGBA4444AVX2(p0);
+            p1 = rgba8888ToRGBA4444AVX2(p1);
+        }
+        else
+        {
+            p0 = rgba8888ToRGB5A1AVX2(p0);
+            p1 = rgba8888ToRGB5A1AVX2(p1);
+        }
+        p0 = _mm256_srai_epi32(_mm256_slli_epi32(p0, 16), 16);
+        p1 = _mm256_srai_epi32(_mm256_slli_epi32(p1, 16), 16);
+        // the pack works on 128 bits lanes, put the quarters back in order
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(p0, p1), _MM_SHUFFLE(3, 1, 2, 0));
+        _mm256_storeu_si256((__m256i*)(outData + i * 2), packed);
+    }
+    return i;
+}
+
+CC_TARGET_AVX2 static inline __m256i premultiply16AVX2(__m256i p)
+{
+    const __m256i alphaLanes = _mm256_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0);
+    __m256i alpha = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(p, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+    __m256i product = _mm256_srli_epi16(_mm256_mullo_epi16(p, _mm256_add_epi16(alpha, _mm256_set1_epi16(1))), 8);
+    return _mm256_or_si256(_mm256_andnot_si256(alphaLanes, product), _mm256_and_si256(alphaLanes, p));
+}
+
+CC_TARGET_AVX2 static ssize_t premultiplyAlphaAVX2(unsigned char* data, ssize_t pixels)
+{
+    ssize_t i = 0;
+    const __m256i zero = _mm256_setzero_si256();
+    for (; i + 8 <= pixels; i += 8)
+    {
+        // unpack and pack both work on 128 bits lanes, the order is kept
+        __m256i p = _mm256_loadu_si256((const __m256i*)(data + i * 4));
+        __m256i lo = premultiply16AVX2(_mm256_unpacklo_epi8(p, zero));
+        __m256i hi = premultiply16AVX2(_mm256_unpackhi_epi8(p, zero));
+        _mm256_storeu_si256((__m256i*)(data + i * 4), _mm256_packus_epi16(lo, hi));
+    }
+    return i;
+}
+
+#endif // CC_PIXEL_CONVERSION_AVX2
+
+//////////////////////////////////////////////////////////////////////////
+// dispatch
+
+#if CC_PIXEL_CONVERSION_AVX2
+#define CC_DISPATCH_AVX2(call) if (s_level == SIMDLevel::AVX2) { return call; }
+#else
+#define CC_DISPATCH_AVX2(call)
+#endif
+
+#if CC_PIXEL_CONVERSION_SSE2
+#define CC_DISPATCH_SSE2(call) if (s_level >= SIMDLevel::SSE2) { return call; }
+#else
+#define CC_DISPATCH_SSE2(call)
+#endif
+
+ssize_t convertRGBA8888ToRGB565(const unsigned char* data, ssize_t pixels, unsigned char* outData)
+{
+    CC_DISPATCH_AVX2(convertRGBA8888To16AVX2<0>(data, pixels, outData))
+    CC_DISPATCH_SSE2(convertRGBA8888To16SSE2<rgba8888ToRGB565>(data, pixels, outData))
+    return 0;
+}
+
+ssize_t convertRGBA8888ToRGBA4444(const unsigned char* data, ssize_t pixels, unsigned char* outData)
+{
+    CC_DISPATCH_AVX2(convertRGBA8888To16AVX2<1>(data, pixels, outData))
+    CC_DISPATCH_SSE2(convertRGBA8888To16SSE2<rgba8888ToRGBA4444>(data, pixels, outData))
+    return 0;
+}
+
+ssize_t convertRGBA8888ToRGB5A1(const unsigned char* data, ssize_t pixels, unsigned char* outData)
+{
+    CC_DISPATCH_AVX2(convertRGBA8888To16AVX2<2>(data, pixels, outData))
+    CC_DISPATCH_SSE2(convertRGBA8888To16SSE2<rgba8888ToRGB5A1>(data, pixels, outData))
+    return 0;
+}
+
+ssize_t convertRGBA8888ToA8(const unsigned char* data, ssize_t pixels, unsigned char* outData)
+{
+    CC_DISPATCH_SSE2(convertRGBA8888ToA8SSE2(data, pixels, outData))
+    return 0;
+}
+
+ssize_t convertRGBA8888ToI8(const unsigned char* data, ssize_t pixels, unsigned char* outData)
+{
+    CC_DISPATCH_SSE2(convertRGBA8888ToI8SSE2(data, pixels, outData))
+    return 0;
+}
+
+ssize_t convertRGBA8888ToAI88(const unsigned char* data, ssize_t pixels, unsigned char* outData)
+{
+    CC_DISPATCH_SSE2(convertRGBA8888ToAI88SSE2(data, pixels, outData))
+    return 0;
+}
+
+ssize_t convertI8ToRGBA8888(const unsigned char* data, ssize_t pixels, unsigned char* outData)
+{
+    CC_DISPATCH_SSE2(convertI8ToRGBA8888SSE2(data, pixels, outData))
+    return 0;
+}
+
+ssize_t convertI8ToRGB565(const unsigned char* data, ssize_t pixels, unsigned char* outData)
+{
+    CC_DISPATCH_SSE2(convertI8To16SSE2<0>(data, pixels, outData))
+    return 0;
+}
+
+ssize_t convertI8ToRGBA4444(const unsigned char* data, ssize_t pixels, unsigned char* outData)
+{
+    CC_DISPATCH_SSE2(convertI8To16SSE2<1>(data, pixels, outData))
+    return 0;
+}
+
+ssize_t convertI8ToRGB5A1(const unsigned char* data, ssize_t pixels, unsigned char* outData)
+{
+    CC_DISPATCH_SSE2(convertI8To16SSE2<2>(data, pixels, outData))
+    return 0;
+}
+
+ssize_t convertI8ToAI88(const unsigned char* data, ssize_t pixels, unsigned char* outData)
+{
+    CC_DISPATCH_SSE2(convertI8ToAI88SSE2(data, pixels, outData))
+    return 0;
+}
+
+ssize_t convertAI88ToRGBA8888(const unsigned char* data, ssize_t pixels, unsigned char* outData)
+{
+    CC_DISPATCH_SSE2(convertAI88ToRGBA8888SSE2(data, pixels, outData))
+    return 0;
+}
+
+ssize_t convertAI88ToRGB565(const unsigned char* data, ssize_t pixels, unsigned char* outData)
+{
+    CC_DISPATCH_SSE2(convertAI88To16SSE2<0>(data, pixels, outData))
+    return 0;
+}
+
+ssize_t convertAI88ToRGBA4444(const unsigned char* data, ssize_t pixels, unsigned char* outData)
+{
+    CC_DISPATCH_SSE2(convertAI88To16SSE2<1>(data, pixels, outData))
+    return 0;
+}
+
+ssize_t convertAI88ToRGB5A1(const unsigned char* data, ssize_t pixels, unsigned char* outData)
+{
+    CC_DISPATCH_SSE2(convertAI88To16SSE2<2>(data, pixels, outData))
+    return 0;
+}
+
+ssize_t convertAI88ToA8(const unsigned char* data, ssize_t pixels, unsigned char* outData)
+{
+    CC_DISPATCH_SSE2(convertAI88To8SSE2<true>(data, pixels, outData))
+    return 0;
+}
+
+ssize_t convertAI88ToI8(const unsigned char* data, ssize_t pixels, unsigned char* outData)
+{
+    CC_DISPATCH_SSE2(convertAI88To8SSE2<false>(data, pixels, outData))
+    return 0;
+}
+
+static ssize_t premultiplyAlphaSIMD(unsigned char* data, ssize_t pixels)
+{
+    CC_DISPATCH_AVX2(premultiplyAlphaAVX2(data, pixels))
+    CC_DISPATCH_SSE2(premultiplyAlphaSSE2(data, pixels))
+    return 0;
+}
+
+void premultiplyAlpha(unsigned char* data, ssize_t pixels)
+{
+    ssize_t i = premultiplyAlphaSIMD(data, pixels);
+
+    unsigned int* data32 = (unsigned int*)data;
+    for (; i < pixels; ++i)
+    {
+        unsigned char* p = data + i * 4;
+        data32[i] = CC_RGB_PREMULTIPLY_ALPHA(p[0], p[1], p[2], p[3]);
+    }
+}
+
+} // namespace PixelConversion
+
+NS_CC_END
@@ -0,0 +1,96 @@
+/****************************************************************************
+ Copyright (c) 2013-2014 Chukong Technologies Inc.
+
+ http://www.cocos2d-x.org
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#ifndef __CCPIXELCONVERSION_H__
+#define __CCPIXELCONVERSION_H__
+
+#include "base/CCPlatformMacros.h"
+#include "CCStdC.h" // for ssize_t on window
+
+NS_CC_BEGIN
+
+/**
+ * @addtogroup textures
+ * @{
+ */
+
+/** Vectorized pixel format conversions used by Texture2D and Image.
+
+ Every conversion handles as many pixels as the vector width allows and returns how many it
+ converted, the caller converts the remaining pixels with the scalar code, whose results are
+ reproduced bit for bit. Returns 0 where no SIMD instruction set is available.
+ The instruction set is chosen at runtime: AVX2 when the CPU supports it, SSE2 on x86 otherwise.
+ */
+namespace PixelConversion {
+
+enum class SIMDLevel
+{
+    NONE,
+    SSE2,
+    AVX2,
+};
+
+/** the best instruction set supported by the compiler and the CPU */
+SIMDLevel getSupportedSIMDLevel();
+
+/** the instruction set in use */
+SIMDLevel getSIMDLevel();
+
+/** restricts the instruction set in use, e.g. to compare the kernels. Capped by getSupportedSIMDLevel() */
+void setSIMDLevel(SIMDLevel level);
+
+// RRRRRRRRGGGGGGGGBBBBBBBBAAAAAAAA ->
+ssize_t convertRGBA8888ToRGB565(const unsigned char* data, ssize_t pixels, unsigned char* outData);
+ssize_t convertRGBA8888ToRGBA4444(const unsigned char* data, ssize_t pixels, unsigned char* outData);
+ssize_t convertRGBA8888ToRGB5A1(const unsigned char* data, ssize_t pixels, unsigned char* outData);
+ssize_t convertRGBA8888ToA8(const unsigned char* data, ssize_t pixels, unsigned char* outData);
+ssize_t convertRGBA8888ToI8(const unsigned char* data, ssize_t pixels, unsigned char* outData);
+ssize_t convertRGBA8888ToAI88(const unsigned char* data, ssize_t pixels, unsigned char* outData);
+
+// IIIIIIII ->
+ssize_t convertI8ToRGBA8888(const unsigned char* data, ssize_t pixels, unsigned char* outData);
+ssize_t convertI8ToRGB565(const unsigned char* data, ssize_t pixels, unsigned char* outData);
+ssize_t convertI8ToRGBA4444(const unsigned char* data, ssize_t pixels, unsigned char* outData);
+ssize_t convertI8ToRGB5A1(const unsigned char* data, ssize_t pixels, unsigned char* outData);
+ssize_t convertI8ToAI88(const unsigned char* data, ssize_t pixels, unsigned char* outData);
+
+// IIIIIIIIAAAAAAAA ->
+ssize_t convertAI88ToRGBA8888(const unsigned char* data, ssize_t pixels, unsigned char* outData);
+ssize_t convertAI88ToRGB565(const unsigned char* data, ssize_t pixels, unsigned char* outData);
+ssize_t convertAI88ToRGBA4444(const unsigned char* data, ssize_t pixels, unsigned char* outData);
+ssize_t convertAI88ToRGB5A1(const unsigned char* data, ssize_t pixels, unsigned char* outData);
+ssize_t convertAI88ToA8(const unsigned char* data, ssize_t pixels, unsigned char* outData);
+ssize_t convertAI88ToI8(const unsigned char* data, ssize_t pixels, unsigned char* outData);
+
+/** premultiplies RGBA8888 pixels in place, like CC_RGB_PREMULTIPLY_ALPHA. Converts all the pixels */
+void premultiplyAlpha(unsigned char* data, ssize_t pixels);
+
+} // namespace PixelConversion
+
+// end of textures group
+/// @}
+
+NS_CC_END
+
+#endif // __CCPIXELCONVERSION_H__
@@ -23,6 +23,9 @@
  ****************************************************************************/
 
 #include "UIRichText.h"
+#include "2d/CCFontAtlasCache.h"
+#include "base/ccUTF8.h"
+#include <unordered_set>
 
 
 NS_CC_BEGIN
@@ -79,6 +82,49 @@ bool RichElementText::init(int tag, const Color3B &color, GLubyte opacity, const
     return false;
 }
 
+float RichElementText::getRunWidth(size_t start, size_t end) const
+{
+    if (end <= start)
+        return 0.0f;
+
+    // as LabelTextFormatter::createStringSprites(), the first letter of a label has no kerning
+    int nextPositionX = 0;
+    int longestLine = 0;
+    for (size_t i = start; i < end; ++i)
+    {
+        nextPositionX += _advances[i] + (i > start ? _kernings[i] : 0);
+        longestLine = MAX(longestLine, nextPositionX);
+    }
+    float width = longestLine;
+    if (_advances[end - 1] < _letterWidths[end - 1])
+    {
+        width = longestLine - _advances[end - 1] + _letterWidths[end - 1];
+    }
+    return width / CC_CONTENT_SCALE_FACTOR();
+}
+
+size_t RichElementText::getRunFit(size_t start, float width) const
+{
+    size_t end = start;
+    int nextPositionX = 0;
+    int longestLine = 0;
+    float widthInPixels = width * CC_CONTENT_SCALE_FACTOR();
+    for (size_t i = start; i < _utf16Text.length(); ++i)
+    {
+        nextPositionX += _advances[i] + (i > start ? _kernings[i] : 0);
+        longestLine = MAX(longestLine, nextPositionX);
+        float runWidth = longestLine;
+        if (_advances[i] < _letterWidths[i])
+        {
+            runWidth = longestLine - _advances[i] + _letterWidths[i];
+        }
+        if (runWidth > widthInPixels)
+            break;
+        end = i + 1;
+    }
+    return end;
+}
+
 RichElementImage* RichElementImage::create(int tag, const Color3B &color, GLubyte opacity, const std::string& filePath)
 {
     RichElementImage* element = new RichElementImage();
@@ -136,6 +182,20 @@ _elementRenderersContainer(nullptr)
 RichText::~RichText()
 {
     _richElements.clear();
+    for (auto& item : _renderers)
+    {
+        for (auto renderer : item.second)
+            renderer->release();
+    }
+    for (auto& item : _unusedRenderers)
+    {
+        for (auto renderer : item.second)
+            renderer->release();
+    }
+    for (auto& item : _fontAtlases)
+    {
+        FontAtlasCache::releaseFontAtlas(item.second);
+    }
 }
     
 RichText* RichText::create()
@@ -194,7 +254,25 @@ void RichText::formatText()
 {
     if (_formatTextDirty)
     {
-        _elementRenderersContainer->removeAllChildren();
+        // the labels and sprites of the previous layout are kept in the container to be reused,
+        // the new layout only sets their strings and positions
+        std::unordered_set<Node*> reusable;
+        for (auto& item : _renderers)
+        {
+            auto& unused = _unusedRenderers[item.first];
+            unused.insert(unused.end(), item.second.begin(), item.second.end());
+        }
+        _renderers.clear();
+        for (auto& item : _unusedRenderers)
+        {
+            reusable.insert(item.second.begin(), item.second.end());
+        }
+        auto children = _elementRenderersContainer->getChildren();
+        for (auto child : children)
+        {
+            if (reusable.find(child) == reusable.end())
+                _elementRenderersContainer->removeChild(child);
+        }
         _elementRenders.clear();
         if (_ignoreSize)
         {
@@ -208,6 +286,11 @@ void RichText::formatText()
                     case RichElement::Type::TEXT:
                     {
                         RichElementText* elmtText = static_cast<RichElementText*>(element);
+                        if (measureText(elmtText))
+                        {
+                            pushTextRun(elmtText, 0, elmtText->_utf16Text.length());
+                            continue;
+                        }
                         if (FileUtils::getInstance()->isFileExist(elmtText->_fontName))
                         {
                             elementRenderer = Label::createWithTTF(elmtText->_text.c_str(), elmtText->_fontName, elmtText->_fontSize);
@@ -221,7 +304,15 @@ void RichText::formatText()
                     case RichElement::Type::IMAGE:
                     {
                         RichElementImage* elmtImage = static_cast<RichElementImage*>(element);
-                        elementRenderer = Sprite::create(elmtImage->_filePath.c_str());
+                        std::string key = "image:" + elmtImage->_filePath;
+                        elementRenderer = getReusableRenderer(key);
+                        if (elementRenderer == nullptr)
+                        {
+                            elementRenderer = Sprite::create(elmtImage->_filePath.c_str());
+                            if (elementRenderer == nullptr)
+                                continue;
+                            addReusableRenderer(key, elementRenderer);
+                        }
                         break;
                     }
                     case RichElement::Type::CUSTOM:
@@ -250,7 +341,14 @@ void RichText::formatText()
                     case RichElement::Type::TEXT:
                     {
                         RichElementText* elmtText = static_cast<RichElementText*>(element);
-                        handleTextRenderer(elmtText->_text.c_str(), elmtText->_fontName.c_str(), elmtText->_fontSize, elmtText->_color, elmtText->_opacity);
+                        if (measureText(elmtText))
+                        {
+                            handleMeasuredText(elmtText);
+                        }
+                        else
+                        {
+                            handleTextRenderer(elmtText->_text.c_str(), elmtText->_fontName.c_str(), elmtText->_fontSize, elmtText->_color, elmtText->_opacity);
+                        }
                         break;
                     }
                     case RichElement::Type::IMAGE:
@@ -272,7 +370,153 @@ void RichText::formatText()
         }
         formarRenderers();
         _formatTextDirty = false;
+
+        for (auto& item : _unusedRenderers)
+        {
+            for (auto renderer : item.second)
+            {
+                _elementRenderersContainer->removeChild(renderer);
+                renderer->release();
+            }
+        }
+        _unusedRenderers.clear();
+    }
+}
+
+bool RichText::measureText(RichElementText* element)
+{
+    if (element->_measureState == RichElementText::MeasureState::NONE)
+    {
+        element->_measureState = RichElementText::MeasureState::UNMEASURABLE;
+        if (element->_text.find('\n') != std::string::npos
+            || !FileUtils::getInstance()->isFileExist(element->_fontName)
+            || !StringUtils::UTF8ToUTF16(element->_text, element->_utf16Text))
+        {
+            return false;
+        }
+
+        // the atlas of the labels created by Label::createWithTTF()
+        TTFConfig ttfConfig(element->_fontName.c_str(), element->_fontSize, GlyphCollection::DYNAMIC);
+        std::string atlasKey = StringUtils::format("%s_%d", element->_fontName.c_str(), ttfConfig.fontSize);
+        FontAtlas* atlas = nullptr;
+        auto it = _fontAtlases.find(atlasKey);
+        if (it != _fontAtlases.end())
+        {
+            atlas = it->second;
+        }
+        else
+        {
+            atlas = FontAtlasCache::getFontAtlasTTF(ttfConfig);
+            if (atlas == nullptr)
+                return false;
+            _fontAtlases[atlasKey] = atlas;
+        }
+
+        const auto& text = element->_utf16Text;
+        size_t length = text.length();
+        atlas->prepareLetterDefinitions(text);
+        int letterCount = 0;
+        int* kernings = atlas->getFont()->getHorizontalKerningForTextUTF16(text, letterCount);
+
+        auto contentScaleFactor = CC_CONTENT_SCALE_FACTOR();
+        element->_advances.resize(length);
+        element->_kernings.resize(length);
+        element->_letterWidths.resize(length);
+        FontLetterDefinition letterDefinition;
+        for (size_t i = 0; i < length; ++i)
+        {
+            // the letters without definition aren't drawn and don't move the next ones
+            if (atlas->getLetterDefinitionForChar(text[i], letterDefinition) && letterDefinition.validDefinition)
+            {
+                element->_advances[i] = letterDefinition.xAdvance;
+                element->_kernings[i] = kernings ? kernings[i] : 0;
+                element->_letterWidths[i] = letterDefinition.width * contentScaleFactor;
+            }
+            else
+            {
+                element->_advances[i] = 0;
+                element->_kernings[i] = 0;
+                element->_letterWidths[i] = 0;
+            }
+        }
+        delete [] kernings;
+
+        element->_measureState = RichElementText::MeasureState::MEASURED;
+    }
+    return element->_measureState == RichElementText::MeasureState::MEASURED;
+}
+
+void RichText::handleMeasuredText(RichElementText* element)
+{
+    // the letters fitting in the line are found with the measured widths, only the labels drawing
+    // the runs of each line are created
+    size_t length = element->_utf16Text.length();
+    size_t start = 0;
+    while (start < length)
+    {
+        float width = element->getRunWidth(start, length);
+        if (width <= _leftSpaceWidth)
+        {
+            pushTextRun(element, start, length);
+            _leftSpaceWidth -= width;
+            return;
+        }
+
+        size_t end = element->getRunFit(start, _leftSpaceWidth);
+        if (end == start && _leftSpaceWidth >= _customSize.width)
+        {
+            // not even a letter fits in an empty line
+            end = start + 1;
+        }
+        if (end > start)
+        {
+            pushTextRun(element, start, end);
+        }
+        addNewLine();
+        start = end;
+    }
+}
+
+void RichText::pushTextRun(RichElementText* element, size_t start, size_t end)
+{
+    std::string text;
+    StringUtils::UTF16ToUTF8(element->_utf16Text.substr(start, end - start), text);
+
+    std::string key = StringUtils::format("ttf:%s:%f", element->_fontName.c_str(), element->_fontSize);
+    Label* textRenderer = static_cast<Label*>(getReusableRenderer(key));
+    if (textRenderer)
+    {
+        textRenderer->setString(text);
     }
+    else
+    {
+        textRenderer = Label::createWithTTF(text, element->_fontName, element->_fontSize);
+        if (textRenderer == nullptr)
+            return;
+        addReusableRenderer(key, textRenderer);
+    }
+    textRenderer->setColor(element->_color);
+    textRenderer->setOpacity(element->_opacity);
+    pushToContainer(textRenderer);
+}
+
+Node* RichText::getReusableRenderer(const std::string& key)
+{
+    auto it = _unusedRenderers.find(key);
+    if (it == _unusedRenderers.end() || it->second.empty())
+        return nullptr;
+
+    // the renderers are taken in the order of the previous layout, so that most of them keep their string
+    Node* renderer = it->second.front();
+    it->second.erase(it->second.begin());
+    _renderers[key].push_back(renderer);
+    return renderer;
+}
+
+void RichText::addReusableRenderer(const std::string& key, Node* renderer)
+{
+    renderer->retain();
+    _renderers[key].push_back(renderer);
 }
     
 void RichText::handleTextRenderer(const std::string& text, const std::string& fontName, float fontSize, const Color3B &color, GLubyte opacity)
@@ -329,7 +573,15 @@ void RichText::handleTextRenderer(const std::string& text, const std::string& fo
     
 void RichText::handleImageRenderer(const std::string& fileParh, const Color3B &color, GLubyte opacity)
 {
-    Sprite* imageRenderer = Sprite::create(fileParh);
+    std::string key = "image:" + fileParh;
+    Node* imageRenderer = getReusableRenderer(key);
+    if (imageRenderer == nullptr)
+    {
+        imageRenderer = Sprite::create(fileParh);
+        if (imageRenderer == nullptr)
+            return;
+        addReusableRenderer(key, imageRenderer);
+    }
     handleCustomRenderer(imageRenderer);
 }
     
@@ -369,7 +621,16 @@ void RichText::formarRenderers()
             Node* l = row->at(j);
             l->setAnchorPoint(Vec2::ZERO);
             l->setPosition(Vec2(nextPosX, 0.0f));
-            _elementRenderersContainer->addChild(l, 1, (int)j);
+            if (l->getParent())
+            {
+                // reused from the previous layout
+                l->setLocalZOrder(1);
+                l->setTag((int)j);
+            }
+            else
+            {
+                _elementRenderersContainer->addChild(l, 1, (int)j);
+            }
             Size iSize = l->getContentSize();
             newContentSizeWidth += iSize.width;
             newContentSizeHeight = MAX(newContentSizeHeight, iSize.height);
@@ -408,7 +669,16 @@ void RichText::formarRenderers()
                 Node* l = row->at(j);
                 l->setAnchorPoint(Vec2::ZERO);
                 l->setPosition(Vec2(nextPosX, nextPosY));
-                _elementRenderersContainer->addChild(l, 1, (int)(i*10 + j));
+                if (l->getParent())
+                {
+                    // reused from the previous layout
+                    l->setLocalZOrder(1);
+                    l->setTag((int)(i*10 + j));
+                }
+                else
+                {
+                    _elementRenderersContainer->addChild(l, 1, (int)(i*10 + j));
+                }
                 nextPosX += l->getContentSize().width;
             }
         }
@@ -54,14 +54,35 @@ protected:
 class RichElementText : public RichElement
 {
 public:
-    RichElementText(){_type = Type::TEXT;};
+    RichElementText():_measureState(MeasureState::NONE){_type = Type::TEXT;};
     virtual ~RichElementText(){};
     bool init(int tag, const Color3B& color, GLubyte opacity, const std::string& text, const std::string& fontName, float fontSize);
     static RichElementText* create(int tag, const Color3B& color, GLubyte opacity, const std::string& text, const std::string& fontName, float fontSize);
 protected:
+    enum class MeasureState
+    {
+        NONE,
+        MEASURED,
+        // a system font or several lines, laid out with labels
+        UNMEASURABLE
+    };
+
+    /** returns the width in points of the letters [start, end) drawn by a label */
+    float getRunWidth(size_t start, size_t end) const;
+    /** returns the end of the longest run of letters from start whose width fits in width */
+    size_t getRunFit(size_t start, float width) const;
+
     std::string _text;
     std::string _fontName;
     float _fontSize;
+
+    // the letters shaped once with the metrics of the font atlas, in pixels, so that the text
+    // is laid out again without creating labels to measure it
+    MeasureState _measureState;
+    std::u16string _utf16Text;
+    std::vector<int> _advances;
+    std::vector<int> _kernings;
+    std::vector<float> _letterWidths;
     friend class RichText;
     
 };
@@ -117,6 +138,11 @@ protected:
     virtual void initRenderer();
     void pushToContainer(Node* renderer);
     void handleTextRenderer(const std::string& text, const std::string& fontName, float fontSize, const Color3B& color, GLubyte opacity);
+    bool measureText(RichElementText* element);
+    void handleMeasuredText(RichElementText* element);
+    void pushTextRun(RichElementText* element, size_t start, size_t end);
+    Node* getReusableRenderer(const std::string& key);
+    void addReusableRenderer(const std::string& key, Node* renderer);
     void handleImageRenderer(const std::string& fileParh, const Color3B& color, GLubyte opacity);
     void handleCustomRenderer(Node* renderer);
     void formarRenderers();
@@ -128,6 +154,11 @@ protected:
     float _leftSpaceWidth;
     float _verticalSpace;
     Node* _elementRenderersContainer;
+    // the font atlases measuring the text elements, by font and size
+    std::unordered_map<std::string, FontAtlas*> _fontAtlases;
+    // the labels and sprites of the current layout, by font or image, and the ones the layout didn't reuse
+    std::unordered_map<std::string, std::vector<Node*>> _renderers;
+    std::unordered_map<std::string, std::vector<Node*>> _unusedRenderers;
 };
     
 }
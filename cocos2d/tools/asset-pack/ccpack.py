@@ -0,0 +1,132 @@
+#!/usr/bin/python
+#ccpack.py
+#Builds a .ccpack asset pack, read by cocos2d::AssetPack, from a resource directory.
+#usage: ccpack.py Resources data.ccpack
+#then, in the game: FileUtils::getInstance()->addSearchPath("data.ccpack");
+
+import argparse
+import os
+import os.path
+import struct
+import sys
+import zlib
+
+PACK_MAGIC = b'CCPK'
+PACK_VERSION = 1
+HEADER_FORMAT = '<4sIIIII'
+ENTRY_FORMAT = '<QIIIIIHH'
+ENTRY_SIZE = struct.calcsize(ENTRY_FORMAT)
+
+COMPRESSION_STORED = 0
+COMPRESSION_DEFLATE = 1
+
+#stored entries are aligned so that they can be read in place
+DATA_ALIGNMENT = 16
+
+#formats which are already compressed, deflating them again is a waste of loading time
+STORED_EXTENSIONS = ['.png', '.jpg', '.jpeg', '.webp', '.pkm', '.pvr.ccz', '.ccz', '.mp3', '.ogg', '.m4a', '.caf', '.zip']
+
+#64 bits FNV-1a, must match AssetPack::hashPath
+def hashPath(path):
+    h = 14695981039346656037
+    for c in bytearray(path):
+        h ^= c
+        h = (h * 1099511628211) & 0xffffffffffffffff
+    return h
+
+def align(value, alignment):
+    return (value + alignment - 1) // alignment * alignment
+
+def shouldDeflate(path, data, minRatio):
+    lower = path.lower()
+    for extension in STORED_EXTENSIONS:
+        if lower.endswith(extension):
+            return None
+    deflated = zlib.compress(data, 9)
+    #keep it stored if it doesn't save enough, it can then be read without copy
+    if len(deflated) > len(data) * minRatio:
+        return None
+    return deflated
+
+def collectFiles(sourceDir, excludes):
+    files = []
+    for root, dirs, names in os.walk(sourceDir):
+        dirs.sort()
+        for name in sorted(names):
+            fullPath = os.path.join(root, name)
+            path = os.path.relpath(fullPath, sourceDir).replace(os.sep, '/')
+            if name.startswith('.') or any(path.startswith(exclude) for exclude in excludes):
+                continue
+            files.append((path, fullPath))
+    return files
+
+def buildPack(sourceDir, output, minRatio, excludes, verbose):
+    files = collectFiles(sourceDir, excludes)
+
+    entries = []
+    names = bytearray()
+    for path, fullPath in files:
+        encodedPath = path.encode('utf-8')
+        with open(fullPath, 'rb') as f:
+            data = f.read()
+        deflated = shouldDeflate(path, data, minRatio)
+        entries.append({
+            'hash': hashPath(encodedPath),
+            'nameOffset': len(names),
+            'nameLength': len(encodedPath),
+            'size': len(data),
+            'compression': COMPRESSION_DEFLATE if deflated is not None else COMPRESSION_STORED,
+            'payload': deflated if deflated is not None else data,
+        })
+        names += encodedPath
+
+    entries.sort(key=lambda entry: entry['hash'])
+
+    headerSize = struct.calcsize(HEADER_FORMAT)
+    indexOffset = align(headerSize, 8)
+    namesOffset = indexOffset + ENTRY_SIZE * len(entries)
+    dataOffset = namesOffset + len(names)
+
+    for entry in entries:
+        dataOffset = align(dataOffset, DATA_ALIGNMENT)
+        entry['dataOffset'] = dataOffset
+        dataOffset += len(entry['payload'])
+
+    if dataOffset > 0xffffffff:
+        sys.exit('Error: the pack would be bigger than 4GB')
+
+    with open(output, 'wb') as f:
+        f.write(struct.pack(HEADER_FORMAT, PACK_MAGIC, PACK_VERSION, len(entries), indexOffset, namesOffset, len(names)))
+        f.write(b'\0' * (indexOffset - headerSize))
+        for entry in entries:
+            f.write(struct.pack(ENTRY_FORMAT, entry['hash'], entry['nameOffset'], entry['nameLength'],
+                                entry['dataOffset'], len(entry['payload']), entry['size'], entry['compression'], 0))
+        f.write(names)
+        for entry in entries:
+            f.write(b'\0' * (entry['dataOffset'] - f.tell()))
+            f.write(entry['payload'])
+
+    if verbose:
+        for entry in entries:
+            name = names[entry['nameOffset']:entry['nameOffset'] + entry['nameLength']].decode('utf-8')
+            method = 'deflate' if entry['compression'] == COMPRESSION_DEFLATE else 'stored'
+            print('%-8s %10d -> %10d %s' % (method, entry['size'], len(entry['payload']), name))
+
+    totalSize = sum(entry['size'] for entry in entries)
+    print('%s: %d files, %d bytes packed in %d bytes' % (output, len(entries), totalSize, dataOffset))
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description='Builds a cocos2d-x asset pack from a resource directory')
+    parser.add_argument('source', help='resource directory, e.g. Resources')
+    parser.add_argument('output', help='pack to write, e.g. data.ccpack')
+    parser.add_argument('--min-ratio', type=float, default=0.9,
+                        help='files are deflated if their deflated size is at most this ratio of their size (default 0.9)')
+    parser.add_argument('--exclude', action='append', default=[],
+                        help='path prefix, relative to the source directory, of files not to pack')
+    parser.add_argument('-v', '--verbose', action='store_true', help='list the packed files')
+    args = parser.parse_args()
+
+    if not os.path.isdir(args.source):
+        sys.exit('Error: ' + args.source + ' is not a directory')
+
+    buildPack(args.source, args.output, args.min_ratio, args.exclude, args.verbose)